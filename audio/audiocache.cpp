@@ -0,0 +1,261 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/audiocache.h"
+#include "audio/audiostream.h"
+#include "audio/decoders/raw.h"
+
+#include "common/system.h"
+
+namespace Audio {
+
+DecodedAudioCache::Inbox::Inbox() : mutex(0), refCount(1) {
+	// Without a backend there are no other threads to guard against
+	if (g_system)
+		mutex = g_system->createMutex();
+}
+
+void DecodedAudioCache::Inbox::lock() {
+	if (mutex)
+		g_system->lockMutex(mutex);
+}
+
+void DecodedAudioCache::Inbox::unlock() {
+	if (mutex)
+		g_system->unlockMutex(mutex);
+}
+
+void DecodedAudioCache::Inbox::release() {
+	lock();
+	const bool unused = (--refCount == 0);
+	unlock();
+
+	if (!unused)
+		return;
+
+	while (!entries.empty()) {
+		free(entries.front()->data);
+		delete entries.front();
+		entries.pop_front();
+	}
+
+	if (mutex)
+		g_system->deleteMutex(mutex);
+	delete this;
+}
+
+/**
+ * Plays a stream while recording the decoded samples, and hands the sound
+ * over to the cache once it has been played to the end. The recording is
+ * dropped if the stream is seeked, or turns out to be larger than expected.
+ */
+class RecordingAudioStream : public SeekableAudioStream {
+public:
+	RecordingAudioStream(DecodedAudioCache::Inbox *inbox, const Common::String &key, SeekableAudioStream *parent, uint32 size)
+		: _inbox(inbox), _key(key), _parent(parent), _capacity(size), _size(0) {
+		_inbox->lock();
+		_inbox->refCount++;
+		_inbox->unlock();
+
+		// Allocate the buffer here on the engine thread, rather than
+		// growing it on the audio thread
+		_data = (byte *)malloc(_capacity);
+	}
+
+	~RecordingAudioStream() {
+		free(_data);
+		delete _parent;
+		_inbox->release();
+	}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		const int samples = _parent->readBuffer(buffer, numSamples);
+
+		if (_data && samples > 0) {
+			const uint32 size = samples * sizeof(int16);
+			if (_size + size > _capacity) {
+				stopRecording();
+			} else {
+				memcpy(_data + _size, buffer, size);
+				_size += size;
+			}
+		}
+
+		if (_data && _parent->endOfData())
+			finishRecording();
+
+		return samples;
+	}
+
+	bool isStereo() const { return _parent->isStereo(); }
+	int getRate() const { return _parent->getRate(); }
+	bool endOfData() const { return _parent->endOfData(); }
+	bool endOfStream() const { return _parent->endOfStream(); }
+
+	bool seek(const Timestamp &where) {
+		stopRecording();
+		return _parent->seek(where);
+	}
+
+	Timestamp getLength() const { return _parent->getLength(); }
+
+private:
+	DecodedAudioCache::Inbox *_inbox;
+	const Common::String _key;
+	SeekableAudioStream *_parent;
+
+	byte *_data;
+	uint32 _capacity;
+	uint32 _size;
+
+	void stopRecording() {
+		free(_data);
+		_data = 0;
+	}
+
+	void finishRecording() {
+		if (!_size) {
+			stopRecording();
+			return;
+		}
+
+		DecodedAudioCache::Entry *entry = new DecodedAudioCache::Entry();
+		entry->key = _key;
+		entry->data = _data;
+		entry->size = _size;
+		entry->rate = _parent->getRate();
+		entry->stereo = _parent->isStereo();
+		_data = 0;
+
+		_inbox->lock();
+		_inbox->entries.push_back(entry);
+		_inbox->unlock();
+	}
+};
+
+DecodedAudioCache::DecodedAudioCache(uint32 memoryBudget, uint32 maxEntrySize)
+	: _memoryBudget(memoryBudget), _maxEntrySize(MIN(maxEntrySize, memoryBudget)),
+	  _memoryUsage(0), _hits(0), _misses(0), _inbox(new Inbox()) {
+}
+
+DecodedAudioCache::~DecodedAudioCache() {
+	clear();
+	_inbox->release();
+}
+
+SeekableAudioStream *DecodedAudioCache::createStream(const Common::String &key) {
+	addRecordedEntries();
+
+	EntryMap::iterator i = _entryMap.find(key);
+	if (i == _entryMap.end()) {
+		_misses++;
+		return 0;
+	}
+
+	_hits++;
+
+	// Move the entry to the front of the LRU list
+	Entry *entry = *i->_value;
+	_entries.erase(i->_value);
+	_entries.push_front(entry);
+	i->_value = _entries.begin();
+
+	return createStream(*entry);
+}
+
+SeekableAudioStream *DecodedAudioCache::cacheStream(const Common::String &key, SeekableAudioStream *stream) {
+	addRecordedEntries();
+
+	if (!stream || _entryMap.contains(key))
+		return stream;
+
+	// Skip sounds which are known to be too large. Leave some leeway for
+	// streams which report their length a bit short.
+	const uint32 frameSize = stream->isStereo() ? 4 : 2;
+	const uint32 frames = (uint32)stream->getLength().convertToFramerate(stream->getRate()).totalNumberOfFrames();
+	if (!frames || frames > _maxEntrySize / frameSize)
+		return stream;
+
+	const uint32 size = MIN<uint32>((frames + frames / 16 + 64) * frameSize, _maxEntrySize);
+	return new RecordingAudioStream(_inbox, key, stream, size);
+}
+
+void DecodedAudioCache::clear() {
+	addRecordedEntries();
+
+	while (!_entries.empty())
+		removeEntry(_entries.begin());
+}
+
+void DecodedAudioCache::addRecordedEntries() {
+	_inbox->lock();
+	EntryList recorded = _inbox->entries;
+	_inbox->entries.clear();
+	_inbox->unlock();
+
+	for (EntryList::iterator i = recorded.begin(); i != recorded.end(); ++i) {
+		Entry *entry = *i;
+
+		// The same sound may have been recorded more than once
+		if (_entryMap.contains(entry->key)) {
+			free(entry->data);
+			delete entry;
+			continue;
+		}
+
+		// Make room for the new entry
+		while (_memoryUsage + entry->size > _memoryBudget)
+			removeEntry(--_entries.end());
+
+		_entries.push_front(entry);
+		_entryMap[entry->key] = _entries.begin();
+		_memoryUsage += entry->size;
+	}
+}
+
+SeekableAudioStream *DecodedAudioCache::createStream(const Entry &entry) const {
+	byte *data = (byte *)malloc(entry.size);
+	assert(data);
+	memcpy(data, entry.data, entry.size);
+
+	byte flags = FLAG_16BITS;
+#ifdef SCUMM_LITTLE_ENDIAN
+	flags |= FLAG_LITTLE_ENDIAN;
+#endif
+	if (entry.stereo)
+		flags |= FLAG_STEREO;
+
+	return makeRawStream(data, entry.size, entry.rate, flags, DisposeAfterUse::YES);
+}
+
+void DecodedAudioCache::removeEntry(EntryList::iterator i) {
+	Entry *entry = *i;
+
+	_memoryUsage -= entry->size;
+	_entryMap.erase(entry->key);
+	_entries.erase(i);
+
+	free(entry->data);
+	delete entry;
+}
+
+} // End of namespace Audio
@@ -0,0 +1,148 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_AUDIOCACHE_H
+#define AUDIO_AUDIOCACHE_H
+
+#include "common/scummsys.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/list.h"
+#include "common/mutex.h"
+#include "common/str.h"
+
+namespace Audio {
+
+class SeekableAudioStream;
+class RecordingAudioStream;
+
+/**
+ * A cache of fully decoded sounds, for engines which play the same short
+ * compressed sounds over and over again.
+ *
+ * Sounds are identified by a key chosen by the engine (usually derived
+ * from the resource the sound was loaded from). Only sounds up to a given
+ * size are cached, and the least recently used ones are dropped once the
+ * memory budget is exceeded. Every stream handed out plays from its own
+ * copy of the decoded data, so cached sounds can be evicted at any time.
+ *
+ * A sound is not decoded in advance. Instead, the decoded samples are
+ * recorded while it is played for the first time, and the sound enters the
+ * cache once it has been played to the end without seeking.
+ *
+ * The cache is meant to be used from the engine thread only. The streams
+ * it hands out may be played on any thread.
+ */
+class DecodedAudioCache {
+public:
+	/**
+	 * Create a new cache.
+	 *
+	 * @param memoryBudget Maximum size of all cached sounds, in bytes.
+	 * @param maxEntrySize Maximum size of a single cached sound, in bytes.
+	 */
+	DecodedAudioCache(uint32 memoryBudget, uint32 maxEntrySize);
+	~DecodedAudioCache();
+
+	/**
+	 * Create a stream for the sound stored under the given key.
+	 *
+	 * @return a new stream, or 0 if the sound is not in the cache
+	 */
+	SeekableAudioStream *createStream(const Common::String &key);
+
+	/**
+	 * Offer a freshly created stream to the cache. If the sound is small
+	 * enough, a stream which plays the given stream and records it for the
+	 * cache is returned, taking over the given stream. Otherwise, the given
+	 * stream is returned.
+	 */
+	SeekableAudioStream *cacheStream(const Common::String &key, SeekableAudioStream *stream);
+
+	/**
+	 * Remove all sounds from the cache.
+	 */
+	void clear();
+
+	/** Returns the number of createStream() calls which found their sound. */
+	uint32 getHits() const { return _hits; }
+
+	/** Returns the number of createStream() calls which did not find their sound. */
+	uint32 getMisses() const { return _misses; }
+
+	/**
+	 * Returns the size of all cached sounds, in bytes. Recorded sounds only
+	 * count once the cache has been used again after their recording ended.
+	 */
+	uint32 getMemoryUsage() const { return _memoryUsage; }
+
+private:
+	friend class RecordingAudioStream;
+
+	struct Entry {
+		Common::String key;
+		byte *data;
+		uint32 size;
+		int rate;
+		bool stereo;
+	};
+
+	/**
+	 * The sounds which have been recorded completely, but not yet been
+	 * added to the cache. Shared between the cache and its recording
+	 * streams, which may outlive it and run on other threads.
+	 */
+	struct Inbox {
+		Common::MutexRef mutex;
+		uint refCount;
+		Common::List<Entry *> entries;
+
+		Inbox();
+		void lock();
+		void unlock();
+		void release();
+	};
+
+	typedef Common::List<Entry *> EntryList;
+	typedef Common::HashMap<Common::String, EntryList::iterator> EntryMap;
+
+	/** All entries, the most recently used one first. */
+	EntryList _entries;
+	EntryMap _entryMap;
+
+	const uint32 _memoryBudget;
+	const uint32 _maxEntrySize;
+	uint32 _memoryUsage;
+
+	uint32 _hits;
+	uint32 _misses;
+
+	Inbox *_inbox;
+
+	SeekableAudioStream *createStream(const Entry &entry) const;
+	void addRecordedEntries();
+	void removeEntry(EntryList::iterator i);
+};
+
+} // End of namespace Audio
+
+#endif
@@ -46,14 +46,24 @@ ADPCMStream::ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Fl
 		_endpos(_startpos + size),
 		_channels(channels),
 		_blockAlign(blockAlign),
-		_rate(rate) {
+		_rate(rate),
+		_blockData(0),
+		_sampleBuffer(0),
+		_sampleBufferPos(0),
+		_sampleBufferEnd(0) {
 
 	reset();
 }
 
+ADPCMStream::~ADPCMStream() {
+	delete[] _blockData;
+	delete[] _sampleBuffer;
+}
+
 void ADPCMStream::reset() {
 	memset(&_status, 0, sizeof(_status));
 	_blockPos[0] = _blockPos[1] = _blockAlign; // To make sure first header is read
+	_sampleBufferPos = _sampleBufferEnd = 0;
 }
 
 bool ADPCMStream::rewind() {
@@ -63,28 +73,59 @@ bool ADPCMStream::rewind() {
 	return true;
 }
 
+int ADPCMStream::readDecodedSamples(int16 *buffer, const int numSamples) {
+	int samples = 0;
+
+	while (samples < numSamples) {
+		if (_sampleBufferPos == _sampleBufferEnd) {
+			if (_stream->eos() || _stream->pos() >= _endpos)
+				break;
+
+			_sampleBufferPos = 0;
+			_sampleBufferEnd = decodeBlock();
+			if (!_sampleBufferEnd)
+				break;
+		}
+
+		const int count = MIN(numSamples - samples, _sampleBufferEnd - _sampleBufferPos);
+		memcpy(buffer + samples, _sampleBuffer + _sampleBufferPos, count * sizeof(int16));
+		_sampleBufferPos += count;
+		samples += count;
+	}
+
+	return samples;
+}
+
+void ADPCMStream::readBlockData(uint32 size) {
+	const uint32 bytesRead = _stream->read(_blockData, size);
+	if (bytesRead < size)
+		memset(_blockData + bytesRead, 0, size - bytesRead);
+}
+
 
 #pragma mark -
 
 
-int Oki_ADPCMStream::readBuffer(int16 *buffer, const int numSamples) {
-	int samples;
-	byte data;
+// Number of bytes decoded at a time by the decoders without block structure
+static const uint32 kADPCMChunkSize = 512;
 
-	for (samples = 0; samples < numSamples && !endOfData(); samples++) {
-		if (_decodedSampleCount == 0) {
-			data = _stream->readByte();
-			_decodedSamples[0] = decodeOKI((data >> 4) & 0x0f);
-			_decodedSamples[1] = decodeOKI((data >> 0) & 0x0f);
-			_decodedSampleCount = 2;
-		}
+Oki_ADPCMStream::Oki_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
+	: ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
+
+	_blockData = new byte[kADPCMChunkSize];
+	_sampleBuffer = new int16[kADPCMChunkSize * 2];
+}
+
+int Oki_ADPCMStream::decodeBlock() {
+	const uint32 size = _stream->read(_blockData, MIN<int32>(kADPCMChunkSize, _endpos - _stream->pos()));
+	int16 *samples = _sampleBuffer;
 
-		// (1 - (count - 1)) ensures that _decodedSamples acts as a FIFO of depth 2
-		buffer[samples] = _decodedSamples[1 - (_decodedSampleCount - 1)];
-		_decodedSampleCount--;
+	for (uint32 i = 0; i < size; i++) {
+		*samples++ = decodeOKI((_blockData[i] >> 4) & 0x0f);
+		*samples++ = decodeOKI((_blockData[i] >> 0) & 0x0f);
 	}
 
-	return samples;
+	return size * 2;
 }
 
 static const int16 okiStepSize[49] = {
@@ -119,136 +160,130 @@ int16 Oki_ADPCMStream::decodeOKI(byte code) {
 #pragma mark -
 
 
-int DVI_ADPCMStream::readBuffer(int16 *buffer, const int numSamples) {
-	int samples;
-	byte data;
+DVI_ADPCMStream::DVI_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
+	: Ima_ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
 
-	for (samples = 0; samples < numSamples && !endOfData(); samples++) {
-		if (_decodedSampleCount == 0) {
-			data = _stream->readByte();
-			_decodedSamples[0] = decodeIMA((data >> 4) & 0x0f, 0);
-			_decodedSamples[1] = decodeIMA((data >> 0) & 0x0f, _channels == 2 ? 1 : 0);
-			_decodedSampleCount = 2;
-		}
+	_blockData = new byte[kADPCMChunkSize];
+	_sampleBuffer = new int16[kADPCMChunkSize * 2];
+}
 
-		// (1 - (count - 1)) ensures that _decodedSamples acts as a FIFO of depth 2
-		buffer[samples] = _decodedSamples[1 - (_decodedSampleCount - 1)];
-		_decodedSampleCount--;
+int DVI_ADPCMStream::decodeBlock() {
+	const uint32 size = _stream->read(_blockData, MIN<int32>(kADPCMChunkSize, _endpos - _stream->pos()));
+	const int secondChannel = (_channels == 2) ? 1 : 0;
+	int16 *samples = _sampleBuffer;
+
+	for (uint32 i = 0; i < size; i++) {
+		*samples++ = decodeIMA((_blockData[i] >> 4) & 0x0f, 0);
+		*samples++ = decodeIMA((_blockData[i] >> 0) & 0x0f, secondChannel);
 	}
 
-	return samples;
+	return size * 2;
 }
 
 #pragma mark -
 
 
-int Apple_ADPCMStream::readBuffer(int16 *buffer, const int numSamples) {
-	// Need to write at least one samples per channel
-	assert((numSamples % _channels) == 0);
+Apple_ADPCMStream::Apple_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
+	: Ima_ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
 
-	// Current sample positions
-	int samples[2] = { 0, 0};
+	if (blockAlign <= 2)
+		error("Apple_ADPCMStream(): invalid blockAlign");
 
-	// Number of samples per channel
-	int chanSamples = numSamples / _channels;
+	_blockData = new byte[blockAlign];
+	_sampleBuffer = new int16[(blockAlign - 2) * 2 * channels];
+}
+
+int Apple_ADPCMStream::decodeBlock() {
+	// The channels are interleaved block-wise, with a block of each channel in
+	// turn; we want them interleaved sample-wise.
+	int frames = (_blockAlign - 2) * 2;
 
 	for (int i = 0; i < _channels; i++) {
-		_stream->seek(_streamPos[i]);
+		if (_stream->eos() || _stream->pos() >= _endpos)
+			return 0;
 
-		while ((samples[i] < chanSamples) &&
-		       // Last byte read and a new one needed
-		       !((_stream->eos() || (_stream->pos() >= _endpos)) && (_chunkPos[i] == 0))) {
+		// 2 byte header per block
+		uint16 temp = _stream->readUint16BE();
 
-			if (_blockPos[i] == _blockAlign) {
-				// 2 byte header per block
-				uint16 temp = _stream->readUint16BE();
+		// First 9 bits are the upper bits of the predictor
+		_status.ima_ch[i].last      = (int16) (temp & 0xFF80);
+		// Lower 7 bits are the step index
+		_status.ima_ch[i].stepIndex =          temp & 0x007F;
 
-				// First 9 bits are the upper bits of the predictor
-				_status.ima_ch[i].last      = (int16) (temp & 0xFF80);
-				// Lower 7 bits are the step index
-				_status.ima_ch[i].stepIndex =          temp & 0x007F;
+		// Clip the step index
+		_status.ima_ch[i].stepIndex = CLIP<int32>(_status.ima_ch[i].stepIndex, 0, 88);
 
-				// Clip the step index
-				_status.ima_ch[i].stepIndex = CLIP<int32>(_status.ima_ch[i].stepIndex, 0, 88);
+		// Decode data
+		const uint32 size = _stream->read(_blockData, CLIP<int32>(_endpos - _stream->pos(), 0, _blockAlign - 2));
+		int16 *samples = _sampleBuffer + i;
 
-				_blockPos[i] = 2;
-			}
-
-			if (_chunkPos[i] == 0) {
-				// Decode data
-				byte data = _stream->readByte();
-				_buffer[i][0] = decodeIMA(data &  0x0F, i);
-				_buffer[i][1] = decodeIMA(data >>    4, i);
-			}
+		for (uint32 j = 0; j < size; j++) {
+			samples[0]         = decodeIMA(_blockData[j] &  0x0F, i);
+			samples[_channels] = decodeIMA(_blockData[j] >>    4, i);
+			samples += _channels * 2;
+		}
 
-			// The original is interleaved block-wise, we want it sample-wise
-			buffer[_channels * samples[i] + i] = _buffer[i][_chunkPos[i]];
+		frames = MIN<int>(frames, size * 2);
+	}
 
-			if (++_chunkPos[i] > 1) {
-				// We're about to decode the next byte, so advance the block position
-				_chunkPos[i] = 0;
-				_blockPos[i]++;
-			}
+	return frames * _channels;
+}
 
-			samples[i]++;
 
-			if (_channels == 2)
-				if (_blockPos[i] == _blockAlign)
-					// We're at the end of the block.
-					// Since the channels are interleaved, skip the next block
-					_stream->skip(MIN<uint32>(_blockAlign, _endpos - _stream->pos()));
+#pragma mark -
 
-			_streamPos[i] = _stream->pos();
-		}
-	}
 
-	return samples[0] + samples[1];
-}
+MSIma_ADPCMStream::MSIma_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
+	: Ima_ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
 
+	if (blockAlign == 0)
+		error("MSIma_ADPCMStream(): blockAlign isn't specified");
 
-#pragma mark -
+	if (blockAlign % (_channels * 4))
+		error("MSIma_ADPCMStream(): invalid blockAlign");
 
+	_blockData = new byte[blockAlign];
+	_sampleBuffer = new int16[blockAlign * 2];
+}
 
-int MSIma_ADPCMStream::readBuffer(int16 *buffer, const int numSamples) {
-	// Need to write at least one sample per channel
-	assert((numSamples % _channels) == 0);
+int MSIma_ADPCMStream::decodeBlock() {
+	for (int i = 0; i < _channels; i++) {
+		// read block header
+		_status.ima_ch[i].last = _stream->readSint16LE();
+		_status.ima_ch[i].stepIndex = _stream->readSint16LE();
+	}
 
-	int samples = 0;
+	// The stream encodes four bytes per channel at a time. A group which is
+	// cut off by the end of the stream is still decoded as a whole.
+	const uint32 groupSize = _channels * 4;
+	const int32 bytesLeft = _endpos - _stream->pos();
+	uint32 groups = (_blockAlign - _channels * 4) / groupSize;
+	if (bytesLeft <= 0)
+		groups = MIN<uint32>(groups, 1);
+	else
+		groups = MIN<uint32>(groups, (bytesLeft + groupSize - 1) / groupSize);
 
-	while (samples < numSamples && !_stream->eos() && _stream->pos() < _endpos) {
-		if (_blockPos[0] == _blockAlign) {
-			for (int i = 0; i < _channels; i++) {
-				// read block header
-				_status.ima_ch[i].last = _stream->readSint16LE();
-				_status.ima_ch[i].stepIndex = _stream->readSint16LE();
-			}
+	readBlockData(groups * groupSize);
 
-			_blockPos[0] = _channels * 4;
-		}
+	const byte *data = _blockData;
+	int16 *samples = _sampleBuffer;
 
-		// Decode a set of samples
+	for (uint32 group = 0; group < groups; group++) {
 		for (int i = 0; i < _channels; i++) {
-			// The stream encodes four bytes per channel at a time
+			int16 *out = samples + i;
+
 			for (int j = 0; j < 4; j++) {
-				byte data = _stream->readByte();
-				_blockPos[0]++;
-				_buffer[i][j * 2] = decodeIMA(data & 0x0f, i);
-				_buffer[i][j * 2 + 1] = decodeIMA((data >> 4) & 0x0f, i);
-				_samplesLeft[i] += 2;
+				const byte code = *data++;
+				out[0]         = decodeIMA(code & 0x0f, i);
+				out[_channels] = decodeIMA((code >> 4) & 0x0f, i);
+				out += _channels * 2;
 			}
 		}
 
-		while (samples < numSamples && _samplesLeft[0] != 0) {
-			for (int i = 0; i < _channels; i++) {
-				buffer[samples + i] = _buffer[i][8 - _samplesLeft[i]];
-				_samplesLeft[i]--;
-			}
-
-			samples += _channels;
-		}
+		samples += _channels * 8;
 	}
 
-	return samples;
+	return groups * _channels * 8;
 }
 
 
@@ -268,6 +303,20 @@ static const int MSADPCMAdaptationTable[] = {
 	768, 614, 512, 409, 307, 230, 230, 230
 };
 
+MS_ADPCMStream::MS_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
+	: ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
+
+	if (blockAlign == 0)
+		error("MS_ADPCMStream(): blockAlign isn't specified for MS ADPCM");
+	if (blockAlign < (uint32)_channels * 7)
+		error("MS_ADPCMStream(): invalid blockAlign");
+
+	memset(&_status, 0, sizeof(_status));
+
+	_blockData = new byte[blockAlign];
+	_sampleBuffer = new int16[blockAlign * 2];
+}
+
 int16 MS_ADPCMStream::decodeMS(ADPCMChannelStatus *c, byte code) {
 	int32 predictor;
 
@@ -286,114 +335,122 @@ int16 MS_ADPCMStream::decodeMS(ADPCMChannelStatus *c, byte code) {
 	return (int16)predictor;
 }
 
-int MS_ADPCMStream::readBuffer(int16 *buffer, const int numSamples) {
-	int samples;
-	byte data;
+int MS_ADPCMStream::decodeBlock() {
 	int i;
 
-	for (samples = 0; samples < numSamples && !endOfData(); samples++) {
-		if (_decodedSampleCount == 0) {
-			if (_blockPos[0] == _blockAlign) {
-				// read block header
-				for (i = 0; i < _channels; i++) {
-					_status.ch[i].predictor = CLIP(_stream->readByte(), (byte)0, (byte)6);
-					_status.ch[i].coeff1 = MSADPCMAdaptCoeff1[_status.ch[i].predictor];
-					_status.ch[i].coeff2 = MSADPCMAdaptCoeff2[_status.ch[i].predictor];
-				}
-
-				for (i = 0; i < _channels; i++)
-					_status.ch[i].delta = _stream->readSint16LE();
-
-				for (i = 0; i < _channels; i++)
-					_status.ch[i].sample1 = _stream->readSint16LE();
-
-				for (i = 0; i < _channels; i++)
-					_decodedSamples[_decodedSampleCount++] = _status.ch[i].sample2 = _stream->readSint16LE();
-
-				for (i = 0; i < _channels; i++)
-					_decodedSamples[_decodedSampleCount++] = _status.ch[i].sample1;
-
-				_blockPos[0] = _channels * 7;
-			} else {
-				data = _stream->readByte();
-				_blockPos[0]++;
-				_decodedSamples[_decodedSampleCount++] = decodeMS(&_status.ch[0], (data >> 4) & 0x0f);
-				_decodedSamples[_decodedSampleCount++] = decodeMS(&_status.ch[_channels - 1], data & 0x0f);
-			}
-		}
+	// read block header
+	for (i = 0; i < _channels; i++) {
+		_status.ch[i].predictor = CLIP(_stream->readByte(), (byte)0, (byte)6);
+		_status.ch[i].coeff1 = MSADPCMAdaptCoeff1[_status.ch[i].predictor];
+		_status.ch[i].coeff2 = MSADPCMAdaptCoeff2[_status.ch[i].predictor];
+	}
 
-		// (1 - (count - 1)) ensures that _decodedSamples acts as a FIFO of depth 2
-		buffer[samples] = _decodedSamples[1 - (_decodedSampleCount - 1)];
-		_decodedSampleCount--;
+	for (i = 0; i < _channels; i++)
+		_status.ch[i].delta = _stream->readSint16LE();
+
+	for (i = 0; i < _channels; i++)
+		_status.ch[i].sample1 = _stream->readSint16LE();
+
+	for (i = 0; i < _channels; i++)
+		_status.ch[i].sample2 = _stream->readSint16LE();
+
+	// The header holds the first two samples of each channel
+	int16 *samples = _sampleBuffer;
+
+	for (i = 0; i < _channels; i++)
+		*samples++ = _status.ch[i].sample2;
+
+	for (i = 0; i < _channels; i++)
+		*samples++ = _status.ch[i].sample1;
+
+	const uint32 size = _stream->read(_blockData, CLIP<int32>(_endpos - _stream->pos(), 0, _blockAlign - _channels * 7));
+
+	for (uint32 j = 0; j < size; j++) {
+		*samples++ = decodeMS(&_status.ch[0], (_blockData[j] >> 4) & 0x0f);
+		*samples++ = decodeMS(&_status.ch[_channels - 1], _blockData[j] & 0x0f);
 	}
 
-	return samples;
+	return samples - _sampleBuffer;
 }
 
 
 #pragma mark -
 
 
+DK3_ADPCMStream::DK3_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
+	: Ima_ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
+
+	// DK3 only works as a stereo stream
+	assert(channels == 2);
+	_topNibble = false;
+
+	_blockData = new byte[blockAlign];
+	_sampleBuffer = new int16[blockAlign * 4 + 4];
+}
+
+// Nibbles are never read across a block boundary; when the data of a block
+// runs out in the middle of a set of samples, the last nibble is reused.
 #define DK3_READ_NIBBLE() \
 do { \
 	if (_topNibble) { \
 		_nibble = _lastByte >> 4; \
 		_topNibble = false; \
-	} else { \
-		if (_stream->pos() >= _endpos) \
-			break; \
-		if ((_stream->pos() % _blockAlign) == 0) \
-			continue; \
-		_lastByte = _stream->readByte(); \
+	} else if (dataPos < size) { \
+		_lastByte = _blockData[dataPos++]; \
 		_nibble = _lastByte & 0xf; \
 		_topNibble = true; \
 	} \
 } while (0)
 
+int DK3_ADPCMStream::decodeBlock() {
+	if ((_stream->pos() % _blockAlign) == 0) {
+		_stream->readUint16LE(); // Unknown
+		uint16 rate = _stream->readUint16LE(); // Copy of rate
+		_stream->skip(6); // Unknown
+		// Get predictor for both sum/diff channels
+		_status.ima_ch[0].last = _stream->readSint16LE();
+		_status.ima_ch[1].last = _stream->readSint16LE();
+		// Get index for both sum/diff channels
+		_status.ima_ch[0].stepIndex = _stream->readByte();
+		_status.ima_ch[1].stepIndex = _stream->readByte();
+
+		if (_stream->eos())
+			return 0;
+
+		// Sanity check
+		assert(rate == getRate());
+	}
 
-int DK3_ADPCMStream::readBuffer(int16 *buffer, const int numSamples) {
-	int samples = 0;
+	// Read the rest of the block
+	const int32 pos = _stream->pos();
+	const int32 blockEnd = (pos / _blockAlign + 1) * _blockAlign;
+	const uint32 size = _stream->read(_blockData, CLIP<int32>(MIN(blockEnd, _endpos) - pos, 0, _blockAlign));
 
-	assert((numSamples % 4) == 0);
-
-	while (samples < numSamples && !_stream->eos() && _stream->pos() < _endpos) {
-		if ((_stream->pos() % _blockAlign) == 0) {
-			_stream->readUint16LE(); // Unknown
-			uint16 rate = _stream->readUint16LE(); // Copy of rate
-			_stream->skip(6); // Unknown
-			// Get predictor for both sum/diff channels
-			_status.ima_ch[0].last = _stream->readSint16LE();
-			_status.ima_ch[1].last = _stream->readSint16LE();
-			// Get index for both sum/diff channels
-			_status.ima_ch[0].stepIndex = _stream->readByte();
-			_status.ima_ch[1].stepIndex = _stream->readByte();
-
-			if (_stream->eos())
-				break;
-
-			// Sanity check
-			assert(rate == getRate());
-		}
+	uint32 dataPos = 0;
+	int16 *samples = _sampleBuffer;
 
+	while (dataPos < size) {
 		DK3_READ_NIBBLE();
 		decodeIMA(_nibble, 0);
 
 		DK3_READ_NIBBLE();
 		decodeIMA(_nibble, 1);
 
-		buffer[samples++] = _status.ima_ch[0].last + _status.ima_ch[1].last;
-		buffer[samples++] = _status.ima_ch[0].last - _status.ima_ch[1].last;
+		*samples++ = _status.ima_ch[0].last + _status.ima_ch[1].last;
+		*samples++ = _status.ima_ch[0].last - _status.ima_ch[1].last;
 
 		DK3_READ_NIBBLE();
 		decodeIMA(_nibble, 0);
 
-		buffer[samples++] = _status.ima_ch[0].last + _status.ima_ch[1].last;
-		buffer[samples++] = _status.ima_ch[0].last - _status.ima_ch[1].last;
+		*samples++ = _status.ima_ch[0].last + _status.ima_ch[1].last;
+		*samples++ = _status.ima_ch[0].last - _status.ima_ch[1].last;
 	}
 
-	return samples;
+	return samples - _sampleBuffer;
 }
 
+#undef DK3_READ_NIBBLE
+
 
 #pragma mark -
 
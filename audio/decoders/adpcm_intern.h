@@ -57,12 +57,41 @@ protected:
 		} ima_ch[2];
 	} _status;
 
+	/**
+	 * Buffers of the decoders which decode a whole block at a time: the raw
+	 * data of the current block, and the samples decoded from it which have
+	 * not been returned by readBuffer() yet. Allocated by the subclasses.
+	 */
+	byte *_blockData;
+	int16 *_sampleBuffer;
+	int _sampleBufferPos;
+	int _sampleBufferEnd;
+
 	virtual void reset();
 
+	/**
+	 * Decode the next block of the stream into _sampleBuffer.
+	 *
+	 * @return the number of decoded samples, 0 when nothing could be decoded
+	 */
+	virtual int decodeBlock() { return 0; }
+
+	/**
+	 * readBuffer() implementation for the decoders implementing decodeBlock().
+	 */
+	int readDecodedSamples(int16 *buffer, const int numSamples);
+
+	/**
+	 * Read size bytes of the current block into _blockData. Anything past
+	 * the end of the stream reads as zero.
+	 */
+	void readBlockData(uint32 size);
+
 public:
 	ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign);
+	virtual ~ADPCMStream();
 
-	virtual bool endOfData() const { return (_stream->eos() || _stream->pos() >= _endpos); }
+	virtual bool endOfData() const { return (_sampleBufferPos == _sampleBufferEnd) && (_stream->eos() || _stream->pos() >= _endpos); }
 	virtual bool isStereo() const { return _channels == 2; }
 	virtual int getRate() const { return _rate; }
 
@@ -80,19 +109,14 @@ public:
 
 class Oki_ADPCMStream : public ADPCMStream {
 public:
-	Oki_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
-		: ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) { _decodedSampleCount = 0; }
-
-	virtual bool endOfData() const { return (_stream->eos() || _stream->pos() >= _endpos) && (_decodedSampleCount == 0); }
+	Oki_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign);
 
-	virtual int readBuffer(int16 *buffer, const int numSamples);
+	virtual int readBuffer(int16 *buffer, const int numSamples) { return readDecodedSamples(buffer, numSamples); }
 
 protected:
 	int16 decodeOKI(byte);
 
-private:
-	uint8 _decodedSampleCount;
-	int16 _decodedSamples[2];
+	virtual int decodeBlock();
 };
 
 class Ima_ADPCMStream : public ADPCMStream {
@@ -111,72 +135,33 @@ public:
 
 class DVI_ADPCMStream : public Ima_ADPCMStream {
 public:
-	DVI_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
-		: Ima_ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) { _decodedSampleCount = 0; }
+	DVI_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign);
 
-	virtual bool endOfData() const { return (_stream->eos() || _stream->pos() >= _endpos) && (_decodedSampleCount == 0); }
+	virtual int readBuffer(int16 *buffer, const int numSamples) { return readDecodedSamples(buffer, numSamples); }
 
-	virtual int readBuffer(int16 *buffer, const int numSamples);
-
-private:
-	uint8 _decodedSampleCount;
-	int16 _decodedSamples[2];
+protected:
+	virtual int decodeBlock();
 };
 
 class Apple_ADPCMStream : public Ima_ADPCMStream {
-protected:
-	// Apple QuickTime IMA ADPCM
-	int32 _streamPos[2];
-	int16 _buffer[2][2];
-	uint8 _chunkPos[2];
-
-	void reset() {
-		Ima_ADPCMStream::reset();
-		_chunkPos[0] = 0;
-		_chunkPos[1] = 0;
-		_streamPos[0] = 0;
-		_streamPos[1] = _blockAlign;
-	}
-
 public:
-	Apple_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
-		: Ima_ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
-		_chunkPos[0] = 0;
-		_chunkPos[1] = 0;
-		_streamPos[0] = 0;
-		_streamPos[1] = _blockAlign;
-	}
+	Apple_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign);
 
-	virtual int readBuffer(int16 *buffer, const int numSamples);
+	virtual int readBuffer(int16 *buffer, const int numSamples) { return readDecodedSamples(buffer, numSamples); }
 
+protected:
+	// Apple QuickTime IMA ADPCM
+	virtual int decodeBlock();
 };
 
 class MSIma_ADPCMStream : public Ima_ADPCMStream {
 public:
-	MSIma_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
-		: Ima_ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
-
-		if (blockAlign == 0)
-			error("MSIma_ADPCMStream(): blockAlign isn't specified");
+	MSIma_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign);
 
-		if (blockAlign % (_channels * 4))
-			error("MSIma_ADPCMStream(): invalid blockAlign");
-
-		_samplesLeft[0] = 0;
-		_samplesLeft[1] = 0;
-	}
-
-	virtual int readBuffer(int16 *buffer, const int numSamples);
-
-	void reset() {
-		Ima_ADPCMStream::reset();
-		_samplesLeft[0] = 0;
-		_samplesLeft[1] = 0;
-	}
+	virtual int readBuffer(int16 *buffer, const int numSamples) { return readDecodedSamples(buffer, numSamples); }
 
-private:
-	int16 _buffer[2][8];
-	int _samplesLeft[2];
+protected:
+	virtual int decodeBlock();
 };
 
 class MS_ADPCMStream : public ADPCMStream {
@@ -201,24 +186,14 @@ protected:
 	}
 
 public:
-	MS_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
-		: ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
-		if (blockAlign == 0)
-			error("MS_ADPCMStream(): blockAlign isn't specified for MS ADPCM");
-		memset(&_status, 0, sizeof(_status));
-		_decodedSampleCount = 0;
-	}
+	MS_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign);
 
-	virtual bool endOfData() const { return (_stream->eos() || _stream->pos() >= _endpos) && (_decodedSampleCount == 0); }
-
-	virtual int readBuffer(int16 *buffer, const int numSamples);
+	virtual int readBuffer(int16 *buffer, const int numSamples) { return readDecodedSamples(buffer, numSamples); }
 
 protected:
 	int16 decodeMS(ADPCMChannelStatus *c, byte);
 
-private:
-	uint8 _decodedSampleCount;
-	int16 _decodedSamples[4];
+	virtual int decodeBlock();
 };
 
 // Duck DK3 IMA ADPCM Decoder
@@ -232,17 +207,16 @@ protected:
 		_topNibble = false;
 	}
 
+	virtual int decodeBlock();
+
 public:
-	DK3_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign)
-		: Ima_ADPCMStream(stream, disposeAfterUse, size, rate, channels, blockAlign) {
+	DK3_ADPCMStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint32 size, int rate, int channels, uint32 blockAlign);
 
-		// DK3 only works as a stereo stream
-		assert(channels == 2);
-		_topNibble = false;
+	virtual int readBuffer(int16 *buffer, const int numSamples) {
+		assert((numSamples % 4) == 0);
+		return readDecodedSamples(buffer, numSamples);
 	}
 
-	virtual int readBuffer(int16 *buffer, const int numSamples);
-
 private:
 	byte _nibble, _lastByte;
 	bool _topNibble;
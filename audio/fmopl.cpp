@@ -21,10 +21,12 @@
 
 #include "audio/fmopl.h"
 
+#include "audio/softsynth/opl/capture.h"
 #include "audio/softsynth/opl/dosbox.h"
 #include "audio/softsynth/opl/mame.h"
 
 #include "common/config-manager.h"
+#include "common/file.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
 
@@ -131,25 +133,42 @@ OPL *Config::create(DriverId driver, OplType type) {
 		}
 	}
 
+	OPL *opl = 0;
+
 	switch (driver) {
 	case kMame:
 		if (type == kOpl2)
-			return new MAME::OPL();
+			opl = new MAME::OPL();
 		else
 			warning("MAME OPL emulator only supports OPL2 emulation");
-		return 0;
+		break;
 
 #ifndef DISABLE_DOSBOX_OPL
 	case kDOSBox:
-		return new DOSBox::OPL(type);
+		opl = new DOSBox::OPL(type);
+		break;
 #endif
 
 	default:
 		warning("Unsupported OPL emulator %d", driver);
 		// TODO: Maybe we should add some dummy emulator too, which just outputs
 		// silence as sound?
-		return 0;
+		break;
 	}
+
+	// Record everything sent to the chip, if requested. The logs can be
+	// replayed by devtools/opl_benchmark.
+	if (opl && ConfMan.hasKey("opl_capture") && !ConfMan.get("opl_capture").empty()) {
+		Common::DumpFile *log = new Common::DumpFile();
+		if (log->open(ConfMan.get("opl_capture")))
+			opl = new Capture::OPL(opl, type, log);
+		else {
+			warning("Could not open OPL capture file '%s'", ConfMan.get("opl_capture").c_str());
+			delete log;
+		}
+	}
+
+	return opl;
 }
 
 bool OPL::_hasInstance = false;
@@ -94,6 +94,14 @@ private:
 class OPL {
 private:
 	static bool _hasInstance;
+
+protected:
+	/**
+	 * Constructor for wrappers, which forward everything to the given
+	 * OPL instance and hence do not count as an instance on their own.
+	 */
+	explicit OPL(OPL * /* wrapped */) {}
+
 public:
 	OPL();
 	virtual ~OPL() { _hasInstance = false; }
@@ -22,15 +22,21 @@
 
 #include "gui/EventRecorder.h"
 
+#include "common/config-manager.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
+#include "common/workerpool.h"
 
 #include "audio/mixer_intern.h"
 #include "audio/rate.h"
 #include "audio/audiostream.h"
 #include "audio/timestamp.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 
 namespace Audio {
 
@@ -44,7 +50,7 @@ namespace Audio {
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, RateConverterQuality quality);
 	~Channel();
 
 	/**
@@ -61,7 +67,7 @@ public:
 	/**
 	 * Queries whether the channel is still playing or not.
 	 */
-	bool isFinished() const { return _stream->endOfStream(); }
+	bool isFinished() const { return _stream->endOfStream() && _drained; }
 
 	/**
 	 * Queries whether the channel is a permanent channel.
@@ -80,8 +86,9 @@ public:
 	 *
 	 * @param paused true, when the channel should be paused.
 	 *               false when it should be unpaused.
+	 * @param time   the time of the request, in milliseconds.
 	 */
-	void pause(bool paused);
+	void pause(bool paused, uint32 time);
 
 	/**
 	 * Queries whether the channel is currently paused.
@@ -123,9 +130,10 @@ public:
 	void notifyGlobalVolChange() { updateChannelVolumes(); }
 
 	/**
-	 * Queries how long the channel has been playing.
+	 * Stores the channel's current state, from which the mixer
+	 * answers queries without touching the channel itself.
 	 */
-	Timestamp getElapsedTime();
+	void getState(ChannelState &state) const;
 
 	/**
 	 * Queries the channel's sound type.
@@ -166,6 +174,7 @@ private:
 	uint32 _pauseTime;
 
 	RateConverter *_converter;
+	bool _drained;
 	Common::DisposablePtr<AudioStream> _stream;
 };
 
@@ -173,25 +182,95 @@ private:
 #pragma mark --- Mixer ---
 #pragma mark -
 
+enum {
+	/**
+	 * How often a channel snapshot is read again while the audio thread is
+	 * updating it, before waiting for the update to finish instead.
+	 */
+	kMaxSnapshotRetries = 64
+};
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+#define MIXER_ATOMIC_BARRIER
+#elif defined(_MSC_VER)
+#define MIXER_ATOMIC_BARRIER
+#else
+/**
+ * Without a known barrier instruction, locking a mutex has to do. Created
+ * together with the mixer, before any other thread uses it.
+ */
+static OSystem::MutexRef s_barrierMutex = 0;
+#endif
+
+/**
+ * Full memory barrier, ordering the accesses to the command queue and the
+ * channel snapshots which are shared between the engine and audio threads.
+ */
+static inline void memoryBarrier() {
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+	__sync_synchronize();
+#elif defined(_MSC_VER)
+	// Interlocked operations are full barriers on all targets of MSVC,
+	// unlike _ReadWriteBarrier(), which only affects the compiler.
+	long dummy;
+	_InterlockedExchange(&dummy, 0);
+#else
+	g_system->lockMutex(s_barrierMutex);
+	g_system->unlockMutex(s_barrierMutex);
+#endif
+}
+
 // TODO: parameter "system" is unused
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _queueMutex(), _queueHead(0), _queueTail(0), _queueOverflowed(false), _sampleRate(sampleRate), _mixerReady(false),
+	  _handleSeed(0), _soundTypeSettings(), _resamplerQuality(kRateConverterLinear), _workerPool(0),
+	  _partialBuffers(0), _partialBufferLen(0), _jobLen(0) {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+#ifndef MIXER_ATOMIC_BARRIER
+	if (!s_barrierMutex)
+		s_barrierMutex = g_system->createMutex();
+#endif
+
+	initRateConverters();
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		_channels[i] = 0;
+		_snapshots[i].seq = 0;
+		_snapshots[i].state.active = false;
+		_channelSettings[i].handle = 0;
+		_channelSettings[i].volume = 0;
+		_channelSettings[i].balance = 0;
+	}
+
+	const Common::String quality = ConfMan.get("resampler_quality");
+	if (quality == "medium")
+		_resamplerQuality = kRateConverterSincMedium;
+	else if (quality == "high")
+		_resamplerQuality = kRateConverterSincHigh;
+	else if (!quality.empty() && quality != "linear")
+		warning("Unknown resampler quality '%s', using linear interpolation", quality.c_str());
 }
 
 MixerImpl::~MixerImpl() {
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
+
+	delete[] _partialBuffers;
+
+	deinitRateConverters();
 }
 
 void MixerImpl::setReady(bool ready) {
 	_mixerReady = ready;
 }
 
+void MixerImpl::setWorkerPool(Common::WorkerPool *pool) {
+	Common::StackLock lock(_mutex);
+	_workerPool = pool;
+}
+
 uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
@@ -217,10 +296,168 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 
 	chan->setHandle(chanHandle);
 	_handleSeed++;
+
+	{
+		Common::StackLock queueLock(_queueMutex);
+		_channelSettings[index].handle = chanHandle._val;
+		_channelSettings[index].volume = chan->getVolume();
+		_channelSettings[index].balance = chan->getBalance();
+	}
+	publishChannel(index);
+
 	if (handle)
 		*handle = chanHandle;
 }
 
+void MixerImpl::deleteChannel(int index) {
+	delete _channels[index];
+	_channels[index] = 0;
+	publishChannel(index);
+}
+
+void MixerImpl::queueCommand(const Command &cmd) {
+	Common::StackLock lock(_queueMutex);
+
+	if (_queueOverflowed || _queueHead - _queueTail == COMMAND_QUEUE_SIZE) {
+		// The audio thread is not keeping up (or not running at all). Rather
+		// than waiting for it, keep the command until it catches up.
+		_queueOverflow.push_back(cmd);
+		memoryBarrier();
+		_queueOverflowed = true;
+		return;
+	}
+
+	_queue[_queueHead % COMMAND_QUEUE_SIZE] = cmd;
+	memoryBarrier();
+	_queueHead = _queueHead + 1;
+}
+
+void MixerImpl::processQueuedCommands() {
+	const uint32 head = _queueHead;
+	memoryBarrier();
+
+	while (_queueTail != head) {
+		const Command cmd = _queue[_queueTail % COMMAND_QUEUE_SIZE];
+		memoryBarrier();
+		_queueTail = _queueTail + 1;
+
+		applyCommand(cmd);
+	}
+}
+
+void MixerImpl::processCommands() {
+	// Only ever called with _mutex held, so there is a single consumer.
+	processQueuedCommands();
+
+	memoryBarrier();
+	if (_queueOverflowed) {
+		// No more commands are added to the queue while there are
+		// overflowed ones, so once the queue is empty, these come next.
+		Common::StackLock lock(_queueMutex);
+		processQueuedCommands();
+
+		while (!_queueOverflow.empty()) {
+			applyCommand(_queueOverflow.front());
+			_queueOverflow.pop_front();
+		}
+
+		memoryBarrier();
+		_queueOverflowed = false;
+	}
+}
+
+void MixerImpl::applyCommand(const Command &cmd) {
+	const int index = cmd.handle % NUM_CHANNELS;
+	const bool validHandle = _channels[index] && _channels[index]->getHandle()._val == cmd.handle;
+
+	switch (cmd.type) {
+	case Command::kSetVolume:
+		if (validHandle)
+			_channels[index]->setVolume(cmd.value);
+		break;
+
+	case Command::kSetBalance:
+		if (validHandle)
+			_channels[index]->setBalance(cmd.value);
+		break;
+
+	case Command::kPauseHandle:
+		if (validHandle) {
+			_channels[index]->pause(cmd.value != 0, cmd.time);
+			publishChannel(index);
+		}
+		break;
+
+	case Command::kPauseID:
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_channels[i] != 0 && _channels[i]->getId() == cmd.id) {
+				_channels[i]->pause(cmd.value != 0, cmd.time);
+				publishChannel(i);
+				break;
+			}
+		}
+		break;
+
+	case Command::kPauseAll:
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_channels[i] != 0) {
+				_channels[i]->pause(cmd.value != 0, cmd.time);
+				publishChannel(i);
+			}
+		}
+		break;
+
+	case Command::kSoundTypeChanged:
+		for (int i = 0; i != NUM_CHANNELS; ++i) {
+			if (_channels[i] && _channels[i]->getType() == cmd.value)
+				_channels[i]->notifyGlobalVolChange();
+		}
+		break;
+	}
+}
+
+void MixerImpl::publishChannel(int index) {
+	// Only ever called with _mutex held, so there is a single writer.
+	ChannelSnapshot &snapshot = _snapshots[index];
+
+	snapshot.seq = snapshot.seq + 1;
+	memoryBarrier();
+
+	if (_channels[index])
+		_channels[index]->getState(snapshot.state);
+	else
+		snapshot.state.active = false;
+
+	memoryBarrier();
+	snapshot.seq = snapshot.seq + 1;
+}
+
+void MixerImpl::readChannel(int index, ChannelState &state) const {
+	const ChannelSnapshot &snapshot = _snapshots[index];
+	uint32 seq;
+
+	for (int tries = 0; tries < kMaxSnapshotRetries; tries++) {
+		seq = snapshot.seq;
+		memoryBarrier();
+		state = snapshot.state;
+		memoryBarrier();
+
+		if (!(seq & 1) && seq == snapshot.seq)
+			return;
+	}
+
+	// The audio thread keeps getting in the way, or was preempted in the
+	// middle of an update. Snapshots only change with _mutex held, so
+	// waiting for it gives a consistent one.
+	Common::StackLock lock(_mutex);
+	state = snapshot.state;
+}
+
+bool MixerImpl::readChannel(SoundHandle handle, ChannelState &state) const {
+	readChannel(handle._val % NUM_CHANNELS, state);
+	return state.active && state.handle == handle._val;
+}
+
 void MixerImpl::playStream(
 			SoundType type,
 			SoundHandle *handle,
@@ -239,6 +476,10 @@ void MixerImpl::playStream(
 
 	assert(_mixerReady);
 
+	// Apply the pending commands before the new channel exists, so that e.g.
+	// a pauseAll() issued before this call does not affect it
+	processCommands();
+
 	// Prevent duplicate sounds
 	if (id != -1) {
 		for (int i = 0; i != NUM_CHANNELS; i++)
@@ -260,7 +501,7 @@ void MixerImpl::playStream(
 #endif
 
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent, _resamplerQuality);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
 	insertChannel(handle, chan);
@@ -279,18 +520,24 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	// Since the mixer callback has been called, the mixer must be ready...
 	_mixerReady = true;
 
+	// Apply the volume, balance and pause changes made since the last pass
+	processCommands();
+
 	//  zero the buf
 	memset(buf, 0, 2 * len * sizeof(int16));
 
+	if (_workerPool)
+		return mixChannelsParallel(buf, len);
+
 	// mix all channels
 	int res = 0, tmp;
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i]) {
 			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = 0;
+				deleteChannel(i);
 			} else if (!_channels[i]->isPaused()) {
 				tmp = _channels[i]->mix(buf, len);
+				publishChannel(i);
 
 				if (tmp > res)
 					res = tmp;
@@ -300,46 +547,96 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	return res;
 }
 
+void MixerImpl::mixChannelJob(void *param, uint job) {
+	MixerImpl *mixer = (MixerImpl *)param;
+	int16 *partial = mixer->_partialBuffers + job * 2 * mixer->_jobLen;
+
+	memset(partial, 0, 2 * mixer->_jobLen * sizeof(int16));
+	mixer->_jobResults[job] = mixer->_jobChannels[job]->mix(partial, mixer->_jobLen);
+}
+
+int MixerImpl::mixChannelsParallel(int16 *buf, uint len) {
+	uint numJobs = 0;
+	for (int i = 0; i != NUM_CHANNELS; i++)
+		if (_channels[i]) {
+			if (_channels[i]->isFinished())
+				deleteChannel(i);
+			else if (!_channels[i]->isPaused())
+				_jobChannels[numJobs++] = _channels[i];
+		}
+
+	if (!numJobs)
+		return 0;
+
+	if (len > _partialBufferLen) {
+		delete[] _partialBuffers;
+		_partialBuffers = new int16[NUM_CHANNELS * 2 * len];
+		_partialBufferLen = len;
+	}
+	_jobLen = len;
+
+	_workerPool->runJobs(mixChannelJob, this, numJobs);
+
+	// Every partial buffer holds exactly what the serial code path would have
+	// added for its channel, so adding them up in channel order (with the same
+	// clipping) gives a bit-identical result.
+	int res = 0;
+	for (uint job = 0; job < numJobs; job++) {
+		const int16 *partial = _partialBuffers + job * 2 * len;
+		for (uint i = 0; i < 2 * len; i++)
+			clampedAdd(buf[i], partial[i]);
+
+		publishChannel(_jobChannels[job]->getHandle()._val % NUM_CHANNELS);
+
+		if (_jobResults[job] > res)
+			res = _jobResults[job];
+	}
+
+	return res;
+}
+
 void MixerImpl::stopAll() {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+		if (_channels[i] != 0 && !_channels[i]->isPermanent())
+			deleteChannel(i);
 	}
 }
 
 void MixerImpl::stopID(int id) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+		if (_channels[i] != 0 && _channels[i]->getId() == id)
+			deleteChannel(i);
 	}
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
+	// Simply ignore stop requests for handles of sounds that already terminated
+	ChannelState state;
+	if (!readChannel(handle, state))
+		return;
+
 	Common::StackLock lock(_mutex);
 
-	// Simply ignore stop requests for handles of sounds that already terminated
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
 
-	delete _channels[index];
-	_channels[index] = 0;
+	deleteChannel(index);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= type && type < ARRAYSIZE(_soundTypeSettings));
 	_soundTypeSettings[type].mute = mute;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	Command cmd;
+	cmd.type = Command::kSoundTypeChanged;
+	cmd.handle = 0;
+	cmd.id = 0;
+	cmd.value = type;
+	cmd.time = 0;
+	queueCommand(cmd);
 }
 
 bool MixerImpl::isSoundTypeMuted(SoundType type) const {
@@ -348,39 +645,66 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
+	ChannelState state;
+	if (!readChannel(handle, state))
+		return;
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	// The slot may have been reused since it was checked, so only update the
+	// cached value if it still belongs to this handle. The command is queued
+	// under the same lock, so it cannot overtake a later one.
+	Common::StackLock lock(_queueMutex);
+	ChannelSettings &settings = _channelSettings[handle._val % NUM_CHANNELS];
+	if (settings.handle != handle._val)
 		return;
+	settings.volume = volume;
 
-	_channels[index]->setVolume(volume);
+	Command cmd;
+	cmd.type = Command::kSetVolume;
+	cmd.handle = handle._val;
+	cmd.id = 0;
+	cmd.value = volume;
+	cmd.time = 0;
+	queueCommand(cmd);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelState state;
+	if (!readChannel(handle, state))
 		return 0;
 
-	return _channels[index]->getVolume();
+	Common::StackLock lock(_queueMutex);
+	const ChannelSettings &settings = _channelSettings[handle._val % NUM_CHANNELS];
+	return settings.handle == handle._val ? settings.volume : 0;
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
+	ChannelState state;
+	if (!readChannel(handle, state))
+		return;
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_queueMutex);
+	ChannelSettings &settings = _channelSettings[handle._val % NUM_CHANNELS];
+	if (settings.handle != handle._val)
 		return;
+	settings.balance = balance;
 
-	_channels[index]->setBalance(balance);
+	Command cmd;
+	cmd.type = Command::kSetBalance;
+	cmd.handle = handle._val;
+	cmd.id = 0;
+	cmd.value = balance;
+	cmd.time = 0;
+	queueCommand(cmd);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelState state;
+	if (!readChannel(handle, state))
 		return 0;
 
-	return _channels[index]->getBalance();
+	Common::StackLock lock(_queueMutex);
+	const ChannelSettings &settings = _channelSettings[handle._val % NUM_CHANNELS];
+	return settings.handle == handle._val ? settings.balance : 0;
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -388,82 +712,107 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 }
 
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Audio::Timestamp ts(0, _sampleRate);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return Timestamp(0, _sampleRate);
+	ChannelState state;
+	if (!readChannel(handle, state))
+		return ts;
+
+	if (state.mixerTimeStamp == 0)
+		return ts;
+
+	uint32 delta = 0;
+	if (state.paused)
+		delta = state.pauseStartTime - state.mixerTimeStamp;
+	else
+		delta = g_system->getMillis(true) - state.mixerTimeStamp - state.pauseTime;
+
+	// Convert the number of samples into a time duration.
+
+	ts = ts.addFrames(state.samplesConsumed);
+	ts = ts.addMsecs(delta);
+
+	// In theory it would seem like a good idea to limit the approximation
+	// so that it never exceeds the theoretical upper bound set by
+	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
+	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
+	// isn't invoked at the regular intervals that I first imagined.
 
-	return _channels[index]->getElapsedTime();
+	return ts;
 }
 
 void MixerImpl::pauseAll(bool paused) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0) {
-			_channels[i]->pause(paused);
-		}
-	}
+	Command cmd;
+	cmd.type = Command::kPauseAll;
+	cmd.handle = 0;
+	cmd.id = 0;
+	cmd.value = paused;
+	cmd.time = g_system->getMillis(true);
+	queueCommand(cmd);
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			_channels[i]->pause(paused);
-			return;
-		}
-	}
+	Command cmd;
+	cmd.type = Command::kPauseID;
+	cmd.handle = 0;
+	cmd.id = id;
+	cmd.value = paused;
+	cmd.time = g_system->getMillis(true);
+	queueCommand(cmd);
 }
 
 void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
-	Common::StackLock lock(_mutex);
-
 	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelState state;
+	if (!readChannel(handle, state))
 		return;
 
-	_channels[index]->pause(paused);
+	Command cmd;
+	cmd.type = Command::kPauseHandle;
+	cmd.handle = handle._val;
+	cmd.id = 0;
+	cmd.value = paused;
+	cmd.time = g_system->getMillis(true);
+	queueCommand(cmd);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+	ChannelState state;
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		readChannel(i, state);
+		if (state.active && state.id == id)
 			return true;
+	}
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
+	ChannelState state;
+	if (readChannel(handle, state))
+		return state.id;
 	return 0;
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	ChannelState state;
+	return readChannel(handle, state);
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+	ChannelState state;
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		readChannel(i, state);
+		if (state.active && state.type == type)
 			return true;
+	}
 	return false;
 }
 
@@ -479,13 +828,15 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// TODO: Maybe we should do logarithmic (not linear) volume
 	// scaling? See also Player_V2::setMasterVolume
 
-	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].volume = volume;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	Command cmd;
+	cmd.type = Command::kSoundTypeChanged;
+	cmd.handle = 0;
+	cmd.id = 0;
+	cmd.value = type;
+	cmd.time = 0;
+	queueCommand(cmd);
 }
 
 int MixerImpl::getVolumeForSoundType(SoundType type) const {
@@ -500,16 +851,17 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
+                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent,
+                 RateConverterQuality quality)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-      _pauseStartTime(0), _pauseTime(0), _converter(0), _volL(0), _volR(0),
+      _pauseStartTime(0), _pauseTime(0), _converter(0), _drained(false), _volL(0), _volR(0),
       _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo, quality);
 }
 
 Channel::~Channel() {
@@ -561,60 +913,43 @@ void Channel::updateChannelVolumes() {
 	}
 }
 
-void Channel::pause(bool paused) {
+void Channel::pause(bool paused, uint32 time) {
 	//assert((paused && _pauseLevel >= 0) || (!paused && _pauseLevel));
 
 	if (paused) {
 		_pauseLevel++;
 
 		if (_pauseLevel == 1)
-			_pauseStartTime = g_system->getMillis(true);
+			_pauseStartTime = time;
 	} else if (_pauseLevel > 0) {
 		_pauseLevel--;
 
 		if (!_pauseLevel) {
-			_pauseTime = (g_system->getMillis(true) - _pauseStartTime);
+			_pauseTime = (time - _pauseStartTime);
 			_pauseStartTime = 0;
 		}
 	}
 }
 
-Timestamp Channel::getElapsedTime() {
-	const uint32 rate = _mixer->getOutputRate();
-	uint32 delta = 0;
-
-	Audio::Timestamp ts(0, rate);
-
-	if (_mixerTimeStamp == 0)
-		return ts;
-
-	if (isPaused())
-		delta = _pauseStartTime - _mixerTimeStamp;
-	else
-		delta = g_system->getMillis(true) - _mixerTimeStamp - _pauseTime;
-
-	// Convert the number of samples into a time duration.
-
-	ts = ts.addFrames(_samplesConsumed);
-	ts = ts.addMsecs(delta);
-
-	// In theory it would seem like a good idea to limit the approximation
-	// so that it never exceeds the theoretical upper bound set by
-	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
-	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
-	// isn't invoked at the regular intervals that I first imagined.
-
-	return ts;
+void Channel::getState(ChannelState &state) const {
+	state.active = true;
+	state.handle = _handle._val;
+	state.id = _id;
+	state.type = _type;
+	state.paused = isPaused();
+	state.samplesConsumed = _samplesConsumed;
+	state.mixerTimeStamp = _mixerTimeStamp;
+	state.pauseStartTime = _pauseStartTime;
+	state.pauseTime = _pauseTime;
 }
 
 int Channel::mix(int16 *data, uint len) {
 	assert(_stream);
 
+	assert(_converter);
+
 	int res = 0;
-	if (_stream->endOfData()) {
-		// TODO: call drain method
-	} else {
-		assert(_converter);
+	if (!_stream->endOfData()) {
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis(true);
 		_pauseTime = 0;
@@ -622,6 +957,14 @@ int Channel::mix(int16 *data, uint len) {
 		_samplesDecoded += res;
 	}
 
+	// Once the stream has ended, mix what the converter still holds back
+	if (_stream->endOfStream() && !_drained) {
+		const int drained = _converter->drain(data + res * 2, len - res, _volL, _volR);
+		if (drained < (int)len - res)
+			_drained = true;
+		res += drained;
+	}
+
 	return res;
 }
 
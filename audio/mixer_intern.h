@@ -24,11 +24,34 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/list.h"
 #include "common/mutex.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
+
+namespace Common {
+class WorkerPool;
+}
 
 namespace Audio {
 
+/**
+ * The state of a mixer channel as seen by the query methods of MixerImpl.
+ * The audio thread publishes a copy of it whenever the channel changes, so
+ * that queries do not have to wait for a mix pass to finish.
+ */
+struct ChannelState {
+	bool active;
+	uint32 handle;
+	int id;
+	Mixer::SoundType type;
+	bool paused;
+	uint32 samplesConsumed;
+	uint32 mixerTimeStamp;
+	uint32 pauseStartTime;
+	uint32 pauseTime;
+};
+
 /**
  * The (default) implementation of the ScummVM audio mixing subsystem.
  *
@@ -51,11 +74,77 @@ namespace Audio {
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 16
+		NUM_CHANNELS = 16,
+		COMMAND_QUEUE_SIZE = 256
+	};
+
+	/**
+	 * A deferred channel update. Calls which only change the parameters of
+	 * a channel are queued and applied by the audio thread at the start of
+	 * the next mix pass, instead of waiting for the current one to finish.
+	 * Calls which change the set of channels apply the queued commands
+	 * first, so that every command only affects the channels which existed
+	 * when it was issued.
+	 */
+	struct Command {
+		enum Type {
+			kSetVolume,
+			kSetBalance,
+			kPauseHandle,
+			kPauseID,
+			kPauseAll,
+			kSoundTypeChanged
+		};
+
+		Type type;
+		uint32 handle;
+		int id;
+		int value;
+		uint32 time;
 	};
 
+	/**
+	 * A ChannelState guarded by a sequence counter, which is odd while the
+	 * audio thread is updating the state.
+	 */
+	struct ChannelSnapshot {
+		volatile uint32 seq;
+		ChannelState state;
+	};
+
+	/** Protects the channel array; held for the whole of each mix pass. */
 	Common::Mutex _mutex;
 
+	/** Serializes the producers of the command queue. */
+	Common::Mutex _queueMutex;
+	Command _queue[COMMAND_QUEUE_SIZE];
+	volatile uint32 _queueHead;
+	volatile uint32 _queueTail;
+
+	/**
+	 * Commands issued while the queue is full, e.g. because the audio thread
+	 * is not running. Guarded by _queueMutex; as long as there are any, new
+	 * commands are added here as well, to keep them in order.
+	 */
+	Common::List<Command> _queueOverflow;
+	volatile bool _queueOverflowed;
+
+	ChannelSnapshot _snapshots[NUM_CHANNELS];
+
+	/**
+	 * The volume and balance last requested for each channel, which the
+	 * channels themselves only get once the commands are applied. Guarded by
+	 * _queueMutex; the handle tells whether the values still belong to the
+	 * sound in the slot.
+	 */
+	struct ChannelSettings {
+		uint32 handle;
+		byte volume;
+		int8 balance;
+	};
+
+	ChannelSettings _channelSettings[NUM_CHANNELS];
+
 	const uint _sampleRate;
 	bool _mixerReady;
 	uint32 _handleSeed;
@@ -70,6 +159,21 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	RateConverterQuality _resamplerQuality;
+
+	Common::WorkerPool *_workerPool;
+
+	// State of the parallel mix pass: every channel is mixed into its own
+	// partial buffer, and these are summed in channel order afterwards.
+	int16 *_partialBuffers;
+	uint _partialBufferLen;
+	uint _jobLen;
+	Channel *_jobChannels[NUM_CHANNELS];
+	int _jobResults[NUM_CHANNELS];
+
+	static void mixChannelJob(void *param, uint job);
+	int mixChannelsParallel(int16 *buf, uint len);
+
 
 public:
 
@@ -120,6 +224,16 @@ public:
 
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
+	void deleteChannel(int index);
+
+	void queueCommand(const Command &cmd);
+	void processQueuedCommands();
+	void processCommands();
+	void applyCommand(const Command &cmd);
+
+	void publishChannel(int index);
+	void readChannel(int index, ChannelState &state) const;
+	bool readChannel(SoundHandle handle, ChannelState &state) const;
 
 public:
 	/**
@@ -139,6 +253,16 @@ public:
 	 * their audio system has been completed.
 	 */
 	void setReady(bool ready);
+
+	/**
+	 * Set the worker pool used to mix channels in parallel, or 0 to mix them
+	 * serially. The pool is not owned by the mixer, and must stay alive until
+	 * it has been replaced or the mixer has been destroyed.
+	 *
+	 * The output is identical to the one of the serial code path, but note
+	 * that streams are then read from different threads at the same time.
+	 */
+	void setWorkerPool(Common::WorkerPool *pool);
 };
 
 
@@ -1,6 +1,7 @@
 MODULE := audio
 
 MODULE_OBJS := \
+	audiocache.o \
 	audiostream.o \
 	fmopl.o \
 	mididrv.o \
@@ -38,6 +39,8 @@ MODULE_OBJS := \
 	mods/tfmx.o \
 	softsynth/adlib.o \
 	softsynth/cms.o \
+	softsynth/emumidi.o \
+	softsynth/opl/capture.o \
 	softsynth/opl/dbopl.o \
 	softsynth/opl/dosbox.o \
 	softsynth/opl/mame.o \
@@ -32,9 +32,14 @@
 #include "audio/rate.h"
 #include "audio/mixer.h"
 #include "common/frac.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Audio {
 
 
@@ -46,6 +51,99 @@ namespace Audio {
  */
 #define INTERMEDIATE_BUFFER_SIZE 512
 
+#ifdef USE_SSE2
+// See setRateConverterSIMD()
+static bool s_useSSE2 = true;
+#endif
+
+bool setRateConverterSIMD(bool enable) {
+#ifdef USE_SSE2
+	s_useSSE2 = enable;
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+#if defined(USE_SSE2) && !defined(OUTPUT_UNSIGNED_AUDIO)
+/**
+ * Scale eight 16 bit samples by the given per lane volumes and mix them into
+ * obuf with saturation. This yields the same results as the scalar code in
+ * mixBuffer, as long as the volumes do not exceed kMaxMixerVolume (256).
+ */
+static inline void mixSamplesSSE2(st_sample_t *obuf, __m128i in, __m128i vol) {
+	const __m128i lo = _mm_mullo_epi16(in, vol);
+	const __m128i hi = _mm_mulhi_epi16(in, vol);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+
+	// Divide by kMaxMixerVolume (256), rounding towards zero
+	p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_srli_epi32(_mm_srai_epi32(p0, 31), 24)), 8);
+	p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_srli_epi32(_mm_srai_epi32(p1, 31), 24)), 8);
+
+	const __m128i out = _mm_loadu_si128((const __m128i *)obuf);
+	_mm_storeu_si128((__m128i *)obuf, _mm_adds_epi16(out, _mm_packs_epi32(p0, p1)));
+}
+#endif
+
+/**
+ * Scale the given samples by the channel volumes and mix them into the
+ * stereo output buffer, clamping the result.
+ *
+ * @param obuf      output buffer, receives 2 * numFrames samples
+ * @param ibuf      input samples, interleaved if stereo
+ * @param numFrames number of sample frames to mix
+ */
+template<bool stereo, bool reverseStereo>
+static void mixBuffer(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r) {
+#if defined(USE_SSE2) && !defined(OUTPUT_UNSIGNED_AUDIO)
+	// The volumes need to fit into 16 bit lanes for the SSE2 code
+	if (!s_useSSE2) {
+		// Use the plain code below
+	} else if (stereo && vol_l <= Audio::Mixer::kMaxMixerVolume && vol_r <= Audio::Mixer::kMaxMixerVolume) {
+		// With reversed stereo the input pairs are swapped, so the right
+		// volume ends up in the even lanes.
+		const __m128i vol = reverseStereo ?
+		                    _mm_set_epi16(vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r) :
+		                    _mm_set_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l);
+
+		for (; numFrames >= 4; numFrames -= 4) {
+			__m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+			if (reverseStereo)
+				in = _mm_shufflehi_epi16(_mm_shufflelo_epi16(in, 0xB1), 0xB1);
+			mixSamplesSSE2(obuf, in, vol);
+			ibuf += 8;
+			obuf += 8;
+		}
+	} else if (vol_l <= Audio::Mixer::kMaxMixerVolume && vol_r <= Audio::Mixer::kMaxMixerVolume) {
+		const __m128i vol = _mm_set_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l);
+
+		for (; numFrames >= 8; numFrames -= 8) {
+			const __m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+			mixSamplesSSE2(obuf, _mm_unpacklo_epi16(in, in), vol);
+			mixSamplesSSE2(obuf + 8, _mm_unpackhi_epi16(in, in), vol);
+			ibuf += 8;
+			obuf += 16;
+		}
+	}
+#endif
+
+	for (; numFrames > 0; --numFrames) {
+		st_sample_t out0, out1;
+		out0 = *ibuf++;
+		out1 = (stereo ? *ibuf++ : out0);
+
+		// output left channel
+		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+}
+
 
 /**
  * Audio rate converter based on simple resampling. Used when no
@@ -60,6 +158,9 @@ protected:
 	const st_sample_t *inPtr;
 	int inLen;
 
+	/** resampled samples, waiting to be mixed into the output buffer */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
 	/** position of how far output is ahead of input */
 	/** Holds what would have been opos-ipos */
 	long opos;
@@ -70,8 +171,8 @@ protected:
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
-		return ST_SUCCESS;
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return 0;
 	}
 };
 
@@ -108,38 +209,47 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
-	while (obuf < oend) {
-
-		// read enough input samples so that opos >= 0
-		do {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			opos--;
-			if (opos >= 0) {
-				inPtr += (stereo ? 2 : 1);
-			}
-		} while (opos >= 0);
-
-		st_sample_t out0, out1;
-		out0 = *inPtr++;
-		out1 = (stereo ? *inPtr++ : out0);
-
-		// Increment output position
-		opos += opos_inc;
-
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+	bool inputDone = false;
+	while (obuf < oend && !inputDone) {
+		// Resample a batch of samples into outBuf, then mix them all at once
+		st_sample_t *outPtr = outBuf;
+		const st_sample_t *outEnd = outBuf + MIN<st_size_t>((oend - obuf) / 2, ARRAYSIZE(outBuf) / 2) * (stereo ? 2 : 1);
+
+		while (outPtr < outEnd) {
+
+			// read enough input samples so that opos >= 0
+			do {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						inLen = 0;
+						inputDone = true;
+						break;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				opos--;
+				if (opos >= 0) {
+					inPtr += (stereo ? 2 : 1);
+				}
+			} while (opos >= 0);
+
+			if (inputDone)
+				break;
+
+			*outPtr++ = *inPtr++;
+			if (stereo)
+				*outPtr++ = *inPtr++;
 
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			// Increment output position
+			opos += opos_inc;
+		}
 
-		obuf += 2;
+		const st_size_t numFrames = (outPtr - outBuf) / (stereo ? 2 : 1);
+		mixBuffer<stereo, reverseStereo>(obuf, outBuf, numFrames, vol_l, vol_r);
+		obuf += numFrames * 2;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -173,11 +283,14 @@ protected:
 	/** current sample(s) in the input stream (left/right channel) */
 	st_sample_t icur0, icur1;
 
+	/** interpolated samples, waiting to be mixed into the output buffer */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
-		return ST_SUCCESS;
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return 0;
 	}
 };
 
@@ -217,48 +330,55 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
-	while (obuf < oend) {
-
-		// read enough input samples so that opos < 0
-		while ((frac_t)FRAC_ONE <= opos) {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			ilast0 = icur0;
-			icur0 = *inPtr++;
-			if (stereo) {
-				ilast1 = icur1;
-				icur1 = *inPtr++;
+	bool inputDone = false;
+	while (obuf < oend && !inputDone) {
+		// Interpolate a batch of samples into outBuf, then mix them all at once
+		st_sample_t *outPtr = outBuf;
+		const st_sample_t *outEnd = outBuf + MIN<st_size_t>((oend - obuf) / 2, ARRAYSIZE(outBuf) / 2) * (stereo ? 2 : 1);
+
+		while (outPtr < outEnd) {
+
+			// read enough input samples so that opos < 0
+			while ((frac_t)FRAC_ONE <= opos) {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						inLen = 0;
+						inputDone = true;
+						break;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				ilast0 = icur0;
+				icur0 = *inPtr++;
+				if (stereo) {
+					ilast1 = icur1;
+					icur1 = *inPtr++;
+				}
+				opos -= FRAC_ONE;
 			}
-			opos -= FRAC_ONE;
-		}
-
-		// Loop as long as the outpos trails behind, and as long as there is
-		// still space in the output buffer.
-		while (opos < (frac_t)FRAC_ONE && obuf < oend) {
-			// interpolate
-			st_sample_t out0, out1;
-			out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
-			out1 = (stereo ?
-						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS)) :
-						  out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
 
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			if (inputDone)
+				break;
 
-			obuf += 2;
+			// Loop as long as the outpos trails behind, and as long as there is
+			// still space in the output buffer.
+			while (opos < (frac_t)FRAC_ONE && outPtr < outEnd) {
+				// interpolate
+				*outPtr++ = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
+				if (stereo)
+					*outPtr++ = (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS));
 
-			// Increment output position
-			opos += opos_inc;
+				// Increment output position
+				opos += opos_inc;
+			}
 		}
+
+		const st_size_t numFrames = (outPtr - outBuf) / (stereo ? 2 : 1);
+		mixBuffer<stereo, reverseStereo>(obuf, outBuf, numFrames, vol_l, vol_r);
+		obuf += numFrames * 2;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -283,11 +403,8 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
 		st_size_t len;
 
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -305,35 +422,456 @@ public:
 		len = input.readBuffer(_buffer, osamp);
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
+		const st_size_t numFrames = len / (stereo ? 2 : 1);
+		mixBuffer<stereo, reverseStereo>(obuf, _buffer, numFrames, vol_l, vol_r);
+		return numFrames;
+	}
+
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return 0;
+	}
+};
+
+
+#pragma mark -
+
+
+/**
+ * A polyphase windowed-sinc filter for converting between two given rates.
+ *
+ * The filter is split into (1 << phaseBits) phases of numTaps coefficients
+ * each. Phase p holds the (Kaiser windowed) impulse response sampled at the
+ * fractional offset p / (1 << phaseBits) between two input samples, in
+ * 2.14 fixed point.
+ */
+struct SincFilterBank {
+	st_rate_t inrate, outrate;
+	RateConverterQuality quality;
+	uint numTaps;
+	uint phaseBits;
+	int16 *coeffs;
+	uint refCount;
+};
+
+enum {
+	kSincCoeffBits = 14,
+	kMaxSincFilterBanks = 8
+};
+
+/**
+ * The filter banks in use or recently used. Unused banks are kept until
+ * their slot is needed, so that sounds played over and over again do not
+ * need to recompute their filter.
+ */
+static SincFilterBank *s_sincFilterBanks[kMaxSincFilterBanks];
+
+/**
+ * Guards s_sincFilterBanks and the reference counts, since converters are
+ * created on the engine threads but usually destroyed on the mixer thread.
+ * Only exists while there is a mixer; before that there is just one thread.
+ */
+static OSystem::MutexRef s_sincFilterBankMutex = 0;
+
+class SincFilterBankLock {
+public:
+	SincFilterBankLock() {
+		if (s_sincFilterBankMutex)
+			g_system->lockMutex(s_sincFilterBankMutex);
+	}
+
+	~SincFilterBankLock() {
+		if (s_sincFilterBankMutex)
+			g_system->unlockMutex(s_sincFilterBankMutex);
+	}
+};
+
+/**
+ * Zeroth order modified Bessel function of the first kind, needed for the
+ * Kaiser window.
+ */
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; ++k) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+static SincFilterBank *createSincFilterBank(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
+	uint numTaps, phaseBits;
+	double rolloff, beta;
+
+	if (quality == kRateConverterSincHigh) {
+		numTaps = 32;
+		phaseBits = 10;
+		rolloff = 0.95;
+		beta = 9.0;
+	} else {
+		numTaps = 16;
+		phaseBits = 8;
+		rolloff = 0.90;
+		beta = 6.0;
+	}
+
+	// When downsampling the cutoff frequency moves down, so the kernel has
+	// to get longer to keep the same steepness. Limit this, to keep the cost
+	// per sample bounded.
+	double cutoff = rolloff;
+	if (outrate < inrate) {
+		cutoff = rolloff * outrate / inrate;
+		numTaps = MIN<uint>(numTaps * ((inrate + outrate - 1) / outrate), numTaps * 4);
+	}
+
+	SincFilterBank *bank = new SincFilterBank();
+	bank->inrate = inrate;
+	bank->outrate = outrate;
+	bank->quality = quality;
+	bank->numTaps = numTaps;
+	bank->phaseBits = phaseBits;
+	bank->coeffs = new int16[(1 << phaseBits) * numTaps];
+	bank->refCount = 0;
+
+	const double halfLength = numTaps / 2.0;
+	const double windowScale = 1.0 / besselI0(beta);
+	double *row = new double[numTaps];
+
+	for (uint phase = 0; phase < (1u << phaseBits); ++phase) {
+		const double frac = (double)phase / (1 << phaseBits);
+
+		// Tap k is applied to the input sample at offset (k - numTaps / 2 + 1)
+		// from the sample preceding the output position.
+		double sum = 0.0;
+		for (uint k = 0; k < numTaps; ++k) {
+			const double t = (double)k - numTaps / 2 + 1 - frac;
+			const double x = M_PI * cutoff * t;
+			const double sinc = (t == 0.0) ? 1.0 : sin(x) / x;
+			const double w = t / halfLength;
+			const double window = (w * w < 1.0) ? besselI0(beta * sqrt(1.0 - w * w)) * windowScale : 0.0;
+
+			row[k] = sinc * window;
+			sum += row[k];
+		}
+
+		// Normalize every phase to unity gain, so that no phase dependent
+		// ripple is introduced.
+		int16 *dst = bank->coeffs + phase * numTaps;
+		for (uint k = 0; k < numTaps; ++k)
+			dst[k] = (int16)floor(row[k] / sum * (1 << kSincCoeffBits) + 0.5);
+	}
+
+	delete[] row;
+	return bank;
+}
+
+static void freeSincFilterBank(SincFilterBank *bank) {
+	delete[] bank->coeffs;
+	delete bank;
+}
+
+/**
+ * Look up the cached bank for the given conversion and take a reference to
+ * it. Must be called with the lock held.
+ */
+static SincFilterBank *findSincFilterBank(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
+	for (int i = 0; i < kMaxSincFilterBanks; ++i) {
+		SincFilterBank *bank = s_sincFilterBanks[i];
+		if (bank && bank->inrate == inrate && bank->outrate == outrate && bank->quality == quality) {
+			bank->refCount++;
+			return bank;
+		}
+	}
+
+	return 0;
+}
+
+static SincFilterBank *acquireSincFilterBank(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
+	{
+		SincFilterBankLock lock;
+		SincFilterBank *bank = findSincFilterBank(inrate, outrate, quality);
+		if (bank)
+			return bank;
+	}
+
+	// Computing the coefficients takes a while, so it is done without the
+	// lock: the mixer thread takes it to release converters, and must not
+	// wait for this.
+	SincFilterBank *newBank = createSincFilterBank(inrate, outrate, quality);
+	SincFilterBank *bank, *unused = 0;
+
+	{
+		SincFilterBankLock lock;
+
+		// Another thread may have created the same bank in the meantime.
+		bank = findSincFilterBank(inrate, outrate, quality);
+		if (bank) {
+			unused = newBank;
+		} else {
+			bank = newBank;
+			bank->refCount = 1;
+
+			int freeSlot = -1;
+			for (int i = 0; i < kMaxSincFilterBanks; ++i) {
+				if (!s_sincFilterBanks[i]) {
+					freeSlot = i;
+					break;
+				} else if (s_sincFilterBanks[i]->refCount == 0 && freeSlot == -1) {
+					freeSlot = i;
+				}
+			}
+
+			// If all slots are taken by banks in use, the new bank is simply
+			// not shared.
+			if (freeSlot != -1) {
+				unused = s_sincFilterBanks[freeSlot];
+				s_sincFilterBanks[freeSlot] = bank;
+			}
+		}
+	}
+
+	// Neither the duplicate nor the evicted bank is referenced anywhere.
+	if (unused)
+		freeSincFilterBank(unused);
+
+	return bank;
+}
+
+static void releaseSincFilterBank(SincFilterBank *bank) {
+	SincFilterBankLock lock;
+	assert(bank->refCount > 0);
+	bank->refCount--;
+
+	for (int i = 0; i < kMaxSincFilterBanks; ++i) {
+		if (s_sincFilterBanks[i] == bank)
+			return;
+	}
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+	// Not in the cache, so nobody else can be using it.
+	freeSincFilterBank(bank);
+}
+
+void initRateConverters() {
+	if (!s_sincFilterBankMutex)
+		s_sincFilterBankMutex = g_system->createMutex();
+}
 
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+void deinitRateConverters() {
+	{
+		SincFilterBankLock lock;
 
-			obuf += 2;
+		// Banks still in use are no longer shared, and get freed by the
+		// last converter using them.
+		for (int i = 0; i < kMaxSincFilterBanks; ++i) {
+			if (s_sincFilterBanks[i] && s_sincFilterBanks[i]->refCount == 0)
+				freeSincFilterBank(s_sincFilterBanks[i]);
+			s_sincFilterBanks[i] = 0;
 		}
-		return (obuf - ostart) / 2;
 	}
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
-		return ST_SUCCESS;
+	if (s_sincFilterBankMutex) {
+		g_system->deleteMutex(s_sincFilterBankMutex);
+		s_sincFilterBankMutex = 0;
+	}
+}
+
+/**
+ * Compute the dot product of the given samples and filter coefficients.
+ * numTaps must be a multiple of 8.
+ */
+static inline int sincDotProduct(const st_sample_t *samples, const int16 *coeffs, uint numTaps) {
+#if defined(USE_SSE2)
+	if (s_useSSE2) {
+		__m128i acc = _mm_setzero_si128();
+		for (uint k = 0; k < numTaps; k += 8) {
+			const __m128i s = _mm_loadu_si128((const __m128i *)(samples + k));
+			const __m128i c = _mm_loadu_si128((const __m128i *)(coeffs + k));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(s, c));
+		}
+		acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+		acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+		return _mm_cvtsi128_si32(acc);
+	}
+#endif
+
+	int acc = 0;
+	for (uint k = 0; k < numTaps; ++k)
+		acc += samples[k] * coeffs[k];
+	return acc;
+}
+
+/**
+ * Audio rate converter based on a polyphase windowed-sinc filter. This
+ * avoids most of the aliasing and high frequency loss of the linear
+ * converter, at the cost of numTaps multiplications per output sample and
+ * channel.
+ *
+ * Like the linear converter, the output position is tracked in fractional
+ * input samples; its fractional part selects the filter phase.
+ */
+template<bool stereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+protected:
+	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
+	const st_sample_t *inPtr;
+	int inLen;
+
+	/** filtered samples, waiting to be mixed into the output buffer */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	SincFilterBank *_bank;
+
+	/**
+	 * The last numTaps input samples of each channel. Every sample is
+	 * stored twice, numTaps apart, so that the most recent numTaps samples
+	 * are always available in order starting at _histPos.
+	 */
+	st_sample_t *_hist[2];
+	uint _histPos;
+
+	/** fractional position of the output stream in input stream unit */
+	frac_t opos;
+
+	/** fractional position increment in the output stream */
+	frac_t opos_inc;
+
+	/**
+	 * Silent input frames still to be fed into the filter after the end of
+	 * the input stream. The filter delays its output by half its length,
+	 * so without them the last input samples would never come out.
+	 */
+	uint _tailLeft;
+
+	int convert(AudioStream *input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+
+	int filter(const st_sample_t *hist, const int16 *coeffs) const {
+		int val = (sincDotProduct(hist, coeffs, _bank->numTaps) + (1 << (kSincCoeffBits - 1))) >> kSincCoeffBits;
+		return CLIP<int>(val, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+	}
+
+public:
+	SincRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality);
+	~SincRateConverter();
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return convert(&input, obuf, osamp, vol_l, vol_r);
+	}
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return convert(0, obuf, osamp, vol_l, vol_r);
 	}
 };
 
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
+	if (inrate >= 65536 || outrate >= 65536) {
+		error("rate effect can only handle rates < 65536");
+	}
+
+	_bank = acquireSincFilterBank(inrate, outrate, quality);
+	assert(_bank->numTaps % 8 == 0 && _bank->phaseBits <= FRAC_BITS);
+
+	for (int i = 0; i < 2; ++i) {
+		_hist[i] = new st_sample_t[_bank->numTaps * 2];
+		memset(_hist[i], 0, _bank->numTaps * 2 * sizeof(st_sample_t));
+	}
+	_histPos = 0;
+
+	opos = FRAC_ONE;
+	opos_inc = (inrate << FRAC_BITS) / outrate;
+
+	inLen = 0;
+	_tailLeft = _bank->numTaps / 2;
+}
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::~SincRateConverter() {
+	delete[] _hist[0];
+	delete[] _hist[1];
+	releaseSincFilterBank(_bank);
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf. Without input, the
+ * filter is flushed with silence instead.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int SincRateConverter<stereo, reverseStereo>::convert(AudioStream *input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	const uint numTaps = _bank->numTaps;
+	const uint phaseShift = FRAC_BITS - _bank->phaseBits;
+
+	bool inputDone = false;
+	while (obuf < oend && !inputDone) {
+		// Filter a batch of samples into outBuf, then mix them all at once
+		st_sample_t *outPtr = outBuf;
+		const st_sample_t *outEnd = outBuf + MIN<st_size_t>((oend - obuf) / 2, ARRAYSIZE(outBuf) / 2) * (stereo ? 2 : 1);
+
+		while (outPtr < outEnd) {
+
+			// read enough input samples so that opos < 0
+			while ((frac_t)FRAC_ONE <= opos) {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					if (input) {
+						inLen = input->readBuffer(inBuf, ARRAYSIZE(inBuf));
+					} else {
+						const uint frames = MIN<uint>(_tailLeft, ARRAYSIZE(inBuf) / 2);
+						inLen = frames * (stereo ? 2 : 1);
+						memset(inBuf, 0, inLen * sizeof(st_sample_t));
+						_tailLeft -= frames;
+					}
+					if (inLen <= 0) {
+						inLen = 0;
+						inputDone = true;
+						break;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				_hist[0][_histPos] = _hist[0][_histPos + numTaps] = *inPtr++;
+				if (stereo)
+					_hist[1][_histPos] = _hist[1][_histPos + numTaps] = *inPtr++;
+				if (++_histPos == numTaps)
+					_histPos = 0;
+				opos -= FRAC_ONE;
+			}
+
+			if (inputDone)
+				break;
+
+			// Loop as long as the outpos trails behind, and as long as there is
+			// still space in the output buffer.
+			while (opos < (frac_t)FRAC_ONE && outPtr < outEnd) {
+				const int16 *coeffs = _bank->coeffs + (opos >> phaseShift) * numTaps;
+
+				*outPtr++ = filter(_hist[0] + _histPos, coeffs);
+				if (stereo)
+					*outPtr++ = filter(_hist[1] + _histPos, coeffs);
+
+				// Increment output position
+				opos += opos_inc;
+			}
+		}
+
+		const st_size_t numFrames = (outPtr - outBuf) / (stereo ? 2 : 1);
+		mixBuffer<stereo, reverseStereo>(obuf, outBuf, numFrames, vol_l, vol_r);
+		obuf += numFrames * 2;
+	}
+	return (obuf - ostart) / 2;
+}
+
 
 #pragma mark -
 
 template<bool stereo, bool reverseStereo>
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
 	if (inrate != outrate) {
-		if ((inrate % outrate) == 0) {
+		if (quality != kRateConverterLinear) {
+			return new SincRateConverter<stereo, reverseStereo>(inrate, outrate, quality);
+		} else if ((inrate % outrate) == 0) {
 			return new SimpleRateConverter<stereo, reverseStereo>(inrate, outrate);
 		} else {
 			return new LinearRateConverter<stereo, reverseStereo>(inrate, outrate);
@@ -346,14 +884,14 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
 	if (stereo) {
 		if (reverseStereo)
-			return makeRateConverter<true, true>(inrate, outrate);
+			return makeRateConverter<true, true>(inrate, outrate, quality);
 		else
-			return makeRateConverter<true, false>(inrate, outrate);
+			return makeRateConverter<true, false>(inrate, outrate, quality);
 	} else
-		return makeRateConverter<false, false>(inrate, outrate);
+		return makeRateConverter<false, false>(inrate, outrate, quality);
 }
 
 } // End of namespace Audio
@@ -65,6 +65,19 @@ static inline void clampedAdd(int16& a, int b) {
 #endif
 }
 
+/**
+ * The resampling methods which can be used to convert between differing
+ * input and output rates.
+ */
+enum RateConverterQuality {
+	/** Linear interpolation, or plain decimation for integral rate ratios */
+	kRateConverterLinear = 0,
+	/** Windowed-sinc filter with a short kernel */
+	kRateConverterSincMedium,
+	/** Windowed-sinc filter with a long kernel and a sharp cutoff */
+	kRateConverterSincHigh
+};
+
 class RateConverter {
 public:
 	RateConverter() {}
@@ -75,10 +88,43 @@ public:
 	 */
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
+	/**
+	 * Mix the samples the converter still holds back into the buffer, once
+	 * the input stream has ended.
+	 *
+	 * @return Number of sample pairs written into the buffer. Less than
+	 *         osamp once there is nothing left.
+	 */
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/**
+ * Create a RateConverter for the specified input and output rates.
+ *
+ * The windowed-sinc qualities share their filter tables between converters
+ * for the same rates.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false, RateConverterQuality quality = kRateConverterLinear);
+
+/**
+ * Allow creating and destroying rate converters on several threads. Called
+ * by the mixer when it is created.
+ */
+void initRateConverters();
+
+/**
+ * Free the shared filter tables. Called by the mixer when it is destroyed.
+ */
+void deinitRateConverters();
+
+/**
+ * Switch between the SIMD code of the rate converters, which is used by
+ * default, and the plain C++ code, e.g. to compare their speed. This must
+ * not be called while converters are running.
+ *
+ * @return whether there is any SIMD code to switch to in this build
+ */
+bool setRateConverterSIMD(bool enable);
 
 } // End of namespace Audio
 
@@ -0,0 +1,327 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/softsynth/emumidi.h"
+
+#include "common/array.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/list.h"
+#include "common/mutex.h"
+#include "common/system.h"
+#include "common/timer.h"
+
+enum {
+	kRenderAheadInterval = 10 * 1000, // microseconds
+	// How long one tick of the timer may keep rendering, as it holds up the
+	// other timers meanwhile
+	kRenderAheadTimeLimit = 4 // milliseconds
+};
+
+// The drivers which are rendering ahead. The timer is removed while this is
+// changed, so the timer never sees it half updated.
+static Common::Array<MidiDriver_Emulated *> s_renderAheadDrivers;
+
+/**
+ * State of the render ahead mode. The rendering timer is the only writer
+ * of the ring buffer and the mixer the only reader. The positions are
+ * counted in frames and wrap around; they are only updated with the mutex
+ * held, but the samples are rendered and copied without it. The mutex is
+ * only taken a few times per mix pass and is needed for the event queue
+ * anyway, so the positions do not get a lock-free scheme of their own like
+ * the command queue of the mixer.
+ */
+struct MidiDriver_Emulated::RenderAhead {
+	struct Event {
+		uint32 time;
+		uint32 msg;
+		Common::Array<byte> sysEx;
+	};
+
+	Common::Mutex mutex;
+
+	int16 *buffer;
+	uint32 bufferFrames;
+	uint32 readPos;
+	uint32 writePos;
+
+	// Guarded by the mutex as well
+	Common::List<Event> events;
+	uint32 lastEventTime;
+	uint32 underruns;
+
+	// Only used by the rendering timer
+	uint32 chunkFrames;
+	uint32 renderPos;
+	bool inTimerProc;
+};
+
+MidiDriver_Emulated::~MidiDriver_Emulated() {
+	stopRenderAhead();
+}
+
+void MidiDriver_Emulated::renderTicks(int16 *data, int len) {
+	const int stereoFactor = isStereo() ? 2 : 1;
+	int step;
+
+	do {
+		step = len;
+		if (step > (_nextTick >> FIXP_SHIFT))
+			step = (_nextTick >> FIXP_SHIFT);
+
+		if (_renderAhead)
+			step = playDueEvents(step);
+
+		generateSamples(data, step);
+
+		if (_renderAhead)
+			_renderAhead->renderPos += step;
+
+		_nextTick -= step << FIXP_SHIFT;
+		if (!(_nextTick >> FIXP_SHIFT)) {
+			if (_renderAhead)
+				_renderAhead->inTimerProc = true;
+
+			if (_timerProc)
+				(*_timerProc)(_timerParam);
+
+			onTimer();
+
+			if (_renderAhead)
+				_renderAhead->inTimerProc = false;
+
+			_nextTick += _samplesPerTick;
+		}
+
+		data += step * stereoFactor;
+		len -= step;
+	} while (len);
+}
+
+int MidiDriver_Emulated::playDueEvents(int maxLen) {
+	RenderAhead &ra = *_renderAhead;
+
+	while (true) {
+		RenderAhead::Event event;
+		{
+			Common::StackLock lock(ra.mutex);
+			if (ra.events.empty())
+				return maxLen;
+
+			const int32 delay = (int32)(ra.events.front().time - ra.renderPos);
+			if (delay > 0)
+				return MIN<int>(maxLen, delay);
+
+			event = ra.events.front();
+			ra.events.pop_front();
+		}
+
+		// The synth must not be used with the mutex held, the timer
+		// callback of the driver may be waiting for it.
+		if (event.sysEx.empty())
+			playEvent(event.msg);
+		else
+			playSysEx(&event.sysEx[0], event.sysEx.size());
+	}
+}
+
+uint32 MidiDriver_Emulated::renderAheadChunk(uint32 maxFrames) {
+	RenderAhead &ra = *_renderAhead;
+	const int stereoFactor = isStereo() ? 2 : 1;
+
+	uint32 readPos;
+	{
+		Common::StackLock lock(ra.mutex);
+		readPos = ra.readPos;
+	}
+
+	const uint32 offset = ra.writePos % ra.bufferFrames;
+	const uint32 space = ra.bufferFrames - (ra.writePos - readPos);
+	const uint32 len = MIN(MIN(space, maxFrames), ra.bufferFrames - offset);
+	if (!len)
+		return 0;
+
+	renderTicks(ra.buffer + offset * stereoFactor, len);
+
+	Common::StackLock lock(ra.mutex);
+	ra.writePos += len;
+	return len;
+}
+
+void MidiDriver_Emulated::fillRenderAhead(uint32 deadline) {
+	// Always render at least one chunk, which is as long as the timer
+	// interval, so that the driver keeps up however slow the synth is.
+	// Refilling after an underrun is spread over several ticks instead.
+	for (bool first = true; ; first = false) {
+		if (!first && (int32)(g_system->getMillis() - deadline) >= 0)
+			return;
+
+		if (!renderAheadChunk(_renderAhead->chunkFrames))
+			return;
+	}
+}
+
+int MidiDriver_Emulated::readRenderAhead(int16 *data, int numSamples) {
+	RenderAhead &ra = *_renderAhead;
+	const int stereoFactor = isStereo() ? 2 : 1;
+
+	uint32 readPos, available;
+	{
+		Common::StackLock lock(ra.mutex);
+		readPos = ra.readPos;
+		available = ra.writePos - readPos;
+	}
+
+	uint32 len = numSamples / stereoFactor;
+	if (len > available) {
+		// Rather play silence than block the audio device; the music
+		// continues where it left off.
+		debug(5, "MidiDriver_Emulated: %d frames missing", len - available);
+		memset(data + available * stereoFactor, 0, (len - available) * stereoFactor * sizeof(int16));
+		len = available;
+
+		Common::StackLock lock(ra.mutex);
+		ra.underruns++;
+	}
+
+	uint32 done = 0;
+	while (done < len) {
+		const uint32 offset = (readPos + done) % ra.bufferFrames;
+		const uint32 count = MIN(len - done, ra.bufferFrames - offset);
+
+		memcpy(data + done * stereoFactor, ra.buffer + offset * stereoFactor, count * stereoFactor * sizeof(int16));
+		done += count;
+	}
+
+	Common::StackLock lock(ra.mutex);
+	ra.readPos += len;
+
+	return numSamples;
+}
+
+void MidiDriver_Emulated::renderAheadTimer(void * /* refCon */) {
+	const uint32 deadline = g_system->getMillis() + kRenderAheadTimeLimit;
+
+	for (uint i = 0; i < s_renderAheadDrivers.size(); i++)
+		s_renderAheadDrivers[i]->fillRenderAhead(deadline);
+}
+
+void MidiDriver_Emulated::startRenderAhead() {
+	if (_renderAhead || !ConfMan.hasKey("midi_render_ahead"))
+		return;
+
+	const int latency = ConfMan.getInt("midi_render_ahead");
+	if (latency <= 0)
+		return;
+
+	RenderAhead *ra = new RenderAhead();
+	ra->bufferFrames = getRate() * CLIP(latency, 20, 1000) / 1000;
+	ra->buffer = new int16[ra->bufferFrames * (isStereo() ? 2 : 1)];
+	ra->readPos = ra->writePos = 0;
+	ra->lastEventTime = 0;
+	ra->underruns = 0;
+	ra->chunkFrames = MAX<uint32>(getRate() / (1000000 / kRenderAheadInterval), 1);
+	ra->renderPos = 0;
+	ra->inTimerProc = false;
+	_renderAhead = ra;
+
+	// Have the whole latency rendered before the mixer asks for it, then
+	// have the timer top it up. The timer is shared by all drivers and
+	// renders on the timer thread, in small pieces so that it does not hold
+	// up the other timers for long.
+	while (renderAheadChunk(ra->bufferFrames))
+		;
+
+	Common::TimerManager *timerManager = g_system->getTimerManager();
+	timerManager->removeTimerProc(renderAheadTimer);
+	s_renderAheadDrivers.push_back(this);
+	timerManager->installTimerProc(renderAheadTimer, kRenderAheadInterval, 0, "MidiEmuRenderAhead");
+}
+
+void MidiDriver_Emulated::stopRenderAhead() {
+	if (!_renderAhead)
+		return;
+
+	Common::TimerManager *timerManager = g_system->getTimerManager();
+	timerManager->removeTimerProc(renderAheadTimer);
+
+	for (uint i = 0; i < s_renderAheadDrivers.size(); i++) {
+		if (s_renderAheadDrivers[i] == this) {
+			s_renderAheadDrivers.remove_at(i);
+			break;
+		}
+	}
+
+	if (!s_renderAheadDrivers.empty())
+		timerManager->installTimerProc(renderAheadTimer, kRenderAheadInterval, 0, "MidiEmuRenderAhead");
+
+	if (_renderAhead->underruns)
+		debug(1, "MidiDriver_Emulated: %d underruns while rendering ahead", _renderAhead->underruns);
+
+	delete[] _renderAhead->buffer;
+	delete _renderAhead;
+	_renderAhead = 0;
+}
+
+bool MidiDriver_Emulated::queueEvent(uint32 b) {
+	return queue(b, 0, 0);
+}
+
+bool MidiDriver_Emulated::queueSysEx(const byte *msg, uint16 length) {
+	if (!length)
+		return _renderAhead != 0;
+	return queue(0, msg, length);
+}
+
+bool MidiDriver_Emulated::queue(uint32 msg, const byte *sysEx, uint16 length) {
+	if (!_renderAhead)
+		return false;
+
+	RenderAhead &ra = *_renderAhead;
+	RenderAhead::Event event;
+	event.msg = msg;
+	if (length)
+		event.sysEx = Common::Array<byte>(sysEx, length);
+
+	Common::StackLock lock(ra.mutex);
+
+	// Events from the timer callback belong to the rendering position.
+	// Others are delayed by the full latency, which keeps their timing
+	// independent of how much has been rendered ahead so far.
+	event.time = ra.inTimerProc ? ra.renderPos : ra.readPos + ra.bufferFrames;
+
+	// Never reorder events
+	if ((int32)(event.time - ra.lastEventTime) < 0)
+		event.time = ra.lastEventTime;
+	ra.lastEventTime = event.time;
+
+	ra.events.push_back(event);
+	return true;
+}
+
+uint32 MidiDriver_Emulated::getUnderrunCount() const {
+	if (!_renderAhead)
+		return 0;
+
+	Common::StackLock lock(_renderAhead->mutex);
+	return _renderAhead->underruns;
+}
@@ -33,6 +33,8 @@ protected:
 	Audio::SoundHandle _mixerSoundHandle;
 
 private:
+	struct RenderAhead;
+
 	Common::TimerManager::TimerProc _timerProc;
 	void *_timerParam;
 
@@ -43,12 +45,65 @@ private:
 	int _nextTick;
 	int _samplesPerTick;
 
+	RenderAhead *_renderAhead;
+
+	void renderTicks(int16 *data, int len);
+	int playDueEvents(int maxLen);
+	bool queue(uint32 msg, const byte *sysEx, uint16 length);
+	uint32 renderAheadChunk(uint32 maxFrames);
+	void fillRenderAhead(uint32 deadline);
+	int readRenderAhead(int16 *data, int numSamples);
+	static void renderAheadTimer(void *refCon);
+
 protected:
 	int _baseFreq;
 
 	virtual void generateSamples(int16 *buf, int len) = 0;
 	virtual void onTimer() {}
 
+	/**
+	 * Start rendering ahead, if enabled with the "midi_render_ahead" config
+	 * key. The samples are then generated by a timer, up to the configured
+	 * latency ahead of the mixer, so that an expensive generateSamples() call
+	 * does not make the audio device run dry. The timer callback of the
+	 * driver is called from the same timer.
+	 *
+	 * The timer runs on the timer thread, which it shares with all other
+	 * timers. It renders 10 ms of audio per driver and tick, and more only
+	 * as long as the tick has taken less than a few milliseconds.
+	 *
+	 * Drivers supporting this have to call it at the end of open(), before
+	 * the stream is handed to the mixer, and have to route their MIDI events
+	 * through queueEvent() and queueSysEx().
+	 */
+	void startRenderAhead();
+
+	/**
+	 * Stop rendering ahead. Must be called by close(), after the stream has
+	 * been stopped and before the synth is destroyed.
+	 */
+	void stopRenderAhead();
+
+	/**
+	 * Queue a MIDI event while rendering ahead. Events sent by the timer
+	 * callback are played at the current rendering position, all others a
+	 * fixed latency after the current playing position. They are played by
+	 * the rendering timer through playEvent().
+	 *
+	 * @return false if not rendering ahead, in which case the caller has to
+	 *         play the event itself
+	 */
+	bool queueEvent(uint32 b);
+
+	/** Same as queueEvent(), for SysEx messages. */
+	bool queueSysEx(const byte *msg, uint16 length);
+
+	/** Play a queued MIDI event on the synth. */
+	virtual void playEvent(uint32 /* b */) {}
+
+	/** Play a queued SysEx message on the synth. */
+	virtual void playSysEx(const byte * /* msg */, uint16 /* length */) {}
+
 public:
 	MidiDriver_Emulated(Audio::Mixer *mixer) :
 		_mixer(mixer),
@@ -57,9 +112,12 @@ public:
 		_timerParam(0),
 		_nextTick(0),
 		_samplesPerTick(0),
+		_renderAhead(0),
 		_baseFreq(250) {
 	}
 
+	virtual ~MidiDriver_Emulated();
+
 	// MidiDriver API
 	virtual int open() {
 		_isOpen = true;
@@ -86,33 +144,18 @@ public:
 		return 1000000 / _baseFreq;
 	}
 
+	/**
+	 * Return how often the mixer asked for more samples than had been
+	 * rendered ahead, since the last call of startRenderAhead().
+	 */
+	uint32 getUnderrunCount() const;
+
 	// AudioStream API
 	virtual int readBuffer(int16 *data, const int numSamples) {
-		const int stereoFactor = isStereo() ? 2 : 1;
-		int len = numSamples / stereoFactor;
-		int step;
-
-		do {
-			step = len;
-			if (step > (_nextTick >> FIXP_SHIFT))
-				step = (_nextTick >> FIXP_SHIFT);
-
-			generateSamples(data, step);
-
-			_nextTick -= step << FIXP_SHIFT;
-			if (!(_nextTick >> FIXP_SHIFT)) {
-				if (_timerProc)
-					(*_timerProc)(_timerParam);
-
-				onTimer();
-
-				_nextTick += _samplesPerTick;
-			}
-
-			data += step * stereoFactor;
-			len -= step;
-		} while (len);
+		if (_renderAhead)
+			return readRenderAhead(data, numSamples);
 
+		renderTicks(data, numSamples / (isStereo() ? 2 : 1));
 		return numSamples;
 	}
 
@@ -48,6 +48,7 @@ protected:
 	void setStr(const char *name, const char *str);
 
 	void generateSamples(int16 *buf, int len);
+	void playEvent(uint32 b);
 
 public:
 	MidiDriver_FluidSynth(Audio::Mixer *mixer);
@@ -183,6 +184,7 @@ int MidiDriver_FluidSynth::open() {
 		error("Failed loading custom sound font '%s'", soundfont);
 
 	MidiDriver_Emulated::open();
+	startRenderAhead();
 
 	// The MT-32 emulator uses kSFXSoundType here. I don't know why.
 	_mixer->playStream(Audio::Mixer::kMusicSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
@@ -195,6 +197,7 @@ void MidiDriver_FluidSynth::close() {
 	_isOpen = false;
 
 	_mixer->stopHandle(_mixerSoundHandle);
+	stopRenderAhead();
 
 	if (_soundFont != -1)
 		fluid_synth_sfunload(_synth, _soundFont, 1);
@@ -204,6 +207,11 @@ void MidiDriver_FluidSynth::close() {
 }
 
 void MidiDriver_FluidSynth::send(uint32 b) {
+	if (!queueEvent(b))
+		playEvent(b);
+}
+
+void MidiDriver_FluidSynth::playEvent(uint32 b) {
 	//byte param3 = (byte) ((b >> 24) & 0xFF);
 	uint param2 = (byte) ((b >> 16) & 0xFF);
 	uint param1 = (byte) ((b >>  8) & 0xFF);
@@ -41,6 +41,7 @@
 #include "common/archive.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
+#include "common/workerpool.h"
 
 #include "graphics/fontman.h"
 #include "graphics/surface.h"
@@ -91,6 +92,20 @@ protected:
 	void onProgramChanged(int /* partNum */, char * /* patchName */) {}
 };
 
+// Renders the partials of the synth on a worker pool provided by the backend
+class RenderJobRunnerScummVM : public RenderJobRunner {
+public:
+	RenderJobRunnerScummVM(Common::WorkerPool *pool) : _pool(pool) {}
+	virtual ~RenderJobRunnerScummVM() { delete _pool; }
+
+	virtual void runJobs(JobProc proc, void *param, unsigned int numJobs) {
+		_pool->runJobs(proc, param, numJobs);
+	}
+
+private:
+	Common::WorkerPool *_pool;
+};
+
 }	// end of namespace MT32Emu
 
 class MidiChannel_MT32 : public MidiChannel_MPU401 {
@@ -104,6 +119,7 @@ private:
 	uint16 _channelMask;
 	MT32Emu::Synth *_synth;
 	MT32Emu::ReportHandlerScummVM *_reportHandler;
+	MT32Emu::RenderJobRunnerScummVM *_renderJobRunner;
 	const MT32Emu::ROMImage *_controlROM, *_pcmROM;
 	Common::File *_controlFile, *_pcmFile;
 	void deleteMuntStructures();
@@ -112,6 +128,8 @@ private:
 
 protected:
 	void generateSamples(int16 *buf, int len);
+	void playEvent(uint32 b);
+	void playSysEx(const byte *msg, uint16 length);
 
 public:
 	bool _initializing;
@@ -147,6 +165,7 @@ MidiDriver_MT32::MidiDriver_MT32(Audio::Mixer *mixer) : MidiDriver_Emulated(mixe
 		_midiChannels[i].init(this, i);
 	}
 	_reportHandler = NULL;
+	_renderJobRunner = NULL;
 	_synth = NULL;
 	// Unfortunately bugs in the emulator cause inaccurate tuning
 	// at rates other than 32KHz, thus we produce data at 32KHz and
@@ -170,6 +189,8 @@ void MidiDriver_MT32::deleteMuntStructures() {
 	_synth = NULL;
 	delete _reportHandler;
 	_reportHandler = NULL;
+	delete _renderJobRunner;
+	_renderJobRunner = NULL;
 
 	if (_controlROM)
 		MT32Emu::ROMImage::freeROMImage(_controlROM);
@@ -221,6 +242,17 @@ int MidiDriver_MT32::open() {
 	_synth->setOutputGain(1.0f * gain);
 	_synth->setReverbOutputGain(0.68f * gain);
 
+	// Optionally render the partials of the different parts on several threads
+	if (ConfMan.hasKey("mt32_threads") && ConfMan.getInt("mt32_threads") > 1) {
+		Common::WorkerPool *pool = g_system->createWorkerPool(ConfMan.getInt("mt32_threads"));
+		if (pool) {
+			_renderJobRunner = new MT32Emu::RenderJobRunnerScummVM(pool);
+			_synth->setRenderJobRunner(_renderJobRunner);
+		} else {
+			warning("MT-32 emulator: threads are not supported by this backend");
+		}
+	}
+
 	_initializing = false;
 
 	if (screenFormat.bytesPerPixel > 1)
@@ -230,12 +262,19 @@ int MidiDriver_MT32::open() {
 
 	g_system->updateScreen();
 
+	startRenderAhead();
+
 	_mixer->playStream(Audio::Mixer::kSFXSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
 
 	return 0;
 }
 
 void MidiDriver_MT32::send(uint32 b) {
+	if (!queueEvent(b))
+		playEvent(b);
+}
+
+void MidiDriver_MT32::playEvent(uint32 b) {
 	_synth->playMsg(b);
 }
 
@@ -257,6 +296,11 @@ void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
 }
 
 void MidiDriver_MT32::sysEx(const byte *msg, uint16 length) {
+	if (!queueSysEx(msg, length))
+		playSysEx(msg, length);
+}
+
+void MidiDriver_MT32::playSysEx(const byte *msg, uint16 length) {
 	if (msg[0] == 0xf0) {
 		_synth->playSysex(msg, length);
 	} else {
@@ -273,6 +317,7 @@ void MidiDriver_MT32::close() {
 	setTimerCallback(NULL, NULL);
 	// Detach the mixer callback handler
 	_mixer->stopHandle(_mixerSoundHandle);
+	stopRenderAhead();
 
 	_synth->close();
 	deleteMuntStructures();
@@ -179,6 +179,8 @@ Synth::Synth(ReportHandler *useReportHandler) {
 	partialManager = NULL;
 	memset(parts, 0, sizeof(parts));
 	renderedSampleCount = 0;
+	renderJobRunner = NULL;
+	partialBufs = NULL;
 }
 
 Synth::~Synth() {
@@ -189,6 +191,7 @@ Synth::~Synth() {
 	if (isDefaultReportHandler) {
 		delete reportHandler;
 	}
+	delete[] partialBufs;
 }
 
 void ReportHandler::showLCDMessage(const char *data) {
@@ -1420,14 +1423,81 @@ void Synth::renderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16s
 	}
 }
 
+void Synth::setRenderJobRunner(RenderJobRunner *runner) {
+	renderJobRunner = runner;
+	if (runner != NULL && partialBufs == NULL) {
+		partialBufs = new float[MT32EMU_MAX_PARTIALS * 2 * MAX_SAMPLES_PER_RUN];
+	}
+}
+
+void Synth::renderPartialJob(void *param, unsigned int job) {
+	Synth *synth = (Synth *)param;
+	for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+		if (synth->partialJob[i] == job) {
+			float *leftBuf = &synth->partialBufs[i * 2 * MAX_SAMPLES_PER_RUN];
+			synth->partialProduced[i] = synth->partialManager->produceOutput(i, leftBuf, leftBuf + MAX_SAMPLES_PER_RUN, synth->partialJobLen);
+		}
+	}
+}
+
+// Renders all the active partials into partialBufs, one job per part.
+// Partials only ever deactivate themselves or their ring modulating slave, which belongs to the same poly,
+// and deactivation only updates the state of the owning part, so the parts can safely be rendered concurrently.
+// For the same reason, whether a partial should reverb cannot change during rendering, unless it stops producing output anyway.
+void Synth::renderPartialsInParallel(Bit32u len) {
+	int partJobs[9];
+	for (int i = 0; i < 9; i++) {
+		partJobs[i] = -1;
+	}
+	partialJobCount = 0;
+	partialJobLen = len;
+	for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+		const Partial *partial = partialManager->getPartial(i);
+		partialProduced[i] = false;
+		partialReverb[i] = reverbEnabled && partialManager->shouldReverb(i);
+		if (!partial->isActive()) {
+			partialJob[i] = 0xFF;
+			continue;
+		}
+		int partNum = partial->getOwnerPart();
+		if (partJobs[partNum] < 0) {
+			partJobs[partNum] = partialJobCount++;
+		}
+		partialJob[i] = partJobs[partNum];
+	}
+	if (partialJobCount == 1) {
+		renderPartialJob(this, 0);
+	} else if (partialJobCount > 1) {
+		renderJobRunner->runJobs(renderPartialJob, this, partialJobCount);
+	}
+}
+
+// Mixes the partials rendered by renderPartialsInParallel() into tmpBufMixLeft/Right, in the order used by the serial renderer.
+void Synth::mixPartials(bool reverb, Bit32u len) {
+	for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+		if (partialProduced[i] && partialReverb[i] == reverb) {
+			const float *leftBuf = &partialBufs[i * 2 * MAX_SAMPLES_PER_RUN];
+			mix(&tmpBufMixLeft[0], leftBuf, len);
+			mix(&tmpBufMixRight[0], leftBuf + MAX_SAMPLES_PER_RUN, len);
+		}
+	}
+}
+
 // FIXME: Using more temporary buffers than we need to
 void Synth::doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16s *reverbDryLeft, Bit16s *reverbDryRight, Bit16s *reverbWetLeft, Bit16s *reverbWetRight, Bit32u len) {
 	clearFloats(&tmpBufMixLeft[0], &tmpBufMixRight[0], len);
+	if (renderJobRunner != NULL) {
+		renderPartialsInParallel(len);
+	}
 	if (!reverbEnabled) {
-		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
-			if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
-				mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
-				mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
+		if (renderJobRunner != NULL) {
+			mixPartials(false, len);
+		} else {
+			for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+				if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
+					mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
+					mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
+				}
 			}
 		}
 		if (nonReverbLeft != NULL) {
@@ -1441,11 +1511,15 @@ void Synth::doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16
 		clearIfNonNull(reverbWetLeft, len);
 		clearIfNonNull(reverbWetRight, len);
 	} else {
-		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
-			if (!partialManager->shouldReverb(i)) {
-				if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
-					mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
-					mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
+		if (renderJobRunner != NULL) {
+			mixPartials(false, len);
+		} else {
+			for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+				if (!partialManager->shouldReverb(i)) {
+					if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
+						mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
+						mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
+					}
 				}
 			}
 		}
@@ -1457,11 +1531,15 @@ void Synth::doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16
 		}
 
 		clearFloats(&tmpBufMixLeft[0], &tmpBufMixRight[0], len);
-		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
-			if (partialManager->shouldReverb(i)) {
-				if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
-					mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
-					mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
+		if (renderJobRunner != NULL) {
+			mixPartials(true, len);
+		} else {
+			for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
+				if (partialManager->shouldReverb(i)) {
+					if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
+						mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
+						mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
+					}
 				}
 			}
 		}
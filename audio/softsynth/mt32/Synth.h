@@ -255,6 +255,18 @@ protected:
 	virtual void onProgramChanged(int /* partNum */, int /* bankNum */, const char * /* patchName */) {}
 };
 
+// Runs independent rendering jobs on behalf of the Synth, optionally on several threads.
+// Note that, when the jobs run in parallel, ReportHandler::onPolyStateChanged() may be called from any of the threads.
+class RenderJobRunner {
+public:
+	typedef void (*JobProc)(void *param, unsigned int job);
+
+	virtual ~RenderJobRunner() {}
+
+	// Must call proc(param, job) for each job from 0 to numJobs - 1, in any order, and return once all of them have finished.
+	virtual void runJobs(JobProc proc, void *param, unsigned int numJobs) = 0;
+};
+
 class Synth {
 friend class Part;
 friend class RhythmPart;
@@ -321,6 +333,16 @@ private:
 	float tmpBufReverbOutLeft[MAX_SAMPLES_PER_RUN];
 	float tmpBufReverbOutRight[MAX_SAMPLES_PER_RUN];
 
+	// Used instead of tmpBufPartialLeft/Right when the partials are rendered by a RenderJobRunner.
+	// Every partial gets its own left and right buffers, so that they can be mixed in the same order as usual afterwards.
+	RenderJobRunner *renderJobRunner;
+	float *partialBufs;
+	bool partialProduced[MT32EMU_MAX_PARTIALS];
+	bool partialReverb[MT32EMU_MAX_PARTIALS];
+	Bit8u partialJob[MT32EMU_MAX_PARTIALS];
+	unsigned int partialJobCount;
+	Bit32u partialJobLen;
+
 	Bit16s tmpNonReverbLeft[MAX_SAMPLES_PER_RUN];
 	Bit16s tmpNonReverbRight[MAX_SAMPLES_PER_RUN];
 	Bit16s tmpReverbDryLeft[MAX_SAMPLES_PER_RUN];
@@ -343,6 +365,9 @@ private:
 	bool prerender();
 	void copyPrerender(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16s *reverbDryLeft, Bit16s *reverbDryRight, Bit16s *reverbWetLeft, Bit16s *reverbWetRight, Bit32u pos, Bit32u len);
 	void checkPrerender(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16s *reverbDryLeft, Bit16s *reverbDryRight, Bit16s *reverbWetLeft, Bit16s *reverbWetRight, Bit32u &pos, Bit32u &len);
+	static void renderPartialJob(void *param, unsigned int job);
+	void renderPartialsInParallel(Bit32u len);
+	void mixPartials(bool reverb, Bit32u len);
 	void doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16s *reverbDryLeft, Bit16s *reverbDryRight, Bit16s *reverbWetLeft, Bit16s *reverbWetRight, Bit32u len);
 
 	void playAddressedSysex(unsigned char channel, const Bit8u *sysex, Bit32u len);
@@ -406,6 +431,10 @@ public:
 	bool isReverbOverridden() const;
 	void setDACInputMode(DACInputMode mode);
 
+	// Optionally renders the partials of different parts in parallel, using the given runner (which may be NULL to render serially).
+	// The output is the same as without a runner. The runner is not owned by the Synth and must stay valid while it is set.
+	void setRenderJobRunner(RenderJobRunner *runner);
+
 	// Sets output gain factor. Applied to all output samples and unrelated with the synth's Master volume.
 	void setOutputGain(float);
 
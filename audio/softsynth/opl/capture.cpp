@@ -0,0 +1,86 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/softsynth/opl/capture.h"
+
+#include "common/stream.h"
+
+namespace OPL {
+namespace Capture {
+
+OPL::OPL(::OPL::OPL *opl, Config::OplType type, Common::WriteStream *log)
+	: ::OPL::OPL(opl), _opl(opl), _log(log) {
+
+	_log->writeUint32BE(kLogTag);
+	_log->writeByte(kLogVersion);
+	_log->writeByte(type);
+}
+
+OPL::~OPL() {
+	_log->finalize();
+	delete _log;
+	delete _opl;
+}
+
+bool OPL::init(int rate) {
+	Common::StackLock lock(_mutex);
+	_log->writeByte(kEventInit);
+	_log->writeUint32LE(rate);
+	return _opl->init(rate);
+}
+
+void OPL::reset() {
+	Common::StackLock lock(_mutex);
+	_log->writeByte(kEventReset);
+	_opl->reset();
+}
+
+void OPL::write(int a, int v) {
+	Common::StackLock lock(_mutex);
+	_log->writeByte(kEventWrite);
+	_log->writeUint16LE(a);
+	_log->writeByte(v);
+	_opl->write(a, v);
+}
+
+byte OPL::read(int a) {
+	Common::StackLock lock(_mutex);
+	return _opl->read(a);
+}
+
+void OPL::writeReg(int r, int v) {
+	Common::StackLock lock(_mutex);
+	_log->writeByte(kEventWriteReg);
+	_log->writeUint16LE(r);
+	_log->writeByte(v);
+	_opl->writeReg(r, v);
+}
+
+void OPL::readBuffer(int16 *buffer, int length) {
+	Common::StackLock lock(_mutex);
+	_log->writeByte(kEventSamples);
+	_log->writeUint32LE(length);
+	_opl->readBuffer(buffer, length);
+}
+
+} // End of namespace Capture
+} // End of namespace OPL
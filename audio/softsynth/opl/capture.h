@@ -0,0 +1,95 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_SOFTSYNTH_OPL_CAPTURE_H
+#define AUDIO_SOFTSYNTH_OPL_CAPTURE_H
+
+#include "audio/fmopl.h"
+
+#include "common/mutex.h"
+
+namespace Common {
+class WriteStream;
+}
+
+namespace OPL {
+namespace Capture {
+
+/**
+ * Format of OPL capture logs, as written by Capture::OPL.
+ *
+ * A log starts with the tag 'OPLL', a version byte and a byte holding the
+ * Config::OplType of the chip. It is followed by a list of events, each
+ * consisting of an event type byte and its little endian arguments.
+ */
+enum {
+	kLogTag = 0x4F504C4C, // 'OPLL'
+	kLogVersion = 1
+};
+
+enum EventType {
+	kEventInit = 0,     ///< uint32 rate
+	kEventReset = 1,    ///< no arguments
+	kEventWrite = 2,    ///< uint16 port, uint8 value
+	kEventWriteReg = 3, ///< uint16 register, uint8 value
+	kEventSamples = 4   ///< uint32 number of samples read
+};
+
+/**
+ * OPL wrapper which records everything done to an emulator into a log,
+ * so that it can be replayed later on, e.g. by devtools/opl_benchmark.
+ *
+ * Registers are usually written from the engine thread, while samples are
+ * read from the mixer thread, so every call is logged and passed on under
+ * a lock. That keeps both the log intact and its order the one the
+ * emulator saw.
+ */
+class OPL : public ::OPL::OPL {
+private:
+	::OPL::OPL *_opl;
+	Common::WriteStream *_log;
+	Common::Mutex _mutex;
+
+public:
+	/**
+	 * Create a capturing wrapper. Takes ownership of both the emulator
+	 * and the log stream.
+	 */
+	OPL(::OPL::OPL *opl, Config::OplType type, Common::WriteStream *log);
+	~OPL();
+
+	bool init(int rate);
+	void reset();
+
+	void write(int a, int v);
+	byte read(int a);
+
+	void writeReg(int r, int v);
+
+	void readBuffer(int16 *buffer, int length);
+	bool isStereo() const { return _opl->isStereo(); }
+};
+
+} // End of namespace Capture
+} // End of namespace OPL
+
+#endif
@@ -36,6 +36,10 @@
 
 #include "dbopl.h"
 
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #ifndef DISABLE_DOSBOX_OPL
 
 namespace OPL {
@@ -90,6 +94,9 @@ namespace DBOPL {
 //Has to fit within 16bit lookuptable
 #define MUL_SH		16
 
+//Maximum amount of samples for which the envelopes are calculated in one go
+#define ENV_BLOCK	64
+
 //Check some ranges
 #if ENV_EXTRA > 3
 #error Too many envelope bits
@@ -595,6 +602,71 @@ INLINE Bits Operator::GetSample( Bits modulation ) {
 	}
 }
 
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+
+//Multiplier to use for a volume, silence simply becomes a multiplier of 0
+static INLINE Bit32s VolumeMul( Bitu vol ) {
+	return ENV_SILENT( vol ) ? 0 : MulTable[ vol >> ENV_EXTRA ];
+}
+
+template< Operator::State yes>
+Bitu Operator::TemplateMulBlock( Bit32s* muls, Bitu count ) {
+	//Nothing changes while off or while holding the sustain level
+	if ( yes == OFF || ( yes == SUSTAIN && ( reg20 & MASK_SUSTAIN ) ) ) {
+		const Bit32s mul = VolumeMul( currentLevel + TemplateVolume< yes >() );
+		for ( Bitu i = 0; i < count; i++ )
+			muls[ i ] = mul;
+		return count;
+	}
+	Bitu i = 0;
+	do {
+		muls[ i++ ] = VolumeMul( currentLevel + TemplateVolume< yes >() );
+	} while ( i < count && state == yes );
+	return i;
+}
+
+void Operator::ForwardBlock( Bit32u* index, Bit32s* muls, Bitu count ) {
+	//Run the envelope a stretch of samples in the same state at a time
+	for ( Bitu done = 0; done < count; ) {
+		switch ( state ) {
+		case OFF:
+			done += TemplateMulBlock< OFF >( muls + done, count - done );
+			break;
+		case RELEASE:
+			done += TemplateMulBlock< RELEASE >( muls + done, count - done );
+			break;
+		case SUSTAIN:
+			done += TemplateMulBlock< SUSTAIN >( muls + done, count - done );
+			break;
+		case DECAY:
+			done += TemplateMulBlock< DECAY >( muls + done, count - done );
+			break;
+		case ATTACK:
+			done += TemplateMulBlock< ATTACK >( muls + done, count - done );
+			break;
+		}
+	}
+	//The wave counter moves on by waveCurrent every sample, silent or not
+	Bit32u wave = waveIndex;
+	Bitu i = 0;
+#ifdef USE_SSE2
+	const __m128i step = _mm_set1_epi32( waveCurrent * 4 );
+	__m128i waves = _mm_setr_epi32( wave + waveCurrent, wave + waveCurrent * 2, wave + waveCurrent * 3, wave + waveCurrent * 4 );
+	for ( ; i + 4 <= count; i += 4 ) {
+		_mm_storeu_si128( (__m128i *)( index + i ), _mm_srli_epi32( waves, WAVE_SH ) );
+		waves = _mm_add_epi32( waves, step );
+	}
+	wave += waveCurrent * i;
+#endif
+	for ( ; i < count; i++ ) {
+		wave += waveCurrent;
+		index[ i ] = wave >> WAVE_SH;
+	}
+	waveIndex = wave;
+}
+
+#endif
+
 Operator::Operator() {
 	chanData = 0;
 	freqMul = 0;
@@ -1219,15 +1291,120 @@ Bit32u Chip::WriteAddr( Bit32u port, Bit8u val ) {
 	return 0;
 }
 
+template< bool opl3Mode >
+static INLINE bool IsLaneChannel( const Channel* ch ) {
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+	return ch->synthHandler == &Channel::BlockTemplate< opl3Mode ? sm3FM : sm2FM > ||
+		ch->synthHandler == &Channel::BlockTemplate< opl3Mode ? sm3AM : sm2AM >;
+#else
+	//Only implemented for the multiplication table wave generator
+	return false;
+#endif
+}
+
+/*
+	Each 2 operator channel only depends on its own previous samples through
+	the feedback, so generating one channel after the other waits on those
+	table lookups and multiplies all the time. Generating a sample of every
+	channel in turn keeps the independent channels in flight together.
+	The output is exactly the same as with BlockTemplate< sm2FM > etc.
+*/
+template< bool opl3Mode >
+void Chip::GenerateLanes( Channel** lanes, Bitu count, Bit32u samples, Bit32s* output ) {
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+	struct Lane {
+		Channel* ch;
+		Operator* op[ 2 ];
+		const Bit16s* waveBase[ 2 ];
+		Bit32u waveMask[ 2 ];
+		Bit32s old0, old1;
+		Bit32s fmMask, amMask;
+		Bit32s maskLeft, maskRight;
+		Bit32u feedback;
+	} lane[ 18 ];
+	Bitu active = 0;
+
+	for ( Bitu l = 0; l < count; l++ ) {
+		Channel* ch = lanes[ l ];
+		const bool am = ch->synthHandler == &Channel::BlockTemplate< opl3Mode ? sm3AM : sm2AM >;
+		//Same early out as BlockTemplate
+		if ( ch->Op( 1 )->Silent() && ( !am || ch->Op( 0 )->Silent() ) ) {
+			ch->old[0] = ch->old[1] = 0;
+			continue;
+		}
+		Lane& ln = lane[ active++ ];
+		ln.ch = ch;
+		for ( int o = 0; o < 2; o++ ) {
+			ln.op[ o ] = ch->Op( o );
+			ln.op[ o ]->Prepare( this );
+			ln.waveBase[ o ] = ln.op[ o ]->waveBase;
+			ln.waveMask[ o ] = ln.op[ o ]->waveMask;
+		}
+		ln.old0 = ch->old[0];
+		ln.old1 = ch->old[1];
+		ln.fmMask = am ? 0 : -1;
+		ln.amMask = am ? -1 : 0;
+		ln.maskLeft = ch->maskLeft;
+		ln.maskRight = ch->maskRight;
+		ln.feedback = ch->feedback;
+	}
+
+	Bit32u index[ 18 ][ 2 ][ ENV_BLOCK ];
+	Bit32s mul[ 18 ][ 2 ][ ENV_BLOCK ];
+	for ( Bitu start = 0; start < samples; start += ENV_BLOCK ) {
+		const Bitu todo = ( samples - start > ENV_BLOCK ) ? ENV_BLOCK : samples - start;
+		for ( Bitu l = 0; l < active; l++ ) {
+			lane[ l ].op[ 0 ]->ForwardBlock( index[ l ][ 0 ], mul[ l ][ 0 ], todo );
+			lane[ l ].op[ 1 ]->ForwardBlock( index[ l ][ 1 ], mul[ l ][ 1 ], todo );
+		}
+		for ( Bitu j = 0; j < todo; j++ ) {
+			Bit32s left = 0, right = 0;
+			for ( Bitu l = 0; l < active; l++ ) {
+				Lane& ln = lane[ l ];
+				//Do unsigned shift so we can shift out all bits but still stay in 10 bit range otherwise
+				Bit32s mod = (Bit32u)((ln.old0 + ln.old1)) >> ln.feedback;
+				Bit32s out0 = ln.old1;
+				ln.old0 = out0;
+				ln.old1 = ( ln.waveBase[ 0 ][ ( index[ l ][ 0 ][ j ] + mod ) & ln.waveMask[ 0 ] ] * mul[ l ][ 0 ][ j ] ) >> MUL_SH;
+				Bit32s sample = ( ln.waveBase[ 1 ][ ( index[ l ][ 1 ][ j ] + ( out0 & ln.fmMask ) ) & ln.waveMask[ 1 ] ] * mul[ l ][ 1 ][ j ] ) >> MUL_SH;
+				sample += out0 & ln.amMask;
+				if ( opl3Mode ) {
+					left += sample & ln.maskLeft;
+					right += sample & ln.maskRight;
+				} else {
+					left += sample;
+				}
+			}
+			if ( opl3Mode ) {
+				output[ ( start + j ) * 2 + 0 ] += left;
+				output[ ( start + j ) * 2 + 1 ] += right;
+			} else {
+				output[ start + j ] += left;
+			}
+		}
+	}
+
+	for ( Bitu l = 0; l < active; l++ ) {
+		lane[ l ].ch->old[0] = lane[ l ].old0;
+		lane[ l ].ch->old[1] = lane[ l ].old1;
+	}
+#endif
+}
+
 void Chip::GenerateBlock2( Bitu total, Bit32s* output ) {
 	while ( total > 0 ) {
 		Bit32u samples = ForwardLFO( total );
 		memset(output, 0, sizeof(Bit32s) * samples);
-		int count = 0;
+		Channel* lanes[ 9 ];
+		Bitu laneCount = 0;
 		for( Channel* ch = chan; ch < chan + 9; ) {
-			count++;
+			if ( IsLaneChannel< false >( ch ) ) {
+				lanes[ laneCount++ ] = ch++;
+				continue;
+			}
 			ch = (ch->*(ch->synthHandler))( this, samples, output );
 		}
+		GenerateLanes< false >( lanes, laneCount, samples, output );
 		total -= samples;
 		output += samples;
 	}
@@ -1237,11 +1414,16 @@ void Chip::GenerateBlock3( Bitu total, Bit32s* output  ) {
 	while ( total > 0 ) {
 		Bit32u samples = ForwardLFO( total );
 		memset(output, 0, sizeof(Bit32s) * samples * 2);
-		int count = 0;
+		Channel* lanes[ 18 ];
+		Bitu laneCount = 0;
 		for( Channel* ch = chan; ch < chan + 18; ) {
-			count++;
+			if ( IsLaneChannel< true >( ch ) ) {
+				lanes[ laneCount++ ] = ch++;
+				continue;
+			}
 			ch = (ch->*(ch->synthHandler))( this, samples, output );
 		}
+		GenerateLanes< true >( lanes, laneCount, samples, output );
 		total -= samples;
 		output += samples * 2;
 	}
@@ -171,10 +171,16 @@ public:
 
 	template< State state>
 	Bits TemplateVolume( );
+	//Run the envelope for at most count samples while staying in the same state
+	template< State state>
+	Bitu TemplateMulBlock( Bit32s* muls, Bitu count );
 
 	Bit32s RateForward( Bit32u add );
 	Bitu ForwardWave();
 	Bitu ForwardVolume();
+	//Forward the envelope and wave counter for count samples, storing the
+	//wave positions and the volume multipliers for each of them
+	void ForwardBlock( Bit32u* index, Bit32s* muls, Bitu count );
 
 	Bits GetSample( Bits modulation );
 	Bits GetWave( Bitu index, Bitu vol );
@@ -263,6 +269,10 @@ struct Chip {
 
 	Bit32u WriteAddr( Bit32u port, Bit8u val );
 
+	//Generate 2 operator channels side by side, one sample of each at a time
+	template< bool opl3Mode >
+	void GenerateLanes( Channel** lanes, Bitu count, Bit32u samples, Bit32s* output );
+
 	void GenerateBlock2( Bitu samples, Bit32s* output );
 	void GenerateBlock3( Bitu samples, Bit32s* output );
 
@@ -32,11 +32,13 @@
 #include "common/textconsole.h"
 #include "common/translation.h"
 #include "common/util.h"
+#include "common/workerpool.h"
 #ifdef USE_RGB_COLOR
 #include "common/list.h"
 #endif
 #include "graphics/font.h"
 #include "graphics/fontman.h"
+#include "graphics/microtiles.h"
 #include "graphics/scaler.h"
 #include "graphics/scaler/aspect.h"
 #include "graphics/surface.h"
@@ -129,7 +131,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #endif
 	_overlayVisible(false),
 	_overlayscreen(0), _tmpscreen2(0),
-	_scalerProc(0), _screenChangeCount(0),
+	_scalerProc(0), _scalerPool(0), _scalerThreads(1), _screenChangeCount(0),
 	_mouseVisible(false), _mouseNeedsRedraw(false), _mouseData(0), _mouseSurface(0),
 	_mouseOrigSurface(0), _cursorDontScale(false), _cursorPaletteDisabled(true),
 	_currentShakePos(0), _newShakePos(0),
@@ -190,6 +192,9 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #else
 	_videoMode.fullscreen = true;
 #endif
+
+	if (ConfMan.hasKey("scaler_threads"))
+		_scalerThreads = ConfMan.getInt("scaler_threads");
 }
 
 SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
@@ -206,6 +211,8 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 	_mouseOrigSurface = 0;
 	g_system->deleteMutex(_graphicsMutex);
 
+	delete _scalerPool;
+
 	free(_currentPalette);
 	free(_cursorPalette);
 	free(_mouseData);
@@ -1047,6 +1054,11 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	if (_mouseNeedsRedraw)
 		undrawMouse();
 
+	// Merge the dirty rects, so that small neighbouring ones are scaled as
+	// one and none of them overlap
+	if (!_forceFull && _numDirtyRects > 1)
+		coalesceDirtyRects();
+
 	// Force a full redraw if requested
 	if (_forceFull) {
 		_numDirtyRects = 1;
@@ -1078,6 +1090,27 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		srcPitch = srcSurf->pitch;
 		dstPitch = _hwscreen->pitch;
 
+		const bool aspectCorrection = _videoMode.aspectRatioCorrection && !_overlayVisible;
+
+		// The scaler only writes to the area of the rect it is run on, so
+		// unless the dirty rects overlap, all of them can be scaled at once.
+		// The same goes for the aspect ratio correction.
+		bool rectsOverlap = false;
+		if (_scalerThreads > 1 || aspectCorrection) {
+			for (r = _dirtyRectList; r != lastRect && !rectsOverlap; ++r) {
+				for (SDL_Rect *r2 = _dirtyRectList; r2 != r; ++r2) {
+					if (r->x < r2->x + r2->w && r2->x < r->x + r->w &&
+					    r->y < r2->y + r2->h && r2->y < r->y + r->h) {
+						rectsOverlap = true;
+						break;
+					}
+				}
+			}
+		}
+
+		int origDstY[NUM_DIRTY_RECT];
+
+		_scalerJobs.clear();
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			register int dst_y = r->y + _currentShakePos;
 			register int dst_h = 0;
@@ -1092,24 +1125,45 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 				orig_dst_y = dst_y;
 				dst_y = dst_y * scale1;
 
-				if (_videoMode.aspectRatioCorrection && !_overlayVisible)
+				if (aspectCorrection)
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				queueScalerJobs(scalerProc, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h, scale1);
 			}
 
+			origDstY[r - _dirtyRectList] = orig_dst_y;
+
 			r->x = rx1;
 			r->y = dst_y;
 			r->w = r->w * scale1;
 			r->h = dst_h * scale1;
 
 #ifdef USE_SCALERS
-			if (_videoMode.aspectRatioCorrection && orig_dst_y < height && !_overlayVisible)
-				r->h = stretch200To240((uint8 *) _hwscreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1);
+			// Stretching an overlapping rect would mess up the unstretched
+			// rows of the others, so each one is stretched right away.
+			if (aspectCorrection && rectsOverlap) {
+				runScalerJobs(true);
+				_scalerJobs.clear();
+
+				if (orig_dst_y < height)
+					r->h = stretch200To240((uint8 *) _hwscreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1);
+			}
 #endif
 		}
+
+		runScalerJobs(rectsOverlap);
+
+#ifdef USE_SCALERS
+		if (aspectCorrection && !rectsOverlap) {
+			for (r = _dirtyRectList; r != lastRect; ++r) {
+				const int orig_dst_y = origDstY[r - _dirtyRectList];
+				if (orig_dst_y < height)
+					r->h = stretch200To240((uint8 *) _hwscreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1);
+			}
+		}
+#endif
 		SDL_UnlockSurface(srcSurf);
 		SDL_UnlockSurface(_hwscreen);
 
@@ -1211,6 +1265,53 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	_mouseNeedsRedraw = false;
 }
 
+void SurfaceSdlGraphicsManager::queueScalerJobs(ScalerProc *proc, const byte *src, uint32 srcPitch, byte *dst, uint32 dstPitch, int width, int height, int scale) {
+	// Split large rects into bands of rows, so that every thread gets a
+	// share of them. The scalers look at the rows around the ones they
+	// scale, which are still there in the source, so the bands match up.
+	// DotMatrix repeats every two source rows, hence the even band height.
+	int bandHeight = height;
+	if (_scalerThreads > 1 && height >= 2 * kMinScalerBandHeight) {
+		bandHeight = MAX<int>(kMinScalerBandHeight, (height + _scalerThreads - 1) / _scalerThreads);
+		bandHeight = (bandHeight + 1) & ~1;
+	}
+
+	for (int y = 0; y < height; y += bandHeight) {
+		ScalerJob job;
+		job.proc = proc;
+		job.src = src + y * srcPitch;
+		job.srcPitch = srcPitch;
+		job.dst = dst + y * scale * dstPitch;
+		job.dstPitch = dstPitch;
+		job.width = width;
+		job.height = MIN(bandHeight, height - y);
+		_scalerJobs.push_back(job);
+	}
+}
+
+void SurfaceSdlGraphicsManager::runScalerJobs(bool rectsOverlap) {
+	if (_scalerThreads > 1 && !_scalerPool) {
+		_scalerPool = g_system->createWorkerPool(_scalerThreads);
+		if (!_scalerPool) {
+			warning("Threads are not supported, scaling on a single thread");
+			_scalerThreads = 1;
+		}
+	}
+
+	// Overlapping rects are scaled in order, so that the last one wins
+	if (!_scalerPool || rectsOverlap || _scalerJobs.size() < 2) {
+		for (uint i = 0; i < _scalerJobs.size(); ++i)
+			runScalerJob(this, i);
+	} else {
+		_scalerPool->runJobs(runScalerJob, this, _scalerJobs.size());
+	}
+}
+
+void SurfaceSdlGraphicsManager::runScalerJob(void *param, uint job) {
+	const ScalerJob &j = ((SurfaceSdlGraphicsManager *)param)->_scalerJobs[job];
+	j.proc(j.src, j.srcPitch, j.dst, j.dstPitch, j.width, j.height);
+}
+
 bool SurfaceSdlGraphicsManager::saveScreenshot(const char *filename) {
 	assert(_hwscreen != NULL);
 
@@ -1350,8 +1451,9 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 		return;
 
 	if (_numDirtyRects == NUM_DIRTY_RECT) {
-		_forceFull = true;
-		return;
+		coalesceDirtyRects();
+		if (_forceFull)
+			return;
 	}
 
 	int height, width;
@@ -1413,6 +1515,80 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	}
 }
 
+#ifdef USE_SCALERS
+static void stretchableRect(Common::Rect &rect) {
+	int x = rect.left, y = rect.top, w = rect.width(), h = rect.height();
+	makeRectStretchable(x, y, w, h);
+	rect = Common::Rect(x, y, x + w, y + h);
+}
+#endif
+
+void SurfaceSdlGraphicsManager::coalesceDirtyRects() {
+	int width, height;
+	if (!_overlayVisible) {
+		width = _videoMode.screenWidth;
+		height = _videoMode.screenHeight;
+	} else {
+		width = _videoMode.overlayWidth;
+		height = _videoMode.overlayHeight;
+	}
+
+	// Rects in real coordinates may be on the overlay while the game
+	// screen is shown, so leave room for both
+	Graphics::MicroTileArray tiles(MAX(_videoMode.screenWidth, _videoMode.overlayWidth), MAX(_videoMode.screenHeight, _videoMode.overlayHeight));
+	for (int i = 0; i < _numDirtyRects; ++i) {
+		const SDL_Rect &r = _dirtyRectList[i];
+		tiles.addRect(Common::Rect(r.x, r.y, r.x + r.w, r.y + r.h));
+	}
+
+	// Leave room for more rects, so that this is not needed again for the
+	// next one already
+	Graphics::RectangleList rects;
+	tiles.getRectangles(rects, kDirtyRectMergeCost, NUM_DIRTY_RECT / 2);
+
+	Common::Array<Common::Rect> work;
+	for (Graphics::RectangleList::const_iterator i = rects.begin(); i != rects.end(); ++i)
+		work.push_back(*i);
+
+#ifdef USE_SCALERS
+	// The tiles split the rects at arbitrary lines, so they have to be made
+	// stretchable again. This can make neighbours overlap, and the scaler
+	// jobs and the aspect ratio correction need disjoint rects, so merge
+	// those until none are left.
+	if (_videoMode.aspectRatioCorrection && !_overlayVisible) {
+		for (uint i = 0; i < work.size(); ++i)
+			stretchableRect(work[i]);
+
+		for (uint i = 0; i < work.size(); ++i) {
+			for (uint j = 0; j < work.size(); ++j) {
+				if (j != i && work[i].intersects(work[j])) {
+					work[i].extend(work[j]);
+					work.remove_at(j);
+					if (j < i)
+						--i;
+					stretchableRect(work[i]);
+					j = (uint)-1;
+				}
+			}
+		}
+	}
+#endif
+
+	_numDirtyRects = 0;
+	for (uint i = 0; i < work.size(); ++i) {
+		if (work[i].width() >= width && work[i].height() >= height) {
+			_forceFull = true;
+			return;
+		}
+
+		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+		r->x = work[i].left;
+		r->y = work[i].top;
+		r->w = work[i].width();
+		r->h = work[i].height();
+	}
+}
+
 int16 SurfaceSdlGraphicsManager::getHeight() {
 	return _videoMode.screenHeight;
 }
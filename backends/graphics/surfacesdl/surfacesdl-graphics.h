@@ -27,6 +27,7 @@
 #include "backends/graphics/sdl/sdl-graphics.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
+#include "common/array.h"
 #include "common/events.h"
 #include "common/system.h"
 
@@ -34,6 +35,10 @@
 
 #include "backends/platform/sdl/sdl-sys.h"
 
+namespace Common {
+class WorkerPool;
+}
+
 #ifndef RELEASE_BUILD
 // Define this to allow for focus rectangle debugging
 #define USE_SDL_DEBUG_FOCUSRECT
@@ -232,6 +237,33 @@ protected:
 	int _scalerType;
 	int _transactionMode;
 
+	/**
+	 * One run of the scaler over a dirty rect, or over a band of rows of a
+	 * large one. See internUpdateScreen().
+	 */
+	struct ScalerJob {
+		ScalerProc *proc;
+		const byte *src;
+		uint32 srcPitch;
+		byte *dst;
+		uint32 dstPitch;
+		int width, height;
+	};
+	Common::Array<ScalerJob> _scalerJobs;
+
+	enum {
+		kMinScalerBandHeight = 16
+	};
+
+	/** Threads the scaler jobs are spread over, created on first use */
+	Common::WorkerPool *_scalerPool;
+	/** Number of threads to scale the screen with, from "scaler_threads" */
+	int _scalerThreads;
+
+	static void runScalerJob(void *param, uint job);
+	void queueScalerJobs(ScalerProc *proc, const byte *src, uint32 srcPitch, byte *dst, uint32 dstPitch, int width, int height, int scale);
+	void runScalerJobs(bool rectsOverlap);
+
 	// Indicates whether it is needed to free _hwsurface in destructor
 	bool _displayDisabled;
 
@@ -245,10 +277,25 @@ protected:
 		MAX_SCALING = 3
 	};
 
+	enum {
+		/**
+		 * The overhead of scaling and blitting one more dirty rect, in
+		 * the number of pixels which could be scaled in the same time.
+		 */
+		kDirtyRectMergeCost = 1024
+	};
+
 	// Dirty rect management
 	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
+	/**
+	 * Merge the dirty rects into fewer, larger and disjoint ones, forcing a
+	 * full redraw only when they cover the whole screen. This is done
+	 * before each update, and whenever the list is full.
+	 */
+	void coalesceDirtyRects();
+
 	struct MousePos {
 		// The mouse position, using either virtual (game) or real
 		// (overlay) coordinates.
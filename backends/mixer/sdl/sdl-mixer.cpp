@@ -29,6 +29,7 @@
 #include "common/system.h"
 #include "common/config-manager.h"
 #include "common/textconsole.h"
+#include "common/workerpool.h"
 
 #ifdef GP2X
 #define SAMPLES_PER_SEC 11025
@@ -40,6 +41,7 @@
 SdlMixerManager::SdlMixerManager()
 	:
 	_mixer(0),
+	_workerPool(0),
 	_audioSuspended(false) {
 
 }
@@ -50,6 +52,7 @@ SdlMixerManager::~SdlMixerManager() {
 	SDL_CloseAudio();
 
 	delete _mixer;
+	delete _workerPool;
 }
 
 void SdlMixerManager::init() {
@@ -95,6 +98,12 @@ void SdlMixerManager::init() {
 		assert(_mixer);
 		_mixer->setReady(true);
 
+		// Optionally mix the channels on several threads
+		if (ConfMan.hasKey("mixer_threads") && ConfMan.getInt("mixer_threads") > 1) {
+			_workerPool = g_system->createWorkerPool(ConfMan.getInt("mixer_threads"));
+			_mixer->setWorkerPool(_workerPool);
+		}
+
 		startAudio();
 	}
 }
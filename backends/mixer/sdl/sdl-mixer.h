@@ -63,6 +63,9 @@ protected:
 	/** The mixer implementation */
 	Audio::MixerImpl *_mixer;
 
+	/** Threads used for mixing, if enabled by the "mixer_threads" setting */
+	Common::WorkerPool *_workerPool;
+
 	/**
 	 * The obtained audio specification after opening the
 	 * audio system.
@@ -69,7 +69,8 @@ MODULE_OBJS += \
 	mixer/sdl/sdl-mixer.o \
 	mutex/sdl/sdl-mutex.o \
 	plugins/sdl/sdl-provider.o \
-	timer/sdl/sdl-timer.o
+	timer/sdl/sdl-timer.o \
+	workerpool/sdl/sdl-workerpool.o
 
 # SDL 1.3 removed audio CD support
 ifndef USE_SDL13
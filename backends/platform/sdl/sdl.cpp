@@ -46,6 +46,7 @@
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/mutex/sdl/sdl-mutex.h"
 #include "backends/timer/sdl/sdl-timer.h"
+#include "backends/workerpool/sdl/sdl-workerpool.h"
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
 #ifdef USE_OPENGL
 #include "backends/graphics/openglsdl/openglsdl-graphics.h"
@@ -532,6 +533,12 @@ Common::TimerManager *OSystem_SDL::getTimerManager() {
 #endif
 }
 
+Common::WorkerPool *OSystem_SDL::createWorkerPool(uint numThreads) {
+	if (numThreads < 2)
+		return 0;
+	return new SdlWorkerPool(numThreads);
+}
+
 #ifdef USE_OPENGL
 
 const OSystem::GraphicsMode *OSystem_SDL::getSupportedGraphicsModes() const {
@@ -73,6 +73,7 @@ public:
 	virtual void getTimeAndDate(TimeDate &td) const;
 	virtual Audio::Mixer *getMixer();
 	virtual Common::TimerManager *getTimerManager();
+	virtual Common::WorkerPool *createWorkerPool(uint numThreads);
 
 protected:
 	bool _inited;
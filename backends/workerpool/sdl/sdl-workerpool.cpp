@@ -0,0 +1,112 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/workerpool/sdl/sdl-workerpool.h"
+#include "common/util.h"
+
+SdlWorkerPool::SdlWorkerPool(uint numThreads)
+	:
+	_numThreads(0), _shouldQuit(false), _proc(0), _param(0),
+	_numJobs(0), _nextJob(0), _pendingJobs(0) {
+
+	_mutex = SDL_CreateMutex();
+	_workCond = SDL_CreateCond();
+	_doneCond = SDL_CreateCond();
+
+	numThreads = CLIP<uint>(numThreads, 1, kMaxThreads + 1);
+	while (_numThreads < numThreads - 1) {
+		_threads[_numThreads] = SDL_CreateThread(workerThreadEntry, this);
+		if (!_threads[_numThreads])
+			break;
+		_numThreads++;
+	}
+}
+
+SdlWorkerPool::~SdlWorkerPool() {
+	SDL_LockMutex(_mutex);
+	_shouldQuit = true;
+	SDL_CondBroadcast(_workCond);
+	SDL_UnlockMutex(_mutex);
+
+	for (uint i = 0; i < _numThreads; i++)
+		SDL_WaitThread(_threads[i], NULL);
+
+	SDL_DestroyCond(_doneCond);
+	SDL_DestroyCond(_workCond);
+	SDL_DestroyMutex(_mutex);
+}
+
+void SdlWorkerPool::runJobs(JobProc proc, void *param, uint numJobs) {
+	SDL_LockMutex(_mutex);
+
+	_proc = proc;
+	_param = param;
+	_numJobs = numJobs;
+	_nextJob = 0;
+	_pendingJobs = numJobs;
+	SDL_CondBroadcast(_workCond);
+
+	// Help out until all jobs are taken, then wait for the workers
+	while (_nextJob < _numJobs) {
+		const uint job = _nextJob++;
+		SDL_UnlockMutex(_mutex);
+		proc(param, job);
+		SDL_LockMutex(_mutex);
+		_pendingJobs--;
+	}
+
+	while (_pendingJobs)
+		SDL_CondWait(_doneCond, _mutex);
+
+	SDL_UnlockMutex(_mutex);
+}
+
+void SdlWorkerPool::workerThread() {
+	SDL_LockMutex(_mutex);
+	while (!_shouldQuit) {
+		if (_nextJob < _numJobs) {
+			const uint job = _nextJob++;
+			SDL_UnlockMutex(_mutex);
+			_proc(_param, job);
+			SDL_LockMutex(_mutex);
+
+			if (--_pendingJobs == 0)
+				SDL_CondSignal(_doneCond);
+		} else {
+			SDL_CondWait(_workCond, _mutex);
+		}
+	}
+	SDL_UnlockMutex(_mutex);
+}
+
+int SDLCALL SdlWorkerPool::workerThreadEntry(void *arg) {
+	SdlWorkerPool *pool = (SdlWorkerPool *)arg;
+	assert(pool);
+	pool->workerThread();
+	return 0;
+}
+
+#endif
@@ -0,0 +1,62 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_WORKERPOOL_SDL_H
+#define BACKENDS_WORKERPOOL_SDL_H
+
+#include "backends/platform/sdl/sdl-sys.h"
+#include "common/workerpool.h"
+
+/**
+ * Worker pool based on SDL threads. The thread calling runJobs() takes part
+ * in the work, so numThreads - 1 helper threads are created.
+ */
+class SdlWorkerPool : public Common::WorkerPool {
+public:
+	SdlWorkerPool(uint numThreads);
+	virtual ~SdlWorkerPool();
+
+	virtual void runJobs(JobProc proc, void *param, uint numJobs);
+
+private:
+	enum {
+		kMaxThreads = 8
+	};
+
+	SDL_mutex *_mutex;
+	SDL_cond *_workCond;
+	SDL_cond *_doneCond;
+	SDL_Thread *_threads[kMaxThreads];
+	uint _numThreads;
+	bool _shouldQuit;
+
+	JobProc _proc;
+	void *_param;
+	uint _numJobs;
+	uint _nextJob;
+	uint _pendingJobs;
+
+	void workerThread();
+	static int SDLCALL workerThreadEntry(void *arg);
+};
+
+#endif
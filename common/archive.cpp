@@ -62,6 +62,58 @@ int Archive::listMatchingMembers(ArchiveMemberList &list, const String &pattern)
 
 
 
+// Counts the changes of all SearchSets, so that a larger stamp is always a
+// later change, see SearchSet::_memberIndex
+static uint32 s_searchSetChanges = 0;
+
+// The list of all existing SearchSets, linked through _nextSearchSet
+static SearchSet *s_firstSearchSet = 0;
+
+SearchSet::SearchSet() : _memberIndexStamp(0), _memberIndexMutex(0), _changeStamp(++s_searchSetChanges) {
+	// Without a backend there are no other threads to guard against
+	if (g_system)
+		_memberIndexMutex = g_system->createMutex();
+
+	_nextSearchSet = s_firstSearchSet;
+	s_firstSearchSet = this;
+}
+
+SearchSet::~SearchSet() {
+	clear();
+
+	for (SearchSet **set = &s_firstSearchSet; *set; set = &(*set)->_nextSearchSet) {
+		if (*set == this) {
+			*set = _nextSearchSet;
+			break;
+		}
+	}
+
+	if (_memberIndexMutex)
+		g_system->deleteMutex(_memberIndexMutex);
+}
+
+void SearchSet::changed() {
+	_changeStamp = ++s_searchSetChanges;
+
+	// There is no RTTI, so nested sets are told apart by their address
+	_nestedSets.clear();
+	for (ArchiveNodeList::const_iterator it = _list.begin(); it != _list.end(); ++it) {
+		for (const SearchSet *set = s_firstSearchSet; set; set = set->_nextSearchSet) {
+			if (it->_arc == set) {
+				_nestedSets.push_back(set);
+				break;
+			}
+		}
+	}
+}
+
+uint32 SearchSet::getChangeStamp() const {
+	uint32 stamp = _changeStamp;
+	for (uint i = 0; i < _nestedSets.size(); ++i)
+		stamp = MAX(stamp, _nestedSets[i]->getChangeStamp());
+	return stamp;
+}
+
 SearchSet::ArchiveNodeList::iterator SearchSet::find(const String &name) {
 	ArchiveNodeList::iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
@@ -92,6 +144,7 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+	changed();
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
@@ -174,6 +227,7 @@ void SearchSet::remove(const String &name) {
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		changed();
 	}
 }
 
@@ -188,6 +242,7 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+	changed();
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -206,17 +261,66 @@ void SearchSet::setPriority(const String &name, int priority) {
 	insert(node);
 }
 
+void SearchSet::buildMemberIndex() const {
+	_memberIndex.clear();
+
+	for (ArchiveNodeList::const_iterator it = _list.begin(); it != _list.end(); ++it) {
+		ArchiveMemberList members;
+		it->_arc->listMembers(members);
+
+		for (ArchiveMemberList::const_iterator member = members.begin(); member != members.end(); ++member) {
+			const String name = (*member)->getName();
+			if (!_memberIndex.contains(name))
+				_memberIndex[name] = it->_arc;
+		}
+	}
+}
+
+Archive *SearchSet::findArchiveForMember(const String &name) const {
+	if (_memberIndexMutex)
+		g_system->lockMutex(_memberIndexMutex);
+
+	const uint32 stamp = getChangeStamp();
+	if (_memberIndexStamp != stamp) {
+		buildMemberIndex();
+		_memberIndexStamp = stamp;
+	}
+
+	MemberIndex::const_iterator indexed = _memberIndex.find(name);
+	const bool found = (indexed != _memberIndex.end());
+	Archive *arc = found ? indexed->_value : 0;
+
+	if (_memberIndexMutex)
+		g_system->unlockMutex(_memberIndexMutex);
+
+	if (found)
+		return arc;
+
+	// No archive lists the name, but one may still accept it
+	for (ArchiveNodeList::const_iterator it = _list.begin(); it != _list.end(); ++it) {
+		if (it->_arc->hasFile(name)) {
+			arc = it->_arc;
+			break;
+		}
+	}
+
+	if (_memberIndexMutex)
+		g_system->lockMutex(_memberIndexMutex);
+
+	if (_memberIndexStamp == stamp)
+		_memberIndex[name] = arc;
+
+	if (_memberIndexMutex)
+		g_system->unlockMutex(_memberIndexMutex);
+
+	return arc;
+}
+
 bool SearchSet::hasFile(const String &name) const {
 	if (name.empty())
 		return false;
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return true;
-	}
-
-	return false;
+	return findArchiveForMember(name) != 0;
 }
 
 int SearchSet::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
@@ -243,11 +347,9 @@ const ArchiveMemberPtr SearchSet::getMember(const String &name) const {
 	if (name.empty())
 		return ArchiveMemberPtr();
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return it->_arc->getMember(name);
-	}
+	Archive *arc = findArchiveForMember(name);
+	if (arc)
+		return arc->getMember(name);
 
 	return ArchiveMemberPtr();
 }
@@ -256,9 +358,21 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 	if (name.empty())
 		return 0;
 
+	Archive *arc = findArchiveForMember(name);
+	if (!arc)
+		return 0;
+
+	SeekableReadStream *stream = arc->createReadStreamForMember(name);
+	if (stream)
+		return stream;
+
+	// The archive has the member, but cannot open it; try the others then
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
-		SeekableReadStream *stream = it->_arc->createReadStreamForMember(name);
+		if (it->_arc == arc)
+			continue;
+
+		stream = it->_arc->createReadStreamForMember(name);
 		if (stream)
 			return stream;
 	}
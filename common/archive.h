@@ -25,6 +25,9 @@
 
 #include "common/str.h"
 #include "common/list.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/mutex.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
 
@@ -140,14 +143,49 @@ class SearchSet : public Archive {
 	typedef List<Node> ArchiveNodeList;
 	ArchiveNodeList _list;
 
+	/**
+	 * The merged index of the members of all archives, mapping each member
+	 * name to the first archive listing it, so that looking up a member is
+	 * a single hash lookup. Names which no archive lists, e.g. paths an
+	 * FSDirectory resolves itself, are looked up in the archives and then
+	 * added as well, mapped to 0 if no archive has them. Member names are
+	 * matched case-insensitively, like the archives do.
+	 *
+	 * The index is built on the first lookup after this set, or a set
+	 * nested in it, changed. Lookups may run on several threads at once,
+	 * hence the mutex; changing the set while looking up members is not
+	 * supported though.
+	 */
+	typedef HashMap<String, Archive *, IgnoreCase_Hash, IgnoreCase_EqualTo> MemberIndex;
+	mutable MemberIndex _memberIndex;
+	mutable uint32 _memberIndexStamp;
+	MutexRef _memberIndexMutex;
+
+	// When this set last changed, and the sets nested in it
+	uint32 _changeStamp;
+	Array<const SearchSet *> _nestedSets;
+
+	// All existing sets, to tell which archives are nested sets
+	SearchSet *_nextSearchSet;
+
+	void changed();
+	uint32 getChangeStamp() const;
+	void buildMemberIndex() const;
+	Archive *findArchiveForMember(const String &name) const;
+
 	ArchiveNodeList::iterator find(const String &name);
 	ArchiveNodeList::const_iterator find(const String &name) const;
 
 	// Add an archive keeping the list sorted by descending priority.
 	void insert(const Node& node);
 
+	// Copying would free the archives and the mutex twice
+	SearchSet(const SearchSet &);
+	SearchSet &operator=(const SearchSet &);
+
 public:
-	virtual ~SearchSet() { clear(); }
+	SearchSet();
+	virtual ~SearchSet();
 
 	/**
 	 * Add a new archive to the searchable set.
@@ -49,6 +49,7 @@ class TaskbarManager;
 class UpdateManager;
 #endif
 class TimerManager;
+class WorkerPool;
 class SeekableReadStream;
 class WriteStream;
 #ifdef ENABLE_KEYMAPPER
@@ -1014,6 +1015,20 @@ public:
 	 */
 	virtual void deleteMutex(MutexRef mutex) = 0;
 
+	/**
+	 * Create a pool of numThreads threads, counting the one which calls
+	 * Common::WorkerPool::runJobs(), for work which can be split into
+	 * independent jobs. The caller owns the returned pool.
+	 *
+	 * Unlike timers, the jobs of a pool may take a while without holding up
+	 * anything else, so this is the place for heavy work such as decoding or
+	 * scaling which should not delay the timer callbacks.
+	 *
+	 * @param numThreads	the number of threads to use, at least 2.
+	 * @return the new pool, or 0 if the backend does not support threads.
+	 */
+	virtual Common::WorkerPool *createWorkerPool(uint numThreads) { return 0; }
+
 	//@}
 
 
@@ -104,10 +104,14 @@ typedef struct {
 
 #include "common/fs.h"
 #include "common/unzip.h"
-#include "common/memstream.h"
+#include "common/bufferedstream.h"
+#include "common/array.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
+#include "common/noncopyable.h"
+#include "common/ptr.h"
+#include "common/system.h"
 
 #if defined(STRICTUNZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
@@ -329,6 +333,10 @@ int unzGetLocalExtrafield(unzFile file, voidp buf, unsigned len);
 #define UNZ_MAXFILENAMEINZIP (256)
 #endif
 
+#ifndef UNZ_CENTRALDIRBUFSIZE
+#define UNZ_CENTRALDIRBUFSIZE (65536)
+#endif
+
 #define SIZECENTRALDIRITEM (0x2e)
 #define SIZEZIPLOCALHEADER (0x1e)
 
@@ -375,10 +383,73 @@ typedef struct {
 typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_Hash,
 	Common::IgnoreCase_EqualTo> ZipHash;
 
+namespace Common {
+
+/**
+ * The stream of a ZIP archive, shared by the archive and the streams of its
+ * members. These may be used from different threads, e.g. a video decoding
+ * ahead from a timer, so everything seeking and reading in the stream has to
+ * hold the lock.
+ */
+class ZipSharedStream : NonCopyable {
+private:
+	SeekableReadStream *_stream;
+	OSystem::MutexRef _mutex;
+
+public:
+	ZipSharedStream(SeekableReadStream *stream) : _stream(stream), _mutex(0) {
+		if (g_system)
+			_mutex = g_system->createMutex();
+	}
+
+	~ZipSharedStream() {
+		delete _stream;
+		if (_mutex)
+			g_system->deleteMutex(_mutex);
+	}
+
+	SeekableReadStream *stream() const { return _stream; }
+
+	void lock() {
+		if (_mutex)
+			g_system->lockMutex(_mutex);
+	}
+
+	void unlock() {
+		if (_mutex)
+			g_system->unlockMutex(_mutex);
+	}
+
+	/**
+	 * Read from the given position of the stream, returning the number of
+	 * bytes read.
+	 */
+	uint32 readAt(uint32 offset, void *dataPtr, uint32 dataSize) {
+		lock();
+		uint32 result = 0;
+		if (_stream->seek(offset, SEEK_SET))
+			result = _stream->read(dataPtr, dataSize);
+		unlock();
+		return result;
+	}
+};
+
+class ZipSharedStreamLock : NonCopyable {
+private:
+	ZipSharedStream &_stream;
+
+public:
+	ZipSharedStreamLock(ZipSharedStream &stream) : _stream(stream) { _stream.lock(); }
+	~ZipSharedStreamLock() { _stream.unlock(); }
+};
+
+} // End of namespace Common
+
 /* unz_s contain internal information about the zipfile
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::ZipSharedStream> _sharedStream; /* owns _stream, shared with the member streams */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -541,6 +612,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	int err=UNZ_OK;
 
 	us->_stream = stream;
+	us->_sharedStream = Common::SharedPtr<Common::ZipSharedStream>(new Common::ZipSharedStream(stream));
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -592,7 +664,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return NULL;
 	}
@@ -602,13 +673,23 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	us->central_pos = central_pos;
 	us->pfile_in_zip_read = NULL;
 
+	// Walking the central directory results in lots of tiny reads, so read
+	// it through a buffer while building the hash.
+	Common::SeekableReadStream *zipStream = us->_stream;
+	us->_stream = Common::wrapBufferedSeekableReadStream(zipStream, UNZ_CENTRALDIRBUFSIZE, DisposeAfterUse::NO);
+
 	err = unzGoToFirstFile((unzFile)us);
 
 	while (err == UNZ_OK) {
-		// Get the file details
+		// Get the file name. The file details have already been read by
+		// unzGoToFirstFile/unzGoToNextFile, so the name is read directly
+		// instead of parsing the whole entry again.
 		char szCurrentFileName[UNZ_MAXFILENAMEINZIP+1];
-		unzGetCurrentFileInfo(us, NULL, szCurrentFileName, sizeof(szCurrentFileName) - 1,
-							NULL, 0, NULL, 0);
+		uLong uSizeRead = MIN<uLong>(us->cur_file_info.size_filename, UNZ_MAXFILENAMEINZIP);
+		us->_stream->seek(us->pos_in_central_dir + us->byte_before_the_zipfile + SIZECENTRALDIRITEM, SEEK_SET);
+		if (us->_stream->read(szCurrentFileName, uSizeRead) != uSizeRead)
+			break;
+		szCurrentFileName[uSizeRead] = '\0';
 
 		// Save details into the hash
 		cached_file_in_zip fe;
@@ -623,6 +704,10 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		// Move to the next file
 		err = unzGoToNextFile((unzFile)us);
 	}
+
+	delete us->_stream;
+	us->_stream = zipStream;
+
 	return (unzFile)us;
 }
 
@@ -641,7 +726,7 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
+	// Member streams which are still open keep the archive stream alive
 	delete s;
 	return UNZ_OK;
 }
@@ -1122,6 +1207,35 @@ int unzOpenCurrentFile (unzFile file) {
 }
 
 
+/*
+  Get the location of the data of the current file in the zipfile, without
+  opening it for reading.
+  *poffset receives the absolute offset of the (possibly compressed) data in
+  the underlying stream.
+  If there is no error, the return value is UNZ_OK.
+*/
+static int unzlocal_GetCurrentFileDataOffset(unzFile file, uLong *poffset) {
+	uInt iSizeVar;
+	unz_s* s;
+	uLong offset_local_extrafield;  /* offset of the local extra field */
+	uInt  size_local_extrafield;    /* size of the local extra field */
+
+	if (file==NULL)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+	if (!s->current_file_ok)
+		return UNZ_PARAMERROR;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s,&iSizeVar,
+				&offset_local_extrafield,&size_local_extrafield)!=UNZ_OK)
+		return UNZ_BADZIPFILE;
+
+	*poffset = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER +
+		iSizeVar + s->byte_before_the_zipfile;
+	return UNZ_OK;
+}
+
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -1416,6 +1530,311 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 
 namespace Common {
 
+/**
+ * A seekable stream reading a single stored member of a ZIP archive.
+ *
+ * Like ZipInflateReadStream, it reads from the shared archive stream at its
+ * own position. When zlib is linked in, the checksum of the member is
+ * verified once it has been read from the start to the end in one go.
+ */
+class ZipStoredReadStream : public SeekableReadStream {
+private:
+	SharedPtr<ZipSharedStream> _parent;
+	const uint32 _dataStart;
+	const uint32 _size;
+	const uint32 _crcWait;
+
+	uint32 _pos;
+	uint32 _crc;
+	bool _crcValid;
+	bool _eos;
+	bool _err;
+
+public:
+	ZipStoredReadStream(const SharedPtr<ZipSharedStream> &parent, uint32 dataStart, uint32 size, uint32 crc)
+		: _parent(parent), _dataStart(dataStart), _size(size), _crcWait(crc),
+		  _pos(0), _crc(0), _crcValid(true), _eos(false), _err(false) {
+		assert(parent);
+	}
+
+	bool err() const { return _err; }
+	void clearErr() {
+		// only reset _eos; I/O errors are not recoverable
+		_eos = false;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		if (_pos + dataSize > _size) {
+			dataSize = _size - _pos;
+			_eos = true;
+		}
+
+		const uint32 readSize = _parent->readAt(_dataStart + _pos, dataPtr, dataSize);
+		if (readSize < dataSize) {
+			warning("ZipStoredReadStream: Truncated member");
+			_err = true;
+			_eos = true;
+		}
+
+#ifdef USE_ZLIB
+		if (_crcValid)
+			_crc = crc32(_crc, (const byte *)dataPtr, readSize);
+#endif
+
+		_pos += readSize;
+
+#ifdef USE_ZLIB
+		if (_crcValid && _pos == _size && _crc != _crcWait) {
+			warning("ZipStoredReadStream: CRC mismatch");
+			_crcValid = false;
+			_err = true;
+		}
+#endif
+
+		return readSize;
+	}
+
+	bool eos() const { return _eos; }
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		int32 newPos = 0;
+		switch (whence) {
+		case SEEK_SET:
+			newPos = offset;
+			break;
+		case SEEK_CUR:
+			newPos = _pos + offset;
+			break;
+		case SEEK_END:
+			newPos = _size + offset;
+			break;
+		}
+
+		if (newPos < 0 || (uint32)newPos > _size)
+			return false;
+
+		// Skipped data is not checksummed, and neither is data read twice
+		if ((uint32)newPos != _pos)
+			_crcValid = false;
+
+		_pos = newPos;
+		_eos = false;
+		return true;
+	}
+};
+
+#ifdef USE_ZLIB
+
+/**
+ * A seekable stream which inflates a single deflated member of a ZIP archive
+ * on the fly.
+ *
+ * Every instance has its own zlib state and input buffer, and only ever
+ * touches the (shared) archive stream from within read(), where it seeks to
+ * its own position first with the stream locked. Thus several members of
+ * the same archive may be open and used at the same time, also from
+ * different threads, though each single member stream only from one thread
+ * at a time. The archive stream is reference counted, so members may also
+ * outlive their archive.
+ *
+ * While inflating, a snapshot of the zlib state is taken every
+ * kSeekPointInterval bytes of output. Seeking backwards then resumes from
+ * the closest snapshot instead of restarting the decompression from the
+ * start of the member.
+ */
+class ZipInflateReadStream : public SeekableReadStream {
+private:
+	enum {
+		BUFSIZE = 16384,		// 1 << MAX_WBITS
+		kSeekPointInterval = 512 * 1024
+	};
+
+	struct SeekPoint {
+		uint32 outPos;		///< uncompressed position of the snapshot
+		uint32 inPos;		///< compressed bytes consumed at the snapshot
+		z_stream state;
+	};
+
+	byte _buf[BUFSIZE];
+
+	SharedPtr<ZipSharedStream> _parent;
+	const uint32 _dataStart;
+	const uint32 _compressedSize;
+	const uint32 _uncompressedSize;
+	const uint32 _crcWait;
+
+	z_stream _stream;
+	int _zlibErr;
+	uint32 _inPos;
+	uint32 _pos;
+	uint32 _crc;
+	bool _crcValid;
+	bool _eos;
+
+	Array<SeekPoint *> _seekPoints;
+
+	void addSeekPoint() {
+		SeekPoint *point = new SeekPoint();
+		point->outPos = _pos;
+		point->inPos = _inPos - _stream.avail_in;
+		if (inflateCopy(&point->state, &_stream) != Z_OK) {
+			delete point;
+			return;
+		}
+		_seekPoints.push_back(point);
+	}
+
+	bool restart(const SeekPoint *point) {
+		inflateEnd(&_stream);
+		memset(&_stream, 0, sizeof(_stream));
+
+		if (point) {
+			_zlibErr = inflateCopy(&_stream, const_cast<z_stream *>(&point->state));
+			_inPos = point->inPos;
+			_pos = point->outPos;
+		} else {
+			_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+			_inPos = 0;
+			_pos = 0;
+		}
+
+		// Data is no longer read in one go from the start, so the checksum
+		// cannot be verified anymore.
+		_crcValid = false;
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		return _zlibErr == Z_OK;
+	}
+
+public:
+	ZipInflateReadStream(const SharedPtr<ZipSharedStream> &parent, uint32 dataStart, uint32 compressedSize, uint32 uncompressedSize, uint32 crc)
+		: _parent(parent), _dataStart(dataStart), _compressedSize(compressedSize),
+		  _uncompressedSize(uncompressedSize), _crcWait(crc), _stream(),
+		  _inPos(0), _pos(0), _crc(0), _crcValid(true), _eos(false) {
+		assert(parent);
+
+		// Negative MAX_WBITS tells zlib there's no zlib header
+		_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+	}
+
+	~ZipInflateReadStream() {
+		for (uint i = 0; i < _seekPoints.size(); ++i) {
+			inflateEnd(&_seekPoints[i]->state);
+			delete _seekPoints[i];
+		}
+
+		inflateEnd(&_stream);
+	}
+
+	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
+	void clearErr() {
+		// only reset _eos; I/O errors are not recoverable
+		_eos = false;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		if (_pos + dataSize > _uncompressedSize) {
+			dataSize = _uncompressedSize - _pos;
+			_eos = true;
+		}
+
+		_stream.next_out = (byte *)dataPtr;
+		_stream.avail_out = dataSize;
+
+		while (_zlibErr == Z_OK && _stream.avail_out) {
+			if (_stream.avail_in == 0) {
+				// If we are out of input data: Read more data, if available.
+				uint32 readSize = MIN<uint32>(BUFSIZE, _compressedSize - _inPos);
+				if (readSize > 0) {
+					readSize = _parent->readAt(_dataStart + _inPos, _buf, readSize);
+					if (readSize == 0) {
+						_zlibErr = Z_ERRNO;
+						break;
+					}
+				}
+				_inPos += readSize;
+				_stream.next_in = _buf;
+				_stream.avail_in = readSize;
+			}
+
+			byte *outBefore = _stream.next_out;
+			_zlibErr = inflate(&_stream, Z_SYNC_FLUSH);
+
+			const uint32 produced = _stream.next_out - outBefore;
+			if (_crcValid)
+				_crc = crc32(_crc, outBefore, produced);
+
+			const uint32 oldPos = _pos;
+			_pos += produced;
+
+			if (_pos / kSeekPointInterval != oldPos / kSeekPointInterval && _zlibErr == Z_OK &&
+			    (_seekPoints.empty() || _seekPoints.back()->outPos < _pos))
+				addSeekPoint();
+		}
+
+		if (_crcValid && _pos == _uncompressedSize && _crc != _crcWait) {
+			warning("ZipInflateReadStream: CRC mismatch");
+			_crcValid = false;
+		}
+
+		if (_stream.avail_out > 0)
+			_eos = true;
+
+		return dataSize - _stream.avail_out;
+	}
+
+	bool eos() const { return _eos; }
+	int32 pos() const { return _pos; }
+	int32 size() const { return _uncompressedSize; }
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		int32 newPos = 0;
+		switch (whence) {
+		case SEEK_SET:
+			newPos = offset;
+			break;
+		case SEEK_CUR:
+			newPos = _pos + offset;
+			break;
+		case SEEK_END:
+			newPos = _uncompressedSize + offset;
+			break;
+		}
+
+		if (newPos < 0 || (uint32)newPos > _uncompressedSize)
+			return false;
+
+		// Find the closest snapshot at or before the target
+		const SeekPoint *point = 0;
+		for (uint i = 0; i < _seekPoints.size() && _seekPoints[i]->outPos <= (uint32)newPos; ++i)
+			point = _seekPoints[i];
+
+		if ((uint32)newPos < _pos || (point && point->outPos > _pos)) {
+			if (!restart(point))
+				return false;
+		}
+
+		// Skip the remaining data by decompressing it
+		byte tmpBuf[1024];
+		uint32 skip = newPos - _pos;
+		while (!err() && skip > 0) {
+			const uint32 skipped = read(tmpBuf, MIN<uint32>(sizeof(tmpBuf), skip));
+			if (!skipped)
+				break;
+			skip -= skipped;
+		}
+
+		_eos = false;
+		return skip == 0;
+	}
+};
+
+#endif // USE_ZLIB
 
 class ZipArchive : public Archive {
 	unzFile _zipFile;
@@ -1459,6 +1878,7 @@ ZipArchive::~ZipArchive() {
 }
 
 bool ZipArchive::hasFile(const String &name) const {
+	ZipSharedStreamLock lock(*((const unz_s *)_zipFile)->_sharedStream);
 	return (unzLocateFile(_zipFile, name.c_str(), 2) == UNZ_OK);
 }
 
@@ -1483,35 +1903,32 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 }
 
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
-	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
-		return 0;
-
-	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
-		return 0;
+	// Looking up the member changes the state of the archive, and reads
+	// from its stream
+	ZipSharedStreamLock lock(*((const unz_s *)_zipFile)->_sharedStream);
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
-
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
+	uLong dataOffset;
+	if (unzlocal_GetCurrentFileDataOffset(_zipFile, &dataOffset) != UNZ_OK)
 		return 0;
-	}
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
-		return 0;
-	}
+	// The returned streams share the archive stream, which stays open until
+	// both this archive and all of them are gone.
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	const unz_file_info &fileInfo = archive->cur_file_info;
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+	if (fileInfo.compression_method == 0)
+		return new ZipStoredReadStream(archive->_sharedStream, dataOffset, fileInfo.uncompressed_size, fileInfo.crc);
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+#ifdef USE_ZLIB
+	return new ZipInflateReadStream(archive->_sharedStream, dataOffset, fileInfo.compressed_size,
+	                                fileInfo.uncompressed_size, fileInfo.crc);
+#else
+	// Cannot decompress the file without zlib.
+	return 0;
+#endif
 }
 
 Archive *makeZipArchive(const String &name) {
@@ -0,0 +1,58 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_WORKERPOOL_H
+#define COMMON_WORKERPOOL_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * A pool of threads on which independent jobs can be run in parallel.
+ * Backends which support threads provide them through
+ * OSystem::createWorkerPool(). Users include the audio mixer, which mixes
+ * several channels in parallel, the scalers of the SDL backend and some
+ * video decoders.
+ */
+class WorkerPool : NonCopyable {
+public:
+	typedef void (*JobProc)(void *param, uint job);
+
+	virtual ~WorkerPool() {}
+
+	/**
+	 * Runs proc(param, 0) up to proc(param, numJobs - 1), in any order and
+	 * possibly in parallel, and returns once all of them have finished.
+	 * The calling thread may run some of the jobs itself.
+	 *
+	 * A pool can only run one batch of jobs at a time, so this must not be
+	 * called again from one of the jobs, or from another thread while a
+	 * batch is running.
+	 */
+	virtual void runJobs(JobProc proc, void *param, uint numJobs) = 0;
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,181 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef DEVTOOLS_BENCHMARK_H
+#define DEVTOOLS_BENCHMARK_H
+
+// The parts shared by the *_benchmark tools. Each tool is built from a
+// single source file, so everything here is defined in the header.
+//
+// Include this after FORBIDDEN_SYMBOL_ALLOW_ALL has been defined.
+
+#include "common/system.h"
+
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(POSIX)
+#include <sys/time.h>
+#endif
+
+namespace Benchmark {
+
+/**
+ * Minimal OSystem, just enough for the code being measured to run. The
+ * time is frozen, which makes the output of emulators and decoders
+ * reproducible; use Timer to measure the time instead.
+ */
+class System : public OSystem {
+public:
+	const GraphicsMode *getSupportedGraphicsModes() const {
+		static const GraphicsMode noModes[] = { { 0, 0, 0 } };
+		return noModes;
+	}
+	int getDefaultGraphicsMode() const { return 0; }
+	bool setGraphicsMode(int mode) { return false; }
+	int getGraphicsMode() const { return 0; }
+	Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	int16 getHeight() { return 0; }
+	int16 getWidth() { return 0; }
+	PaletteManager *getPaletteManager() { return 0; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	Graphics::Surface *lockScreen() { return 0; }
+	void unlockScreen() {}
+	void fillScreen(uint32 col) {}
+	void updateScreen() {}
+	void setShakePos(int shakeOffset) {}
+	void showOverlay() {}
+	void hideOverlay() {}
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	void clearOverlay() {}
+	void grabOverlay(void *buf, int pitch) {}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	int16 getOverlayHeight() { return 0; }
+	int16 getOverlayWidth() { return 0; }
+	bool showMouse(bool visible) { return false; }
+	void warpMouse(int x, int y) {}
+	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+	uint32 getMillis(bool skipRecord) { return 0; }
+	void delayMillis(uint msecs) {}
+	void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+	MutexRef createMutex() { return 0; }
+	void lockMutex(MutexRef mutex) {}
+	void unlockMutex(MutexRef mutex) {}
+	void deleteMutex(MutexRef mutex) {}
+	Audio::Mixer *getMixer() { return 0; }
+	void quit() {}
+	void displayMessageOnOSD(const char *msg) {}
+	void logMessage(LogMessageType::Type type, const char *message) { fputs(message, stderr); }
+};
+
+/**
+ * Measures the wall clock time since it was created or last restarted.
+ * Where no high resolution clock is known, the processor time is used,
+ * which does not include the time spent in other threads.
+ */
+class Timer {
+public:
+	Timer() { restart(); }
+
+	void restart() { _start = now(); }
+	double getSeconds() const { return now() - _start; }
+
+	/** @return the current time in seconds, relative to some fixed point */
+	static double now() {
+#if defined(WIN32)
+		LARGE_INTEGER frequency, counter;
+		if (QueryPerformanceFrequency(&frequency) && QueryPerformanceCounter(&counter))
+			return (double)counter.QuadPart / frequency.QuadPart;
+		return GetTickCount() / 1000.0;
+#elif defined(POSIX)
+		struct timeval tv;
+		gettimeofday(&tv, 0);
+		return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+		return (double)clock() / CLOCKS_PER_SEC;
+#endif
+	}
+
+private:
+	double _start;
+};
+
+/**
+ * Repeats a piece of work for at least a given time, counting how often it
+ * was done:
+ *
+ *   Benchmark::Loop loop(minSeconds);
+ *   do {
+ *       work();
+ *   } while (loop.next());
+ *
+ * next() may be passed the number of units, e.g. frames, a pass did.
+ */
+class Loop {
+public:
+	Loop(double minSeconds, long minCount = 1) : _minSeconds(minSeconds), _minCount(minCount), _count(0), _seconds(0.0) {}
+
+	/** Count the units of work done since the last call, and check whether to go on. */
+	bool next(long count = 1) {
+		_count += count;
+		_seconds = _timer.getSeconds();
+		return _seconds < _minSeconds || _count < _minCount;
+	}
+
+	long getCount() const { return _count; }
+	double getSeconds() const { return _seconds; }
+	double getPerSecond() const { return _seconds > 0.0 ? _count / _seconds : 0.0; }
+	double getMillisEach() const { return _count ? _seconds * 1000.0 / _count : 0.0; }
+
+private:
+	Timer _timer;
+	const double _minSeconds;
+	const long _minCount;
+	long _count;
+	double _seconds;
+};
+
+const uint32 kHashSeed = 2166136261U;
+
+/** FNV-1a over the visible pixels of a surface, continuing from hash. */
+inline uint32 hashSurface(const Graphics::Surface &surface, uint32 hash = kHashSeed) {
+	for (int y = 0; y < surface.h; ++y) {
+		const byte *row = (const byte *)surface.getBasePtr(0, y);
+		for (int x = 0; x < surface.w * surface.format.bytesPerPixel; ++x)
+			hash = (hash ^ row[x]) * 16777619;
+	}
+
+	return hash;
+}
+
+} // End of namespace Benchmark
+
+#endif
@@ -0,0 +1,550 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "common/array.h"
+#include "common/memstream.h"
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+#include "graphics/decoders/jpeg.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+const uint8 zigZagOrder[64] = {
+	 0,  1,  8, 16,  9,  2,  3, 10,
+	17, 24, 32, 25, 18, 11,  4,  5,
+	12, 19, 26, 33, 40, 48, 41, 34,
+	27, 20, 13,  6,  7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36,
+	29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46,
+	53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// The example tables from Annex K of the JPEG standard
+const uint8 lumaQuant[64] = {
+	16, 11, 10, 16,  24,  40,  51,  61,
+	12, 12, 14, 19,  26,  58,  60,  55,
+	14, 13, 16, 24,  40,  57,  69,  56,
+	14, 17, 22, 29,  51,  87,  80,  62,
+	18, 22, 37, 56,  68, 109, 103,  77,
+	24, 35, 55, 64,  81, 104, 113,  92,
+	49, 64, 78, 87, 103, 121, 120, 101,
+	72, 92, 95, 98, 112, 100, 103,  99
+};
+
+const uint8 chromaQuant[64] = {
+	17, 18, 24, 47, 99, 99, 99, 99,
+	18, 21, 26, 66, 99, 99, 99, 99,
+	24, 26, 56, 99, 99, 99, 99, 99,
+	47, 66, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99
+};
+
+const uint8 dcLumaBits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+const uint8 dcChromaBits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+const uint8 dcValues[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+const uint8 acLumaBits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D };
+const uint8 acLumaValues[162] = {
+	0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+	0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+	0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+	0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+	0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+	0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA
+};
+
+const uint8 acChromaBits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+const uint8 acChromaValues[162] = {
+	0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+	0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+	0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+	0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+	0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+	0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+	0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+	0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+	0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA
+};
+
+struct HuffmanCode {
+	uint16 code;
+	uint8 length;
+};
+
+/** A Huffman table in the form of a DHT segment, and the codes it assigns. */
+struct HuffmanTable {
+	const uint8 *bits;
+	const uint8 *values;
+	HuffmanCode codes[256];
+
+	HuffmanTable(const uint8 *b, const uint8 *v) : bits(b), values(v) {
+		memset(codes, 0, sizeof(codes));
+
+		uint16 code = 0;
+		int k = 0;
+		for (int length = 1; length <= 16; ++length) {
+			for (int i = 0; i < bits[length - 1]; ++i, ++k) {
+				codes[values[k]].code = code++;
+				codes[values[k]].length = length;
+			}
+			code <<= 1;
+		}
+	}
+
+	int count() const {
+		int n = 0;
+		for (int i = 0; i < 16; ++i)
+			n += bits[i];
+		return n;
+	}
+};
+
+/** Writes the entropy coded data, MSB first, with 0xFF bytes stuffed. */
+class BitWriter {
+public:
+	BitWriter(Common::Array<byte> &data) : _data(data), _value(0), _bits(0) {}
+
+	void putBits(uint32 value, int n) {
+		for (int i = n - 1; i >= 0; --i) {
+			_value = (_value << 1) | ((value >> i) & 1);
+			if (++_bits == 8)
+				flushByte();
+		}
+	}
+
+	void putCode(const HuffmanTable &table, uint8 symbol) {
+		const HuffmanCode &c = table.codes[symbol];
+		if (!c.length) {
+			fprintf(stderr, "Symbol %02X is missing from a Huffman table\n", symbol);
+			exit(1);
+		}
+		putBits(c.code, c.length);
+	}
+
+	/** Pad the last byte with 1 bits. */
+	void align() {
+		while (_bits)
+			putBits(1, 1);
+	}
+
+private:
+	void flushByte() {
+		_data.push_back(_value);
+		if (_value == 0xFF)
+			_data.push_back(0);
+		_value = 0;
+		_bits = 0;
+	}
+
+	Common::Array<byte> &_data;
+	uint32 _value;
+	int _bits;
+};
+
+void putUint16BE(Common::Array<byte> &data, uint16 value) {
+	data.push_back(value >> 8);
+	data.push_back(value & 0xFF);
+}
+
+void putMarker(Common::Array<byte> &data, byte marker) {
+	data.push_back(0xFF);
+	data.push_back(marker);
+}
+
+void putHuffmanTable(Common::Array<byte> &data, byte id, const HuffmanTable &table) {
+	putMarker(data, 0xC4);
+	putUint16BE(data, 2 + 1 + 16 + table.count());
+	data.push_back(id);
+	for (int i = 0; i < 16; ++i)
+		data.push_back(table.bits[i]);
+	for (int i = 0; i < table.count(); ++i)
+		data.push_back(table.values[i]);
+}
+
+/** The sizes of the size categories of the JPEG standard. */
+int bitLength(int value) {
+	if (value < 0)
+		value = -value;
+
+	int n = 0;
+	while (value) {
+		value >>= 1;
+		++n;
+	}
+	return n;
+}
+
+struct Plane {
+	int width, height;
+	Common::Array<uint8> pixels;
+
+	uint8 get(int x, int y) const {
+		return pixels[MIN(y, height - 1) * width + MIN(x, width - 1)];
+	}
+};
+
+/** Forward DCT and quantization of the 8x8 block at (x, y), in zig-zag order. */
+void transformBlock(const Plane &plane, int x, int y, const uint8 *quant, int *out) {
+	static double cosTable[8][8];
+	static bool init = false;
+	if (!init) {
+		for (int u = 0; u < 8; ++u)
+			for (int i = 0; i < 8; ++i)
+				cosTable[u][i] = cos((2 * i + 1) * u * M_PI / 16) * (u ? 0.5 : 0.5 / sqrt(2.0));
+		init = true;
+	}
+
+	double tmp[8][8];
+	for (int j = 0; j < 8; ++j) {
+		for (int u = 0; u < 8; ++u) {
+			double sum = 0.0;
+			for (int i = 0; i < 8; ++i)
+				sum += (plane.get(x + i, y + j) - 128) * cosTable[u][i];
+			tmp[j][u] = sum;
+		}
+	}
+
+	for (int v = 0; v < 8; ++v) {
+		for (int u = 0; u < 8; ++u) {
+			double sum = 0.0;
+			for (int j = 0; j < 8; ++j)
+				sum += tmp[j][u] * cosTable[v][j];
+
+			const int k = v * 8 + u;
+			out[k] = (int)floor(sum / quant[k] + 0.5);
+		}
+	}
+
+	int zigZag[64];
+	for (int i = 0; i < 64; ++i)
+		zigZag[i] = out[zigZagOrder[i]];
+	memcpy(out, zigZag, sizeof(zigZag));
+}
+
+void encodeBlock(BitWriter &bits, const int *block, int &predictor, const HuffmanTable &dc, const HuffmanTable &ac) {
+	const int diff = block[0] - predictor;
+	predictor = block[0];
+
+	int size = bitLength(diff);
+	bits.putCode(dc, size);
+	if (size)
+		bits.putBits(diff < 0 ? diff - 1 : diff, size);
+
+	int run = 0;
+	for (int i = 1; i < 64; ++i) {
+		if (!block[i]) {
+			++run;
+			continue;
+		}
+
+		while (run > 15) {
+			bits.putCode(ac, 0xF0);
+			run -= 16;
+		}
+
+		size = bitLength(block[i]);
+		bits.putCode(ac, (run << 4) | size);
+		bits.putBits(block[i] < 0 ? block[i] - 1 : block[i], size);
+		run = 0;
+	}
+
+	if (run)
+		bits.putCode(ac, 0x00);
+}
+
+/**
+ * Fill the image with something resembling a video frame: smooth
+ * gradients with some shapes and noise on top.
+ */
+void createTestImage(Plane *planes, int width, int height) {
+	srand(1);
+	for (int c = 0; c < 3; ++c) {
+		planes[c].width = width;
+		planes[c].height = height;
+		planes[c].pixels.resize(width * height);
+	}
+
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			int r = x * 255 / width;
+			int g = y * 255 / height;
+			int b = ((x / 40 + y / 40) & 1) ? 200 : 60;
+			const int noise = (rand() % 32) - 16;
+
+			r = CLIP(r + noise, 0, 255);
+			g = CLIP(g + noise, 0, 255);
+			b = CLIP(b + noise, 0, 255);
+
+			planes[0].pixels[y * width + x] = CLIP<int>(( 77 * r + 150 * g +  29 * b) >> 8, 0, 255);
+			planes[1].pixels[y * width + x] = CLIP<int>(((-43 * r -  85 * g + 128 * b) >> 8) + 128, 0, 255);
+			planes[2].pixels[y * width + x] = CLIP<int>(((128 * r - 107 * g -  21 * b) >> 8) + 128, 0, 255);
+		}
+	}
+}
+
+Plane downsample(const Plane &plane, int factorH, int factorV) {
+	Plane out;
+	out.width = (plane.width + factorH - 1) / factorH;
+	out.height = (plane.height + factorV - 1) / factorV;
+	out.pixels.resize(out.width * out.height);
+
+	for (int y = 0; y < out.height; ++y) {
+		for (int x = 0; x < out.width; ++x) {
+			int sum = 0;
+			for (int j = 0; j < factorV; ++j)
+				for (int i = 0; i < factorH; ++i)
+					sum += plane.get(x * factorH + i, y * factorV + j);
+			out.pixels[y * out.width + x] = (sum + factorH * factorV / 2) / (factorH * factorV);
+		}
+	}
+
+	return out;
+}
+
+/**
+ * Encode a baseline JPEG with the example tables of the standard, at
+ * quality 75, the luma sampled factorH x factorV times as much as the
+ * chroma, and a restart marker every restartInterval MCUs if non-zero.
+ */
+void encodeJPEG(Common::Array<byte> &data, const Plane *planes, int factorH, int factorV, int restartInterval) {
+	const int width = planes[0].width;
+	const int height = planes[0].height;
+
+	uint8 quant[2][64];
+	for (int i = 0; i < 64; ++i) {
+		quant[0][i] = CLIP((lumaQuant[i] * 50 + 50) / 100, 1, 255);
+		quant[1][i] = CLIP((chromaQuant[i] * 50 + 50) / 100, 1, 255);
+	}
+
+	const HuffmanTable dcTables[2] = { HuffmanTable(dcLumaBits, dcValues), HuffmanTable(dcChromaBits, dcValues) };
+	const HuffmanTable acTables[2] = { HuffmanTable(acLumaBits, acLumaValues), HuffmanTable(acChromaBits, acChromaValues) };
+
+	data.clear();
+	putMarker(data, 0xD8);
+
+	for (int t = 0; t < 2; ++t) {
+		putMarker(data, 0xDB);
+		putUint16BE(data, 2 + 65);
+		data.push_back(t);
+		for (int i = 0; i < 64; ++i)
+			data.push_back(quant[t][zigZagOrder[i]]);
+	}
+
+	putMarker(data, 0xC0);
+	putUint16BE(data, 8 + 3 * 3);
+	data.push_back(8);
+	putUint16BE(data, height);
+	putUint16BE(data, width);
+	data.push_back(3);
+	for (int c = 0; c < 3; ++c) {
+		data.push_back(c + 1);
+		data.push_back(c ? 0x11 : ((factorH << 4) | factorV));
+		data.push_back(c ? 1 : 0);
+	}
+
+	for (int t = 0; t < 2; ++t) {
+		putHuffmanTable(data, 0x00 | t, dcTables[t]);
+		putHuffmanTable(data, 0x10 | t, acTables[t]);
+	}
+
+	if (restartInterval) {
+		putMarker(data, 0xDD);
+		putUint16BE(data, 4);
+		putUint16BE(data, restartInterval);
+	}
+
+	putMarker(data, 0xDA);
+	putUint16BE(data, 6 + 2 * 3);
+	data.push_back(3);
+	for (int c = 0; c < 3; ++c) {
+		data.push_back(c + 1);
+		data.push_back(c ? 0x11 : 0x00);
+	}
+	data.push_back(0);
+	data.push_back(63);
+	data.push_back(0);
+
+	const Plane chroma[2] = { downsample(planes[1], factorH, factorV), downsample(planes[2], factorH, factorV) };
+	const Plane *components[3] = { &planes[0], &chroma[0], &chroma[1] };
+
+	const int xMCU = (width + factorH * 8 - 1) / (factorH * 8);
+	const int yMCU = (height + factorV * 8 - 1) / (factorV * 8);
+
+	BitWriter bits(data);
+	int predictors[3] = { 0, 0, 0 };
+	int block[64];
+	int mcu = 0;
+
+	for (int y = 0; y < yMCU; ++y) {
+		for (int x = 0; x < xMCU; ++x) {
+			for (int c = 0; c < 3; ++c) {
+				const int h = c ? 1 : factorH;
+				const int v = c ? 1 : factorV;
+				const int t = c ? 1 : 0;
+
+				for (int j = 0; j < v; ++j) {
+					for (int i = 0; i < h; ++i) {
+						transformBlock(*components[c], (x * h + i) * 8, (y * v + j) * 8, quant[t], block);
+						encodeBlock(bits, block, predictors[c], dcTables[t], acTables[t]);
+					}
+				}
+			}
+
+			++mcu;
+			if (restartInterval && (mcu % restartInterval) == 0 && mcu < xMCU * yMCU) {
+				bits.align();
+				putMarker(data, 0xD0 + ((mcu / restartInterval - 1) & 7));
+				predictors[0] = predictors[1] = predictors[2] = 0;
+			}
+		}
+	}
+
+	bits.align();
+	putMarker(data, 0xD9);
+}
+
+bool loadFile(const char *filename, Common::Array<byte> &data) {
+	FILE *f = fopen(filename, "rb");
+	if (!f) {
+		fprintf(stderr, "Could not open '%s'\n", filename);
+		return false;
+	}
+
+	byte buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		for (size_t i = 0; i < n; ++i)
+			data.push_back(buffer[i]);
+
+	fclose(f);
+	return true;
+}
+
+/**
+ * Decode the image to the given format repeatedly for at least the given
+ * time, and print the speed and the checksum of the decoded image.
+ */
+void benchmark(const char *name, const Common::Array<byte> &data, const Graphics::PixelFormat &format, double minSeconds) {
+	uint32 hash = 0;
+	int width = 0, height = 0;
+
+	Benchmark::Loop loop(minSeconds);
+	do {
+		Common::MemoryReadStream stream(data.begin(), data.size());
+		Graphics::JPEGDecoder jpeg;
+		jpeg.setOutputPixelFormat(format);
+
+		const Graphics::Surface *surface = jpeg.loadStream(stream) ? jpeg.getSurface() : 0;
+		if (!surface) {
+			printf("%-12s failed to decode\n", name);
+			return;
+		}
+
+		if (!loop.getCount()) {
+			hash = Benchmark::hashSurface(*surface);
+			width = surface->w;
+			height = surface->h;
+		}
+	} while (loop.next());
+
+	printf("%-12s %4dx%-4d %8u %12.1f %12.2f   %08x\n", name, width, height, data.size(),
+	       loop.getPerSecond(), loop.getMillisEach(), hash);
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[]) {
+	double minSeconds = 1.0;
+
+	if (argc > 3 || (argc >= 2 && argv[1][0] == '-')) {
+		printf("Usage: %s [image.jpg] [seconds]\n\n", argv[0]);
+		printf("Decodes a JPEG image repeatedly for the given time (1 second by default)\n");
+		printf("and reports the speed in images per second, along with a checksum of the\n");
+		printf("decoded image to compare decoder changes with. Without an image, built-in\n");
+		printf("640x480 test images are used, with each of the common chroma subsamplings.\n");
+		return 1;
+	}
+
+	if (argc == 3 && (minSeconds = atof(argv[2])) <= 0.0) {
+		fprintf(stderr, "Invalid time '%s'\n", argv[2]);
+		return 1;
+	}
+
+	printf("%-12s %9s %8s %12s %12s   %8s\n", "Image", "Size", "Bytes", "images/s", "ms/image", "Checksum");
+
+	// The decoder's default format, and the one of most 16 bit screens
+	const Graphics::PixelFormat rgba8888(4, 8, 8, 8, 0, 24, 16, 8, 0);
+	const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+
+	Common::Array<byte> data;
+	if (argc >= 2) {
+		if (!loadFile(argv[1], data))
+			return 1;
+
+		benchmark("file", data, rgba8888, minSeconds);
+		benchmark("file 565", data, rgb565, minSeconds);
+		return 0;
+	}
+
+	Plane planes[3];
+	createTestImage(planes, 640, 480);
+
+	encodeJPEG(data, planes, 1, 1, 0);
+	benchmark("4:4:4", data, rgba8888, minSeconds);
+	encodeJPEG(data, planes, 2, 1, 0);
+	benchmark("4:2:2", data, rgba8888, minSeconds);
+	encodeJPEG(data, planes, 2, 2, 0);
+	benchmark("4:2:0", data, rgba8888, minSeconds);
+	benchmark("4:2:0 565", data, rgb565, minSeconds);
+	encodeJPEG(data, planes, 2, 2, 7);
+	benchmark("4:2:0 RST", data, rgba8888, minSeconds);
+
+	return 0;
+}
@@ -0,0 +1,16 @@
+
+MODULE := devtools/jpeg_benchmark
+
+MODULE_OBJS := \
+	jpeg_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := jpeg_benchmark
+
+# The decoder is taken straight from the graphics library
+TOOL_DEPS := \
+	graphics/libgraphics.a \
+	common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,201 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+#include "audio/rate.h"
+
+#include "common/config-manager.h"
+#include "common/system.h"
+
+#include "devtools/benchmark/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+enum {
+	kOutputRate = 48000,
+	kFramesPerPass = 1024,
+	// The output of this many passes is compared between the SIMD and the
+	// plain code
+	kHashedPasses = 64
+};
+
+const double kMinSeconds = 0.5;
+
+/**
+ * An endless stream of pseudo random noise, at a quarter of the full
+ * level so that mixing many of them does not just clip.
+ */
+class NoiseStream : public Audio::AudioStream {
+public:
+	NoiseStream(int rate, bool stereo, uint32 seed) : _rate(rate), _stereo(stereo), _seed(seed) {}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		for (int i = 0; i < numSamples; ++i) {
+			_seed = _seed * 1103515245 + 12345;
+			buffer[i] = (int16)(_seed >> 16) / 4;
+		}
+		return numSamples;
+	}
+
+	bool isStereo() const { return _stereo; }
+	int getRate() const { return _rate; }
+	bool endOfData() const { return false; }
+
+private:
+	const int _rate;
+	const bool _stereo;
+	uint32 _seed;
+};
+
+/**
+ * The channel formats, used in turn: resampled mono, resampled stereo and
+ * stereo at the output rate, which is only scaled and mixed.
+ */
+struct ChannelFormat {
+	int rate;
+	bool stereo;
+};
+
+const ChannelFormat kChannelFormats[] = {
+	{ 22050, false },
+	{ 44100, true },
+	{ kOutputRate, true }
+};
+
+struct Result {
+	double nsPerChannelFrame;
+	uint32 hash;
+};
+
+/**
+ * Mix the given number of channels until kMinSeconds have passed.
+ */
+Result mix(uint numChannels) {
+	Benchmark::System system;
+	Audio::MixerImpl mixer(&system, kOutputRate);
+	mixer.setReady(true);
+
+	for (uint i = 0; i < numChannels; ++i) {
+		const ChannelFormat &format = kChannelFormats[i % ARRAYSIZE(kChannelFormats)];
+
+		// Vary the balance, so that both output channels get different
+		// volumes
+		Audio::SoundHandle handle;
+		Audio::Mixer *base = &mixer;
+		base->playStream(Audio::Mixer::kPlainSoundType, &handle, new NoiseStream(format.rate, format.stereo, i + 1),
+		                 -1, Audio::Mixer::kMaxChannelVolume * 3 / 4, (int8)((int)(i * 37) % 255 - 127));
+	}
+
+	int16 buffer[kFramesPerPass * 2];
+	uint32 hash = Benchmark::kHashSeed;
+	long passes = 0;
+
+	Benchmark::Loop loop(kMinSeconds);
+	do {
+		mixer.mixCallback((byte *)buffer, sizeof(buffer));
+
+		if (passes++ < kHashedPasses) {
+			for (uint i = 0; i < ARRAYSIZE(buffer); ++i)
+				hash = (hash ^ (uint16)buffer[i]) * 16777619;
+		}
+	} while (loop.next(kFramesPerPass));
+
+	Result result;
+	result.nsPerChannelFrame = loop.getMillisEach() * 1000000.0 / numChannels;
+	result.hash = hash;
+	return result;
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[]) {
+	if (argc > 1) {
+		printf("Usage: %s\n\n", argv[0]);
+		printf("Mixes 1, 8 and 16 channels of noise at %d Hz with each resampler\n", kOutputRate);
+		printf("quality, once with the SIMD code of the rate converters and once with\n");
+		printf("the plain code, and reports the time per channel and output frame and\n");
+		printf("whether both produce the same output. The channels are in turn mono at\n");
+		printf("22050 Hz, stereo at 44100 Hz and stereo at the output rate.\n");
+		return 1;
+	}
+
+	Benchmark::System system;
+	g_system = &system;
+
+	static const char *const qualities[] = { "linear", "medium", "high" };
+	static const uint channelCounts[] = { 1, 8, 16 };
+
+	const bool haveSIMD = Audio::setRateConverterSIMD(true);
+	if (!haveSIMD)
+		printf("This build has no SIMD code in the rate converters.\n\n");
+
+	printf("%-8s %-6s", "Quality", "Code");
+	for (uint c = 0; c < ARRAYSIZE(channelCounts); ++c)
+		printf(" %8u ch", channelCounts[c]);
+	printf(" %8s\n", "Output");
+
+	for (uint q = 0; q < ARRAYSIZE(qualities); ++q) {
+		ConfMan.set("resampler_quality", qualities[q]);
+
+		uint32 plainHash = 0;
+
+		for (int simd = 0; simd <= (haveSIMD ? 1 : 0); ++simd) {
+			Audio::setRateConverterSIMD(simd != 0);
+
+			printf("%-8s %-6s", qualities[q], simd ? "SIMD" : "plain");
+
+			uint32 hash = 0;
+			for (uint c = 0; c < ARRAYSIZE(channelCounts); ++c) {
+				const Result result = mix(channelCounts[c]);
+				printf(" %11.1f", result.nsPerChannelFrame);
+				fflush(stdout);
+
+				// Compare the output of the most channels
+				hash = result.hash;
+			}
+
+			if (!simd)
+				plainHash = hash;
+
+			printf(" %8s\n", !simd ? "-" : (hash == plainHash ? "same" : "DIFFERS"));
+		}
+	}
+
+	printf("\nTimes are in nanoseconds per channel and output frame.\n");
+
+	Audio::setRateConverterSIMD(true);
+	g_system = 0;
+	return 0;
+}
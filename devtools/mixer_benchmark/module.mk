@@ -0,0 +1,16 @@
+
+MODULE := devtools/mixer_benchmark
+
+MODULE_OBJS := \
+	mixer_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := mixer_benchmark
+
+# The mixer and the rate converters are taken straight from the audio library
+TOOL_DEPS := \
+	audio/libaudio.a \
+	common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,19 @@
+MODULE := devtools/mt32_benchmark
+
+MODULE_OBJS := \
+	mt32_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := mt32_benchmark
+
+# The emulator is taken straight from the audio library
+TOOL_DEPS := \
+	audio/softsynth/mt32/libmt32.a \
+	audio/libaudio.a \
+	common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
+
+# The worker threads are POSIX threads
+$(MODULE)/mt32_benchmark$(EXEEXT): LDFLAGS += -pthread
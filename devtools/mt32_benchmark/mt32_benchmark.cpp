@@ -0,0 +1,354 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "audio/softsynth/mt32/mt32emu.h"
+
+#include "common/array.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "devtools/benchmark/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef POSIX
+#include <pthread.h>
+#endif
+
+namespace {
+
+#ifdef POSIX
+
+/**
+ * Runs the jobs of the synth on numThreads threads, including the calling
+ * one. Works like the worker pool of the SDL mixer.
+ */
+class PosixJobRunner : public MT32Emu::RenderJobRunner {
+public:
+	PosixJobRunner(uint numThreads);
+	virtual ~PosixJobRunner();
+
+	virtual void runJobs(JobProc proc, void *param, unsigned int numJobs);
+
+private:
+	enum {
+		kMaxThreads = 8
+	};
+
+	pthread_mutex_t _mutex;
+	pthread_cond_t _workCond;
+	pthread_cond_t _doneCond;
+	pthread_t _threads[kMaxThreads];
+	uint _numThreads;
+	bool _shouldQuit;
+
+	JobProc _proc;
+	void *_param;
+	uint _numJobs;
+	uint _nextJob;
+	uint _pendingJobs;
+
+	void workerThread();
+	static void *workerThreadEntry(void *arg);
+};
+
+PosixJobRunner::PosixJobRunner(uint numThreads)
+	:
+	_numThreads(0), _shouldQuit(false), _proc(0), _param(0),
+	_numJobs(0), _nextJob(0), _pendingJobs(0) {
+
+	pthread_mutex_init(&_mutex, 0);
+	pthread_cond_init(&_workCond, 0);
+	pthread_cond_init(&_doneCond, 0);
+
+	numThreads = CLIP<uint>(numThreads, 1, kMaxThreads + 1);
+	while (_numThreads < numThreads - 1) {
+		if (pthread_create(&_threads[_numThreads], 0, workerThreadEntry, this))
+			break;
+		_numThreads++;
+	}
+}
+
+PosixJobRunner::~PosixJobRunner() {
+	pthread_mutex_lock(&_mutex);
+	_shouldQuit = true;
+	pthread_cond_broadcast(&_workCond);
+	pthread_mutex_unlock(&_mutex);
+
+	for (uint i = 0; i < _numThreads; i++)
+		pthread_join(_threads[i], 0);
+
+	pthread_cond_destroy(&_doneCond);
+	pthread_cond_destroy(&_workCond);
+	pthread_mutex_destroy(&_mutex);
+}
+
+void PosixJobRunner::runJobs(JobProc proc, void *param, unsigned int numJobs) {
+	pthread_mutex_lock(&_mutex);
+
+	_proc = proc;
+	_param = param;
+	_numJobs = numJobs;
+	_nextJob = 0;
+	_pendingJobs = numJobs;
+	pthread_cond_broadcast(&_workCond);
+
+	// Help out until all jobs are taken, then wait for the workers
+	while (_nextJob < _numJobs) {
+		const uint job = _nextJob++;
+		pthread_mutex_unlock(&_mutex);
+		proc(param, job);
+		pthread_mutex_lock(&_mutex);
+		_pendingJobs--;
+	}
+
+	while (_pendingJobs)
+		pthread_cond_wait(&_doneCond, &_mutex);
+
+	pthread_mutex_unlock(&_mutex);
+}
+
+void PosixJobRunner::workerThread() {
+	pthread_mutex_lock(&_mutex);
+	while (!_shouldQuit) {
+		if (_nextJob < _numJobs) {
+			const uint job = _nextJob++;
+			pthread_mutex_unlock(&_mutex);
+			_proc(_param, job);
+			pthread_mutex_lock(&_mutex);
+
+			if (--_pendingJobs == 0)
+				pthread_cond_signal(&_doneCond);
+		} else {
+			pthread_cond_wait(&_workCond, &_mutex);
+		}
+	}
+	pthread_mutex_unlock(&_mutex);
+}
+
+void *PosixJobRunner::workerThreadEntry(void *arg) {
+	((PosixJobRunner *)arg)->workerThread();
+	return 0;
+}
+
+#endif // POSIX
+
+/**
+ * Load a ROM into memory and wrap it in a Common::File, as the emulator
+ * wants one. This avoids the need for a filesystem factory.
+ */
+Common::File *loadROM(const char *dir, const char *name) {
+	const Common::String path = Common::String::format("%s/%s", dir, name);
+
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f)
+		return 0;
+
+	fseek(f, 0, SEEK_END);
+	const long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	byte *data = (byte *)malloc(size);
+	if (!data || fread(data, 1, size, f) != (size_t)size) {
+		free(data);
+		fclose(f);
+		return 0;
+	}
+	fclose(f);
+
+	Common::File *file = new Common::File();
+	file->open(new Common::MemoryReadStream(data, size, DisposeAfterUse::YES), name);
+	return file;
+}
+
+struct Event {
+	uint32 frame;
+	uint32 msg;
+};
+
+typedef Common::Array<Event> EventList;
+
+void addEvent(EventList &events, uint32 frame, byte status, byte data1, byte data2 = 0) {
+	Event event;
+	event.frame = frame;
+	event.msg = status | (data1 << 8) | (data2 << 16);
+	events.push_back(event);
+}
+
+/**
+ * Create a test sequence: all eight melodic parts playing overlapping
+ * chords with different programs, plus a drum pattern on the rhythm part.
+ * It keeps most of the 32 partials busy, which is the interesting case.
+ */
+void createTestSequence(EventList &events, uint32 &length) {
+	static const byte programs[8] = { 0, 6, 16, 24, 32, 48, 56, 88 };
+	static const byte drums[4] = { 36, 42, 38, 42 };
+	const uint32 beat = 32000 / 4;
+
+	// By default, parts 1 to 8 are on MIDI channels 2 to 9, rhythm is on 10
+	for (int part = 0; part < 8; ++part)
+		addEvent(events, 0, 0xC1 + part, programs[part]);
+
+	const int beats = 64;
+	for (int b = 0; b < beats; ++b) {
+		const uint32 frame = b * beat;
+
+		for (int part = 0; part < 8; ++part) {
+			if ((b + part) % 2)
+				continue;
+
+			const byte note = 48 + (b * 5 + part * 7) % 24;
+			addEvent(events, frame, 0x91 + part, note, 64 + part * 8);
+			addEvent(events, frame + beat * 3 / 2, 0x81 + part, note, 64);
+		}
+
+		addEvent(events, frame, 0x99, drums[b % 4], 100);
+	}
+
+	length = beats * beat + 32000;
+}
+
+/**
+ * Play the events on the synth, in chunks of at most 512 frames like our
+ * MIDI driver does, and return the time spent rendering, in seconds.
+ */
+double play(MT32Emu::Synth &synth, const EventList &events, uint32 length, Common::Array<int16> &output) {
+	double elapsed = 0.0;
+	uint32 frame = 0;
+	uint e = 0;
+
+	output.resize(length * 2);
+
+	while (frame < length) {
+		while (e < events.size() && events[e].frame <= frame)
+			synth.playMsg(events[e++].msg);
+
+		uint32 frames = MIN<uint32>(512, length - frame);
+		if (e < events.size())
+			frames = MIN<uint32>(frames, events[e].frame - frame);
+
+		const Benchmark::Timer timer;
+		synth.render(&output[frame * 2], frames);
+		elapsed += timer.getSeconds();
+
+		frame += frames;
+	}
+
+	return elapsed;
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[]) {
+	if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+		printf("Usage: %s [ROM directory]\n\n", argv[0]);
+		printf("Plays a built-in test sequence on the MT-32 emulator, rendering the\n");
+		printf("partials on 1, 2 and 4 threads, and reports the speed of each and\n");
+		printf("whether the output matches the one of the single threaded renderer.\n");
+		printf("The ROMs are read from the given directory, or the current one.\n");
+		return 1;
+	}
+
+	const char *dir = (argc == 2) ? argv[1] : ".";
+
+	EventList events;
+	uint32 length;
+	createTestSequence(events, length);
+
+#ifdef POSIX
+	static const uint threadCounts[] = { 1, 2, 4 };
+#else
+	// Without threads, there is only the serial renderer to measure
+	static const uint threadCounts[] = { 1 };
+#endif
+	Common::Array<int16> reference;
+	double referenceTime = 0.0;
+
+	printf("%-8s %12s %14s %10s %10s\n", "Threads", "Samples", "Samples/sec", "Speedup", "Output");
+
+	for (uint i = 0; i < ARRAYSIZE(threadCounts); ++i) {
+		Common::File *controlFile = loadROM(dir, "MT32_CONTROL.ROM");
+		if (!controlFile)
+			controlFile = loadROM(dir, "CM32L_CONTROL.ROM");
+		Common::File *pcmFile = loadROM(dir, "MT32_PCM.ROM");
+		if (!pcmFile)
+			pcmFile = loadROM(dir, "CM32L_PCM.ROM");
+		if (!controlFile || !pcmFile) {
+			fprintf(stderr, "Could not load MT32_CONTROL.ROM / CM32L_CONTROL.ROM and MT32_PCM.ROM / CM32L_PCM.ROM from '%s'\n", dir);
+			delete controlFile;
+			delete pcmFile;
+			return 1;
+		}
+
+		const MT32Emu::ROMImage *controlROM = MT32Emu::ROMImage::makeROMImage(controlFile);
+		const MT32Emu::ROMImage *pcmROM = MT32Emu::ROMImage::makeROMImage(pcmFile);
+
+		MT32Emu::Synth *synth = new MT32Emu::Synth();
+		if (!synth->open(*controlROM, *pcmROM)) {
+			fprintf(stderr, "Could not open the MT-32 emulator\n");
+			return 1;
+		}
+
+		MT32Emu::RenderJobRunner *runner = 0;
+#ifdef POSIX
+		if (threadCounts[i] > 1) {
+			runner = new PosixJobRunner(threadCounts[i]);
+			synth->setRenderJobRunner(runner);
+		}
+#endif
+
+		Common::Array<int16> output;
+		const double elapsed = play(*synth, events, length, output);
+
+		synth->close();
+		delete synth;
+		delete runner;
+		MT32Emu::ROMImage::freeROMImage(controlROM);
+		MT32Emu::ROMImage::freeROMImage(pcmROM);
+		delete controlFile;
+		delete pcmFile;
+
+		const double rate = elapsed > 0.0 ? length / elapsed : 0.0;
+		if (i == 0) {
+			reference = output;
+			referenceTime = elapsed;
+			printf("%-8u %12u %14.0f %10s %10s\n", threadCounts[i], length, rate, "-", "-");
+		} else {
+			const bool identical = !memcmp(&reference[0], &output[0], output.size() * sizeof(int16));
+			printf("%-8u %12u %14.0f %9.2fx %10s\n", threadCounts[i], length, rate,
+				elapsed > 0.0 ? referenceTime / elapsed : 0.0, identical ? "identical" : "DIFFERENT");
+		}
+	}
+
+	return 0;
+}
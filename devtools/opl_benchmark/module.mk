@@ -0,0 +1,16 @@
+
+MODULE := devtools/opl_benchmark
+
+MODULE_OBJS := \
+	opl_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := opl_benchmark
+
+# The emulators are taken straight from the audio library
+TOOL_DEPS := \
+	audio/libaudio.a \
+	common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,326 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "audio/fmopl.h"
+#include "audio/softsynth/opl/capture.h"
+
+#include "common/array.h"
+#include "common/endian.h"
+#include "common/system.h"
+
+#include "devtools/benchmark/benchmark.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+struct Event {
+	byte type;
+	uint32 arg1;
+	uint32 arg2;
+};
+
+typedef Common::Array<Event> EventList;
+
+/**
+ * Load a log written by OPL::Capture::OPL, i.e. via the "opl_capture"
+ * config key.
+ */
+bool loadLog(const char *filename, OPL::Config::OplType &type, EventList &events) {
+	FILE *f = fopen(filename, "rb");
+	if (!f) {
+		fprintf(stderr, "Could not open '%s'\n", filename);
+		return false;
+	}
+
+	byte header[6];
+	if (fread(header, 1, sizeof(header), f) != sizeof(header) || READ_BE_UINT32(header) != OPL::Capture::kLogTag) {
+		fprintf(stderr, "'%s' is not an OPL capture log\n", filename);
+		fclose(f);
+		return false;
+	}
+
+	if (header[4] != OPL::Capture::kLogVersion) {
+		fprintf(stderr, "Unsupported OPL capture log version %d\n", header[4]);
+		fclose(f);
+		return false;
+	}
+
+	type = (OPL::Config::OplType)header[5];
+
+	int c;
+	while ((c = fgetc(f)) != EOF) {
+		byte args[4];
+		Event event;
+		event.type = c;
+		event.arg1 = event.arg2 = 0;
+
+		switch (c) {
+		case OPL::Capture::kEventInit:
+		case OPL::Capture::kEventSamples:
+			if (fread(args, 1, 4, f) != 4)
+				break;
+			event.arg1 = READ_LE_UINT32(args);
+			events.push_back(event);
+			continue;
+
+		case OPL::Capture::kEventReset:
+			events.push_back(event);
+			continue;
+
+		case OPL::Capture::kEventWrite:
+		case OPL::Capture::kEventWriteReg:
+			if (fread(args, 1, 3, f) != 3)
+				break;
+			event.arg1 = READ_LE_UINT16(args);
+			event.arg2 = args[2];
+			events.push_back(event);
+			continue;
+
+		default:
+			fprintf(stderr, "Unknown event %d in OPL capture log\n", c);
+			break;
+		}
+
+		// Either a truncated or a corrupt log, replay what we have so far.
+		fprintf(stderr, "Warning: '%s' is truncated\n", filename);
+		break;
+	}
+
+	fclose(f);
+	return true;
+}
+
+void addEvent(EventList &events, byte type, uint32 arg1 = 0, uint32 arg2 = 0) {
+	Event event;
+	event.type = type;
+	event.arg1 = arg1;
+	event.arg2 = arg2;
+	events.push_back(event);
+}
+
+/**
+ * Create an OPL2 test sequence for when no log is given: all nine
+ * channels playing a few seconds worth of chords with different
+ * waveforms, envelopes and feedback settings, read in 512 sample chunks
+ * like our AdLib drivers do.
+ */
+void createTestSequence(EventList &events) {
+	static const byte operatorOffsets[9] = { 0x00, 0x01, 0x02, 0x08, 0x09, 0x0A, 0x10, 0x11, 0x12 };
+	static const uint16 fnums[12] = { 0x157, 0x16B, 0x181, 0x198, 0x1B0, 0x1CA, 0x1E5, 0x202, 0x220, 0x241, 0x263, 0x287 };
+
+	addEvent(events, OPL::Capture::kEventInit, 44100);
+	addEvent(events, OPL::Capture::kEventReset);
+	addEvent(events, OPL::Capture::kEventWriteReg, 0x01, 0x20);
+
+	for (int ch = 0; ch < 9; ++ch) {
+		const byte op = operatorOffsets[ch];
+		addEvent(events, OPL::Capture::kEventWriteReg, 0x20 + op, 0x01 + (ch & 1) * 0x20);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0x23 + op, 0x01 + (ch & 2) * 0x40);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0x40 + op, 0x10 + ch * 2);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0x43 + op, 0x0C);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0x60 + op, 0xF2 - ch * 0x10);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0x63 + op, 0xF4 - ch * 0x10);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0x80 + op, 0x77);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0x83 + op, 0x57);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0xE0 + op, ch & 3);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0xE3 + op, (ch >> 1) & 3);
+		addEvent(events, OPL::Capture::kEventWriteReg, 0xC0 + ch, (ch % 7) << 1);
+	}
+
+	for (int step = 0; step < 32; ++step) {
+		for (int ch = 0; ch < 9; ++ch) {
+			const int note = (step * 5 + ch * 4) % 12;
+			const int block = 2 + (ch + step) % 4;
+
+			addEvent(events, OPL::Capture::kEventWriteReg, 0xA0 + ch, fnums[note] & 0xFF);
+			addEvent(events, OPL::Capture::kEventWriteReg, 0xB0 + ch, 0x20 | (block << 2) | (fnums[note] >> 8));
+		}
+
+		for (int i = 0; i < 8; ++i)
+			addEvent(events, OPL::Capture::kEventSamples, 512);
+
+		for (int ch = 0; ch < 9; ++ch)
+			addEvent(events, OPL::Capture::kEventWriteReg, 0xB0 + ch, 0x00);
+
+		for (int i = 0; i < 2; ++i)
+			addEvent(events, OPL::Capture::kEventSamples, 512);
+	}
+}
+
+/**
+ * Replay the events on the given emulator.
+ *
+ * @return the time spent, in seconds
+ */
+double replay(OPL::OPL *opl, const EventList &events, Common::Array<int16> &output) {
+	const Benchmark::Timer timer;
+
+	for (EventList::const_iterator i = events.begin(); i != events.end(); ++i) {
+		switch (i->type) {
+		case OPL::Capture::kEventInit:
+			opl->init(i->arg1);
+			break;
+
+		case OPL::Capture::kEventReset:
+			opl->reset();
+			break;
+
+		case OPL::Capture::kEventWrite:
+			opl->write(i->arg1, i->arg2);
+			break;
+
+		case OPL::Capture::kEventWriteReg:
+			opl->writeReg(i->arg1, i->arg2);
+			break;
+
+		case OPL::Capture::kEventSamples: {
+			const uint pos = output.size();
+			output.resize(pos + i->arg1);
+			opl->readBuffer(&output[pos], i->arg1);
+			break;
+			}
+		}
+	}
+
+	return timer.getSeconds();
+}
+
+double rmsLevel(const Common::Array<int16> &a) {
+	if (a.empty())
+		return 0.0;
+
+	double sum = 0.0;
+	for (uint i = 0; i < a.size(); ++i)
+		sum += (double)a[i] * a[i];
+
+	return sqrt(sum / a.size());
+}
+
+double rmsDifference(const Common::Array<int16> &a, const Common::Array<int16> &b) {
+	const uint length = MIN(a.size(), b.size());
+	if (!length)
+		return 0.0;
+
+	double sum = 0.0;
+	for (uint i = 0; i < length; ++i) {
+		const double diff = a[i] - b[i];
+		sum += diff * diff;
+	}
+
+	return sqrt(sum / length);
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[]) {
+	if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+		printf("Usage: %s [capture log]\n\n", argv[0]);
+		printf("Replays an OPL register log, as recorded with the \"opl_capture\" config\n");
+		printf("key, through all OPL emulators supporting its chip type and reports their\n");
+		printf("speed and their RMS difference to the output of the first emulator.\n");
+		printf("Without a log a built-in OPL2 test sequence is used.\n");
+		return 1;
+	}
+
+	Benchmark::System system;
+	g_system = &system;
+
+	OPL::Config::OplType type = OPL::Config::kOpl2;
+	EventList events;
+
+	if (argc == 2) {
+		if (!loadLog(argv[1], type, events))
+			return 1;
+	} else {
+		createTestSequence(events);
+	}
+
+	uint32 flags = 0;
+	switch (type) {
+	case OPL::Config::kOpl2:
+		flags = OPL::Config::kFlagOpl2;
+		break;
+
+	case OPL::Config::kDualOpl2:
+		flags = OPL::Config::kFlagDualOpl2;
+		break;
+
+	case OPL::Config::kOpl3:
+		flags = OPL::Config::kFlagOpl3;
+		break;
+	}
+
+	Common::Array<int16> reference;
+	bool referenceStereo = false;
+	const char *referenceName = 0;
+
+	printf("%-8s %12s %12s %10s %10s\n", "Emulator", "Samples", "ns/sample", "RMS level", "RMS diff");
+
+	// Skip the "auto" entry, which is always first
+	for (const OPL::Config::EmulatorDescription *desc = OPL::Config::getAvailable() + 1; desc->name; ++desc) {
+		if (!(desc->flags & flags))
+			continue;
+
+		OPL::OPL *opl = OPL::Config::create(desc->id, type);
+		if (!opl) {
+			printf("%-8s failed to create emulator\n", desc->name);
+			continue;
+		}
+
+		Common::Array<int16> output;
+		const double elapsed = replay(opl, events, output);
+		const bool stereo = opl->isStereo();
+		delete opl;
+
+		const uint frames = stereo ? output.size() / 2 : output.size();
+		const double nsPerSample = frames ? elapsed * 1000000000.0 / frames : 0.0;
+
+		if (!referenceName) {
+			reference = output;
+			referenceStereo = stereo;
+			referenceName = desc->name;
+			printf("%-8s %12u %12.1f %10.2f %10s\n", desc->name, frames, nsPerSample, rmsLevel(output), "-");
+		} else if (stereo != referenceStereo) {
+			printf("%-8s %12u %12.1f %10.2f %10s\n", desc->name, frames, nsPerSample, rmsLevel(output), "n/a");
+		} else {
+			printf("%-8s %12u %12.1f %10.2f %10.2f\n", desc->name, frames, nsPerSample, rmsLevel(output), rmsDifference(reference, output));
+		}
+	}
+
+	if (referenceName)
+		printf("\nRMS differences are relative to '%s', in 16 bit sample units.\n", referenceName);
+
+	g_system = 0;
+	return 0;
+}
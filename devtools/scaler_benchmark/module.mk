@@ -0,0 +1,16 @@
+
+MODULE := devtools/scaler_benchmark
+
+MODULE_OBJS := \
+	scaler_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := scaler_benchmark
+
+# The scalers are taken straight from the graphics library
+TOOL_DEPS := \
+	graphics/libgraphics.a \
+	common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
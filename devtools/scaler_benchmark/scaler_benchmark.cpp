@@ -0,0 +1,169 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "common/scummsys.h"
+#include "common/util.h"
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "graphics/scaler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+struct ScalerEntry {
+	const char *name;
+	ScalerProc *proc;
+	int factor;
+};
+
+const ScalerEntry scalers[] = {
+	{ "Normal1x", Normal1x, 1 },
+#ifdef USE_SCALERS
+	{ "Normal2x", Normal2x, 2 },
+	{ "Normal3x", Normal3x, 3 },
+	{ "2xSaI", _2xSaI, 2 },
+	{ "Super2xSaI", Super2xSaI, 2 },
+	{ "SuperEagle", SuperEagle, 2 },
+	{ "AdvMame2x", AdvMame2x, 2 },
+	{ "AdvMame3x", AdvMame3x, 3 },
+	{ "TV2x", TV2x, 2 },
+	{ "DotMatrix", DotMatrix, 2 },
+#ifdef USE_HQ_SCALERS
+	{ "HQ2x", HQ2x, 2 },
+	{ "HQ3x", HQ3x, 3 },
+#endif
+#endif
+	{ 0, 0, 0 }
+};
+
+// The scalers read one pixel beyond each edge of the source rectangle
+enum {
+	kBorder = 2
+};
+
+/**
+ * Fill the source with something resembling game graphics: large areas
+ * of a few colors with some dithering, so that the edge detection of the
+ * more elaborate scalers has something to do.
+ */
+void createTestImage(uint16 *pixels, int pitch, int width, int height, uint32 bitFormat) {
+	static const uint8 colors[8][3] = {
+		{ 0, 0, 0 }, { 255, 255, 255 }, { 200, 40, 40 }, { 40, 160, 40 },
+		{ 40, 40, 200 }, { 220, 200, 60 }, { 120, 90, 60 }, { 100, 100, 110 }
+	};
+
+	srand(1);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			int color = ((x / 24) + (y / 16) * 3 + ((x * y) >> 9)) & 7;
+			if ((rand() & 15) == 0)
+				color = rand() & 7;
+
+			const uint8 *c = colors[color];
+			if (bitFormat == 565)
+				pixels[y * pitch + x] = ((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3);
+			else
+				pixels[y * pitch + x] = ((c[0] >> 3) << 10) | ((c[1] >> 3) << 5) | (c[2] >> 3);
+		}
+	}
+}
+
+/**
+ * Run the scaler repeatedly over the source for at least the given time.
+ *
+ * @return the number of source pixels scaled per second
+ */
+double benchmark(const ScalerEntry &scaler, const uint16 *src, int srcPitch, uint16 *dst, int width, int height, double minSeconds) {
+	const int dstPitch = width * scaler.factor;
+
+	Benchmark::Loop loop(minSeconds);
+	do {
+		scaler.proc((const uint8 *)src, srcPitch * sizeof(uint16), (uint8 *)dst, dstPitch * sizeof(uint16), width, height);
+	} while (loop.next());
+
+	return loop.getPerSecond() * width * height;
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[]) {
+	int width = 320, height = 200;
+	double minSeconds = 1.0;
+
+	if (argc > 3 || (argc >= 2 && argv[1][0] == '-')) {
+		printf("Usage: %s [width]x[height] [seconds]\n\n", argv[0]);
+		printf("Runs every scaler on a test image of the given size (320x200 by default)\n");
+		printf("for the given time (1 second by default) in both 16 bit formats and\n");
+		printf("reports the speed in source megapixels per second.\n");
+		return 1;
+	}
+
+	if (argc >= 2 && (sscanf(argv[1], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)) {
+		fprintf(stderr, "Invalid size '%s'\n", argv[1]);
+		return 1;
+	}
+
+	if (argc == 3 && (minSeconds = atof(argv[2])) <= 0.0) {
+		fprintf(stderr, "Invalid time '%s'\n", argv[2]);
+		return 1;
+	}
+
+	const int srcPitch = width + 2 * kBorder;
+	uint16 *srcBuffer = new uint16[srcPitch * (height + 2 * kBorder)];
+	uint16 *dst = new uint16[width * 3 * height * 3];
+	const uint16 *src = srcBuffer + kBorder * srcPitch + kBorder;
+
+	printf("%-12s %12s %12s\n", "Scaler", "565 MPix/s", "555 MPix/s");
+
+	double results[2][ARRAYSIZE(scalers)];
+	static const uint32 formats[2] = { 565, 555 };
+
+	for (int f = 0; f < 2; ++f) {
+		createTestImage(srcBuffer, srcPitch, srcPitch, height + 2 * kBorder, formats[f]);
+		InitScalers(formats[f]);
+
+		for (int i = 0; scalers[i].name; ++i)
+			results[f][i] = benchmark(scalers[i], src, srcPitch, dst, width, height, minSeconds) / 1000000.0;
+
+		DestroyScalers();
+	}
+
+	for (int i = 0; scalers[i].name; ++i)
+		printf("%-12s %12.1f %12.1f\n", scalers[i].name, results[0][i], results[1][i]);
+
+	delete[] srcBuffer;
+	delete[] dst;
+	return 0;
+}
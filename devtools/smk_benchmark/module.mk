@@ -0,0 +1,23 @@
+
+MODULE := devtools/smk_benchmark
+
+MODULE_OBJS := \
+	smk_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := smk_benchmark
+
+# The decoder is taken straight from the video library
+TOOL_DEPS := \
+	video/libvideo.a \
+	graphics/libgraphics.a \
+	audio/libaudio.a \
+	common/libcommon.a
+
+# The audio library pulls in the QuickTime parser, which needs zlib
+ifdef USE_ZLIB
+TOOL_DEPS += -lz
+endif
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,278 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "common/array.h"
+#include "common/endian.h"
+#include "common/memstream.h"
+#include "common/system.h"
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "graphics/surface.h"
+
+#include "video/smk_decoder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+/** Writes the LSB first bit stream the Smacker trees are stored in. */
+class BitWriter {
+public:
+	BitWriter(Common::Array<byte> &data) : _data(data), _bits(0) {}
+
+	void putBit(uint32 bit) {
+		if ((_bits & 7) == 0)
+			_data.push_back(0);
+		if (bit)
+			_data.back() |= 1 << (_bits & 7);
+		++_bits;
+	}
+
+	void putBits(uint32 value, int n) {
+		for (int i = 0; i < n; ++i)
+			putBit((value >> i) & 1);
+	}
+
+private:
+	Common::Array<byte> &_data;
+	uint32 _bits;
+};
+
+/**
+ * Write a byte tree holding 0 to 255, all with 8 bit codes. Since the
+ * leaves are written depth first, the code of a value is its bits, MSB
+ * first.
+ */
+void writeByteTree(BitWriter &bits, int depth = 0, int value = 0) {
+	if (depth == 0)
+		bits.putBit(1);
+
+	if (depth == 8) {
+		bits.putBit(0);
+		bits.putBits(value, 8);
+	} else {
+		bits.putBit(1);
+		writeByteTree(bits, depth + 1, value << 1);
+		writeByteTree(bits, depth + 1, (value << 1) | 1);
+	}
+
+	if (depth == 0)
+		bits.putBit(0);
+}
+
+void writeByte(BitWriter &bits, byte value) {
+	for (int i = 7; i >= 0; --i)
+		bits.putBit((value >> i) & 1);
+}
+
+/**
+ * Write the structure of a random tree with 16 bit values, and return
+ * the number of entries it needs. Leaves become likelier with the depth,
+ * which gives code lengths of the kind a Huffman encoder produces.
+ */
+uint32 writeTreeNodes(BitWriter &bits, int depth, int maxDepth, const uint16 *markers, uint &leaves) {
+	if (depth >= maxDepth || (depth >= 2 && (rand() % 16) < depth)) {
+		// The first leaves are the cache markers, so that they are used
+		uint16 value = (leaves < 3) ? markers[leaves] : (uint16)rand();
+		++leaves;
+
+		bits.putBit(0);
+		writeByte(bits, value & 0xFF);
+		writeByte(bits, value >> 8);
+		return 1;
+	}
+
+	bits.putBit(1);
+	uint32 size = writeTreeNodes(bits, depth + 1, maxDepth, markers, leaves);
+	return size + writeTreeNodes(bits, depth + 1, maxDepth, markers, leaves) + 1;
+}
+
+/** Write a complete tree and return the allocation size for the header. */
+uint32 writeTree(BitWriter &bits, int maxDepth) {
+	uint16 markers[3];
+	for (int i = 0; i < 3; ++i)
+		markers[i] = 0x8000 + i;
+
+	bits.putBit(1);
+	writeByteTree(bits);
+	writeByteTree(bits);
+	for (int i = 0; i < 3; ++i)
+		bits.putBits(markers[i], 16);
+
+	uint leaves = 0;
+	uint32 size = writeTreeNodes(bits, 0, maxDepth, markers, leaves);
+	bits.putBit(0);
+
+	// Room for the cache entries which are not in the tree
+	return (size + 3) * 4;
+}
+
+void putUint32LE(Common::Array<byte> &data, uint32 value) {
+	for (int i = 0; i < 4; ++i)
+		data.push_back((value >> (i * 8)) & 0xFF);
+}
+
+/**
+ * Create a Smacker v4 video with random trees and random frame data. The
+ * trees are complete, so they decode any bits, and the frames are large
+ * enough for the decoder never to run out of them.
+ */
+void createTestVideo(Common::Array<byte> &video, int width, int height, uint32 frameCount) {
+	srand(1);
+
+	Common::Array<byte> trees;
+	BitWriter bits(trees);
+	const uint32 mMapSize = writeTree(bits, 14);
+	const uint32 mClrSize = writeTree(bits, 16);
+	const uint32 fullSize = writeTree(bits, 16);
+	const uint32 typeSize = writeTree(bits, 12);
+
+	const uint32 frameSize = (width * height * 2 + 64) & ~3;
+
+	video.clear();
+	for (const char *signature = "SMK4"; *signature; ++signature)
+		video.push_back(*signature);
+	putUint32LE(video, width);
+	putUint32LE(video, height);
+	putUint32LE(video, frameCount);
+	putUint32LE(video, (uint32)-1500); // 15 fps
+	putUint32LE(video, 0);
+	for (int i = 0; i < 7; ++i)
+		putUint32LE(video, 0);
+	putUint32LE(video, trees.size());
+	putUint32LE(video, mMapSize);
+	putUint32LE(video, mClrSize);
+	putUint32LE(video, fullSize);
+	putUint32LE(video, typeSize);
+	for (int i = 0; i < 7; ++i)
+		putUint32LE(video, 0);
+	putUint32LE(video, 0);
+	for (uint32 i = 0; i < frameCount; ++i)
+		putUint32LE(video, frameSize);
+	for (uint32 i = 0; i < frameCount; ++i)
+		video.push_back(0);
+
+	for (uint i = 0; i < trees.size(); ++i)
+		video.push_back(trees[i]);
+
+	for (uint32 i = 0; i < frameCount * frameSize; ++i)
+		video.push_back(rand() & 0xFF);
+}
+
+bool loadFile(const char *filename, Common::Array<byte> &video) {
+	FILE *f = fopen(filename, "rb");
+	if (!f) {
+		fprintf(stderr, "Could not open '%s'\n", filename);
+		return false;
+	}
+
+	byte buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		for (size_t i = 0; i < n; ++i)
+			video.push_back(buffer[i]);
+
+	fclose(f);
+	return true;
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[]) {
+	double minSeconds = 2.0;
+
+	if (argc > 3 || (argc >= 2 && argv[1][0] == '-')) {
+		printf("Usage: %s [video.smk] [seconds]\n\n", argv[0]);
+		printf("Decodes a Smacker video repeatedly for the given time (2 seconds by\n");
+		printf("default) and reports the speed in frames per second, along with a\n");
+		printf("checksum of the decoded frames to compare decoder changes with.\n");
+		printf("Without a video a built-in 640x480 test video with random data is used.\n");
+		return 1;
+	}
+
+	if (argc == 3 && (minSeconds = atof(argv[2])) <= 0.0) {
+		fprintf(stderr, "Invalid time '%s'\n", argv[2]);
+		return 1;
+	}
+
+	Benchmark::System system;
+	g_system = &system;
+
+	Common::Array<byte> video;
+	if (argc >= 2) {
+		if (!loadFile(argv[1], video))
+			return 1;
+	} else {
+		createTestVideo(video, 640, 480, 30);
+	}
+
+	byte *data = (byte *)malloc(video.size());
+	memcpy(data, video.begin(), video.size());
+
+	// The decoder needs g_system until it is gone
+	Video::SmackerDecoder *decoder = new Video::SmackerDecoder();
+	if (!decoder->loadStream(new Common::MemoryReadStream(data, video.size(), DisposeAfterUse::YES))) {
+		fprintf(stderr, "Not a Smacker video\n");
+		delete decoder;
+		return 1;
+	}
+
+	// The first pass computes the checksum, the timed ones only decode
+	uint32 hash = Benchmark::kHashSeed;
+	uint32 frameCount = 0;
+	while (!decoder->endOfVideo()) {
+		const Graphics::Surface *surface = decoder->decodeNextFrame();
+		if (surface)
+			hash = Benchmark::hashSurface(*surface, hash);
+		++frameCount;
+	}
+
+	Benchmark::Loop loop(minSeconds);
+	long frames;
+	do {
+		frames = 0;
+		decoder->rewind();
+		while (!decoder->endOfVideo()) {
+			decoder->decodeNextFrame();
+			++frames;
+		}
+	} while (loop.next(frames));
+
+	printf("%dx%d, %u frames, checksum %08x\n", decoder->getWidth(), decoder->getHeight(), frameCount, hash);
+	printf("%.1f frames/second, %.2f ms/frame\n", loop.getPerSecond(), loop.getMillisEach());
+
+	delete decoder;
+	g_system = 0;
+	return 0;
+}
@@ -0,0 +1,22 @@
+
+MODULE := devtools/theme_benchmark
+
+MODULE_OBJS := \
+	theme_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := theme_benchmark
+
+# The theme engine and the renderers are taken straight from the libraries
+TOOL_DEPS := \
+	gui/libgui.a \
+	graphics/libgraphics.a \
+	common/libcommon.a
+
+# The theme engine reads themes from ZIP archives, which needs zlib
+ifdef USE_ZLIB
+TOOL_DEPS += -lz
+endif
+
+# Include common rules
+include $(srcdir)/rules.mk
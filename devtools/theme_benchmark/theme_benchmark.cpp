@@ -0,0 +1,382 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "backends/fs/abstract-fs.h"
+#include "backends/fs/fs-factory.h"
+
+#include "common/array.h"
+#include "common/rect.h"
+#include "common/str.h"
+#include "common/system.h"
+
+#include "devtools/benchmark/benchmark.h"
+
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+#include "graphics/VectorRenderer.h"
+
+#include "gui/ThemeEngine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+/**
+ * A file system without any files. The builtin theme does not need any,
+ * but the search manager always looks at the current directory.
+ */
+class EmptyFSNode : public AbstractFSNode {
+public:
+	AbstractFSNode *getChild(const Common::String &name) const { return new EmptyFSNode(); }
+	AbstractFSNode *getParent() const { return new EmptyFSNode(); }
+	bool exists() const { return false; }
+	bool getChildren(AbstractFSList &list, ListMode mode, bool hidden) const { return false; }
+	Common::String getName() const { return Common::String(); }
+	Common::String getPath() const { return Common::String(); }
+	bool isDirectory() const { return false; }
+	bool isReadable() const { return false; }
+	bool isWritable() const { return false; }
+	Common::SeekableReadStream *createReadStream() { return 0; }
+	Common::WriteStream *createWriteStream() { return 0; }
+};
+
+class EmptyFilesystemFactory : public FilesystemFactory {
+public:
+	AbstractFSNode *makeCurrentDirectoryFileNode() const { return new EmptyFSNode(); }
+	AbstractFSNode *makeFileNodePath(const Common::String &path) const { return new EmptyFSNode(); }
+	AbstractFSNode *makeRootFileNode() const { return new EmptyFSNode(); }
+};
+
+/**
+ * The benchmark OSystem with an RGB565 overlay of a given size, just enough
+ * for the theme engine to run. The overlay is kept in memory, so that what
+ * was drawn can be checked.
+ */
+class BenchmarkSystem : public Benchmark::System {
+public:
+	BenchmarkSystem() { _fsFactory = new EmptyFilesystemFactory(); }
+	~BenchmarkSystem() { _overlay.free(); }
+
+	void setOverlaySize(int width, int height) {
+		_overlay.free();
+		_overlay.create(width, height, getOverlayFormat());
+		clearOverlay();
+	}
+
+	const Graphics::Surface &getOverlay() const { return _overlay; }
+
+	int16 getHeight() { return _overlay.h; }
+	int16 getWidth() { return _overlay.w; }
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0); }
+	void clearOverlay() { memset(_overlay.pixels, 0, _overlay.pitch * _overlay.h); }
+	void grabOverlay(void *buf, int pitch) {
+		for (int y = 0; y < _overlay.h; ++y)
+			memcpy((byte *)buf + y * pitch, _overlay.getBasePtr(0, y), _overlay.w * _overlay.format.bytesPerPixel);
+	}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {
+		for (int i = 0; i < h; ++i)
+			memcpy(_overlay.getBasePtr(x, y + i), (const byte *)buf + i * pitch, w * _overlay.format.bytesPerPixel);
+	}
+	int16 getOverlayHeight() { return _overlay.h; }
+	int16 getOverlayWidth() { return _overlay.w; }
+
+private:
+	Graphics::Surface _overlay;
+};
+
+BenchmarkSystem *benchmarkSystem;
+
+/** A rectangle given in 640x480 coordinates, scaled to the overlay size. */
+Common::Rect rect(int scale, int x, int y, int w, int h) {
+	return Common::Rect(x * scale, y * scale, (x + w) * scale, (y + h) * scale);
+}
+
+/**
+ * Draws the launcher, and an options dialog on top of it, the way the GUI
+ * manager does when redrawing everything. Every widget type and state is
+ * drawn at least once. The frame number changes which widgets are
+ * highlighted, so that consecutive frames differ.
+ */
+void drawFrame(GUI::ThemeEngine &theme, int scale, int frame) {
+	typedef GUI::ThemeEngine Theme;
+
+	theme.clearAll();
+	theme.openDialog(true, Theme::kShadingNone);
+
+	// The launcher
+	theme.drawDialogBackground(rect(scale, 0, 0, 640, 480), Theme::kDialogBackgroundMain);
+	theme.drawText(rect(scale, 20, 10, 600, 20), "ScummVM 1.7.0git", Theme::kStateEnabled);
+	theme.drawWidgetBackground(rect(scale, 20, 40, 120, 20), 0, Theme::kWidgetBackgroundEditText);
+	theme.drawText(rect(scale, 24, 40, 112, 20), "Search:", Theme::kStateEnabled, Graphics::kTextAlignLeft);
+	theme.drawWidgetBackground(rect(scale, 20, 70, 460, 360), 0, Theme::kWidgetBackgroundBorder);
+	for (int i = 0; i < 17; ++i) {
+		const bool selected = (i == frame % 17);
+		theme.drawText(rect(scale, 24, 74 + i * 20, 440, 20), Common::String::format("Game number %d (PC/English)", i),
+		               selected ? Theme::kStateHighlight : Theme::kStateEnabled, Graphics::kTextAlignLeft,
+		               selected ? Theme::kTextInversionFocus : Theme::kTextInversionNone, 0, true, Theme::kFontStyleNormal);
+	}
+	theme.drawScrollbar(rect(scale, 464, 70, 16, 360), (80 + frame % 100) * scale, 60 * scale, Theme::kScrollbarStateSlider);
+
+	static const char *const launcherButtons[] = {
+		"Start", "Load...", "Add Game...", "Edit Game...", "Remove Game", "Options...", "About...", "Quit"
+	};
+	for (int i = 0; i < 8; ++i)
+		theme.drawButton(rect(scale, 500, 70 + i * 32, 120, 24), launcherButtons[i],
+		                 i == frame % 8 ? Theme::kStateHighlight : (i == 4 ? Theme::kStateDisabled : Theme::kStateEnabled));
+
+	theme.finishBuffering();
+	theme.updateScreen(false);
+
+	// The options dialog, over the shaded launcher
+	theme.openDialog(true, Theme::kShadingDim);
+	theme.drawDialogBackground(rect(scale, 40, 30, 560, 420), Theme::kDialogBackgroundDefault);
+
+	Common::Array<Common::String> tabs;
+	tabs.push_back("Graphics");
+	tabs.push_back("Audio");
+	tabs.push_back("Volume");
+	tabs.push_back("MIDI");
+	tabs.push_back("Paths");
+	theme.drawTab(rect(scale, 50, 40, 540, 350), 20 * scale, 90 * scale, tabs, frame % 5, 0, 2 * scale);
+
+	for (int i = 0; i < 4; ++i) {
+		theme.drawText(rect(scale, 60, 70 + i * 26, 120, 20), "Graphics mode:", Theme::kStateEnabled, Graphics::kTextAlignRight);
+		theme.drawPopUpWidget(rect(scale, 190, 70 + i * 26, 200, 20), "<default>", 0, i == 3 ? Theme::kStateDisabled : Theme::kStateEnabled);
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		theme.drawCheckbox(rect(scale, 60, 180 + i * 22, 200, 20), "Fullscreen mode", ((frame + i) & 1) != 0,
+		                   i == 2 ? Theme::kStateDisabled : Theme::kStateEnabled);
+		theme.drawRadiobutton(rect(scale, 300, 180 + i * 22, 200, 20), "Subtitles", i == frame % 3);
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		theme.drawWidgetBackground(rect(scale, 60, 260 + i * 24, 300, 16), 0, Theme::kWidgetBackgroundSlider);
+		theme.drawSlider(rect(scale, 60, 260 + i * 24, 300, 16), ((frame * 7 + i * 50) % 300) * scale,
+		                 i == 2 ? Theme::kStateDisabled : Theme::kStateEnabled);
+	}
+
+	theme.drawLineSeparator(rect(scale, 60, 340, 520, 4));
+	theme.drawWidgetBackground(rect(scale, 380, 260, 200, 60), 0, Theme::kWidgetBackgroundBorderSmall);
+	theme.drawWidgetBackground(rect(scale, 380, 330, 200, 20), 0, Theme::kWidgetBackgroundPlain);
+	theme.drawWidgetBackground(rect(scale, 60, 355, 300, 20), 0, Theme::kWidgetBackgroundEditText);
+	theme.drawText(rect(scale, 64, 355, 292, 20), "/home/user/games", Theme::kStateEnabled, Graphics::kTextAlignLeft);
+	theme.drawCaret(rect(scale, 200, 357, 1, 16), false);
+
+	theme.drawButton(rect(scale, 380, 410, 100, 24), "Cancel", frame % 4 == 0 ? Theme::kStatePressed : Theme::kStateEnabled);
+	theme.drawButton(rect(scale, 490, 410, 100, 24), "OK", frame % 4 == 1 ? Theme::kStateHighlight : Theme::kStateEnabled);
+
+	theme.drawDialogBackground(rect(scale, 400, 200, 160, 30), Theme::kDialogBackgroundTooltip);
+	theme.drawDialogBackground(rect(scale, 420, 100, 160, 60), Theme::kDialogBackgroundSpecial);
+	theme.drawDialogBackground(rect(scale, 420, 170, 160, 20), Theme::kDialogBackgroundPlain);
+
+	theme.finishBuffering();
+	theme.updateScreen();
+}
+
+/**
+ * Draws the builtin theme's widgets repeatedly for at least the given time,
+ * and prints the speed and the checksum of the overlay after the first
+ * frames.
+ */
+void benchmarkTheme(GUI::ThemeEngine::GraphicsMode mode, int scale, double minSeconds) {
+	benchmarkSystem->setOverlaySize(640 * scale, 480 * scale);
+
+	GUI::ThemeEngine theme("builtin", mode);
+	if (!theme.init()) {
+		printf("%-10s %dx failed to load the theme\n", "builtin", scale);
+		return;
+	}
+	theme.enable();
+
+	uint32 hash = 0;
+
+	Benchmark::Loop loop(minSeconds, 8);
+	do {
+		drawFrame(theme, scale, loop.getCount());
+
+		if (loop.getCount() < 8)
+			hash = (hash ^ Benchmark::hashSurface(benchmarkSystem->getOverlay())) * 16777619;
+	} while (loop.next());
+
+	theme.disable();
+
+	printf("%-10s %-3s %4dx%-4d %12.1f %12.3f   %08x\n", "builtin", mode == GUI::ThemeEngine::kGfxAntialias16bit ? "AA" : "",
+	       640 * scale, 480 * scale, loop.getPerSecond(), loop.getMillisEach(), hash);
+}
+
+/**
+ * Draws the shapes the builtin theme does not use, with the steps the
+ * other themes use for dialogs, buttons, tabs and sliders: gradients,
+ * rounded squares and shadows.
+ */
+void drawShapes(Graphics::VectorRenderer &renderer, int scale, int frame) {
+	typedef Graphics::VectorRenderer Renderer;
+
+	renderer.setFillMode(Renderer::kFillGradient);
+	renderer.setGradientFactor(1);
+	renderer.setGradientColors(214, 113, 8, 240, 200, 25);
+	renderer.setShadowOffset(0);
+	renderer.setStrokeWidth(0);
+	renderer.fillSurface();
+
+	// Dialog backgrounds
+	renderer.setGradientColors(254, 232, 204, 255, 242, 231);
+	renderer.setFgColor(0, 0, 0);
+	renderer.setStrokeWidth(1);
+	renderer.setShadowOffset(4 * scale);
+	renderer.drawRoundedSquare(40 * scale, 30 * scale, 8 * scale, 560 * scale, 400 * scale);
+	renderer.drawSquare(420 * scale, 100 * scale, 160 * scale, 60 * scale);
+
+	// Buttons
+	renderer.setShadowOffset(3 * scale);
+	renderer.setGradientFactor(2);
+	for (int i = 0; i < 8; ++i) {
+		if (i == frame % 8)
+			renderer.setGradientColors(206, 121, 99, 173, 40, 8);
+		else
+			renderer.setGradientColors(173, 40, 8, 241, 108, 24);
+		renderer.drawRoundedSquare((60 + (i % 4) * 130) * scale, (360 + (i / 4) * 34) * scale, 5 * scale, 110 * scale, 24 * scale);
+	}
+
+	// Tabs
+	renderer.setFillMode(Renderer::kFillBackground);
+	renderer.setShadowOffset(0);
+	renderer.setGradientFactor(1);
+	for (int i = 0; i < 5; ++i) {
+		if (i == frame % 5)
+			renderer.setBgColor(254, 232, 204);
+		else
+			renderer.setBgColor(206, 121, 99);
+		renderer.drawTab((60 + i * 100) * scale, 50 * scale, 5 * scale, 90 * scale, 20 * scale);
+	}
+
+	// Sliders, check boxes and radio buttons
+	renderer.setBgColor(255, 255, 255);
+	renderer.setFgColor(0, 0, 0);
+	renderer.setShadowOffset(1 * scale);
+	for (int i = 0; i < 3; ++i) {
+		renderer.drawRoundedSquare(60 * scale, (100 + i * 30) * scale, 4 * scale, 300 * scale, 16 * scale);
+		renderer.drawSquare(400 * scale, (100 + i * 30) * scale, 16 * scale, 16 * scale);
+		renderer.drawCircle(450 * scale, (108 + i * 30) * scale, 8 * scale);
+	}
+
+	renderer.setFillMode(Renderer::kFillGradient);
+	renderer.setGradientColors(206, 121, 99, 173, 40, 8);
+	for (int i = 0; i < 3; ++i)
+		renderer.drawRoundedSquare(62 * scale, (102 + i * 30) * scale, 3 * scale, ((frame * 7 + i * 50) % 290 + 6) * scale, 12 * scale);
+
+	// Edit fields, list and scroll bar
+	renderer.setFillMode(Renderer::kFillBackground);
+	renderer.setBgColor(0, 0, 0);
+	renderer.setBevelColor(255, 255, 255);
+	renderer.setFgColor(140, 140, 140);
+	renderer.setShadowOffset(0);
+	renderer.drawBeveledSquare(60 * scale, 200 * scale, 300 * scale, 20 * scale, 2 * scale);
+	renderer.drawBeveledSquare(60 * scale, 230 * scale, 300 * scale, 110 * scale, 2 * scale);
+	renderer.setFillMode(Renderer::kFillForeground);
+	renderer.setFgColor(255, 255, 255);
+	renderer.drawSquare(62 * scale, (232 + (frame % 5) * 20) * scale, 280 * scale, 20 * scale);
+	renderer.drawTriangle(344 * scale, 234 * scale, 12 * scale, 12 * scale, Renderer::kTriangleUp);
+	renderer.drawTriangle(344 * scale, 324 * scale, 12 * scale, 12 * scale, Renderer::kTriangleDown);
+}
+
+/**
+ * Draws the shapes repeatedly for at least the given time, and prints the
+ * speed and the checksum of the surface after the first frames.
+ */
+void benchmarkShapes(GUI::ThemeEngine::GraphicsMode mode, int scale, double minSeconds) {
+	Graphics::Surface surface;
+	surface.create(640 * scale, 480 * scale, benchmarkSystem->getOverlayFormat());
+
+	Graphics::VectorRenderer *renderer = Graphics::createRenderer(mode);
+	renderer->setSurface(&surface);
+
+	uint32 hash = 0;
+
+	Benchmark::Loop loop(minSeconds, 8);
+	do {
+		drawShapes(*renderer, scale, loop.getCount());
+
+		if (loop.getCount() < 8)
+			hash = (hash ^ Benchmark::hashSurface(surface)) * 16777619;
+	} while (loop.next());
+
+	delete renderer;
+	surface.free();
+
+	printf("%-10s %-3s %4dx%-4d %12.1f %12.3f   %08x\n", "shapes", mode == GUI::ThemeEngine::kGfxAntialias16bit ? "AA" : "",
+	       640 * scale, 480 * scale, loop.getPerSecond(), loop.getMillisEach(), hash);
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[]) {
+	double minSeconds = 1.0;
+
+	if (argc > 2 || (argc == 2 && (minSeconds = atof(argv[1])) <= 0.0)) {
+		printf("Usage: %s [seconds]\n\n", argv[0]);
+		printf("Draws the widgets of the builtin theme, and the gradients, rounded squares\n");
+		printf("and shadows of the other themes, with both renderers at 1x, 2x and 3x the\n");
+		printf("640x480 overlay size. Each test runs for the given time (1 second by\n");
+		printf("default) and reports the speed in frames per second, along with a checksum\n");
+		printf("of the drawn pixels to compare renderer changes with.\n");
+		return 1;
+	}
+
+	benchmarkSystem = new BenchmarkSystem();
+	g_system = benchmarkSystem;
+
+	printf("%-10s %-3s %9s %12s %12s   %8s\n", "Test", "", "Size", "frames/s", "ms/frame", "Checksum");
+
+	static const GUI::ThemeEngine::GraphicsMode modes[] = {
+		GUI::ThemeEngine::kGfxStandard16bit,
+#ifndef DISABLE_FANCY_THEMES
+		GUI::ThemeEngine::kGfxAntialias16bit
+#endif
+	};
+
+	for (uint i = 0; i < ARRAYSIZE(modes); ++i) {
+		for (int scale = 1; scale <= 3; ++scale)
+			benchmarkTheme(modes[i], scale, minSeconds);
+	}
+
+	for (uint i = 0; i < ARRAYSIZE(modes); ++i) {
+		for (int scale = 1; scale <= 3; ++scale)
+			benchmarkShapes(modes[i], scale, minSeconds);
+	}
+
+	g_system = 0;
+	delete benchmarkSystem;
+	return 0;
+}
@@ -82,6 +82,9 @@ public:
 
 protected:
 	void readSoundData(Common::SeekableReadStream *stream);
+	// processFrame() syncs to the start time of the track's next frame,
+	// which is ahead of the shown one when decoding ahead
+	bool supportsDecodeAhead() const { return false; }
 
 private:
 	void handleNextFrame();
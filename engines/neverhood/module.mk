@@ -12,7 +12,6 @@ MODULE_OBJS = \
 	graphics.o \
 	klaymen.o \
 	menumodule.o \
-	microtiles.o \
 	module.o \
 	modules/module1000.o \
 	modules/module1100.o \
@@ -36,7 +36,7 @@ Screen::Screen(NeverhoodEngine *vm)
 
 	_renderQueue = new RenderQueue();
 	_prevRenderQueue = new RenderQueue();
-	_microTiles = new MicroTileArray(640, 480);
+	_microTiles = new Graphics::MicroTileArray(640, 480);
 
 }
 
@@ -86,18 +86,18 @@ void Screen::update() {
 		renderItem._refresh = true;
 	}
 
-	RectangleList *updateRects = _microTiles->getRectangles();
+	Graphics::RectangleList *updateRects = _microTiles->getRectangles();
 
 	for (RenderQueue::iterator it = _renderQueue->begin(); it != _renderQueue->end(); ++it) {
 		RenderItem &renderItem = (*it);
-		for (RectangleList::iterator ri = updateRects->begin(); ri != updateRects->end(); ++ri)
+		for (Graphics::RectangleList::iterator ri = updateRects->begin(); ri != updateRects->end(); ++ri)
 			blitRenderItem(renderItem, *ri);
 	}
 
 	SWAP(_renderQueue, _prevRenderQueue);
 	_renderQueue->clear();
 
-	for (RectangleList::iterator ri = updateRects->begin(); ri != updateRects->end(); ++ri) {
+	for (Graphics::RectangleList::iterator ri = updateRects->begin(); ri != updateRects->end(); ++ri) {
 		Common::Rect &r = *ri;
 		_vm->_system->copyRectToScreen((const byte*)_backScreen->getBasePtr(r.left, r.top), _backScreen->pitch, r.left, r.top, r.width(), r.height());
 	}
@@ -51,6 +51,11 @@ public:
 class NeverhoodSmackerDecoder : public Video::SmackerDecoder {
 public:
 	void forceSeekToFrame(uint frame);
+
+protected:
+	// forceSeekToFrame() moves the stream and the track behind the back of
+	// the decoder
+	bool supportsDecodeAhead() const { return false; }
 };
 
 class SmackerPlayer : public Entity {
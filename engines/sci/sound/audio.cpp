@@ -44,7 +44,8 @@
 namespace Sci {
 
 AudioPlayer::AudioPlayer(ResourceManager *resMan) : _resMan(resMan), _audioRate(11025),
-		_syncResource(NULL), _syncOffset(0), _audioCdStart(0) {
+		_syncResource(NULL), _syncOffset(0), _audioCdStart(0),
+		_decodedCache(2 * 1024 * 1024, 256 * 1024) {
 
 	_mixer = g_system->getMixer();
 	_wPlayFlag = false;
@@ -276,6 +277,16 @@ Audio::RewindableAudioStream *AudioPlayer::getAudioStream(uint32 number, uint32
 
 	if (audioCompressionType) {
 #if (defined(USE_MAD) || defined(USE_VORBIS) || defined(USE_FLAC))
+		// Short compressed sounds are kept decoded, as they tend to be played
+		// over and over again. They get recorded for the cache while they are
+		// played for the first time.
+		const Common::String cacheKey = Common::String::format("%u:%u", volume, number);
+		audioSeekStream = _decodedCache.createStream(cacheKey);
+		if (audioSeekStream) {
+			*sampleLen = (audioSeekStream->getLength().msecs() * 60) / 1000; // we translate msecs to ticks
+			return audioSeekStream;
+		}
+
 		// Compressed audio made by our tool
 		byte *compressedData = (byte *)malloc(audioRes->size);
 		assert(compressedData);
@@ -304,6 +315,8 @@ Audio::RewindableAudioStream *AudioPlayer::getAudioStream(uint32 number, uint32
 #endif
 			break;
 		}
+
+		audioSeekStream = _decodedCache.cacheStream(cacheKey, audioSeekStream);
 #else
 		error("Compressed audio file encountered, but no appropriate decoder is compiled in");
 #endif
@@ -25,6 +25,7 @@
 #define SCI_AUDIO_H
 
 #include "sci/engine/vm_types.h"
+#include "audio/audiocache.h"
 #include "audio/mixer.h"
 
 namespace Audio {
@@ -95,6 +96,7 @@ private:
 	uint _syncOffset;
 	uint32 _audioCdStart;
 	bool _wPlayFlag;
+	Audio::DecodedAudioCache _decodedCache; /**< Decoded MP3/OGG/FLAC audio resources */
 };
 
 } // End of namespace Sci
@@ -170,7 +170,7 @@ void Animation::setFrame(uint nr) {
 	forceRefresh();
 }
 
-bool Animation::doRender(RectangleList *updateRects) {
+bool Animation::doRender(Graphics::RectangleList *updateRects) {
 	AnimationDescription *animationDescriptionPtr = getAnimationDescription();
 	assert(animationDescriptionPtr);
 	assert(_currentFrame < animationDescriptionPtr->getFrameCount());
@@ -151,7 +151,7 @@ public:
 	void setCallbacks();
 
 protected:
-	virtual bool doRender(RectangleList *updateRects);
+	virtual bool doRender(Graphics::RectangleList *updateRects);
 
 private:
 	enum Direction {
@@ -124,7 +124,7 @@ public:
 	          Common::Rect *pSrcPartRect = NULL,
 	          uint color = BS_ARGB(255, 255, 255, 255),
 	          int width = -1, int height = -1,
-			  RectangleList *updateRects = 0) {
+			  Graphics::RectangleList *updateRects = 0) {
 		assert(_pImage);
 		return _pImage->blit(posX, posY, flipping, pSrcPartRect, color, width, height, updateRects);
 	}
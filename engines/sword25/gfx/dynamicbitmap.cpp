@@ -73,7 +73,7 @@ uint DynamicBitmap::getPixel(int x, int y) const {
 	return _image->getPixel(x, y);
 }
 
-bool DynamicBitmap::doRender(RectangleList *updateRects) {
+bool DynamicBitmap::doRender(Graphics::RectangleList *updateRects) {
 	// Get the frame buffer object
 	GraphicEngine *pGfx = Kernel::getInstance()->getGfx();
 	assert(pGfx);
@@ -42,11 +42,11 @@
 // Includes
 #include "sword25/kernel/common.h"
 #include "common/rect.h"
+#include "graphics/microtiles.h"
 #include "sword25/gfx/graphicengine.h"
 
 namespace Sword25 {
 
-class RectangleList;
 
 class Image {
 public:
@@ -132,7 +132,7 @@ public:
 	                  Common::Rect *pPartRect = NULL,
 	                  uint color = BS_ARGB(255, 255, 255, 255),
 	                  int width = -1, int height = -1,
-					  RectangleList *updateRects = 0) = 0;
+					  Graphics::RectangleList *updateRects = 0) = 0;
 
 	/**
 	    @brief fills a rectangular section of the image with a color.
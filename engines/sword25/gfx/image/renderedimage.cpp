@@ -229,7 +229,7 @@ uint RenderedImage::getPixel(int x, int y) {
 
 // -----------------------------------------------------------------------------
 
-bool RenderedImage::blit(int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height, RectangleList *updateRects) {
+bool RenderedImage::blit(int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height, Graphics::RectangleList *updateRects) {
 	int ca = (color >> 24) & 0xff;
 
 	// Check if we need to draw anything at all
@@ -292,7 +292,7 @@ bool RenderedImage::blit(int posX, int posY, int flipping, Common::Rect *pPartRe
 		img = &srcImage;
 	}
 
-	for (RectangleList::iterator it = updateRects->begin(); it != updateRects->end(); ++it) {
+	for (Graphics::RectangleList::iterator it = updateRects->begin(); it != updateRects->end(); ++it) {
 		const Common::Rect &clipRect = *it;
 
 		int skipLeft = 0, skipTop = 0;
@@ -80,7 +80,7 @@ bool SWImage::blit(int posX, int posY,
                       Common::Rect *pPartRect,
                       uint color,
                       int width, int height,
-					  RectangleList *updateRects) {
+					  Graphics::RectangleList *updateRects) {
 	error("Blit() is not supported.");
 	return false;
 }
@@ -604,7 +604,7 @@ bool VectorImage::blit(int posX, int posY,
                        Common::Rect *pPartRect,
                        uint color,
                        int width, int height,
-					   RectangleList *updateRects) {
+					   Graphics::RectangleList *updateRects) {
 	static VectorImage *oldThis = 0;
 	static int              oldWidth = -2;
 	static int              oldHeight = -2;
@@ -213,7 +213,7 @@ public:
 	                  Common::Rect *pPartRect = NULL,
 	                  uint color = BS_ARGB(255, 255, 255, 255),
 	                  int width = -1, int height = -1,
-					  RectangleList *updateRects = 0);
+					  Graphics::RectangleList *updateRects = 0);
 
 	class SWFBitStream;
 
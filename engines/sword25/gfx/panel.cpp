@@ -69,7 +69,7 @@ Panel::Panel(InputPersistenceBlock &reader, RenderObjectPtr<RenderObject> parent
 Panel::~Panel() {
 }
 
-bool Panel::doRender(RectangleList *updateRects) {
+bool Panel::doRender(Graphics::RectangleList *updateRects) {
 	// Falls der Alphawert 0 ist, ist das Panel komplett durchsichtig und es muss nichts gezeichnet werden.
 	if (_color >> 24 == 0)
 		return true;
@@ -77,7 +77,7 @@ bool Panel::doRender(RectangleList *updateRects) {
 	GraphicEngine *gfxPtr = Kernel::getInstance()->getGfx();
 	assert(gfxPtr);
 
-	for (RectangleList::iterator it = updateRects->begin(); it != updateRects->end(); ++it) {
+	for (Graphics::RectangleList::iterator it = updateRects->begin(); it != updateRects->end(); ++it) {
 		const Common::Rect &clipRect = *it;
 		if (_bbox.intersects(clipRect)) {
 			Common::Rect intersectionRect = _bbox.findIntersectingRect(clipRect);
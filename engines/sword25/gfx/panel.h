@@ -61,7 +61,7 @@ public:
 	virtual bool unpersist(InputPersistenceBlock &reader);
 
 protected:
-	virtual bool doRender(RectangleList *updateRects);
+	virtual bool doRender(Graphics::RectangleList *updateRects);
 
 private:
 	uint _color;
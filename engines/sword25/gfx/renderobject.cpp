@@ -131,7 +131,7 @@ void RenderObject::preRender(RenderObjectQueue *renderQueue) {
 
 }
 
-bool RenderObject::render(RectangleList *updateRects, const Common::Array<int> &updateRectsMinZ) {
+bool RenderObject::render(Graphics::RectangleList *updateRects, const Common::Array<int> &updateRectsMinZ) {
 
 	// Falls das Objekt nicht sichtbar ist, muss gar nichts gezeichnet werden
 	if (!_visible)
@@ -143,7 +143,7 @@ bool RenderObject::render(RectangleList *updateRects, const Common::Array<int> &
 
 	// Only draw if the bounding box intersects any update rectangle and
 	// the object is in front of the minimum Z value.
-	for (RectangleList::iterator rectIt = updateRects->begin(); !needRender && rectIt != updateRects->end(); ++rectIt, ++index)
+	for (Graphics::RectangleList::iterator rectIt = updateRects->begin(); !needRender && rectIt != updateRects->end(); ++rectIt, ++index)
 		needRender = (_bbox.contains(*rectIt) || _bbox.intersects(*rectIt)) && getAbsoluteZ() >= updateRectsMinZ[index];
 
 	if (needRender)
@@ -45,6 +45,7 @@
 #include "sword25/kernel/common.h"
 #include "sword25/kernel/persistable.h"
 #include "common/rect.h"
+#include "graphics/microtiles.h"
 #include "sword25/gfx/renderobjectptr.h"
 
 #include "common/list.h"
@@ -54,7 +55,6 @@ namespace Sword25 {
 class Kernel;
 class RenderObjectManager;
 class RenderObjectQueue;
-class RectangleList;
 class Bitmap;
 class Animation;
 class AnimationTemplate;
@@ -223,7 +223,7 @@ public:
 	            Dieses kann entweder direkt geschehen oder durch den Aufruf von UpdateObjectState() an einem Vorfahren-Objekt.<br>
 	            Diese Methode darf nur von BS_RenderObjectManager aufgerufen werden.
 	*/
-	bool render(RectangleList *updateRects, const Common::Array<int> &updateRectsMinZ);
+	bool render(Graphics::RectangleList *updateRects, const Common::Array<int> &updateRectsMinZ);
 
 	/**
 	    @brief Bereitet das Objekt und alle seine Unterobjekte auf einen Rendervorgang vor.
@@ -430,7 +430,7 @@ protected:
 	    @return Gibt false zurck, falls das Rendern fehlgeschlagen ist.
 	    @remark
 	 */
-	virtual bool doRender(RectangleList *updateRects) = 0; // { return true; }
+	virtual bool doRender(Graphics::RectangleList *updateRects) = 0; // { return true; }
 
 	// RenderObject-Baum Variablen
 	// ---------------------------
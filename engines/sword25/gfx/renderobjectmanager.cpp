@@ -61,7 +61,7 @@ RenderObjectManager::RenderObjectManager(int width, int height, int framebufferC
 	_frameStarted(false) {
 	// Wurzel des BS_RenderObject-Baumes erzeugen.
 	_rootPtr = (new RootRenderObject(this, width, height))->getHandle();
-	_uta = new MicroTileArray(width, height);
+	_uta = new Graphics::MicroTileArray(width, height);
 	_currQueue = new RenderObjectQueue();
 	_prevQueue = new RenderObjectQueue();
 }
@@ -111,7 +111,7 @@ bool RenderObjectManager::render() {
     	if (!_prevQueue->exists(*it))
     		_uta->addRect((*it)._bbox);
 
-	RectangleList *updateRects = _uta->getRectangles();
+	Graphics::RectangleList *updateRects = _uta->getRectangles();
 	Common::Array<int> updateRectsMinZ;
 
 	updateRectsMinZ.reserve(updateRects->size());
@@ -119,7 +119,7 @@ bool RenderObjectManager::render() {
 	// Calculate the minimum drawing Z value of each update rectangle
 	// Solid bitmaps with a Z order less than the value calculated here would be overdrawn again and
 	// so don't need to be drawn in the first place which speeds things up a bit.
-	for (RectangleList::iterator rectIt = updateRects->begin(); rectIt != updateRects->end(); ++rectIt) {
+	for (Graphics::RectangleList::iterator rectIt = updateRects->begin(); rectIt != updateRects->end(); ++rectIt) {
 		int minZ = 0;
 		for (RenderObjectQueue::iterator it = _currQueue->reverse_begin(); it != _currQueue->end(); --it) {
 			if ((*it)._renderObject->isVisible() && (*it)._renderObject->isSolid() &&
@@ -134,7 +134,7 @@ bool RenderObjectManager::render() {
 	if (_rootPtr->render(updateRects, updateRectsMinZ)) {
 		// Copy updated rectangles to the video screen
 		Graphics::Surface *backSurface = Kernel::getInstance()->getGfx()->getSurface();
-		for (RectangleList::iterator rectIt = updateRects->begin(); rectIt != updateRects->end(); ++rectIt) {
+		for (Graphics::RectangleList::iterator rectIt = updateRects->begin(); rectIt != updateRects->end(); ++rectIt) {
 			const int x = (*rectIt).left;
 			const int y = (*rectIt).top;
 			const int width = (*rectIt).width();
@@ -47,7 +47,7 @@
 #include "sword25/gfx/renderobjectptr.h"
 #include "sword25/kernel/persistable.h"
 
-#include "sword25/gfx/microtiles.h"
+#include "graphics/microtiles.h"
 
 namespace Sword25 {
 
@@ -131,7 +131,7 @@ private:
 	typedef Common::Array<RenderObjectPtr<TimedRenderObject> > RenderObjectList;
 	RenderObjectList _timedRenderObjects;
 
-	MicroTileArray *_uta;
+	Graphics::MicroTileArray *_uta;
 	RenderObjectQueue *_currQueue, *_prevQueue;
 
 	// RenderObject-Tree Variablen
@@ -59,7 +59,7 @@ private:
 	}
 
 protected:
-	virtual bool doRender(RectangleList *updateRects) {
+	virtual bool doRender(Graphics::RectangleList *updateRects) {
 		return true;
 	}
 };
@@ -83,7 +83,7 @@ bool StaticBitmap::initBitmapResource(const Common::String &filename) {
 StaticBitmap::~StaticBitmap() {
 }
 
-bool StaticBitmap::doRender(RectangleList *updateRects) {
+bool StaticBitmap::doRender(Graphics::RectangleList *updateRects) {
 	// Bitmap holen
 	Resource *resourcePtr = Kernel::getInstance()->getResourceManager()->requestResource(_resourceFilename);
 	assert(resourcePtr);
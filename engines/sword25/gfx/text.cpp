@@ -131,7 +131,7 @@ void Text::setAutoWrapThreshold(uint autoWrapThreshold) {
 	}
 }
 
-bool Text::doRender(RectangleList *updateRects) {
+bool Text::doRender(Graphics::RectangleList *updateRects) {
 	// Font-Resource locken.
 	FontResource *fontPtr = lockFontResource();
 	if (!fontPtr)
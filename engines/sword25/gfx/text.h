@@ -136,7 +136,7 @@ public:
 	virtual bool  unpersist(InputPersistenceBlock &reader);
 
 protected:
-	virtual bool doRender(RectangleList *updateRects);
+	virtual bool doRender(Graphics::RectangleList *updateRects);
 
 private:
 	Text(RenderObjectPtr<RenderObject> parentPtr);
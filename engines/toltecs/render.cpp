@@ -41,7 +41,7 @@ Common::Rect makeRect(int16 x, int16 y, int16 width, int16 height) {
 RenderQueue::RenderQueue(ToltecsEngine *vm) : _vm(vm) {
 	_currQueue = new RenderQueueArray();
 	_prevQueue = new RenderQueueArray();
-	_updateUta = new MicroTileArray(640, 400);
+	_updateUta = new Graphics::MicroTileArray(640, 400);
 }
 
 RenderQueue::~RenderQueue() {
@@ -280,31 +280,44 @@ void RenderQueue::addDirtyRect(const Common::Rect &rect) {
 }
 
 void RenderQueue::restoreDirtyBackground() {
-	int n_rects = 0;
-	Common::Rect *rects = _updateUta->getRectangles(&n_rects, 0, 0, 639, _vm->_cameraHeight - 1);
-	for (int i = 0; i < n_rects; i++) {
-		byte *destp = _vm->_screen->_frontScreen + rects[i].left + rects[i].top * 640;
-		byte *srcp = _vm->_screen->_backScreen + (_vm->_cameraX + rects[i].left) + (_vm->_cameraY + rects[i].top) * _vm->_sceneWidth;
-		int16 w = rects[i].width();
-		int16 h = rects[i].height();
+	Graphics::RectangleList *updateRects = getDirtyRects();
+	for (Graphics::RectangleList::const_iterator r = updateRects->begin(); r != updateRects->end(); ++r) {
+		byte *destp = _vm->_screen->_frontScreen + r->left + r->top * 640;
+		byte *srcp = _vm->_screen->_backScreen + (_vm->_cameraX + r->left) + (_vm->_cameraY + r->top) * _vm->_sceneWidth;
+		int16 w = r->width();
+		int16 h = r->height();
 		while (h--) {
 			memcpy(destp, srcp, w);
 			destp += 640;
 			srcp += _vm->_sceneWidth;
 		}
-		invalidateItemsByRect(rects[i], NULL);
+		invalidateItemsByRect(*r, NULL);
 	}
-	delete[] rects;
+	delete updateRects;
 }
 
 void RenderQueue::updateDirtyRects() {
-	int n_rects = 0;
-	Common::Rect *rects = _updateUta->getRectangles(&n_rects, 0, 0, 639, _vm->_cameraHeight - 1);
-	for (int i = 0; i < n_rects; i++) {
-		_vm->_system->copyRectToScreen(_vm->_screen->_frontScreen + rects[i].left + rects[i].top * 640,
-			640, rects[i].left, rects[i].top, rects[i].width(), rects[i].height());
+	Graphics::RectangleList *updateRects = getDirtyRects();
+	for (Graphics::RectangleList::const_iterator r = updateRects->begin(); r != updateRects->end(); ++r) {
+		_vm->_system->copyRectToScreen(_vm->_screen->_frontScreen + r->left + r->top * 640,
+			640, r->left, r->top, r->width(), r->height());
 	}
-	delete[] rects;
+	delete updateRects;
+}
+
+Graphics::RectangleList *RenderQueue::getDirtyRects() {
+	// Only the part of the screen showing the scene is restored and updated
+	const Common::Rect camera(640, _vm->_cameraHeight);
+
+	Graphics::RectangleList *updateRects = _updateUta->getRectangles();
+	for (Graphics::RectangleList::iterator r = updateRects->begin(); r != updateRects->end(); ) {
+		r->clip(camera);
+		if (r->isEmpty())
+			r = updateRects->erase(r);
+		else
+			++r;
+	}
+	return updateRects;
 }
 
 
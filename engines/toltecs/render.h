@@ -24,11 +24,11 @@
 #ifndef TOLTECS_RENDER_H
 #define TOLTECS_RENDER_H
 
+#include "graphics/microtiles.h"
 #include "graphics/surface.h"
 
 #include "toltecs/segmap.h"
 #include "toltecs/screen.h"
-#include "toltecs/microtiles.h"
 
 namespace Toltecs {
 
@@ -81,7 +81,7 @@ protected:
 
 	ToltecsEngine *_vm;
 	RenderQueueArray *_currQueue, *_prevQueue;
-	MicroTileArray *_updateUta;
+	Graphics::MicroTileArray *_updateUta;
 
 	bool rectIntersectsItem(const Common::Rect &rect);
     RenderQueueItem *findItemInQueue(RenderQueueArray *queue, const RenderQueueItem &item);
@@ -91,6 +91,7 @@ protected:
     void addDirtyRect(const Common::Rect &rect);
     void restoreDirtyBackground();
     void updateDirtyRects();
+    Graphics::RectangleList *getDirtyRects();
 
 };
 
@@ -38,6 +38,9 @@ public:
 protected:
 	void handleAudioTrack(byte track, uint32 chunkSize, uint32 unpackedSize);
 	SmackerVideoTrack *createVideoTrack(uint32 width, uint32 height, uint32 frameCount, const Common::Rational &frameRate, uint32 flags, uint32 signature) const;
+	// handleAudioTrack() sets the resolution returned by isLowRes() as the
+	// packets are read, which must match the frame being shown
+	bool supportsDecodeAhead() const { return false; }
 
 private:
 	bool _lowRes;
@@ -26,6 +26,7 @@
 
 #include "graphics/surface.h"
 #include "graphics/colormasks.h"
+#include "graphics/rowfill.h"
 
 #include "gui/ThemeEngine.h"
 #include "graphics/VectorRenderer.h"
@@ -241,37 +242,21 @@ namespace Graphics {
 /**
  * Fills several pixels in a row with a given color.
  *
- * This is a replacement function for Common::fill, using an unrolled
- * loop to maximize performance on most architectures.
- * This function may (and should) be overloaded in any child renderers
- * for portable platforms with platform-specific assembly code.
+ * This is a replacement function for Common::fill. The actual work is
+ * done by Graphics::fillRow, which writes several pixels at a time where
+ * the platform allows it.
  *
  * This fill operation is extensively used throughout the renderer, so this
- * counts as one of the main bottlenecks. Please replace it with assembly
- * when possible!
+ * counts as one of the main bottlenecks.
  *
  * @param first Pointer to the first pixel to fill.
  * @param last Pointer to the last pixel to fill.
  * @param color Color of the pixel
  */
 template<typename PixelType>
-void colorFill(PixelType *first, PixelType *last, PixelType color) {
-	register int count = (last - first);
-	if (!count)
-		return;
-	register int n = (count + 7) >> 3;
-	switch (count % 8) {
-	case 0: do {
-				*first++ = color;
-	case 7:		*first++ = color;
-	case 6:		*first++ = color;
-	case 5:		*first++ = color;
-	case 4:		*first++ = color;
-	case 3:		*first++ = color;
-	case 2:		*first++ = color;
-	case 1:		*first++ = color;
-			} while (--n > 0);
-	}
+inline void colorFill(PixelType *first, PixelType *last, PixelType color) {
+	if (last > first)
+		fillRow(first, last - first, color, color);
 }
 
 
@@ -380,17 +365,15 @@ gradientFill(PixelType *ptr, int width, int x, int y) {
 		colorFill<PixelType>(ptr, ptr + width, _gradCache[curGrad]);
 	} else if (grad == 3 && ox) {
 		colorFill<PixelType>(ptr, ptr + width, _gradCache[curGrad + 1]);
-	} else {
-		for (int j = x; j < x + width; j++, ptr++) {
-			bool oy = ((j & 1) == 1);
-
-			if ((ox && oy) ||
-				((grad == 2 || grad == 3) && ox && !oy) ||
-				(grad == 3 && oy))
-				*ptr = _gradCache[curGrad + 1];
-			else
-				*ptr = _gradCache[curGrad];
-		}
+	} else if (width > 0) {
+		// The pattern of a row only depends on the parity of the column
+		const PixelType evenColor = ((grad == 2 || grad == 3) && ox) ? _gradCache[curGrad + 1] : _gradCache[curGrad];
+		const PixelType oddColor = (ox || grad == 3) ? _gradCache[curGrad + 1] : _gradCache[curGrad];
+
+		if (x & 1)
+			fillRow(ptr, width, oddColor, evenColor);
+		else
+			fillRow(ptr, width, evenColor, oddColor);
 	}
 }
 
@@ -520,10 +503,7 @@ applyScreenShading(GUI::ThemeEngine::ShadingStyle shadingStyle) {
 	if (shadingStyle == GUI::ThemeEngine::kShadingDim) {
 
 		// TODO: Check how this interacts with kFeatureOverlaySupportsAlpha
-		for (int i = 0; i < pixels; ++i) {
-			*ptr = ((*ptr & colorMask) >> 1) | _alphaMask;
-			++ptr;
-		}
+		darkenRow(ptr, pixels, (PixelType)colorMask, 1, _alphaMask, 0);
 
 	} else if (shadingStyle == GUI::ThemeEngine::kShadingLuminance) {
 		while (pixels--) {
@@ -578,10 +558,7 @@ darkenFill(PixelType *ptr, PixelType *end) {
 	if (!g_system->hasFeature(OSystem::kFeatureOverlaySupportsAlpha)) {
 		// !kFeatureOverlaySupportsAlpha (but might have alpha bits)
 
-		while (ptr != end) {
-			*ptr = ((*ptr & ~mask) >> 2) | _alphaMask;
-			++ptr;
-		}
+		darkenRow(ptr, end - ptr, (PixelType)~mask, 2, _alphaMask, 0);
 	} else {
 		// kFeatureOverlaySupportsAlpha
 		// assuming at least 3 alpha bits
@@ -590,12 +567,9 @@ darkenFill(PixelType *ptr, PixelType *end) {
 		PixelType addA = (PixelType)(255 >> _format.aLoss) << _format.aShift;
 		addA -= (addA >> 2);
 
-		while (ptr != end) {
-			// Darken the colour, and increase the alpha
-			// (0% -> 75%, 100% -> 100%)
-			*ptr = (PixelType)(((*ptr & ~mask) >> 2) + addA);
-			++ptr;
-		}
+		// Darken the colour, and increase the alpha
+		// (0% -> 75%, 100% -> 100%)
+		darkenRow(ptr, end - ptr, (PixelType)~mask, 2, 0, addA);
 	}
 }
 
@@ -1616,9 +1590,7 @@ drawSquareShadow(int x, int y, int w, int h, int blur) {
 	ptr = (PixelType *)_activeSurface->getBasePtr(x + blur, y + h - 1);
 
 	while (i++ < blur) {
-		j = w - blur;
-		while (j--)
-			blendPixelPtr(ptr + j, 0, ((blur - i) << 8) / blur);
+		blendFill(ptr, ptr + w - blur, 0, ((blur - i) << 8) / blur);
 		ptr += pitch;
 	}
 
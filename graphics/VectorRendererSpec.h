@@ -24,6 +24,7 @@
 #define VECTOR_RENDERER_SPEC_H
 
 #include "graphics/VectorRenderer.h"
+#include "graphics/rowfill.h"
 
 namespace Graphics {
 
@@ -216,7 +217,8 @@ protected:
 	 * @param alpha Alpha intensity of the pixel (0-255)
 	 */
 	inline void blendFill(PixelType *first, PixelType *last, PixelType color, uint8 alpha) {
-		while (first != last) blendPixelPtr(first++, color, alpha);
+		if (last > first)
+			blendRow(first, last - first, color, alpha, _format);
 	}
 
 	void darkenFill(PixelType *first, PixelType *last);
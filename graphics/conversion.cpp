@@ -24,6 +24,10 @@
 
 #include "common/endian.h"
 
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Graphics {
 
 // TODO: YUV to RGB conversion function
@@ -95,6 +99,166 @@ inline void crossBlitLogic3BppSource(byte *dst, const byte *src, const uint w, c
 	}
 }
 
+#ifdef USE_SSE2
+
+/**
+ * Converts four colors at a time, with the same result as converting each
+ * of them with PixelFormat::colorToARGB() and PixelFormat::ARGBToColor().
+ * Every channel is moved into place with a couple of shifts and a mask,
+ * which works for any pair of formats.
+ */
+class ColorConverterSSE2 {
+public:
+	ColorConverterSSE2(const PixelFormat &srcFmt, const PixelFormat &dstFmt) : _numChannels(0) {
+		uint32 constant = 0;
+
+		addChannel(srcFmt.rShift, srcFmt.rLoss, dstFmt.rLoss, dstFmt.rShift);
+		addChannel(srcFmt.gShift, srcFmt.gLoss, dstFmt.gLoss, dstFmt.gShift);
+		addChannel(srcFmt.bShift, srcFmt.bLoss, dstFmt.bLoss, dstFmt.bShift);
+
+		// Colors without alpha are opaque
+		if (srcFmt.aBits() == 0)
+			constant = dstFmt.ARGBToColor(0xFF, 0, 0, 0);
+		else
+			addChannel(srcFmt.aShift, srcFmt.aLoss, dstFmt.aLoss, dstFmt.aShift);
+
+		_constant = _mm_set1_epi32(constant);
+	}
+
+	__m128i convert(__m128i colors) const {
+		const __m128i byteMask = _mm_set1_epi32(0xFF);
+		__m128i result = _constant;
+
+		for (int i = 0; i < _numChannels; ++i) {
+			const Channel &c = _channels[i];
+			__m128i value = _mm_sll_epi32(_mm_srl_epi32(colors, c.srcShift), c.srcLoss);
+			value = _mm_and_si128(value, byteMask);
+			value = _mm_sll_epi32(_mm_srl_epi32(value, c.dstLoss), c.dstShift);
+			result = _mm_or_si128(result, value);
+		}
+
+		return result;
+	}
+
+private:
+	struct Channel {
+		__m128i srcShift, srcLoss, dstLoss, dstShift;
+	};
+
+	Channel _channels[4];
+	int _numChannels;
+	__m128i _constant;
+
+	void addChannel(byte srcShift, byte srcLoss, byte dstLoss, byte dstShift) {
+		// Channels missing on either side do not contribute anything
+		if (srcLoss >= 8 || dstLoss >= 8)
+			return;
+
+		Channel &c = _channels[_numChannels++];
+		c.srcShift = _mm_cvtsi32_si128(srcShift);
+		c.srcLoss = _mm_cvtsi32_si128(srcLoss);
+		c.dstLoss = _mm_cvtsi32_si128(dstLoss);
+		c.dstShift = _mm_cvtsi32_si128(dstShift);
+	}
+};
+
+inline void loadColors(const uint16 *src, __m128i &lo, __m128i &hi) {
+	const __m128i colors = _mm_loadu_si128((const __m128i *)src);
+	lo = _mm_unpacklo_epi16(colors, _mm_setzero_si128());
+	hi = _mm_unpackhi_epi16(colors, _mm_setzero_si128());
+}
+
+inline void loadColors(const uint32 *src, __m128i &lo, __m128i &hi) {
+	lo = _mm_loadu_si128((const __m128i *)src);
+	hi = _mm_loadu_si128((const __m128i *)(src + 4));
+}
+
+inline void storeColors(uint16 *dst, __m128i lo, __m128i hi) {
+	// Keep the lower 16 bits of each color, like storing to a uint16 does,
+	// and sign extend them so that packing does not saturate
+	lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+	hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+	_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(lo, hi));
+}
+
+inline void storeColors(uint32 *dst, __m128i lo, __m128i hi) {
+	_mm_storeu_si128((__m128i *)dst, lo);
+	_mm_storeu_si128((__m128i *)(dst + 4), hi);
+}
+
+/**
+ * Same as crossBlitLogic(), converting eight pixels at a time. All of them
+ * are read before any is written, so this can convert in place in the same
+ * cases.
+ */
+template<typename SrcColor, typename DstColor, bool backward>
+void crossBlitLogicSSE2(byte *dst, const byte *src, const uint w, const uint h,
+                        const PixelFormat &srcFmt, const PixelFormat &dstFmt,
+                        const uint srcDelta, const uint dstDelta) {
+	const ColorConverterSSE2 converter(srcFmt, dstFmt);
+
+	for (uint y = 0; y < h; ++y) {
+		uint x = 0;
+
+		for (; x + 8 <= w; x += 8) {
+			__m128i lo, hi;
+
+			if (backward) {
+				loadColors((const SrcColor *)src - 7, lo, hi);
+				storeColors((DstColor *)dst - 7, converter.convert(lo), converter.convert(hi));
+				src -= 8 * sizeof(SrcColor);
+				dst -= 8 * sizeof(DstColor);
+			} else {
+				loadColors((const SrcColor *)src, lo, hi);
+				storeColors((DstColor *)dst, converter.convert(lo), converter.convert(hi));
+				src += 8 * sizeof(SrcColor);
+				dst += 8 * sizeof(DstColor);
+			}
+		}
+
+		// The remaining pixels of the row
+		crossBlitLogic<SrcColor, DstColor, backward>(dst, src, w - x, 1, srcFmt, dstFmt, 0, 0);
+		if (backward) {
+			src -= (w - x) * sizeof(SrcColor) + srcDelta;
+			dst -= (w - x) * sizeof(DstColor) + dstDelta;
+		} else {
+			src += (w - x) * sizeof(SrcColor) + srcDelta;
+			dst += (w - x) * sizeof(DstColor) + dstDelta;
+		}
+	}
+}
+
+#endif // USE_SSE2
+
+/**
+ * Picks the fastest implementation of crossBlitLogic() available.
+ */
+template<typename SrcColor, typename DstColor, bool backward>
+inline void crossBlitRows(byte *dst, const byte *src, const uint w, const uint h,
+                          const PixelFormat &srcFmt, const PixelFormat &dstFmt,
+                          const uint srcDelta, const uint dstDelta) {
+#ifdef USE_SSE2
+	crossBlitLogicSSE2<SrcColor, DstColor, backward>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
+#else
+	crossBlitLogic<SrcColor, DstColor, backward>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
+#endif
+}
+
+template<typename DstColor>
+inline void crossBlitMapLogic(byte *dst, const byte *src, const uint w, const uint h,
+                              const uint32 *map, const uint srcDelta, const uint dstDelta) {
+	for (uint y = 0; y < h; ++y) {
+		for (uint x = 0; x < w; ++x) {
+			*(DstColor *)dst = map[*src];
+			src--;
+			dst -= sizeof(DstColor);
+		}
+
+		src -= srcDelta;
+		dst -= dstDelta;
+	}
+}
+
 } // End of anonymous namespace
 
 // Function to blit a rect from one color format to another
@@ -132,11 +296,11 @@ bool crossBlit(byte *dst, const byte *src,
 	// TODO: optimized cases for dstDelta of 0
 	if (dstFmt.bytesPerPixel == 2) {
 		if (srcFmt.bytesPerPixel == 2) {
-			crossBlitLogic<uint16, uint16, false>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
+			crossBlitRows<uint16, uint16, false>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
 		} else if (srcFmt.bytesPerPixel == 3) {
 			crossBlitLogic3BppSource<uint16, false>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
 		} else {
-			crossBlitLogic<uint32, uint16, false>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
+			crossBlitRows<uint32, uint16, false>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
 		}
 	} else if (dstFmt.bytesPerPixel == 4) {
 		if (srcFmt.bytesPerPixel == 2) {
@@ -147,7 +311,7 @@ bool crossBlit(byte *dst, const byte *src,
 			// color than per source color.
 			dst += h * dstPitch - dstDelta - dstFmt.bytesPerPixel;
 			src += h * srcPitch - srcDelta - srcFmt.bytesPerPixel;
-			crossBlitLogic<uint16, uint32, true>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
+			crossBlitRows<uint16, uint32, true>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
 		} else if (srcFmt.bytesPerPixel == 3) {
 			// We need to blit the surface from bottom right to top left here.
 			// This is neeeded, because when we convert to the same memory
@@ -158,7 +322,7 @@ bool crossBlit(byte *dst, const byte *src,
 			src += h * srcPitch - srcDelta - srcFmt.bytesPerPixel;
 			crossBlitLogic3BppSource<uint32, true>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
 		} else {
-			crossBlitLogic<uint32, uint32, false>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
+			crossBlitRows<uint32, uint32, false>(dst, src, w, h, srcFmt, dstFmt, srcDelta, dstDelta);
 		}
 	} else {
 		return false;
@@ -166,4 +330,28 @@ bool crossBlit(byte *dst, const byte *src,
 	return true;
 }
 
+bool crossBlitMap(byte *dst, const byte *src,
+                  const uint dstPitch, const uint srcPitch,
+                  const uint w, const uint h,
+                  const uint bytesPerPixel, const uint32 *map) {
+	if (bytesPerPixel != 2 && bytesPerPixel != 4)
+		return false;
+
+	// Like crossBlit(), go from bottom right to top left, so that the
+	// larger destination does not overwrite the source when converting
+	// in place.
+	const uint srcDelta = (srcPitch - w);
+	const uint dstDelta = (dstPitch - w * bytesPerPixel);
+
+	dst += h * dstPitch - dstDelta - bytesPerPixel;
+	src += h * srcPitch - srcDelta - 1;
+
+	if (bytesPerPixel == 2)
+		crossBlitMapLogic<uint16>(dst, src, w, h, map, srcDelta, dstDelta);
+	else
+		crossBlitMapLogic<uint32>(dst, src, w, h, map, srcDelta, dstDelta);
+
+	return true;
+}
+
 } // End of namespace Graphics
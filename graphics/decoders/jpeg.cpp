@@ -45,7 +45,8 @@ static const uint8 _zigZagOrder[64] = {
 
 JPEGDecoder::JPEGDecoder() : ImageDecoder(),
 	_stream(NULL), _w(0), _h(0), _numComp(0), _components(NULL), _numScanComp(0),
-	_scanComp(NULL), _currentComp(NULL), _rgbSurface(0) {
+	_scanComp(NULL), _currentComp(NULL), _rgbSurface(0),
+	_outputFormat(4, 8, 8, 8, 0, 24, 16, 8, 0) {
 
 	// Initialize the quantization tables
 	for (int i = 0; i < JPEG_MAX_QUANT_TABLES; i++)
@@ -55,8 +56,6 @@ JPEGDecoder::JPEGDecoder() : ImageDecoder(),
 	for (int i = 0; i < 2 * JPEG_MAX_HUFF_TABLES; i++) {
 		_huff[i].count = 0;
 		_huff[i].values = NULL;
-		_huff[i].sizes = NULL;
-		_huff[i].codes = NULL;
 	}
 }
 
@@ -72,20 +71,43 @@ const Surface *JPEGDecoder::getSurface() const {
 	if (_rgbSurface)
 		return _rgbSurface;
 
-	// Create an RGBA8888 surface
 	_rgbSurface = new Graphics::Surface();
-	_rgbSurface->create(_w, _h, Graphics::PixelFormat(4, 8, 8, 8, 0, 24, 16, 8, 0));
 
-	// Get our component surfaces
-	const Graphics::Surface *yComponent = getComponent(1);
-	const Graphics::Surface *uComponent = getComponent(2);
-	const Graphics::Surface *vComponent = getComponent(3);
-
-	YUVToRGBMan.convert444(_rgbSurface, Graphics::YUVToRGBManager::kScaleFull, (byte *)yComponent->pixels, (byte *)uComponent->pixels, (byte *)vComponent->pixels, yComponent->w, yComponent->h, yComponent->pitch, uComponent->pitch);
+	const Component *y = findComponent(1);
+	const Component *u = findComponent(2);
+	const Component *v = findComponent(3);
+
+	if (_maxFactorH == 2 && _maxFactorV == 2 && y->factorH == 2 && y->factorV == 2 &&
+			u->factorH == 1 && u->factorV == 1 && v->factorH == 1 && v->factorV == 1) {
+		// 4:2:0 is the most common layout, so convert it straight from the
+		// subsampled chroma. The converter needs even dimensions, which the
+		// component surfaces have since they cover whole MCUs.
+		uint16 width = (_w + 1) & ~1;
+		uint16 height = (_h + 1) & ~1;
+
+		_rgbSurface->create(width, height, _outputFormat);
+		YUVToRGBMan.convert420(_rgbSurface, Graphics::YUVToRGBManager::kScaleFull, (const byte *)y->surface.pixels, (const byte *)u->surface.pixels, (const byte *)v->surface.pixels, width, height, y->surface.pitch, u->surface.pitch);
+		_rgbSurface->w = _w;
+		_rgbSurface->h = _h;
+	} else {
+		_rgbSurface->create(_w, _h, _outputFormat);
+
+		// Get our component surfaces
+		const Graphics::Surface *yComponent = getComponent(1);
+		const Graphics::Surface *uComponent = getComponent(2);
+		const Graphics::Surface *vComponent = getComponent(3);
+
+		YUVToRGBMan.convert444(_rgbSurface, Graphics::YUVToRGBManager::kScaleFull, (byte *)yComponent->pixels, (byte *)uComponent->pixels, (byte *)vComponent->pixels, yComponent->w, yComponent->h, yComponent->pitch, uComponent->pitch);
+	}
 
 	return _rgbSurface;
 }
 
+void JPEGDecoder::setOutputPixelFormat(const PixelFormat &format) {
+	assert(format.bytesPerPixel == 2 || format.bytesPerPixel == 4);
+	_outputFormat = format;
+}
+
 void JPEGDecoder::destroy() {
 	// Reset member variables
 	_stream = NULL;
@@ -93,8 +115,10 @@ void JPEGDecoder::destroy() {
 	_restartInterval = 0;
 
 	// Free the components
-	for (int c = 0; c < _numComp; c++)
+	for (int c = 0; c < _numComp; c++) {
 		_components[c].surface.free();
+		_components[c].upsampledSurface.free();
+	}
 	delete[] _components; _components = NULL;
 	_numComp = 0;
 
@@ -113,13 +137,12 @@ void JPEGDecoder::destroy() {
 	for (int i = 0; i < 2 * JPEG_MAX_HUFF_TABLES; i++) {
 		_huff[i].count = 0;
 		delete[] _huff[i].values; _huff[i].values = NULL;
-		delete[] _huff[i].sizes; _huff[i].sizes = NULL;
-		delete[] _huff[i].codes; _huff[i].codes = NULL;
 	}
 
 	if (_rgbSurface) {
 		_rgbSurface->free();
 		delete _rgbSurface;
+		_rgbSurface = 0;
 	}
 }
 
@@ -298,49 +321,49 @@ bool JPEGDecoder::readDHT() {
 		tableId &= 0xF;
 		uint8 tableNum = (tableId << 1) + tableType;
 
+		HuffmanTable &huff = _huff[tableNum];
+
 		// Free the Huffman table
-		delete[] _huff[tableNum].values; _huff[tableNum].values = NULL;
-		delete[] _huff[tableNum].sizes; _huff[tableNum].sizes = NULL;
-		delete[] _huff[tableNum].codes; _huff[tableNum].codes = NULL;
+		delete[] huff.values; huff.values = NULL;
 
 		// Read the number of values for each length
 		uint8 numValues[16];
-		_huff[tableNum].count = 0;
+		huff.count = 0;
 		for (int len = 0; len < 16; len++) {
 			numValues[len] = _stream->readByte();
-			_huff[tableNum].count += numValues[len];
+			huff.count += numValues[len];
 		}
 
 		// Allocate memory for the current table
-		_huff[tableNum].values = new uint8[_huff[tableNum].count];
-		_huff[tableNum].sizes = new uint8[_huff[tableNum].count];
-		_huff[tableNum].codes = new uint16[_huff[tableNum].count];
+		huff.values = new uint8[huff.count];
 
 		// Read the table contents
+		for (int i = 0; i < huff.count; i++)
+			huff.values[i] = _stream->readByte();
+
+		// Assign the Huffman codes, which are consecutive for each length,
+		// and fill the decoding tables
+		memset(huff.lookup, 0, sizeof(huff.lookup));
+
+		int32 curCode = 0;
 		int cur = 0;
-		for (int len = 0; len < 16; len++) {
-			for (int i = 0; i < numValues[len]; i++) {
-				_huff[tableNum].values[cur] = _stream->readByte();
-				_huff[tableNum].sizes[cur] = len + 1;
-				cur++;
-			}
-		}
+		for (int len = 1; len <= 16; len++) {
+			huff.valueOffset[len] = cur - curCode;
+
+			for (int i = 0; i < numValues[len - 1]; i++) {
+				// Every lookahead starting with a short code decodes to it
+				if (len <= JPEG_HUFF_LOOKUP_BITS && curCode < (1 << len)) {
+					int shift = JPEG_HUFF_LOOKUP_BITS - len;
+					for (int j = 0; j < (1 << shift); j++)
+						huff.lookup[(curCode << shift) | j] = (len << 8) | huff.values[cur];
+				}
 
-		// Fill the table of Huffman codes
-		cur = 0;
-		uint16 curCode = 0;
-		uint8 curCodeSize = _huff[tableNum].sizes[0];
-		while (cur < _huff[tableNum].count) {
-			// Increase the code size to fit the request
-			while (_huff[tableNum].sizes[cur] != curCodeSize) {
-				curCode <<= 1;
-				curCodeSize++;
+				curCode++;
+				cur++;
 			}
 
-			// Assign the current code
-			_huff[tableNum].codes[cur] = curCode;
-			curCode++;
-			cur++;
+			huff.maxCode[len] = numValues[len - 1] ? curCode - 1 : -1;
+			curCode <<= 1;
 		}
 	}
 
@@ -436,9 +459,10 @@ bool JPEGDecoder::readSOS() {
 	if (_h % (_maxFactorV * 8) != 0)
 		yMCU++;
 
-	// Initialize the scan surfaces
+	// Initialize the scan surfaces. Subsampled components are stored in
+	// their own resolution and only scaled up when needed.
 	for (uint16 c = 0; c < _numScanComp; c++) {
-		_scanComp[c]->surface.create(xMCU * _maxFactorH * 8, yMCU * _maxFactorV * 8, PixelFormat::createFormatCLUT8());
+		_scanComp[c]->surface.create(xMCU * _scanComp[c]->factorH * 8, yMCU * _scanComp[c]->factorV * 8, PixelFormat::createFormatCLUT8());
 	}
 
 	bool ok = true;
@@ -455,7 +479,10 @@ bool JPEGDecoder::readSOS() {
 
 				if (interval == 0) {
 					interval = _restartInterval;
-					_bitsNumber = 0;
+
+					// Skip the rest of the current byte, the next
+					// interval starts on a byte boundary
+					_bitsNumber &= ~7;
 
 					for (byte i = 0; i < _numScanComp; i++)
 						_scanComp[i]->DCpredictor = 0;
@@ -467,8 +494,11 @@ bool JPEGDecoder::readSOS() {
 	// Trim Component surfaces back to image height and width
 	// Note: Code using jpeg must use surface.pitch correctly...
 	for (uint16 c = 0; c < _numScanComp; c++) {
-		_scanComp[c]->surface.w = _w;
-		_scanComp[c]->surface.h = _h;
+		uint8 scalingH = _maxFactorH / _scanComp[c]->factorH;
+		uint8 scalingV = _maxFactorV / _scanComp[c]->factorV;
+
+		_scanComp[c]->surface.w = (_w + scalingH - 1) / scalingH;
+		_scanComp[c]->surface.h = (_h + scalingV - 1) / scalingV;
 	}
 
 	return ok;
@@ -554,6 +584,17 @@ bool JPEGDecoder::readMCU(uint16 xMCU, uint16 yMCU) {
 void JPEGDecoder::idct1D8x8(int32 src[8], int32 dest[64], int32 ps, int32 half) {
 	int p, n;
 
+	// Most rows and columns only have the DC coefficient left after
+	// quantization. This gives exactly the same result as the full IDCT.
+	if (!(src[1] | src[2] | src[3] | src[4] | src[5] | src[6] | src[7])) {
+		int32 dc = ((src[0] << 9) + half) >> ps;
+
+		for (int i = 0; i < 8; i++)
+			dest[i * 8] = dc;
+
+		return;
+	}
+
 	src[0] <<= 9;
 	src[1] <<= 7;
 	src[3] *= 181;
@@ -606,12 +647,12 @@ bool JPEGDecoder::readDataUnit(uint16 x, uint16 y) {
 	readAC(readData);
 
 	// Calculate the DCT coefficients from the input sequence
+	const uint16 *quant = _quant[_currentComp->quantTableSelector];
 	int32 block[64];
 	for (uint8 i = 0; i < 64; i++) {
 		// Dequantize
 		int32 val = readData[i];
-		int16 quant = _quant[_currentComp->quantTableSelector][i];
-		val *= quant;
+		val *= (int16)quant[i];
 
 		// Store the normalized coefficients, undoing the Zig-Zag
 		block[_zigZagOrder[i]] = val;
@@ -620,37 +661,25 @@ bool JPEGDecoder::readDataUnit(uint16 x, uint16 y) {
 	// Apply the IDCT
 	idct2D8x8(block);
 
-	// Level shift to make the values unsigned
-	for (int i = 0; i < 64; i++) {
-		block[i] = block[i] + 128;
+	// Paint the component surface, converting coordinates from blocks to
+	// pixels
+	byte *ptr = (byte *)_currentComp->surface.getBasePtr(x << 3, y << 3);
 
-		if (block[i] < 0)
-			block[i] = 0;
-
-		if (block[i] > 255)
-			block[i] = 255;
-	}
+	for (uint8 j = 0; j < 8; j++) {
+		for (uint8 i = 0; i < 8; i++) {
+			// Level shift to make the values unsigned
+			int32 val = block[j * 8 + i] + 128;
 
-	// Paint the component surface
-	uint8 scalingV = _maxFactorV / _currentComp->factorV;
-	uint8 scalingH = _maxFactorH / _currentComp->factorH;
+			if (val < 0)
+				val = 0;
 
-	// Convert coordinates from MCU blocks to pixels
-	x <<= 3;
-	y <<= 3;
+			if (val > 255)
+				val = 255;
 
-	for (uint8 j = 0; j < 8; j++) {
-		for (uint16 sV = 0; sV < scalingV; sV++) {
-			// Get the beginning of the block line
-			byte *ptr = (byte *)_currentComp->surface.getBasePtr(x * scalingH, (y + j) * scalingV + sV);
-
-			for (uint8 i = 0; i < 8; i++) {
-				for (uint16 sH = 0; sH < scalingH; sH++) {
-					*ptr = (byte)(block[j * 8 + i]);
-					ptr++;
-				}
-			}
+			ptr[i] = (byte)val;
 		}
+
+		ptr += _currentComp->surface.pitch;
 	}
 
 	return true;
@@ -698,90 +727,136 @@ void JPEGDecoder::readAC(int16 *out) {
 }
 
 int16 JPEGDecoder::readSignedBits(uint8 numBits) {
-	uint16 ret = 0;
 	if (numBits > 16)
 		error("requested %d bits", numBits); //XXX
 
+	if (numBits == 0)
+		return 0;
+
+	if (_bitsNumber < numBits)
+		fillBits();
+
 	// MSB=0 for negatives, 1 for positives
-	for (int i = 0; i < numBits; i++)
-		ret = (ret << 1) + readBit();
+	_bitsNumber -= numBits;
+	int32 ret = (_bitsData >> _bitsNumber) & ((1 << numBits) - 1);
 
 	// Extend sign bits (PAG109)
-	if (!(ret >> (numBits - 1))) {
-		uint16 tmp = ((uint16)-1 << numBits) + 1;
-		ret = ret + tmp;
-	}
+	if (ret < (1 << (numBits - 1)))
+		ret -= (1 << numBits) - 1;
+
 	return ret;
 }
 
-// TODO: optimize?
 uint8 JPEGDecoder::readHuff(uint8 table) {
-	bool foundCode = false;
-	uint8 val = 0;
-
-	uint8 cur = 0;
-	uint8 codeSize = 1;
-	uint16 code = readBit();
-	while (!foundCode) {
-		// Prepare a code of the current size
-		while (codeSize < _huff[table].sizes[cur]) {
-			code = (code << 1) + readBit();
-			codeSize++;
-		}
+	const HuffmanTable &huff = _huff[table];
 
-		// Compare the codes of the current size
-		while (!foundCode && (codeSize == _huff[table].sizes[cur])) {
-			if (code == _huff[table].codes[cur]) {
-				// Found the code
-				val = _huff[table].values[cur];
-				foundCode = true;
-			} else {
-				// Continue reading
-				cur++;
-			}
+	if (_bitsNumber < 16)
+		fillBits();
+
+	// Short codes are decoded with a single lookup
+	int32 code = (_bitsData >> (_bitsNumber - JPEG_HUFF_LOOKUP_BITS)) & ((1 << JPEG_HUFF_LOOKUP_BITS) - 1);
+	uint16 entry = huff.lookup[code];
+
+	if (entry) {
+		_bitsNumber -= entry >> 8;
+		return entry & 0xFF;
+	}
+
+	// Longer codes are read one more bit at a time, until the code is not
+	// larger than the largest code of its length
+	_bitsNumber -= JPEG_HUFF_LOOKUP_BITS;
+	uint8 codeSize = JPEG_HUFF_LOOKUP_BITS;
+
+	while (code > huff.maxCode[codeSize]) {
+		if (codeSize == 16) {
+			warning("JPEG: Invalid Huffman code");
+			return 0;
 		}
+
+		code = (code << 1) | readBit();
+		codeSize++;
 	}
 
-	return val;
+	return huff.values[huff.valueOffset[codeSize] + code];
 }
 
 uint8 JPEGDecoder::readBit() {
-	// Read a whole byte if necessary
-	if (_bitsNumber == 0) {
-		_bitsData = _stream->readByte();
-		_bitsNumber = 8;
+	if (_bitsNumber == 0)
+		fillBits();
+
+	_bitsNumber--;
+
+	return (_bitsData >> _bitsNumber) & 1;
+}
+
+void JPEGDecoder::fillBits() {
+	// Read whole bytes until at least 25 bits are buffered
+	while (_bitsNumber <= 24) {
+		uint8 data = _stream->readByte();
 
 		// Detect markers
-		if (_bitsData == 0xFF) {
+		if (data == 0xFF) {
 			uint8 byte2 = _stream->readByte();
 
 			// A stuffed 0 validates the previous byte
-			if (byte2 != 0) {
-				if (byte2 == 0xDC) {
-					// DNL marker: Define Number of Lines
-					// TODO: terminate scan
-					warning("DNL marker detected: terminate scan");
-				} else if (byte2 >= 0xD0 && byte2 <= 0xD7) {
-					debug(7, "RST%d marker detected", byte2 & 7);
-					_bitsData = _stream->readByte();
-				} else {
-					warning("Error: marker 0x%02X read in entropy data", byte2);
-				}
+			if (byte2 >= 0xD0 && byte2 <= 0xD7) {
+				debug(7, "RST%d marker detected", byte2 & 7);
+				data = _stream->readByte();
+			} else if (byte2 != 0) {
+				// Any other marker ends the entropy coded data. Leave it
+				// for loadStream() and pad the rest of the scan with zeros.
+				debug(7, "Marker 0x%02X ends the entropy data", byte2);
+				_stream->seek(-2, SEEK_CUR);
+				data = 0;
 			}
 		}
-	}
-	_bitsNumber--;
 
-	return (_bitsData & (1 << _bitsNumber)) ? 1 : 0;
+		_bitsData = (_bitsData << 8) | data;
+		_bitsNumber += 8;
+	}
 }
 
-const Surface *JPEGDecoder::getComponent(uint c) const {
+const JPEGDecoder::Component *JPEGDecoder::findComponent(uint c) const {
 	for (int i = 0; i < _numComp; i++)
 		if (_components[i].id == c) // We found the desired component
-			return &_components[i].surface;
+			return &_components[i];
 
 	error("JPEGDecoder::getComponent: No component %d present", c);
 	return NULL;
 }
 
+const Surface *JPEGDecoder::getComponent(uint c) const {
+	const Component *comp = findComponent(c);
+
+	uint8 scalingH = _maxFactorH / comp->factorH;
+	uint8 scalingV = _maxFactorV / comp->factorV;
+
+	if (scalingH == 1 && scalingV == 1)
+		return &comp->surface;
+
+	// Scale subsampled components up to the size of the image
+	if (!comp->upsampledSurface.pixels) {
+		Surface &upsampled = comp->upsampledSurface;
+		upsampled.create(_w, _h, PixelFormat::createFormatCLUT8());
+
+		for (int y = 0; y < upsampled.h; y++) {
+			byte *dst = (byte *)upsampled.getBasePtr(0, y);
+
+			// Repeat the previous line where the component has no new one
+			if (y % scalingV) {
+				memcpy(dst, dst - upsampled.pitch, upsampled.w);
+				continue;
+			}
+
+			const byte *src = (const byte *)comp->surface.getBasePtr(0, y / scalingV);
+
+			for (int x = 0; x < upsampled.w; src++)
+				for (uint8 sH = 0; sH < scalingH && x < upsampled.w; sH++)
+					dst[x++] = *src;
+		}
+	}
+
+	return &comp->upsampledSurface;
+}
+
 } // End of Graphics namespace
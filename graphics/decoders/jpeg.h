@@ -44,6 +44,7 @@ struct PixelFormat;
 
 #define JPEG_MAX_QUANT_TABLES 4
 #define JPEG_MAX_HUFF_TABLES 2
+#define JPEG_HUFF_LOOKUP_BITS 9
 
 class JPEGDecoder : public ImageDecoder {
 public:
@@ -60,6 +61,13 @@ public:
 	uint16 getHeight() const { return _h; }
 	const Surface *getComponent(uint c) const;
 
+	/**
+	 * Set the format of the surface returned by getSurface(), which is
+	 * RGBA8888 by default. Converting straight to the format needed saves
+	 * the caller a conversion. Only 2 and 4 byte formats are supported.
+	 */
+	void setOutputPixelFormat(const PixelFormat &format);
+
 private:
 	Common::SeekableReadStream *_stream;
 	uint16 _w, _h;
@@ -69,6 +77,7 @@ private:
 	// a getSurface() call while still upholding the
 	// const requirement in other ImageDecoders
 	mutable Graphics::Surface *_rgbSurface;
+	PixelFormat _outputFormat;
 
 	// Image components
 	uint8 _numComp;
@@ -84,11 +93,16 @@ private:
 		uint8 ACentropyTableSelector;
 		int16 DCpredictor;
 
-		// Result image for this component
+		// Result image for this component, in its own resolution
 		Surface surface;
+
+		// The result image scaled up to the size of the whole image, for
+		// getComponent(). Only used for subsampled components.
+		mutable Surface upsampledSurface;
 	};
 
 	Component *_components;
+	const Component *findComponent(uint c) const;
 
 	// Scan components
 	uint8 _numScanComp;
@@ -106,8 +120,15 @@ private:
 	struct HuffmanTable {
 		uint8 count;
 		uint8 *values;
-		uint8 *sizes;
-		uint16 *codes;
+
+		// Code length << 8 | value for every JPEG_HUFF_LOOKUP_BITS bit
+		// prefix of a code of up to that length, 0 for the longer codes
+		uint16 lookup[1 << JPEG_HUFF_LOOKUP_BITS];
+
+		// The largest code of each length, or -1 if there is none, and
+		// what to add to a code of each length to get its value's index
+		int32 maxCode[17];
+		int32 valueOffset[17];
 	} _huff[2 * JPEG_MAX_HUFF_TABLES];
 
 	// Marker read functions
@@ -128,7 +149,8 @@ private:
 	// Huffman decoding
 	uint8 readHuff(uint8 table);
 	uint8 readBit();
-	uint8 _bitsData;
+	void fillBits();
+	uint32 _bitsData;
 	uint8 _bitsNumber;
 
 	// Inverse Discrete Cosine Transformation
@@ -0,0 +1,208 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/microtiles.h"
+
+#include "common/array.h"
+#include "common/util.h"
+
+namespace Graphics {
+
+MicroTileArray::MicroTileArray(int16 width, int16 height) : _width(width), _height(height) {
+	_tilesW = (width + kTileSize - 1) / kTileSize;
+	_tilesH = (height + kTileSize - 1) / kTileSize;
+	_tiles = new BoundingBox[_tilesW * _tilesH];
+	clear();
+}
+
+MicroTileArray::~MicroTileArray() {
+	delete[] _tiles;
+}
+
+void MicroTileArray::addRect(Common::Rect r) {
+	if (!r.isValidRect())
+		return;
+
+	r.clip(_width, _height);
+	if (r.isEmpty())
+		return;
+
+	// From here on the coordinates are inclusive
+	const int ux0 = r.left / kTileSize;
+	const int uy0 = r.top / kTileSize;
+	const int ux1 = (r.right - 1) / kTileSize;
+	const int uy1 = (r.bottom - 1) / kTileSize;
+
+	const int tx0 = r.left % kTileSize;
+	const int ty0 = r.top % kTileSize;
+	const int tx1 = (r.right - 1) % kTileSize;
+	const int ty1 = (r.bottom - 1) % kTileSize;
+
+	for (int yc = uy0; yc <= uy1; yc++) {
+		for (int xc = ux0; xc <= ux1; xc++) {
+			const int ix0 = (xc == ux0) ? tx0 : 0;
+			const int ix1 = (xc == ux1) ? tx1 : kTileSize - 1;
+			const int iy0 = (yc == uy0) ? ty0 : 0;
+			const int iy1 = (yc == uy1) ? ty1 : kTileSize - 1;
+			updateBoundingBox(_tiles[xc + yc * _tilesW], ix0, iy0, ix1, iy1);
+		}
+	}
+}
+
+void MicroTileArray::clear() {
+	memset(_tiles, 0, _tilesW * _tilesH * sizeof(BoundingBox));
+}
+
+void MicroTileArray::updateBoundingBox(BoundingBox &boundingBox, byte x0, byte y0, byte x1, byte y1) {
+	if (boundingBox != kEmptyBoundingBox) {
+		x0 = MIN(tileX0(boundingBox), x0);
+		y0 = MIN(tileY0(boundingBox), y0);
+		x1 = MAX(tileX1(boundingBox), x1);
+		y1 = MAX(tileY1(boundingBox), y1);
+	}
+	boundingBox = makeBoundingBox(x0, y0, x1, y1);
+}
+
+RectangleList *MicroTileArray::getRectangles() {
+	RectangleList *rects = new RectangleList();
+	int i = 0;
+
+	for (int y = 0; y < _tilesH; ++y) {
+		for (int x = 0; x < _tilesW; ++x) {
+			const BoundingBox boundingBox = _tiles[i];
+
+			if (boundingBox == kEmptyBoundingBox) {
+				++i;
+				continue;
+			}
+
+			const int x0 = (x * kTileSize) + tileX0(boundingBox);
+			const int y0 = (y * kTileSize) + tileY0(boundingBox);
+			const int y1 = (y * kTileSize) + tileY1(boundingBox);
+
+			// Continue the rect into the following tiles as long as their
+			// changes line up with this one's
+			while (x + 1 < _tilesW &&
+			       tileX1(_tiles[i]) == kTileSize - 1 &&
+			       _tiles[i + 1] != kEmptyBoundingBox &&
+			       tileX0(_tiles[i + 1]) == 0 &&
+			       tileY0(_tiles[i + 1]) == tileY0(boundingBox) &&
+			       tileY1(_tiles[i + 1]) == tileY1(boundingBox)) {
+				++x;
+				++i;
+			}
+
+			const int x1 = (x * kTileSize) + tileX1(_tiles[i]);
+
+			rects->push_back(Common::Rect(x0, y0, x1 + 1, y1 + 1));
+
+			++i;
+		}
+	}
+
+	return rects;
+}
+
+/**
+ * The number of pixels which would be updated needlessly when merging the
+ * two rects into their bounding box.
+ */
+static int mergeWaste(const Common::Rect &r1, const Common::Rect &r2) {
+	Common::Rect merged(r1);
+	merged.extend(r2);
+
+	const Common::Rect overlap = r1.findIntersectingRect(r2);
+
+	return merged.width() * merged.height() - r1.width() * r1.height() - r2.width() * r2.height() + overlap.width() * overlap.height();
+}
+
+/**
+ * Merge the rect at j into the one at i, along with every other rect the
+ * result then overlaps, so that the rects stay disjoint. Returns the new
+ * index of the merged rect.
+ */
+static uint mergeRects(Common::Array<Common::Rect> &rects, uint i, uint j) {
+	rects[i].extend(rects[j]);
+	rects.remove_at(j);
+	if (j < i)
+		--i;
+
+	for (uint k = 0; k < rects.size(); ++k) {
+		if (k != i && rects[i].intersects(rects[k])) {
+			rects[i].extend(rects[k]);
+			rects.remove_at(k);
+			if (k < i)
+				--i;
+			// The merged rect grew, so look at all the others again
+			k = (uint)-1;
+		}
+	}
+
+	return i;
+}
+
+void MicroTileArray::getRectangles(RectangleList &rects, uint mergeCost, uint maxRects) {
+	RectangleList *tileRects = getRectangles();
+	Common::Array<Common::Rect> work;
+	work.reserve(tileRects->size());
+	for (RectangleList::const_iterator i = tileRects->begin(); i != tileRects->end(); ++i)
+		work.push_back(*i);
+	delete tileRects;
+
+	// First merge every pair which is cheaper to update as one rect. A
+	// merged rect may now be worth merging with the ones after it, so
+	// those are looked at again.
+	for (uint i = 0; i < work.size(); ++i) {
+		for (uint j = i + 1; j < work.size(); ++j) {
+			if (mergeWaste(work[i], work[j]) <= (int)mergeCost) {
+				i = mergeRects(work, i, j);
+				j = i;
+			}
+		}
+	}
+
+	// Then, if there are still too many rects, merge the pairs which waste
+	// the least.
+	while (work.size() > maxRects && work.size() > 1) {
+		uint best1 = 0, best2 = 1;
+		int bestWaste = mergeWaste(work[0], work[1]);
+
+		for (uint i = 0; i < work.size(); ++i) {
+			for (uint j = i + 1; j < work.size(); ++j) {
+				const int waste = mergeWaste(work[i], work[j]);
+				if (waste < bestWaste) {
+					bestWaste = waste;
+					best1 = i;
+					best2 = j;
+				}
+			}
+		}
+
+		mergeRects(work, best1, best2);
+	}
+
+	rects.clear();
+	for (uint i = 0; i < work.size(); ++i)
+		rects.push_back(work[i]);
+}
+
+} // End of namespace Graphics
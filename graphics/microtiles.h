@@ -0,0 +1,97 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_MICROTILES_H
+#define GRAPHICS_MICROTILES_H
+
+#include "common/scummsys.h"
+#include "common/list.h"
+#include "common/rect.h"
+
+namespace Graphics {
+
+typedef Common::List<Common::Rect> RectangleList;
+
+/**
+ * Keeps track of the changed areas of a screen. The screen is divided into
+ * tiles, and each tile remembers the bounding box of the changes inside it,
+ * so adding rects is cheap and any number of them takes the same space.
+ */
+class MicroTileArray {
+public:
+	MicroTileArray(int16 width, int16 height);
+	~MicroTileArray();
+
+	/** Mark the given rect (clipped to the screen) as changed. */
+	void addRect(Common::Rect r);
+
+	/** Forget about all changes. */
+	void clear();
+
+	/**
+	 * Get the changed areas, as rects spanning adjacent tiles where the
+	 * changes line up. The caller has to delete the returned list.
+	 */
+	RectangleList *getRectangles();
+
+	/**
+	 * Get the changed areas, merging rects into their bounding box where
+	 * this is cheaper than handling them separately: mergeCost is the cost
+	 * of one more rect, in the number of pixels which could be updated for
+	 * the same price. Regardless of the cost, rects are merged until there
+	 * are at most maxRects left. The rects returned never overlap.
+	 */
+	void getRectangles(RectangleList &rects, uint mergeCost, uint maxRects);
+
+private:
+	typedef uint32 BoundingBox;
+
+	enum {
+		kTileSize = 32
+	};
+
+	static const BoundingBox kEmptyBoundingBox = 0;
+
+	BoundingBox *_tiles;
+	int16 _width, _height;
+	int16 _tilesW, _tilesH;
+
+	static byte tileX0(BoundingBox boundingBox) { return ((boundingBox >> 24) & 0xFF) - 1; }
+	static byte tileY0(BoundingBox boundingBox) { return ((boundingBox >> 16) & 0xFF) - 1; }
+	static byte tileX1(BoundingBox boundingBox) { return (boundingBox >> 8) & 0xFF; }
+	static byte tileY1(BoundingBox boundingBox) { return boundingBox & 0xFF; }
+
+	/**
+	 * The bounding boxes store their coordinates inclusively, and the
+	 * left/top ones one higher, so that an empty box can be told apart
+	 * from one covering just the top left pixel.
+	 */
+	static BoundingBox makeBoundingBox(byte x0, byte y0, byte x1, byte y1) {
+		return ((x0 + 1) << 24) | ((y0 + 1) << 16) | (x1 << 8) | y1;
+	}
+
+	void updateBoundingBox(BoundingBox &boundingBox, byte x0, byte y0, byte x1, byte y1);
+};
+
+} // End of namespace Graphics
+
+#endif
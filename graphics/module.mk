@@ -12,7 +12,9 @@ MODULE_OBJS := \
 	fonts/ttf.o \
 	fonts/winfont.o \
 	maccursor.o \
+	microtiles.o \
 	primitives.o \
+	rowfill.o \
 	scaler.o \
 	scaler/thumbnail_intern.o \
 	sjis.o \
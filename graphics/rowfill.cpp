@@ -0,0 +1,288 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/rowfill.h"
+#include "graphics/pixelformat.h"
+
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Graphics {
+
+namespace {
+
+/**
+ * Fills a row with one color, using an unrolled loop. This is the most
+ * used operation of the vector renderer.
+ */
+template<typename PixelType>
+void colorFillLogic(PixelType *first, uint count, PixelType color) {
+	if (!count)
+		return;
+
+	int n = (count + 7) >> 3;
+	switch (count % 8) {
+	case 0: do {
+				*first++ = color;
+	case 7:		*first++ = color;
+	case 6:		*first++ = color;
+	case 5:		*first++ = color;
+	case 4:		*first++ = color;
+	case 3:		*first++ = color;
+	case 2:		*first++ = color;
+	case 1:		*first++ = color;
+			} while (--n > 0);
+	}
+}
+
+template<typename PixelType>
+void fillRowLogic(PixelType *dst, uint count, PixelType color1, PixelType color2) {
+	if (color1 == color2) {
+		colorFillLogic(dst, count, color1);
+		return;
+	}
+
+	for (; count >= 2; count -= 2) {
+		*dst++ = color1;
+		*dst++ = color2;
+	}
+
+	if (count)
+		*dst = color1;
+}
+
+/**
+ * Blends pixels with a color, one channel at a time. Each channel is
+ * computed as (dst * (256 - alpha) + color * alpha) >> 8, which is the
+ * same as dst + (color - dst) * alpha / 256 rounded down, but has no
+ * negative intermediate values and fits in 16 bits.
+ */
+template<typename PixelType>
+struct RowBlender {
+	struct Channel {
+		int shift;
+		PixelType mask;
+		uint32 colorWeighted;
+	};
+
+	Channel channels[3];
+	int numChannels;
+	uint32 dstWeight;
+	PixelType keepMask;
+
+	RowBlender(PixelType color, uint8 alpha, const PixelFormat &format) : numChannels(0), dstWeight(256 - alpha), keepMask(0) {
+		addChannel(color, alpha, format.rShift, format.rLoss);
+		addChannel(color, alpha, format.gShift, format.gLoss);
+		addChannel(color, alpha, format.bShift, format.bLoss);
+
+		if (format.aLoss < 8)
+			keepMask = (PixelType)((0xFF >> format.aLoss) << format.aShift);
+	}
+
+	void addChannel(PixelType color, uint8 alpha, int shift, int loss) {
+		if (loss >= 8)
+			return;
+
+		Channel &c = channels[numChannels++];
+		c.shift = shift;
+		c.mask = (PixelType)(0xFF >> loss);
+		c.colorWeighted = ((color >> shift) & c.mask) * alpha;
+	}
+
+	PixelType blend(PixelType pixel) const {
+		PixelType result = pixel & keepMask;
+
+		for (int i = 0; i < numChannels; ++i) {
+			const Channel &c = channels[i];
+			const uint32 value = (pixel >> c.shift) & c.mask;
+			result |= (PixelType)(((value * dstWeight + c.colorWeighted) >> 8) << c.shift);
+		}
+
+		return result;
+	}
+};
+
+template<typename PixelType>
+void blendRowLogic(PixelType *dst, uint count, const RowBlender<PixelType> &blender) {
+	for (; count; --count, ++dst)
+		*dst = blender.blend(*dst);
+}
+
+template<typename PixelType>
+void darkenRowLogic(PixelType *dst, uint count, PixelType mask, int shift, PixelType orBits, PixelType addBits) {
+	for (; count; --count, ++dst)
+		*dst = (PixelType)((((*dst & mask) >> shift) | orBits) + addBits);
+}
+
+#ifdef USE_SSE2
+
+// The lane size of the operations below follows the pixel type, which is
+// passed only to pick the matching instruction.
+
+inline __m128i setColors(uint16 color1, uint16 color2) {
+	return _mm_set1_epi32(color1 | (color2 << 16));
+}
+
+inline __m128i setColors(uint32 color1, uint32 color2) {
+	return _mm_set_epi32(color2, color1, color2, color1);
+}
+
+inline __m128i set1(uint16 value) { return _mm_set1_epi16((int16)value); }
+inline __m128i set1(uint32 value) { return _mm_set1_epi32(value); }
+
+inline __m128i shiftLeft(__m128i v, __m128i count, uint16) { return _mm_sll_epi16(v, count); }
+inline __m128i shiftLeft(__m128i v, __m128i count, uint32) { return _mm_sll_epi32(v, count); }
+
+inline __m128i shiftRight(__m128i v, __m128i count, uint16) { return _mm_srl_epi16(v, count); }
+inline __m128i shiftRight(__m128i v, __m128i count, uint32) { return _mm_srl_epi32(v, count); }
+
+inline __m128i add(__m128i a, __m128i b, uint16) { return _mm_add_epi16(a, b); }
+inline __m128i add(__m128i a, __m128i b, uint32) { return _mm_add_epi32(a, b); }
+
+template<typename PixelType>
+void fillRowSSE2(PixelType *dst, uint count, PixelType color1, PixelType color2) {
+	// An even number of pixels, so that the pattern starts over each time
+	const uint step = 16 / sizeof(PixelType);
+	const __m128i colors = setColors(color1, color2);
+
+	for (; count >= step; count -= step, dst += step)
+		_mm_storeu_si128((__m128i *)dst, colors);
+
+	fillRowLogic(dst, count, color1, color2);
+}
+
+template<typename PixelType>
+void blendRowSSE2(PixelType *dst, uint count, const RowBlender<PixelType> &blender) {
+	const uint step = 16 / sizeof(PixelType);
+	const PixelType tag = 0;
+
+	// All values stay below 65536, so for 32 bit pixels the upper half of
+	// each lane is zero and a 16 bit multiplication is enough as well.
+	const __m128i dstWeight = set1((PixelType)blender.dstWeight);
+	const __m128i keepMask = set1(blender.keepMask);
+	const __m128i eight = _mm_cvtsi32_si128(8);
+
+	__m128i shift[3], mask[3], colorWeighted[3];
+	for (int i = 0; i < blender.numChannels; ++i) {
+		shift[i] = _mm_cvtsi32_si128(blender.channels[i].shift);
+		mask[i] = set1(blender.channels[i].mask);
+		colorWeighted[i] = set1((PixelType)blender.channels[i].colorWeighted);
+	}
+
+	for (; count >= step; count -= step, dst += step) {
+		const __m128i pixels = _mm_loadu_si128((const __m128i *)dst);
+		__m128i result = _mm_and_si128(pixels, keepMask);
+
+		for (int i = 0; i < blender.numChannels; ++i) {
+			__m128i value = _mm_and_si128(shiftRight(pixels, shift[i], tag), mask[i]);
+			value = add(_mm_mullo_epi16(value, dstWeight), colorWeighted[i], tag);
+			value = shiftRight(value, eight, tag);
+			result = _mm_or_si128(result, shiftLeft(value, shift[i], tag));
+		}
+
+		_mm_storeu_si128((__m128i *)dst, result);
+	}
+
+	blendRowLogic(dst, count, blender);
+}
+
+template<typename PixelType>
+void darkenRowSSE2(PixelType *dst, uint count, PixelType mask, int shift, PixelType orBits, PixelType addBits) {
+	const uint step = 16 / sizeof(PixelType);
+	const PixelType tag = 0;
+
+	const __m128i maskV = set1(mask);
+	const __m128i shiftV = _mm_cvtsi32_si128(shift);
+	const __m128i orBitsV = set1(orBits);
+	const __m128i addBitsV = set1(addBits);
+
+	for (; count >= step; count -= step, dst += step) {
+		__m128i pixels = _mm_loadu_si128((const __m128i *)dst);
+		pixels = shiftRight(_mm_and_si128(pixels, maskV), shiftV, tag);
+		pixels = add(_mm_or_si128(pixels, orBitsV), addBitsV, tag);
+		_mm_storeu_si128((__m128i *)dst, pixels);
+	}
+
+	darkenRowLogic(dst, count, mask, shift, orBits, addBits);
+}
+
+#endif // USE_SSE2
+
+/**
+ * Picks the fastest implementation of each operation available.
+ */
+template<typename PixelType>
+inline void fillRowAny(PixelType *dst, uint count, PixelType color1, PixelType color2) {
+#ifdef USE_SSE2
+	fillRowSSE2(dst, count, color1, color2);
+#else
+	fillRowLogic(dst, count, color1, color2);
+#endif
+}
+
+template<typename PixelType>
+inline void blendRowAny(PixelType *dst, uint count, PixelType color, uint8 alpha, const PixelFormat &format) {
+	const RowBlender<PixelType> blender(color, alpha, format);
+#ifdef USE_SSE2
+	blendRowSSE2(dst, count, blender);
+#else
+	blendRowLogic(dst, count, blender);
+#endif
+}
+
+template<typename PixelType>
+inline void darkenRowAny(PixelType *dst, uint count, PixelType mask, int shift, PixelType orBits, PixelType addBits) {
+#ifdef USE_SSE2
+	darkenRowSSE2(dst, count, mask, shift, orBits, addBits);
+#else
+	darkenRowLogic(dst, count, mask, shift, orBits, addBits);
+#endif
+}
+
+} // End of anonymous namespace
+
+void fillRow(uint16 *dst, uint count, uint16 color1, uint16 color2) {
+	fillRowAny(dst, count, color1, color2);
+}
+
+void fillRow(uint32 *dst, uint count, uint32 color1, uint32 color2) {
+	fillRowAny(dst, count, color1, color2);
+}
+
+void blendRow(uint16 *dst, uint count, uint16 color, uint8 alpha, const PixelFormat &format) {
+	blendRowAny(dst, count, color, alpha, format);
+}
+
+void blendRow(uint32 *dst, uint count, uint32 color, uint8 alpha, const PixelFormat &format) {
+	blendRowAny(dst, count, color, alpha, format);
+}
+
+void darkenRow(uint16 *dst, uint count, uint16 mask, int shift, uint16 orBits, uint16 addBits) {
+	darkenRowAny(dst, count, mask, shift, orBits, addBits);
+}
+
+void darkenRow(uint32 *dst, uint count, uint32 mask, int shift, uint32 orBits, uint32 addBits) {
+	darkenRowAny(dst, count, mask, shift, orBits, addBits);
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,84 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_ROWFILL_H
+#define GRAPHICS_ROWFILL_H
+
+#include "common/scummsys.h"
+
+namespace Graphics {
+
+struct PixelFormat;
+
+/**
+ * @file
+ * Operations on a row of 16 or 32 bit pixels, as used by the vector
+ * renderer for its fills, gradients and shadows. When SSE2 is available,
+ * several pixels are processed at a time.
+ */
+
+/**
+ * Fills a row of pixels alternating between two colors, starting with
+ * the first one. Pass the same color twice for a plain fill.
+ *
+ * @param dst     the first pixel of the row
+ * @param count   the number of pixels to fill
+ * @param color1  the color of the first, third, ... pixel
+ * @param color2  the color of the second, fourth, ... pixel
+ */
+void fillRow(uint16 *dst, uint count, uint16 color1, uint16 color2);
+void fillRow(uint32 *dst, uint count, uint32 color1, uint32 color2);
+
+/**
+ * Blends a row of pixels with a color. Each color channel becomes
+ * dst + (color - dst) * alpha / 256, rounded down, while the alpha channel
+ * of the pixels is kept. Bits of the pixels which belong to no channel are
+ * cleared.
+ *
+ * @param dst     the first pixel of the row
+ * @param count   the number of pixels to blend
+ * @param color   the color to blend the pixels with
+ * @param alpha   the weight of the color, from 0 to 255
+ * @param format  the format of the pixels, which must have 8 bits or
+ *                less per channel
+ */
+void blendRow(uint16 *dst, uint count, uint16 color, uint8 alpha, const PixelFormat &format);
+void blendRow(uint32 *dst, uint count, uint32 color, uint8 alpha, const PixelFormat &format);
+
+/**
+ * Darkens a row of pixels by shifting their bits. Each pixel becomes
+ * (((dst & mask) >> shift) | orBits) + addBits.
+ *
+ * @param dst      the first pixel of the row
+ * @param count    the number of pixels to change
+ * @param mask     the bits of the pixels to keep before shifting, which
+ *                 usually excludes the lowest bits of each channel
+ * @param shift    the number of bits to shift the pixels right by
+ * @param orBits   bits to set afterwards, e.g. the alpha channel
+ * @param addBits  value to add to the pixels afterwards
+ */
+void darkenRow(uint16 *dst, uint count, uint16 mask, int shift, uint16 orBits, uint16 addBits);
+void darkenRow(uint32 *dst, uint count, uint32 mask, int shift, uint32 orBits, uint32 addBits);
+
+} // End of namespace Graphics
+
+#endif
@@ -97,7 +97,9 @@ void HQ3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 #define PIXEL22_C   *(q+2+nextlineDst2) = w5;
 
 extern "C" uint32   *RGBtoYUV;
-#define YUV(x)	RGBtoYUV[w ## x]
+
+// The YUV values around the current pixel, as cached by computeHQPatterns().
+#define YUV(x)	yuv[((x) - 1) / 3][chunkPos + ((x) - 1) % 3]
 
 /*
  * The HQ3x high quality 3x graphics filter.
@@ -107,6 +109,9 @@ extern "C" uint32   *RGBtoYUV;
 template<typename ColorMask>
 static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	register int  w1, w2, w3, w4, w5, w6, w7, w8, w9;
+	uint32 yuv[3][kHQChunkSize + 2];
+	int patterns[kHQChunkSize];
+	int chunkPos = 0;
 
 	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
 	const uint16 *p = (const uint16 *)srcPtr;
@@ -137,22 +142,19 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 
 		int tmpWidth = width;
 		while (tmpWidth--) {
+			if (tmpWidth + 1 == width || chunkPos == kHQChunkSize) {
+				const int count = (tmpWidth + 1 < kHQChunkSize) ? tmpWidth + 1 : (int)kHQChunkSize;
+				computeHQPatterns(p, nextlineSrc, count, RGBtoYUV, yuv, patterns);
+				chunkPos = 0;
+			}
+
 			p++;
 
 			w3 = *(p - nextlineSrc);
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			const int pattern = patterns[chunkPos];
 
 			switch (pattern) {
 			case 0:
@@ -2927,6 +2929,7 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			w5 = w6;
 			w8 = w9;
 
+			chunkPos++;
 			q += 3;
 		}
 		p += nextlineSrc - width;
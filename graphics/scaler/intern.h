@@ -26,6 +26,10 @@
 #include "common/scummsys.h"
 #include "graphics/colormasks.h"
 
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
 
 /**
  * Interpolate two 16 bit pixel *pairs* at once with equal weights 1.
@@ -218,4 +222,101 @@ static inline bool diffYUV(int yuv1, int yuv2) {
 */
 }
 
+/**
+ * Number of pixels for which computeHQPatterns() works at once.
+ */
+enum {
+	kHQChunkSize = 64
+};
+
+#ifdef USE_SSE2
+/**
+ * Same as diffYUV(), for four pairs of YUV values at once.
+ * @return all bits set where the values differ
+ */
+static inline __m128i diffYUV_SSE2(__m128i yuv1, __m128i yuv2) {
+	const __m128i Ymask = _mm_set1_epi32(0x00FF0000);
+	const __m128i Umask = _mm_set1_epi32(0x0000FF00);
+	const __m128i Vmask = _mm_set1_epi32(0x000000FF);
+
+	__m128i diff, mask, result;
+
+	diff = _mm_sub_epi32(_mm_and_si128(yuv1, Ymask), _mm_and_si128(yuv2, Ymask));
+	mask = _mm_srai_epi32(diff, 31);
+	diff = _mm_sub_epi32(_mm_xor_si128(diff, mask), mask);
+	result = _mm_cmpgt_epi32(diff, _mm_set1_epi32(0x00300000));
+
+	diff = _mm_sub_epi32(_mm_and_si128(yuv1, Umask), _mm_and_si128(yuv2, Umask));
+	mask = _mm_srai_epi32(diff, 31);
+	diff = _mm_sub_epi32(_mm_xor_si128(diff, mask), mask);
+	result = _mm_or_si128(result, _mm_cmpgt_epi32(diff, _mm_set1_epi32(0x00000700)));
+
+	diff = _mm_sub_epi32(_mm_and_si128(yuv1, Vmask), _mm_and_si128(yuv2, Vmask));
+	mask = _mm_srai_epi32(diff, 31);
+	diff = _mm_sub_epi32(_mm_xor_si128(diff, mask), mask);
+	return _mm_or_si128(result, _mm_cmpgt_epi32(diff, _mm_set1_epi32(0x00000006)));
+}
+#endif
+
+/**
+ * Compute the patterns used by the hq scaler family for count (at most
+ * kHQChunkSize) pixels of a row, i.e. for each pixel which of its eight
+ * neighbours differ from it. Also returns the YUV values of the rows above,
+ * at and below the pixels in yuv[0], yuv[1] and yuv[2], starting one pixel
+ * to the left, so that the caller does not need further table lookups.
+ * @param p Pointer at the first pixel.
+ * @param nextlineSrc Pitch of the source, in pixels.
+ * @param count Number of pixels.
+ * @param rgbToYUV The table set up by InitLUT().
+ * @param yuv Receives the YUV values around the pixels.
+ * @param patterns Receives the pattern of each pixel.
+ */
+static inline void computeHQPatterns(const uint16 *p, uint32 nextlineSrc, int count, const uint32 *rgbToYUV,
+                                     uint32 yuv[3][kHQChunkSize + 2], int *patterns) {
+	for (int row = 0; row < 3; row++) {
+		const uint16 *src = p - 1 + (row - 1) * (int)nextlineSrc;
+		for (int x = 0; x < count + 2; x++)
+			yuv[row][x] = rgbToYUV[src[x]];
+	}
+
+	// Bit 0 to 7 of the pattern are set for neighbours w1 to w9, skipping
+	// the pixel itself (w5), when they differ from it.
+	static const int offsetX[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+	static const int offsetY[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+
+	int x = 0;
+#ifdef USE_SSE2
+	for (; x + 4 <= count; x += 4) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i w5 = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)(p + x)), zero);
+		const __m128i yuv5 = _mm_loadu_si128((const __m128i *)&yuv[1][x + 1]);
+		__m128i pattern = zero;
+
+		for (int n = 0; n < 8; n++) {
+			const uint16 *src = p + x + offsetX[n] + offsetY[n] * (int)nextlineSrc;
+			const __m128i w = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src), zero);
+			const __m128i yuvN = _mm_loadu_si128((const __m128i *)&yuv[offsetY[n] + 1][x + 1 + offsetX[n]]);
+			const __m128i differs = _mm_andnot_si128(_mm_cmpeq_epi32(w, w5), diffYUV_SSE2(yuv5, yuvN));
+
+			pattern = _mm_or_si128(pattern, _mm_and_si128(differs, _mm_set1_epi32(1 << n)));
+		}
+
+		_mm_storeu_si128((__m128i *)&patterns[x], pattern);
+	}
+#endif
+	for (; x < count; x++) {
+		const int w5 = p[x];
+		const int yuv5 = yuv[1][x + 1];
+		int pattern = 0;
+
+		for (int n = 0; n < 8; n++) {
+			const int w = p[x + offsetX[n] + offsetY[n] * (int)nextlineSrc];
+			if (w5 != w && diffYUV(yuv5, yuv[offsetY[n] + 1][x + 1 + offsetX[n]]))
+				pattern |= 1 << n;
+		}
+
+		patterns[x] = pattern;
+	}
+}
+
 #endif
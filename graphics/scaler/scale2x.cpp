@@ -19,7 +19,7 @@
  */
 
 /*
- * This file contains a C and MMX implementation of the Scale2x effect.
+ * This file contains a C, MMX and SSE2 implementation of the Scale2x effect.
  *
  * You can find an high level description of the effect at :
  *
@@ -34,6 +34,10 @@
 
 #include "common/scummsys.h"
 
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #include "graphics/scaler/scale2x.h"
 
 /***************************************************************************/
@@ -500,3 +504,109 @@ void scale2x_32_mmx(scale2x_uint32* dst0, scale2x_uint32* dst1, const scale2x_ui
 }
 
 #endif
+
+/***************************************************************************/
+/* Scale2x SSE2 implementation */
+
+#if defined(USE_SSE2)
+
+/*
+ * Apply the Scale2x effect at a single row, like scale2x_16_def_single(),
+ * but for 8 pixels at once. The remaining pixels are left to the C
+ * implementation.
+ */
+static inline void scale2x_16_sse2_single(scale2x_uint16* dst, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count) {
+	while (count >= 8) {
+		const __m128i b = _mm_loadu_si128((const __m128i *)src0);
+		const __m128i d = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i e = _mm_loadu_si128((const __m128i *)src1);
+		const __m128i f = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i h = _mm_loadu_si128((const __m128i *)src2);
+
+		/* all pixels are E, except where B != H and D != F */
+		const __m128i flat = _mm_or_si128(_mm_cmpeq_epi16(b, h), _mm_cmpeq_epi16(d, f));
+		const __m128i mask0 = _mm_andnot_si128(flat, _mm_cmpeq_epi16(d, b));
+		const __m128i mask1 = _mm_andnot_si128(flat, _mm_cmpeq_epi16(f, b));
+
+		/* select B where the mask is set, E elsewhere */
+		const __m128i be = _mm_xor_si128(b, e);
+		const __m128i out0 = _mm_xor_si128(e, _mm_and_si128(be, mask0));
+		const __m128i out1 = _mm_xor_si128(e, _mm_and_si128(be, mask1));
+
+		_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(out0, out1));
+		_mm_storeu_si128((__m128i *)(dst + 8), _mm_unpackhi_epi16(out0, out1));
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 16;
+		count -= 8;
+	}
+
+	scale2x_16_def_single(dst, src0, src1, src2, count);
+}
+
+/*
+ * Apply the Scale2x effect at a single row, like scale2x_32_def_single(),
+ * but for 4 pixels at once.
+ */
+static inline void scale2x_32_sse2_single(scale2x_uint32* dst, const scale2x_uint32* src0, const scale2x_uint32* src1, const scale2x_uint32* src2, unsigned count) {
+	while (count >= 4) {
+		const __m128i b = _mm_loadu_si128((const __m128i *)src0);
+		const __m128i d = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i e = _mm_loadu_si128((const __m128i *)src1);
+		const __m128i f = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i h = _mm_loadu_si128((const __m128i *)src2);
+
+		const __m128i flat = _mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f));
+		const __m128i mask0 = _mm_andnot_si128(flat, _mm_cmpeq_epi32(d, b));
+		const __m128i mask1 = _mm_andnot_si128(flat, _mm_cmpeq_epi32(f, b));
+
+		const __m128i be = _mm_xor_si128(b, e);
+		const __m128i out0 = _mm_xor_si128(e, _mm_and_si128(be, mask0));
+		const __m128i out1 = _mm_xor_si128(e, _mm_and_si128(be, mask1));
+
+		_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi32(out0, out1));
+		_mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi32(out0, out1));
+
+		src0 += 4;
+		src1 += 4;
+		src2 += 4;
+		dst += 8;
+		count -= 4;
+	}
+
+	scale2x_32_def_single(dst, src0, src1, src2, count);
+}
+
+/**
+ * Scale by a factor of 2 a row of pixels of 16 bits.
+ * This function operates like scale2x_16_def(), and gives the same result.
+ * @param src0 Pointer at the first pixel of the previous row.
+ * @param src1 Pointer at the first pixel of the current row.
+ * @param src2 Pointer at the first pixel of the next row.
+ * @param count Length in pixels of the src0, src1 and src2 rows.
+ * @param dst0 First destination row, double length in pixels.
+ * @param dst1 Second destination row, double length in pixels.
+ */
+void scale2x_16_sse2(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count) {
+	scale2x_16_sse2_single(dst0, src0, src1, src2, count);
+	scale2x_16_sse2_single(dst1, src2, src1, src0, count);
+}
+
+/**
+ * Scale by a factor of 2 a row of pixels of 32 bits.
+ * This function operates like scale2x_32_def(), and gives the same result.
+ * @param src0 Pointer at the first pixel of the previous row.
+ * @param src1 Pointer at the first pixel of the current row.
+ * @param src2 Pointer at the first pixel of the next row.
+ * @param count Length in pixels of the src0, src1 and src2 rows.
+ * @param dst0 First destination row, double length in pixels.
+ * @param dst1 Second destination row, double length in pixels.
+ */
+void scale2x_32_sse2(scale2x_uint32* dst0, scale2x_uint32* dst1, const scale2x_uint32* src0, const scale2x_uint32* src1, const scale2x_uint32* src2, unsigned count) {
+	scale2x_32_sse2_single(dst0, src0, src1, src2, count);
+	scale2x_32_sse2_single(dst1, src2, src1, src0, count);
+}
+
+#endif
@@ -36,6 +36,10 @@
 
 #include "graphics/scaler/scale3x.h"
 
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
 /***************************************************************************/
 /* Scale3x C implementation */
 
@@ -220,3 +224,221 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
 	scale3x_32_def_center(dst1, src0, src1, src2, count);
 	scale3x_32_def_border(dst2, src2, src1, src0, count);
 }
+
+/***************************************************************************/
+/* Scale3x SSE2 implementation */
+
+#if defined(USE_SSE2)
+
+/*
+ * Return the pixels of x where the mask is set, and those of y elsewhere.
+ */
+static inline __m128i scale3x_select(__m128i mask, __m128i x, __m128i y) {
+	return _mm_xor_si128(y, _mm_and_si128(_mm_xor_si128(x, y), mask));
+}
+
+/*
+ * Apply the Scale3x effect at a single border row, like
+ * scale3x_16_def_border(), but for 8 pixels at once.
+ */
+static inline void scale3x_16_sse2_border(scale3x_uint16* dst, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	while (count >= 8) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)(src0 - 1));
+		const __m128i b = _mm_loadu_si128((const __m128i *)src0);
+		const __m128i c = _mm_loadu_si128((const __m128i *)(src0 + 1));
+		const __m128i d = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i e = _mm_loadu_si128((const __m128i *)src1);
+		const __m128i f = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i h = _mm_loadu_si128((const __m128i *)src2);
+
+		const __m128i flat = _mm_or_si128(_mm_cmpeq_epi16(b, h), _mm_cmpeq_epi16(d, f));
+		const __m128i db = _mm_andnot_si128(flat, _mm_cmpeq_epi16(d, b));
+		const __m128i fb = _mm_andnot_si128(flat, _mm_cmpeq_epi16(f, b));
+		const __m128i mask1 = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi16(e, c), db), _mm_andnot_si128(_mm_cmpeq_epi16(e, a), fb));
+
+		scale3x_uint16 out0[8], out1[8], out2[8];
+		_mm_storeu_si128((__m128i *)out0, scale3x_select(db, d, e));
+		_mm_storeu_si128((__m128i *)out1, scale3x_select(mask1, b, e));
+		_mm_storeu_si128((__m128i *)out2, scale3x_select(fb, f, e));
+
+		for (unsigned i = 0; i < 8; ++i) {
+			dst[0] = out0[i];
+			dst[1] = out1[i];
+			dst[2] = out2[i];
+			dst += 3;
+		}
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		count -= 8;
+	}
+
+	scale3x_16_def_border(dst, src0, src1, src2, count);
+}
+
+/*
+ * Apply the Scale3x effect at the center row, like
+ * scale3x_16_def_center(), but for 8 pixels at once.
+ */
+static inline void scale3x_16_sse2_center(scale3x_uint16* dst, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	while (count >= 8) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)(src0 - 1));
+		const __m128i b = _mm_loadu_si128((const __m128i *)src0);
+		const __m128i c = _mm_loadu_si128((const __m128i *)(src0 + 1));
+		const __m128i d = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i e = _mm_loadu_si128((const __m128i *)src1);
+		const __m128i f = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i g = _mm_loadu_si128((const __m128i *)(src2 - 1));
+		const __m128i h = _mm_loadu_si128((const __m128i *)src2);
+		const __m128i i = _mm_loadu_si128((const __m128i *)(src2 + 1));
+
+		const __m128i flat = _mm_or_si128(_mm_cmpeq_epi16(b, h), _mm_cmpeq_epi16(d, f));
+		const __m128i mask0 = _mm_andnot_si128(flat, _mm_or_si128(
+			_mm_andnot_si128(_mm_cmpeq_epi16(e, g), _mm_cmpeq_epi16(d, b)),
+			_mm_andnot_si128(_mm_cmpeq_epi16(e, a), _mm_cmpeq_epi16(d, h))));
+		const __m128i mask2 = _mm_andnot_si128(flat, _mm_or_si128(
+			_mm_andnot_si128(_mm_cmpeq_epi16(e, i), _mm_cmpeq_epi16(f, b)),
+			_mm_andnot_si128(_mm_cmpeq_epi16(e, c), _mm_cmpeq_epi16(f, h))));
+
+		scale3x_uint16 out0[8], out1[8], out2[8];
+		_mm_storeu_si128((__m128i *)out0, scale3x_select(mask0, d, e));
+		_mm_storeu_si128((__m128i *)out1, e);
+		_mm_storeu_si128((__m128i *)out2, scale3x_select(mask2, f, e));
+
+		for (unsigned j = 0; j < 8; ++j) {
+			dst[0] = out0[j];
+			dst[1] = out1[j];
+			dst[2] = out2[j];
+			dst += 3;
+		}
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		count -= 8;
+	}
+
+	scale3x_16_def_center(dst, src0, src1, src2, count);
+}
+
+/*
+ * Apply the Scale3x effect at a single border row, like
+ * scale3x_32_def_border(), but for 4 pixels at once.
+ */
+static inline void scale3x_32_sse2_border(scale3x_uint32* dst, const scale3x_uint32* src0, const scale3x_uint32* src1, const scale3x_uint32* src2, unsigned count) {
+	while (count >= 4) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)(src0 - 1));
+		const __m128i b = _mm_loadu_si128((const __m128i *)src0);
+		const __m128i c = _mm_loadu_si128((const __m128i *)(src0 + 1));
+		const __m128i d = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i e = _mm_loadu_si128((const __m128i *)src1);
+		const __m128i f = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i h = _mm_loadu_si128((const __m128i *)src2);
+
+		const __m128i flat = _mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f));
+		const __m128i db = _mm_andnot_si128(flat, _mm_cmpeq_epi32(d, b));
+		const __m128i fb = _mm_andnot_si128(flat, _mm_cmpeq_epi32(f, b));
+		const __m128i mask1 = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi32(e, c), db), _mm_andnot_si128(_mm_cmpeq_epi32(e, a), fb));
+
+		scale3x_uint32 out0[4], out1[4], out2[4];
+		_mm_storeu_si128((__m128i *)out0, scale3x_select(db, d, e));
+		_mm_storeu_si128((__m128i *)out1, scale3x_select(mask1, b, e));
+		_mm_storeu_si128((__m128i *)out2, scale3x_select(fb, f, e));
+
+		for (unsigned i = 0; i < 4; ++i) {
+			dst[0] = out0[i];
+			dst[1] = out1[i];
+			dst[2] = out2[i];
+			dst += 3;
+		}
+
+		src0 += 4;
+		src1 += 4;
+		src2 += 4;
+		count -= 4;
+	}
+
+	scale3x_32_def_border(dst, src0, src1, src2, count);
+}
+
+/*
+ * Apply the Scale3x effect at the center row, like
+ * scale3x_32_def_center(), but for 4 pixels at once.
+ */
+static inline void scale3x_32_sse2_center(scale3x_uint32* dst, const scale3x_uint32* src0, const scale3x_uint32* src1, const scale3x_uint32* src2, unsigned count) {
+	while (count >= 4) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)(src0 - 1));
+		const __m128i b = _mm_loadu_si128((const __m128i *)src0);
+		const __m128i c = _mm_loadu_si128((const __m128i *)(src0 + 1));
+		const __m128i d = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i e = _mm_loadu_si128((const __m128i *)src1);
+		const __m128i f = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i g = _mm_loadu_si128((const __m128i *)(src2 - 1));
+		const __m128i h = _mm_loadu_si128((const __m128i *)src2);
+		const __m128i i = _mm_loadu_si128((const __m128i *)(src2 + 1));
+
+		const __m128i flat = _mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f));
+		const __m128i mask0 = _mm_andnot_si128(flat, _mm_or_si128(
+			_mm_andnot_si128(_mm_cmpeq_epi32(e, g), _mm_cmpeq_epi32(d, b)),
+			_mm_andnot_si128(_mm_cmpeq_epi32(e, a), _mm_cmpeq_epi32(d, h))));
+		const __m128i mask2 = _mm_andnot_si128(flat, _mm_or_si128(
+			_mm_andnot_si128(_mm_cmpeq_epi32(e, i), _mm_cmpeq_epi32(f, b)),
+			_mm_andnot_si128(_mm_cmpeq_epi32(e, c), _mm_cmpeq_epi32(f, h))));
+
+		scale3x_uint32 out0[4], out1[4], out2[4];
+		_mm_storeu_si128((__m128i *)out0, scale3x_select(mask0, d, e));
+		_mm_storeu_si128((__m128i *)out1, e);
+		_mm_storeu_si128((__m128i *)out2, scale3x_select(mask2, f, e));
+
+		for (unsigned j = 0; j < 4; ++j) {
+			dst[0] = out0[j];
+			dst[1] = out1[j];
+			dst[2] = out2[j];
+			dst += 3;
+		}
+
+		src0 += 4;
+		src1 += 4;
+		src2 += 4;
+		count -= 4;
+	}
+
+	scale3x_32_def_center(dst, src0, src1, src2, count);
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 16 bits.
+ * This function operates like scale3x_16_def(), and gives the same result.
+ * @param src0 Pointer at the first pixel of the previous row.
+ * @param src1 Pointer at the first pixel of the current row.
+ * @param src2 Pointer at the first pixel of the next row.
+ * @param count Length in pixels of the src0, src1 and src2 rows.
+ * @param dst0 First destination row, triple length in pixels.
+ * @param dst1 Second destination row, triple length in pixels.
+ * @param dst2 Third destination row, triple length in pixels.
+ */
+void scale3x_16_sse2(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	scale3x_16_sse2_border(dst0, src0, src1, src2, count);
+	scale3x_16_sse2_center(dst1, src0, src1, src2, count);
+	scale3x_16_sse2_border(dst2, src2, src1, src0, count);
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 32 bits.
+ * This function operates like scale3x_32_def(), and gives the same result.
+ * @param src0 Pointer at the first pixel of the previous row.
+ * @param src1 Pointer at the first pixel of the current row.
+ * @param src2 Pointer at the first pixel of the next row.
+ * @param count Length in pixels of the src0, src1 and src2 rows.
+ * @param dst0 First destination row, triple length in pixels.
+ * @param dst1 Second destination row, triple length in pixels.
+ * @param dst2 Third destination row, triple length in pixels.
+ */
+void scale3x_32_sse2(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32* dst2, const scale3x_uint32* src0, const scale3x_uint32* src1, const scale3x_uint32* src2, unsigned count) {
+	scale3x_32_sse2_border(dst0, src0, src1, src2, count);
+	scale3x_32_sse2_center(dst1, src0, src1, src2, count);
+	scale3x_32_sse2_border(dst2, src2, src1, src0, count);
+}
+
+#endif
@@ -86,6 +86,10 @@
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
 
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
 }
@@ -192,6 +196,105 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	return _lookup;
 }
 
+#ifdef USE_SSE2
+
+/**
+ * Converts YUV to RGB eight pixels at a time with SSE2, with the same
+ * result as the lookup tables. The chroma values are still looked up in
+ * _colorTab, by the caller, as there is one per two or four pixels anyway.
+ */
+class YUVToRGBConverterSSE2 {
+public:
+	YUVToRGBConverterSSE2(const Graphics::PixelFormat &format, YUVToRGBManager::LuminanceScale scale) {
+		_limited = (scale == YUVToRGBManager::kScaleITU);
+		_rLoss = _mm_cvtsi32_si128(format.rLoss);
+		_gLoss = _mm_cvtsi32_si128(format.gLoss);
+		_bLoss = _mm_cvtsi32_si128(format.bLoss);
+		_rShift = _mm_cvtsi32_si128(format.rShift);
+		_gShift = _mm_cvtsi32_si128(format.gShift);
+		_bShift = _mm_cvtsi32_si128(format.bShift);
+		_alpha = format.RGBToColor(0, 0, 0);
+	}
+
+	/**
+	 * Convert a row, except for the last (width % 8) pixels.
+	 *
+	 * @param dst   the destination row
+	 * @param ySrc  the luminance values
+	 * @param crR   the red chroma offset of each pixel, like cr_r
+	 * @param crbG  the green chroma offset of each pixel, like crb_g
+	 * @param cbB   the blue chroma offset of each pixel, like cb_b
+	 * @param width the number of pixels
+	 * @return the number of pixels converted
+	 */
+	template<typename PixelInt>
+	int convertRow(byte *dst, const byte *ySrc, const int16 *crR, const int16 *crbG, const int16 *cbB, int width) const;
+
+private:
+	bool _limited;
+	__m128i _rLoss, _gLoss, _bLoss;
+	__m128i _rShift, _gShift, _bShift;
+	uint32 _alpha;
+
+	/**
+	 * Add the chroma offsets (still including their table offset) to the
+	 * luminance and clamp the result like the tables in YUVToRGBLookup do.
+	 */
+	__m128i channel(__m128i y, const int16 *offsets, int tableOffset) const {
+		__m128i value = _mm_add_epi16(y, _mm_sub_epi16(_mm_loadu_si128((const __m128i *)offsets), _mm_set1_epi16(tableOffset)));
+
+		if (!_limited)
+			return _mm_unpacklo_epi8(_mm_packus_epi16(value, value), _mm_setzero_si128());
+
+		// (value - 16) * 255 / 219, the division being done as a multiply
+		// by 2^23 / 219, which is exact over this range
+		value = _mm_max_epi16(_mm_min_epi16(value, _mm_set1_epi16(235)), _mm_set1_epi16(16));
+		value = _mm_mullo_epi16(_mm_sub_epi16(value, _mm_set1_epi16(16)), _mm_set1_epi16(255));
+		return _mm_srli_epi16(_mm_mulhi_epu16(value, _mm_set1_epi16((short)38305)), 7);
+	}
+
+	void store(uint16 *dst, __m128i r, __m128i g, __m128i b) const {
+		__m128i pixels = _mm_set1_epi16((short)_alpha);
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(r, _rLoss), _rShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(g, _gLoss), _gShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(b, _bLoss), _bShift));
+		_mm_storeu_si128((__m128i *)dst, pixels);
+	}
+
+	void store(uint32 *dst, __m128i r, __m128i g, __m128i b) const {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alpha = _mm_set1_epi32(_alpha);
+
+		__m128i pixels = _mm_or_si128(alpha, _mm_sll_epi32(_mm_srl_epi32(_mm_unpacklo_epi16(r, zero), _rLoss), _rShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(_mm_unpacklo_epi16(g, zero), _gLoss), _gShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(_mm_unpacklo_epi16(b, zero), _bLoss), _bShift));
+		_mm_storeu_si128((__m128i *)dst, pixels);
+
+		pixels = _mm_or_si128(alpha, _mm_sll_epi32(_mm_srl_epi32(_mm_unpackhi_epi16(r, zero), _rLoss), _rShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(_mm_unpackhi_epi16(g, zero), _gLoss), _gShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(_mm_unpackhi_epi16(b, zero), _bLoss), _bShift));
+		_mm_storeu_si128((__m128i *)(dst + 4), pixels);
+	}
+};
+
+template<typename PixelInt>
+int YUVToRGBConverterSSE2::convertRow(byte *dst, const byte *ySrc, const int16 *crR, const int16 *crbG, const int16 *cbB, int width) const {
+	int x = 0;
+
+	for (; x + 8 <= width; x += 8) {
+		const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(ySrc + x)), _mm_setzero_si128());
+
+		store((PixelInt *)dst + x,
+		      channel(y, crR + x, 0 * 768 + 256),
+		      channel(y, crbG + x, 1 * 768 + 256),
+		      channel(y, cbB + x, 2 * 768 + 256));
+	}
+
+	return x;
+}
+
+#endif // USE_SSE2
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
@@ -227,6 +330,46 @@ void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	}
 }
 
+#ifdef USE_SSE2
+
+template<typename PixelInt>
+void convertYUV444ToRGBSSE2(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, YUVToRGBManager::LuminanceScale scale, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const int16 *Cr_r_tab = colorTab;
+	const int16 *Cr_g_tab = Cr_r_tab + 256;
+	const int16 *Cb_g_tab = Cr_g_tab + 256;
+	const int16 *Cb_b_tab = Cb_g_tab + 256;
+	const uint32 *rgbToPix = lookup->getRGBToPix();
+
+	const YUVToRGBConverterSSE2 converter(lookup->getFormat(), scale);
+	int16 *chroma = new int16[3 * yWidth];
+	int16 *crR = chroma, *crbG = chroma + yWidth, *cbB = chroma + 2 * yWidth;
+
+	for (int h = 0; h < yHeight; h++) {
+		for (int w = 0; w < yWidth; w++) {
+			crR[w]  = Cr_r_tab[vSrc[w]];
+			crbG[w] = Cr_g_tab[vSrc[w]] + Cb_g_tab[uSrc[w]];
+			cbB[w]  = Cb_b_tab[uSrc[w]];
+		}
+
+		// The pixels left over by the vector code
+		for (int w = converter.convertRow<PixelInt>(dstPtr, ySrc, crR, crbG, cbB, yWidth); w < yWidth; w++) {
+			register const uint32 *L;
+			int16 cr_r = crR[w], crb_g = crbG[w], cb_b = cbB[w];
+
+			PUT_PIXEL(ySrc[w], dstPtr + w * sizeof(PixelInt));
+		}
+
+		dstPtr += dstPitch;
+		ySrc += yPitch;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+
+	delete[] chroma;
+}
+
+#endif
+
 void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Sanity checks
 	assert(dst && dst->pixels);
@@ -236,10 +379,17 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
 	// Use a templated function to avoid an if check on every pixel
+#ifdef USE_SSE2
+	if (dst->format.bytesPerPixel == 2)
+		convertYUV444ToRGBSSE2<uint16>((byte *)dst->pixels, dst->pitch, lookup, scale, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	else
+		convertYUV444ToRGBSSE2<uint32>((byte *)dst->pixels, dst->pitch, lookup, scale, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+#else
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV444ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 	else
 		convertYUV444ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+#endif
 }
 
 template<typename PixelInt>
@@ -281,6 +431,50 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	}
 }
 
+#ifdef USE_SSE2
+
+template<typename PixelInt>
+void convertYUV420ToRGBSSE2(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, YUVToRGBManager::LuminanceScale scale, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const int16 *Cr_r_tab = colorTab;
+	const int16 *Cr_g_tab = Cr_r_tab + 256;
+	const int16 *Cb_g_tab = Cr_g_tab + 256;
+	const int16 *Cb_b_tab = Cb_g_tab + 256;
+	const uint32 *rgbToPix = lookup->getRGBToPix();
+
+	const YUVToRGBConverterSSE2 converter(lookup->getFormat(), scale);
+	int16 *chroma = new int16[3 * yWidth];
+	int16 *crR = chroma, *crbG = chroma + yWidth, *cbB = chroma + 2 * yWidth;
+
+	for (int h = 0; h < (yHeight >> 1); h++) {
+		// Every chroma value covers two pixels in each of two rows
+		for (int w = 0; w < (yWidth >> 1); w++) {
+			crR[2 * w]  = crR[2 * w + 1]  = Cr_r_tab[vSrc[w]];
+			crbG[2 * w] = crbG[2 * w + 1] = Cr_g_tab[vSrc[w]] + Cb_g_tab[uSrc[w]];
+			cbB[2 * w]  = cbB[2 * w + 1]  = Cb_b_tab[uSrc[w]];
+		}
+
+		for (int row = 0; row < 2; row++) {
+			// The pixels left over by the vector code
+			for (int w = converter.convertRow<PixelInt>(dstPtr, ySrc, crR, crbG, cbB, yWidth); w < yWidth; w++) {
+				register const uint32 *L;
+				int16 cr_r = crR[w], crb_g = crbG[w], cb_b = cbB[w];
+
+				PUT_PIXEL(ySrc[w], dstPtr + w * sizeof(PixelInt));
+			}
+
+			dstPtr += dstPitch;
+			ySrc += yPitch;
+		}
+
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+
+	delete[] chroma;
+}
+
+#endif
+
 void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Sanity checks
 	assert(dst && dst->pixels);
@@ -292,10 +486,17 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
 	// Use a templated function to avoid an if check on every pixel
+#ifdef USE_SSE2
+	if (dst->format.bytesPerPixel == 2)
+		convertYUV420ToRGBSSE2<uint16>((byte *)dst->pixels, dst->pitch, lookup, scale, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	else
+		convertYUV420ToRGBSSE2<uint32>((byte *)dst->pixels, dst->pitch, lookup, scale, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+#else
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV420ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 	else
 		convertYUV420ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+#endif
 }
 
 #define READ_QUAD(ptr, prefix) \
@@ -318,6 +318,7 @@ ThemeEngine::~ThemeEngine() {
 	_vectorRenderer = 0;
 	_screen.free();
 	_backBuffer.free();
+	_dialogBackground.free();
 
 	unloadTheme();
 
@@ -437,6 +438,8 @@ bool ThemeEngine::init() {
 }
 
 void ThemeEngine::clearAll() {
+	discardDialogBackground();
+
 	if (_initOk) {
 		_system->clearOverlay();
 		_system->grabOverlay(_screen.pixels, _screen.pitch);
@@ -508,6 +511,8 @@ void ThemeEngine::setGraphicsMode(GraphicsMode mode) {
 	uint32 width = _system->getOverlayWidth();
 	uint32 height = _system->getOverlayHeight();
 
+	discardDialogBackground();
+
 	_backBuffer.free();
 	_backBuffer.create(width, height, _overlayFormat);
 
@@ -1246,6 +1251,14 @@ void ThemeEngine::addDirtyRect(Common::Rect r) {
 	if (r.isEmpty())
 		return;
 
+	// Keep track of the area which differs from the stored dialog background
+	if (_dialogBackground.pixels) {
+		if (_dialogBackgroundDamage.isEmpty())
+			_dialogBackgroundDamage = r;
+		else
+			_dialogBackgroundDamage.extend(r);
+	}
+
 	// Check if the new rectangle is contained within another in the list
 	Common::List<Common::Rect>::iterator it;
 	for (it = _dirtyScreen.begin(); it != _dirtyScreen.end();) {
@@ -1291,6 +1304,35 @@ void ThemeEngine::openDialog(bool doBuffer, ShadingStyle style) {
 	_vectorRenderer->setSurface(&_screen);
 }
 
+void ThemeEngine::storeDialogBackground() {
+	if (!_dialogBackground.pixels)
+		_dialogBackground.create(_screen.w, _screen.h, _screen.format);
+
+	memcpy(_dialogBackground.getBasePtr(0, 0), _screen.getBasePtr(0, 0), _screen.pitch * _screen.h);
+	_dialogBackgroundDamage = Common::Rect();
+}
+
+bool ThemeEngine::restoreDialogBackground() {
+	if (!_dialogBackground.pixels)
+		return false;
+
+	// Only the area drawn since the background was stored needs to be
+	// restored and sent to the overlay again.
+	const Common::Rect r = _dialogBackgroundDamage;
+	const int bytes = r.width() * _screen.format.bytesPerPixel;
+	for (int y = r.top; y < r.bottom; ++y)
+		memcpy(_screen.getBasePtr(r.left, y), _dialogBackground.getBasePtr(r.left, y), bytes);
+
+	addDirtyRect(r);
+	_dialogBackgroundDamage = Common::Rect();
+	return true;
+}
+
+void ThemeEngine::discardDialogBackground() {
+	_dialogBackground.free();
+	_dialogBackgroundDamage = Common::Rect();
+}
+
 bool ThemeEngine::createCursor(const Common::String &filename, int hotspotX, int hotspotY) {
 	if (!_system->hasFeature(OSystem::kFeatureCursorPalette))
 		return true;
@@ -1582,12 +1624,9 @@ bool ThemeEngine::themeConfigUsable(const Common::FSNode &node, Common::String &
 			// Open THEMERC from the ZIP file.
 			stream.open("THEMERC", *zipArchive);
 		}
-		// Delete the ZIP archive again. Note: This only works because
-		// stream.open() only uses ZipArchive::createReadStreamForMember,
-		// and that in turn happens to read all the data for a given
-		// archive member into a memory block. So there will be no dangling
-		// reference to zipArchive anywhere. This could change if we
-		// ever modify ZipArchive::createReadStreamForMember.
+		// Delete the ZIP archive again. The member stream shares the
+		// archive's file stream, which stays open until the member stream
+		// is closed as well.
 		delete zipArchive;
 	} else if (node.isDirectory()) {
 		Common::FSNode headerfile = node.getChild("THEMERC");
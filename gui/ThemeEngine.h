@@ -28,6 +28,7 @@
 #include "common/hash-str.h"
 #include "common/hashmap.h"
 #include "common/list.h"
+#include "common/rect.h"
 #include "common/str.h"
 
 #include "graphics/surface.h"
@@ -39,10 +40,6 @@
 
 class OSystem;
 
-namespace Common {
-struct Rect;
-}
-
 namespace Graphics {
 struct DrawStep;
 class VectorRenderer;
@@ -306,6 +303,27 @@ public:
 	 */
 	void openDialog(bool enableBuffering, ShadingStyle shading = kShadingNone);
 
+	/**
+	 * Stores the current screen, which holds the dialogs below the top
+	 * dialog, so that the top dialog can later be redrawn on its own.
+	 * Must be called right after openDialog() for the top dialog.
+	 */
+	void storeDialogBackground();
+
+	/**
+	 * Restores the screen stored by storeDialogBackground(), and marks
+	 * everything drawn over it since then as dirty.
+	 *
+	 * @return false if no screen is stored.
+	 */
+	bool restoreDialogBackground();
+
+	/**
+	 * Discards the screen stored by storeDialogBackground(). Called
+	 * whenever the dialogs below the top dialog change.
+	 */
+	void discardDialogBackground();
+
 	/**
 	 * The updateScreen() method is called every frame.
 	 * It processes all the drawing queues and then copies dirty rects
@@ -635,6 +653,12 @@ protected:
 	/** Backbuffer surface. Stores previous states of the screen to blit back */
 	Graphics::Surface _backBuffer;
 
+	/** Screen below the top dialog, see storeDialogBackground() */
+	Graphics::Surface _dialogBackground;
+
+	/** Bounding box of everything drawn over _dialogBackground */
+	Common::Rect _dialogBackgroundDamage;
+
 	/** Sets whether the current drawing is being buffered (stored for later
 	    processing) or drawn directly to the screen. */
 	bool _buffering;
@@ -217,9 +217,20 @@ void GuiManager::redraw() {
 		shading = ThemeEngine::kShadingNone;
 
 	switch (_redrawStatus) {
+		case kRedrawTopDialog:
+			// The dialogs below the top one did not change, so when their
+			// screen was stored, only the top dialog has to be redrawn.
+			if (_theme->restoreDialogBackground()) {
+				_theme->openDialog(true, ThemeEngine::kShadingNone);
+				_dialogStack.top()->drawDialog();
+				_theme->finishBuffering();
+				break;
+			}
+
+			// fall through
+
 		case kRedrawCloseDialog:
 		case kRedrawFull:
-		case kRedrawTopDialog:
 			_theme->clearAll();
 			_theme->openDialog(true, ThemeEngine::kShadingNone);
 
@@ -227,8 +238,15 @@ void GuiManager::redraw() {
 				_dialogStack[i]->drawDialog();
 
 			_theme->finishBuffering();
+			_theme->updateScreen(false);
+			_theme->openDialog(true, shading);
 
-			// fall through
+			if (_dialogStack.size() > 1)
+				_theme->storeDialogBackground();
+
+			_dialogStack.top()->drawDialog();
+			_theme->finishBuffering();
+			break;
 
 		case kRedrawOpenDialog:
 			_theme->updateScreen(false);
@@ -405,6 +423,7 @@ void GuiManager::openDialog(Dialog *dialog) {
 		getTopDialog()->lostFocus();
 
 	_dialogStack.push(dialog);
+	_theme->discardDialogBackground();
 	if (_redrawStatus != kRedrawFull)
 		_redrawStatus = kRedrawOpenDialog;
 
@@ -422,6 +441,7 @@ void GuiManager::closeTopDialog() {
 
 	// Remove the dialog from the stack
 	_dialogStack.pop()->lostFocus();
+	_theme->discardDialogBackground();
 
 	if (!_dialogStack.empty())
 		getTopDialog()->receivedFocus();
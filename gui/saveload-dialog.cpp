@@ -22,6 +22,7 @@
 #include "gui/saveload-dialog.h"
 #include "common/translation.h"
 #include "common/config-manager.h"
+#include "common/system.h"
 
 #include "gui/message.h"
 #include "gui/gui-manager.h"
@@ -535,6 +536,12 @@ enum {
 	kNewSaveCmd = 'SAVE'
 };
 
+enum {
+	// Upper bound (in milliseconds) we want to spend loading meta infos in
+	// handleTickle.
+	kMaxMetaInfoLoadTime = 20
+};
+
 SaveLoadChooserGrid::SaveLoadChooserGrid(const Common::String &title, bool saveMode)
 	: SaveLoadChooserDialog("SaveLoadChooser", saveMode), _lines(0), _columns(0), _entriesPerPage(0),
 	_curPage(0), _newSaveContainer(0), _nextFreeSaveSlot(0), _buttons() {
@@ -569,6 +576,15 @@ void SaveLoadChooserGrid::handleCommand(CommandSender *sender, uint32 cmd, uint3
 		const SaveStateDescriptor &desc = _saveList[cmd - 1 + _curPage * _entriesPerPage];
 
 		if (_saveMode) {
+			// The meta infos might not have been loaded yet, make sure the
+			// slot is not write protected.
+			const SaveStateDescriptor &metaInfos = getMetaInfos(desc.getSaveSlot());
+			if (metaInfos.getWriteProtectedFlag()) {
+				updateSlotButton(_buttons[cmd - 1], desc.getSaveSlot(), metaInfos);
+				draw();
+				return;
+			}
+
 			_resultString = desc.getDescription();
 		}
 
@@ -618,10 +634,27 @@ void SaveLoadChooserGrid::handleMouseWheel(int x, int y, int direction) {
 	}
 }
 
+void SaveLoadChooserGrid::handleTickle() {
+	const uint32 start = g_system->getMillis();
+
+	while (!_pendingButtons.empty() && (g_system->getMillis() - start) < kMaxMetaInfoLoadTime) {
+		const uint curNum = _pendingButtons.front();
+		_pendingButtons.remove_at(0);
+
+		SlotButton &curButton = _buttons[curNum];
+		const int saveSlot = _saveList[_curPage * _entriesPerPage + curNum].getSaveSlot();
+		updateSlotButton(curButton, saveSlot, getMetaInfos(saveSlot));
+		curButton.button->draw();
+	}
+
+	SaveLoadChooserDialog::handleTickle();
+}
+
 void SaveLoadChooserGrid::open() {
 	SaveLoadChooserDialog::open();
 
 	_saveList = _metaEngine->listSaves(_target.c_str());
+	_metaInfoCache.clear();
 	_resultString.clear();
 
 	// Load information to restore the last page the user had open.
@@ -788,6 +821,7 @@ void SaveLoadChooserGrid::close() {
 
 	SaveLoadChooserDialog::close();
 	hideButtons();
+	_metaInfoCache.clear();
 }
 
 int SaveLoadChooserGrid::runIntern() {
@@ -845,58 +879,34 @@ void SaveLoadChooserGrid::hideButtons() {
 		i->button->setGfx(0);
 		i->setVisible(false);
 	}
+
+	_pendingButtons.clear();
+}
+
+const SaveStateDescriptor &SaveLoadChooserGrid::getMetaInfos(int saveSlot) {
+	MetaInfoCache::const_iterator i = _metaInfoCache.find(saveSlot);
+	if (i != _metaInfoCache.end())
+		return i->_value;
+
+	return _metaInfoCache[saveSlot] = _metaEngine->querySaveMetaInfos(_target.c_str(), saveSlot);
 }
 
 void SaveLoadChooserGrid::updateSaves() {
 	hideButtons();
 
 	for (uint i = _curPage * _entriesPerPage, curNum = 0; i < _saveList.size() && curNum < _entriesPerPage; ++i, ++curNum) {
-		const uint saveSlot = _saveList[i].getSaveSlot();
-
-		SaveStateDescriptor desc = _metaEngine->querySaveMetaInfos(_target.c_str(), saveSlot);
 		SlotButton &curButton = _buttons[curNum];
 		curButton.setVisible(true);
-		const Graphics::Surface *thumbnail = desc.getThumbnail();
-		if (thumbnail) {
-			curButton.button->setGfx(desc.getThumbnail());
-		} else {
-			curButton.button->setGfx(kThumbnailWidth, kThumbnailHeight2, 0, 0, 0);
-		}
-		curButton.description->setLabel(Common::String::format("%d. %s", saveSlot, desc.getDescription().c_str()));
-
-		Common::String tooltip(_("Name: "));
-		tooltip += desc.getDescription();
 
-		if (_saveDateSupport) {
-			const Common::String &saveDate = desc.getSaveDate();
-			if (!saveDate.empty()) {
-				tooltip += "\n";
-				tooltip +=  _("Date: ") + saveDate;
-			}
-
-			const Common::String &saveTime = desc.getSaveTime();
-			if (!saveTime.empty()) {
-				tooltip += "\n";
-				tooltip += _("Time: ") + saveTime;
-			}
-		}
-
-		if (_playTimeSupport) {
-			const Common::String &playTime = desc.getPlayTime();
-			if (!playTime.empty()) {
-				tooltip += "\n";
-				tooltip += _("Playtime: ") + playTime;
-			}
-		}
-
-		curButton.button->setTooltip(tooltip);
-
-		// In save mode we disable the button, when it's write protected.
-		// TODO: Maybe we should not display it at all then?
-		if (_saveMode && desc.getWriteProtectedFlag()) {
-			curButton.button->setEnabled(false);
+		// Use the meta infos if we already have them, otherwise show what
+		// the save list knows until handleTickle() loads them.
+		const int saveSlot = _saveList[i].getSaveSlot();
+		MetaInfoCache::const_iterator metaInfos = _metaInfoCache.find(saveSlot);
+		if (metaInfos != _metaInfoCache.end()) {
+			updateSlotButton(curButton, saveSlot, metaInfos->_value);
 		} else {
-			curButton.button->setEnabled(true);
+			updateSlotButton(curButton, saveSlot, _saveList[i]);
+			_pendingButtons.push_back(curNum);
 		}
 	}
 
@@ -914,6 +924,51 @@ void SaveLoadChooserGrid::updateSaves() {
 		_nextButton->setEnabled(false);
 }
 
+void SaveLoadChooserGrid::updateSlotButton(SlotButton &curButton, int saveSlot, const SaveStateDescriptor &desc) {
+	const Graphics::Surface *thumbnail = desc.getThumbnail();
+	if (thumbnail) {
+		curButton.button->setGfx(desc.getThumbnail());
+	} else {
+		curButton.button->setGfx(kThumbnailWidth, kThumbnailHeight2, 0, 0, 0);
+	}
+	curButton.description->setLabel(Common::String::format("%d. %s", saveSlot, desc.getDescription().c_str()));
+
+	Common::String tooltip(_("Name: "));
+	tooltip += desc.getDescription();
+
+	if (_saveDateSupport) {
+		const Common::String &saveDate = desc.getSaveDate();
+		if (!saveDate.empty()) {
+			tooltip += "\n";
+			tooltip +=  _("Date: ") + saveDate;
+		}
+
+		const Common::String &saveTime = desc.getSaveTime();
+		if (!saveTime.empty()) {
+			tooltip += "\n";
+			tooltip += _("Time: ") + saveTime;
+		}
+	}
+
+	if (_playTimeSupport) {
+		const Common::String &playTime = desc.getPlayTime();
+		if (!playTime.empty()) {
+			tooltip += "\n";
+			tooltip += _("Playtime: ") + playTime;
+		}
+	}
+
+	curButton.button->setTooltip(tooltip);
+
+	// In save mode we disable the button, when it's write protected.
+	// TODO: Maybe we should not display it at all then?
+	if (_saveMode && desc.getWriteProtectedFlag()) {
+		curButton.button->setEnabled(false);
+	} else {
+		curButton.button->setEnabled(true);
+	}
+}
+
 SavenameDialog::SavenameDialog()
 	: Dialog("SavenameDialog") {
 	_title = new StaticTextWidget(this, "SavenameDialog.DescriptionText", Common::String());
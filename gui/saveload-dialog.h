@@ -27,6 +27,8 @@
 
 #include "engines/metaengine.h"
 
+#include "common/hashmap.h"
+
 namespace GUI {
 
 #define kSwitchSaveLoadDialog -2
@@ -163,6 +165,7 @@ public:
 protected:
 	virtual void handleCommand(CommandSender *sender, uint32 cmd, uint32 data);
 	virtual void handleMouseWheel(int x, int y, int direction);
+	virtual void handleTickle();
 private:
 	virtual int runIntern();
 
@@ -200,6 +203,15 @@ private:
 	void destroyButtons();
 	void hideButtons();
 	void updateSaves();
+	void updateSlotButton(SlotButton &button, int saveSlot, const SaveStateDescriptor &desc);
+
+	// Querying the meta infos reads the whole save thumbnail, which is too
+	// slow to do for a whole page at once. The buttons are first set up
+	// from the save list, and the meta infos are loaded in handleTickle().
+	typedef Common::HashMap<int, SaveStateDescriptor> MetaInfoCache;
+	MetaInfoCache _metaInfoCache;
+	Common::Array<uint> _pendingButtons;
+	const SaveStateDescriptor &getMetaInfos(int saveSlot);
 };
 
 #endif // !DISABLE_SAVELOADCHOOSER_GRID
@@ -0,0 +1,147 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decoders/adpcm.h"
+#include "audio/audiostream.h"
+
+#include "common/memstream.h"
+
+class ADPCMStreamTestSuite : public CxxTest::TestSuite
+{
+private:
+	struct TestCase {
+		Audio::ADPCMType type;
+		int channels;
+		uint32 blockAlign;
+		uint32 size;
+		int numSamples;
+		uint32 checksum;
+	};
+
+	static const int kRate = 22050;
+
+	// Creates pseudo-random ADPCM data, with sane values in the block headers.
+	byte *createData(const TestCase &test) {
+		byte *data = (byte *)malloc(test.size);
+		uint32 seed = 12345;
+		for (uint32 i = 0; i < test.size; i++) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = (seed >> 16) & 0xFF;
+		}
+
+		for (uint32 block = 0; block < test.size; block += test.blockAlign) {
+			if (test.type == Audio::kADPCMMSIma) {
+				for (int i = 0; i < test.channels && block + i * 4 + 3 < test.size; i++)
+					WRITE_LE_UINT16(data + block + i * 4 + 2, data[block + i * 4 + 2] % 89);
+			} else if (test.type == Audio::kADPCMDK3 && block + 15 < test.size) {
+				WRITE_LE_UINT16(data + block + 2, kRate);
+				data[block + 14] %= 89;
+				data[block + 15] %= 89;
+			}
+
+			if (!test.blockAlign)
+				break;
+		}
+
+		return data;
+	}
+
+	// Decodes the whole stream in chunks of the given size, and returns
+	// a checksum of the samples (FNV-1a).
+	uint32 decode(const TestCase &test, int chunkSize, int &numSamples) {
+		byte *data = createData(test);
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream(data, test.size, DisposeAfterUse::YES);
+		Audio::RewindableAudioStream *s = Audio::makeADPCMStream(stream, DisposeAfterUse::YES, test.size, test.type, kRate, test.channels, test.blockAlign);
+
+		int16 *buffer = new int16[chunkSize];
+		uint32 checksum = 2166136261u;
+		numSamples = 0;
+
+		while (!s->endOfData()) {
+			const int samples = s->readBuffer(buffer, chunkSize);
+			if (samples <= 0)
+				break;
+
+			for (int i = 0; i < samples; i++) {
+				checksum = (checksum ^ (uint16)buffer[i]) * 16777619u;
+			}
+			numSamples += samples;
+		}
+
+		delete[] buffer;
+		delete s;
+		return checksum;
+	}
+
+	void checkDecoding(const TestCase &test) {
+		const int chunkSizes[] = { 4, 16, 1024 };
+
+		for (int i = 0; i < ARRAYSIZE(chunkSizes); i++) {
+			int numSamples;
+			const uint32 checksum = decode(test, chunkSizes[i], numSamples);
+
+			TS_ASSERT_EQUALS(numSamples, test.numSamples);
+			TS_ASSERT_EQUALS(checksum, test.checksum);
+		}
+	}
+
+public:
+	void test_oki() {
+		const TestCase test = { Audio::kADPCMOki, 1, 0, 1001, 2002, 708559453u };
+		checkDecoding(test);
+	}
+
+	void test_dvi() {
+		const TestCase mono = { Audio::kADPCMDVI, 1, 0, 1000, 2000, 2913797831u };
+		checkDecoding(mono);
+		const TestCase stereo = { Audio::kADPCMDVI, 2, 0, 1000, 2000, 1521521689u };
+		checkDecoding(stereo);
+	}
+
+	void test_ms_ima() {
+		const TestCase mono = { Audio::kADPCMMSIma, 1, 256, 256 * 4 + 37, 2088, 2269959262u };
+		checkDecoding(mono);
+		const TestCase stereo = { Audio::kADPCMMSIma, 2, 512, 512 * 3 + 37, 3088, 3319482254u };
+		checkDecoding(stereo);
+	}
+
+	void test_ms() {
+		const TestCase mono = { Audio::kADPCMMS, 1, 256, 256 * 4 + 37, 2062, 1205694991u };
+		checkDecoding(mono);
+	}
+
+	void test_ms_stereo_header() {
+		// The header holds the first two samples of both channels
+		const byte data[] = {
+			0, 0,                   // predictor
+			0x10, 0x00, 0x10, 0x00, // delta
+			0x01, 0x01, 0x02, 0x02, // sample1
+			0x03, 0x03, 0x04, 0x04, // sample2
+			0x00, 0x00
+		};
+
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream(data, sizeof(data));
+		Audio::RewindableAudioStream *s = Audio::makeADPCMStream(stream, DisposeAfterUse::YES, sizeof(data), Audio::kADPCMMS, kRate, 2, sizeof(data));
+
+		int16 buffer[8];
+		TS_ASSERT_EQUALS(s->readBuffer(buffer, 8), 8);
+		TS_ASSERT_EQUALS(buffer[0], 0x0303);
+		TS_ASSERT_EQUALS(buffer[1], 0x0404);
+		TS_ASSERT_EQUALS(buffer[2], 0x0101);
+		TS_ASSERT_EQUALS(buffer[3], 0x0202);
+		TS_ASSERT(s->endOfData());
+
+		delete s;
+	}
+
+	void test_apple() {
+		const TestCase mono = { Audio::kADPCMApple, 1, 34, 34 * 10, 640, 3704641989u };
+		checkDecoding(mono);
+		const TestCase stereo = { Audio::kADPCMApple, 2, 34, 34 * 10, 640, 3133097809u };
+		checkDecoding(stereo);
+	}
+
+	void test_dk3() {
+		const TestCase test = { Audio::kADPCMDK3, 2, 256, 256 * 4 + 100, 2784, 1032457669u };
+		checkDecoding(test);
+	}
+};
@@ -0,0 +1,140 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiocache.h"
+#include "audio/decoders/raw.h"
+#include "audio/audiostream.h"
+
+#include "helper.h"
+
+class DecodedAudioCacheTestSuite : public CxxTest::TestSuite
+{
+private:
+	// Creates a one second 16 bit stream, which is (1 + isStereo) * 22050 bytes large.
+	Audio::SeekableAudioStream *createStream(const bool isStereo, int16 **sine) {
+		return createSineStream<int16>(11025, 1, sine, false, isStereo);
+	}
+
+	void checkStream(Audio::SeekableAudioStream *s, const int16 *sine, const bool isStereo) {
+		TS_ASSERT(s != 0);
+		if (!s)
+			return;
+
+		const int totalSamples = 11025 * (isStereo ? 2 : 1);
+		int16 *buffer = new int16[totalSamples];
+
+		TS_ASSERT_EQUALS(s->getRate(), 11025);
+		TS_ASSERT_EQUALS(s->isStereo(), isStereo);
+		TS_ASSERT_EQUALS(s->readBuffer(buffer, totalSamples), totalSamples);
+		TS_ASSERT_EQUALS(memcmp(sine, buffer, sizeof(int16) * totalSamples), 0);
+		TS_ASSERT_EQUALS(s->endOfData(), true);
+
+		delete[] buffer;
+		delete s;
+	}
+
+	// Plays the stream to the end, and deletes it
+	void play(Audio::SeekableAudioStream *s) {
+		int16 buffer[1000];
+		while (s->readBuffer(buffer, ARRAYSIZE(buffer)) > 0)
+			;
+		delete s;
+	}
+
+public:
+	void test_hit_and_miss() {
+		Audio::DecodedAudioCache cache(1024 * 1024, 64 * 1024);
+		int16 *sine;
+
+		TS_ASSERT(cache.createStream("sound") == 0);
+		TS_ASSERT_EQUALS(cache.getMisses(), 1u);
+
+		// The sound is recorded while it is played for the first time
+		Audio::SeekableAudioStream *s = createStream(true, &sine);
+		Audio::SeekableAudioStream *recording = cache.cacheStream("sound", s);
+		TS_ASSERT_DIFFERS(recording, s);
+		checkStream(recording, sine, true);
+
+		// Every cached stream plays the whole sound on its own
+		Audio::SeekableAudioStream *first = cache.createStream("sound");
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), 11025u * 4);
+		checkStream(cache.createStream("sound"), sine, true);
+		checkStream(first, sine, true);
+		TS_ASSERT_EQUALS(cache.getHits(), 2u);
+		TS_ASSERT_EQUALS(cache.getMisses(), 1u);
+
+		cache.clear();
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), 0u);
+		TS_ASSERT(cache.createStream("sound") == 0);
+
+		delete[] sine;
+	}
+
+	void test_incomplete_playback() {
+		Audio::DecodedAudioCache cache(1024 * 1024, 64 * 1024);
+		int16 *sine;
+		int16 buffer[100];
+
+		// Sounds which are stopped early are not cached
+		Audio::SeekableAudioStream *s = cache.cacheStream("sound", createStream(false, &sine));
+		TS_ASSERT_EQUALS(s->readBuffer(buffer, ARRAYSIZE(buffer)), (int)ARRAYSIZE(buffer));
+		delete s;
+		TS_ASSERT(cache.createStream("sound") == 0);
+		delete[] sine;
+
+		// Neither are sounds which have been seeked
+		s = cache.cacheStream("sound", createStream(false, &sine));
+		TS_ASSERT_EQUALS(s->readBuffer(buffer, ARRAYSIZE(buffer)), (int)ARRAYSIZE(buffer));
+		TS_ASSERT(s->rewind());
+		checkStream(s, sine, false);
+		TS_ASSERT(cache.createStream("sound") == 0);
+		delete[] sine;
+
+		// The stream may outlive the cache
+		Audio::DecodedAudioCache *shortLived = new Audio::DecodedAudioCache(1024 * 1024, 64 * 1024);
+		s = shortLived->cacheStream("sound", createStream(false, &sine));
+		delete shortLived;
+		checkStream(s, sine, false);
+		delete[] sine;
+	}
+
+	void test_too_large() {
+		Audio::DecodedAudioCache cache(1024 * 1024, 11025 * 4 - 1);
+		int16 *sine;
+
+		// The stream is too large to be cached, so it is passed through
+		Audio::SeekableAudioStream *s = createStream(true, &sine);
+		TS_ASSERT_EQUALS(cache.cacheStream("sound", s), s);
+		checkStream(s, sine, true);
+
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), 0u);
+		TS_ASSERT(cache.createStream("sound") == 0);
+
+		delete[] sine;
+	}
+
+	void test_eviction() {
+		// Room for two mono sounds
+		Audio::DecodedAudioCache cache(11025 * 2 * 2, 11025 * 2);
+		int16 *sine;
+
+		play(cache.cacheStream("a", createStream(false, &sine)));
+		delete[] sine;
+		play(cache.cacheStream("b", createStream(false, &sine)));
+		delete[] sine;
+
+		// Use "a", so that "b" is the least recently used sound
+		delete cache.createStream("a");
+
+		Audio::SeekableAudioStream *s = createStream(false, &sine);
+		checkStream(cache.cacheStream("c", s), sine, false);
+
+		checkStream(cache.createStream("c"), sine, false);
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), 11025u * 2 * 2);
+		Audio::SeekableAudioStream *a = cache.createStream("a");
+		TS_ASSERT(a != 0);
+		delete a;
+		TS_ASSERT(cache.createStream("b") == 0);
+
+		delete[] sine;
+	}
+};
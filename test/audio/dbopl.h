@@ -0,0 +1,114 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/softsynth/opl/dosbox.h"
+
+#ifndef DISABLE_DOSBOX_OPL
+
+class DOSBoxOPLTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kWritesPerChunk = 8,
+		kChunks = 400
+	};
+
+	struct RegisterRange {
+		int first;
+		int last;
+	};
+
+	uint32 _seed;
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 16;
+	}
+
+	// Plays random register writes, interleaved with reads of differently
+	// sized buffers, and returns a checksum of the output (FNV-1a).
+	// Registers 2-4 are left alone, since the timers need the system clock.
+	uint32 render(OPL::Config::OplType type, bool percussion, int &numSamples) {
+		static const RegisterRange ranges[] = {
+			{ 0x20, 0x35 }, { 0x40, 0x55 }, { 0x60, 0x75 }, { 0x80, 0x95 },
+			{ 0xA0, 0xA8 }, { 0xB0, 0xB8 }, { 0xBD, 0xBD }, { 0xC0, 0xC8 },
+			{ 0xE0, 0xF5 }, { 0x08, 0x08 }
+		};
+
+		OPL::DOSBox::OPL opl(type);
+		opl.init(44100);
+
+		const bool opl3 = (type == OPL::Config::kOpl3);
+		const int channels = opl3 ? 2 : 1;
+
+		opl.writeReg(0x01, 0x20);
+		if (opl3)
+			opl.writeReg(0x105, 0x01);
+
+		_seed = 4321;
+		uint32 checksum = 2166136261u;
+		numSamples = 0;
+
+		int16 buffer[700 * 2];
+
+		for (int chunk = 0; chunk < kChunks; chunk++) {
+			for (int i = 0; i < kWritesPerChunk; i++) {
+				const RegisterRange &range = ranges[nextRandom() % ARRAYSIZE(ranges)];
+				int reg = range.first + nextRandom() % (range.last - range.first + 1);
+				int val = nextRandom() & 0xFF;
+
+				// Make attenuation, attack and key on more likely to be audible
+				if (reg >= 0x40 && reg <= 0x55)
+					val &= 0xDF;
+				else if (reg >= 0x60 && reg <= 0x75)
+					val |= 0x80;
+				else if (reg >= 0xB0 && reg <= 0xB8 && (nextRandom() & 3))
+					val |= 0x20;
+				else if (reg == 0xBD && !percussion)
+					val &= 0xC0;
+
+				if (opl3 && (nextRandom() & 1))
+					reg += 0x100;
+
+				opl.writeReg(reg, val);
+			}
+
+			if (opl3 && chunk % 50 == 25)
+				opl.writeReg(0x104, nextRandom() & 0x3F);
+
+			const int frames = 1 + nextRandom() % 700;
+			opl.readBuffer(buffer, frames * channels);
+
+			for (int i = 0; i < frames * channels; i++)
+				checksum = (checksum ^ (uint16)buffer[i]) * 16777619u;
+			numSamples += frames * channels;
+		}
+
+		return checksum;
+	}
+
+	void checkOutput(OPL::Config::OplType type, bool percussion, int expectedSamples, uint32 expectedChecksum) {
+		int numSamples;
+		const uint32 checksum = render(type, percussion, numSamples);
+
+		TS_ASSERT_EQUALS(numSamples, expectedSamples);
+		TS_ASSERT_EQUALS(checksum, expectedChecksum);
+	}
+
+public:
+	// The expected checksums are those of the original per sample
+	// synthesis code, which the block renderer has to match exactly.
+
+	void test_opl2() {
+		checkOutput(OPL::Config::kOpl2, false, 143993, 4235731801u);
+	}
+
+	void test_opl2_percussion() {
+		checkOutput(OPL::Config::kOpl2, true, 143993, 969947394u);
+	}
+
+	void test_opl3() {
+		checkOutput(OPL::Config::kOpl3, true, 268328, 2142048361u);
+	}
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+
+#include "common/system.h"
+
+class MixerTestSuite : public CxxTest::TestSuite {
+	enum {
+		kRate = 22050,
+		kFrames = 64,
+		kLoud = 4000,
+		kQuiet = 100
+	};
+
+	// Just what the mixer needs: mutexes, which do nothing as there is only
+	// one thread, and a clock.
+	class TestSystem : public OSystem {
+	public:
+		const GraphicsMode *getSupportedGraphicsModes() const {
+			static const GraphicsMode noModes[] = { { 0, 0, 0 } };
+			return noModes;
+		}
+		int getDefaultGraphicsMode() const { return 0; }
+		bool setGraphicsMode(int mode) { return false; }
+		int getGraphicsMode() const { return 0; }
+		Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+		Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+		void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+		int16 getHeight() { return 0; }
+		int16 getWidth() { return 0; }
+		PaletteManager *getPaletteManager() { return 0; }
+		void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+		Graphics::Surface *lockScreen() { return 0; }
+		void unlockScreen() {}
+		void fillScreen(uint32 col) {}
+		void updateScreen() {}
+		void setShakePos(int shakeOffset) {}
+		void showOverlay() {}
+		void hideOverlay() {}
+		Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+		void clearOverlay() {}
+		void grabOverlay(void *buf, int pitch) {}
+		void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+		int16 getOverlayHeight() { return 0; }
+		int16 getOverlayWidth() { return 0; }
+		bool showMouse(bool visible) { return false; }
+		void warpMouse(int x, int y) {}
+		void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+		uint32 getMillis(bool skipRecord) { return 1000; }
+		void delayMillis(uint msecs) {}
+		void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+		MutexRef createMutex() { return 0; }
+		void lockMutex(MutexRef mutex) {}
+		void unlockMutex(MutexRef mutex) {}
+		void deleteMutex(MutexRef mutex) {}
+		Audio::Mixer *getMixer() { return 0; }
+		void quit() {}
+		void displayMessageOnOSD(const char *msg) {}
+		void logMessage(LogMessageType::Type type, const char *message) {}
+	};
+
+	// An endless mono stream of a constant level
+	class ConstantStream : public Audio::AudioStream {
+		const int16 _level;
+
+	public:
+		ConstantStream(int16 level) : _level(level) {}
+
+		int readBuffer(int16 *buffer, const int numSamples) {
+			for (int i = 0; i < numSamples; ++i)
+				buffer[i] = _level;
+			return numSamples;
+		}
+
+		bool isStereo() const { return false; }
+		int getRate() const { return kRate; }
+		bool endOfData() const { return false; }
+	};
+
+	TestSystem _system;
+	Audio::MixerImpl *_mixer;
+
+	Audio::SoundHandle play(int16 level) {
+		Audio::SoundHandle handle;
+		Audio::Mixer *mixer = _mixer;
+		mixer->playStream(Audio::Mixer::kPlainSoundType, &handle, new ConstantStream(level));
+		return handle;
+	}
+
+	// Runs a mix pass and returns the left output level
+	int mix() {
+		int16 buffer[kFrames * 2];
+		_mixer->mixCallback((byte *)buffer, sizeof(buffer));
+		return buffer[0];
+	}
+
+public:
+	void setUp() {
+		g_system = &_system;
+		_mixer = new Audio::MixerImpl(&_system, kRate);
+		_mixer->setReady(true);
+	}
+
+	void tearDown() {
+		delete _mixer;
+		g_system = 0;
+	}
+
+	void test_play_after_pause_all() {
+		Audio::SoundHandle loud = play(kLoud);
+		_mixer->pauseAll(true);
+
+		// Only the sounds playing when pauseAll() is called are paused,
+		// even when the mixer has not run in between
+		Audio::SoundHandle quiet = play(kQuiet);
+		const int level = mix();
+		TS_ASSERT_LESS_THAN(0, level);
+		TS_ASSERT_LESS_THAN(level, kQuiet + 1);
+		TS_ASSERT(_mixer->isSoundHandleActive(loud));
+		TS_ASSERT(_mixer->isSoundHandleActive(quiet));
+
+		_mixer->pauseAll(false);
+		TS_ASSERT_LESS_THAN(kLoud, mix());
+	}
+
+	void test_pause_nesting() {
+		Audio::SoundHandle handle = play(kLoud);
+		_mixer->pauseHandle(handle, true);
+		_mixer->pauseAll(true);
+		_mixer->pauseHandle(handle, false);
+		TS_ASSERT_EQUALS(mix(), 0);
+
+		_mixer->pauseAll(false);
+		TS_ASSERT_LESS_THAN(0, mix());
+
+		// Pausing and unpausing again before the next pass cancels out
+		_mixer->pauseHandle(handle, true);
+		_mixer->pauseHandle(handle, false);
+		TS_ASSERT_LESS_THAN(0, mix());
+	}
+
+	void test_command_order() {
+		Audio::SoundHandle handle = play(kLoud);
+
+		// More commands than fit into the queue, with the mixer not running.
+		// They must neither block nor get lost, and the last one wins.
+		for (int i = 0; i < 1000; ++i)
+			_mixer->setChannelVolume(handle, (i & 1) ? Audio::Mixer::kMaxChannelVolume : 0);
+		_mixer->setChannelVolume(handle, 0);
+		TS_ASSERT_EQUALS(_mixer->getChannelVolume(handle), 0);
+		TS_ASSERT_EQUALS(mix(), 0);
+
+		for (int i = 0; i < 300; ++i)
+			_mixer->pauseHandle(handle, true);
+		_mixer->setChannelVolume(handle, Audio::Mixer::kMaxChannelVolume);
+		for (int i = 0; i < 300; ++i)
+			_mixer->pauseHandle(handle, false);
+		TS_ASSERT_LESS_THAN(kLoud / 2, mix());
+	}
+
+	void test_stop_handle() {
+		Audio::SoundHandle handle = play(kLoud);
+		_mixer->setChannelVolume(handle, 0);
+		_mixer->stopHandle(handle);
+		TS_ASSERT(!_mixer->isSoundHandleActive(handle));
+
+		// A new sound in the same slot is not affected by the old commands
+		Audio::SoundHandle other = play(kLoud);
+		TS_ASSERT(!_mixer->isSoundHandleActive(handle));
+		TS_ASSERT(_mixer->isSoundHandleActive(other));
+		TS_ASSERT_LESS_THAN(kLoud / 2, mix());
+
+		// Nor by new ones for the old handle
+		_mixer->setChannelVolume(handle, 0);
+		_mixer->setChannelBalance(handle, -127);
+		TS_ASSERT_EQUALS(_mixer->getChannelVolume(other), Audio::Mixer::kMaxChannelVolume);
+		TS_ASSERT_EQUALS(_mixer->getChannelBalance(other), 0);
+		TS_ASSERT_EQUALS(_mixer->getChannelVolume(handle), 0);
+		TS_ASSERT_LESS_THAN(kLoud / 2, mix());
+	}
+};
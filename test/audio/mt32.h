@@ -0,0 +1,203 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#ifdef USE_MT32EMU
+
+#include "audio/softsynth/mt32/mt32emu.h"
+
+#include "common/array.h"
+#include "common/file.h"
+#include "common/memstream.h"
+
+class MT32TestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kControlROMSize = 65536,
+		kPCMROMSize = 524288,
+		kTimbres = 8,
+		kTimbreData = 0x9000,
+		kFrames = 32000
+	};
+
+	// Runs the jobs backwards, one after the other. If the parallel
+	// renderer depended on the order of its jobs, this would show it just
+	// like threads would, only reproducibly.
+	class ReverseJobRunner : public MT32Emu::RenderJobRunner {
+	public:
+		uint batches;
+
+		ReverseJobRunner() : batches(0) {}
+
+		void runJobs(JobProc proc, void *param, unsigned int numJobs) {
+			++batches;
+			while (numJobs--)
+				proc(param, numJobs);
+		}
+	};
+
+	class QuietReportHandler : public MT32Emu::ReportHandler {
+	public:
+		void printDebug(const char *fmt, va_list list) {}
+	};
+
+	static void writeUint16LE(byte *rom, uint pos, uint16 value) {
+		rom[pos] = value & 0xFF;
+		rom[pos + 1] = value >> 8;
+	}
+
+	// Synth partials only, so that the PCM ROM can be empty
+	static void createTimbre(MT32Emu::TimbreParam &timbre, int num) {
+		memset(&timbre, 0, sizeof(timbre));
+		memcpy(timbre.common.name, "Test      ", 10);
+		timbre.common.partialMute = (num & 1) ? 0x0F : 0x03;
+
+		for (int i = 0; i < 4; ++i) {
+			MT32Emu::TimbreParam::PartialParam &p = timbre.partial[i];
+			p.wg.pitchCoarse = 36 + (i & 1) * 12;
+			p.wg.pitchFine = 50 + i * 3;
+			p.wg.pitchKeyfollow = 11;
+			p.wg.pitchBenderEnabled = 1;
+			p.wg.waveform = (num + i) & 1;
+			p.wg.pulseWidth = 20 + num * 10;
+			p.wg.pulseWidthVeloSensitivity = 7;
+
+			for (int j = 0; j < 5; ++j)
+				p.pitchEnv.level[j] = 50;
+			p.pitchLFO.rate = 40 + num;
+			p.pitchLFO.depth = 10;
+
+			p.tvf.cutoff = 50 + num * 5;
+			p.tvf.resonance = num * 3;
+			p.tvf.keyfollow = 11;
+			p.tvf.biasPoint = 64;
+			p.tvf.biasLevel = 7;
+			p.tvf.envDepth = 60;
+			p.tvf.envVeloSensitivity = 20;
+			for (int j = 0; j < 5; ++j)
+				p.tvf.envTime[j] = 10 + j * 15;
+			for (int j = 0; j < 4; ++j)
+				p.tvf.envLevel[j] = 100 - j * 15;
+
+			p.tva.level = 80;
+			p.tva.veloSensitivity = 50;
+			p.tva.biasPoint1 = 64;
+			p.tva.biasLevel1 = 12;
+			p.tva.biasPoint2 = 64;
+			p.tva.biasLevel2 = 12;
+			for (int j = 0; j < 5; ++j)
+				p.tva.envTime[j] = 5 + j * 10 + num;
+			for (int j = 0; j < 4; ++j)
+				p.tva.envLevel[j] = 100 - j * 10;
+		}
+	}
+
+	// A control ROM which passes for an MT-32 1.07 one. All timbre banks
+	// point to kTimbres made up timbres, and the rhythm keys alternate
+	// between reverb on and off.
+	static byte *createControlROM() {
+		byte *rom = (byte *)calloc(kControlROMSize, 1);
+
+		memcpy(rom + 0x4010, "\000 ver1.07 10 Oct, 87 ", 22);
+
+		// No limits for the timbre parameters
+		memset(rom + 0x51F4, 0xFF, 72);
+
+		for (int i = 0; i < kTimbres; ++i) {
+			MT32Emu::TimbreParam timbre;
+			createTimbre(timbre, i);
+			memcpy(rom + kTimbreData + i * 256, &timbre, sizeof(timbre));
+		}
+
+		for (int i = 0; i < 64; ++i) {
+			const uint16 address = kTimbreData + (i % kTimbres) * 256;
+			writeUint16LE(rom, 0x8000 + i * 2, address);
+			writeUint16LE(rom, 0xC000 + i * 2, address - 0x4000);
+			if (i < 30)
+				writeUint16LE(rom, 0x3200 + i * 2, address);
+		}
+
+		for (int i = 0; i < 85; ++i) {
+			byte *rhythm = rom + 0x73FE + i * 4;
+			rhythm[0] = 64 + i % 6;
+			rhythm[1] = 80;
+			rhythm[2] = i % 15;
+			rhythm[3] = i & 1;
+		}
+
+		static const byte reserve[9] = { 4, 4, 4, 4, 4, 4, 2, 2, 4 };
+		memcpy(rom + 0x57B1, reserve, 9);
+		for (int i = 0; i < 9; ++i)
+			rom[0x57CC + i] = (i * 3) % 15;
+		for (int i = 0; i < 8; ++i)
+			rom[0x57BA + i] = i * 16;
+
+		return rom;
+	}
+
+	// Plays overlapping chords on all parts, plus drums, and renders them
+	// in chunks of varying size.
+	bool render(MT32Emu::RenderJobRunner *runner, Common::Array<int16> &output) {
+		Common::File controlFile, pcmFile;
+		controlFile.open(new Common::MemoryReadStream(createControlROM(), kControlROMSize, DisposeAfterUse::YES), "MT32_CONTROL.ROM");
+		pcmFile.open(new Common::MemoryReadStream((byte *)calloc(kPCMROMSize, 1), kPCMROMSize, DisposeAfterUse::YES), "MT32_PCM.ROM");
+
+		const MT32Emu::ROMImage *controlROM = MT32Emu::ROMImage::makeROMImage(&controlFile);
+		const MT32Emu::ROMImage *pcmROM = MT32Emu::ROMImage::makeROMImage(&pcmFile);
+
+		QuietReportHandler reportHandler;
+		MT32Emu::Synth *synth = new MT32Emu::Synth(&reportHandler);
+		const bool opened = synth->open(*controlROM, *pcmROM);
+
+		if (opened) {
+			synth->setRenderJobRunner(runner);
+
+			output.resize(kFrames * 2);
+			uint32 frame = 0;
+			for (int step = 0; frame < kFrames; ++step) {
+				for (int part = 0; part < 8; ++part) {
+					if ((step + part) % 3 == 0)
+						synth->playMsg((0x91 + part) | ((48 + (step * 5 + part * 7) % 24) << 8) | ((64 + part * 8) << 16));
+					if ((step + part) % 3 == 2)
+						synth->playMsg((0xB1 + part) | (123 << 8));
+				}
+				synth->playMsg(0x99 | ((35 + step % 12) << 8) | (100 << 16));
+
+				const uint32 frames = MIN<uint32>(kFrames - frame, 300 + (step % 5) * 200);
+				synth->render(&output[frame * 2], frames);
+				frame += frames;
+			}
+
+			synth->close();
+		}
+
+		delete synth;
+		MT32Emu::ROMImage::freeROMImage(controlROM);
+		MT32Emu::ROMImage::freeROMImage(pcmROM);
+		return opened;
+	}
+
+public:
+	void test_parallel_render_matches_serial() {
+		Common::Array<int16> serial, parallel;
+		TS_ASSERT(render(0, serial));
+
+		ReverseJobRunner runner;
+		TS_ASSERT(render(&runner, parallel));
+		TS_ASSERT_LESS_THAN(0u, runner.batches);
+
+		uint loud = 0;
+		for (uint i = 0; i < serial.size(); ++i) {
+			if (ABS(serial[i]) > 1000)
+				++loud;
+		}
+		TS_ASSERT_LESS_THAN((uint)kFrames / 2, loud);
+
+		TS_ASSERT_EQUALS(serial.size(), parallel.size());
+		if (serial.size() == parallel.size())
+			TS_ASSERT_SAME_DATA(serial.begin(), parallel.begin(), serial.size() * sizeof(int16));
+	}
+};
+
+#endif
@@ -0,0 +1,254 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixer.h"
+#include "audio/rate.h"
+#include "audio/audiostream.h"
+
+#include "audio/decoders/raw.h"
+
+#include "common/memstream.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite {
+	enum {
+		kFrames = 1003
+	};
+
+	// Fill the output buffer with values which make the mixing saturate
+	static void fillOutput(int16 *out, int samples) {
+		for (int i = 0; i < samples; ++i)
+			out[i] = (int16)((i * 7919) % 65536 - 32768);
+	}
+
+	// Create a stream with samples covering the whole 16 bit range
+	static Audio::AudioStream *createStream(int rate, bool isStereo, int16 **samples) {
+		const int numSamples = 4 * kFrames * (isStereo ? 2 : 1);
+		byte *data = (byte *)malloc(numSamples * 2);
+
+		if (samples)
+			*samples = new int16[numSamples];
+
+		for (int i = 0; i < numSamples; ++i) {
+			const int16 sample = (int16)((i * 12345 + 4321) % 65536 - 32768);
+			WRITE_LE_UINT16(data + i * 2, sample);
+			if (samples)
+				(*samples)[i] = sample;
+		}
+
+		return Audio::makeRawStream(new Common::MemoryReadStream(data, numSamples * 2, DisposeAfterUse::YES), rate,
+		                            Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (isStereo ? Audio::FLAG_STEREO : 0));
+	}
+
+	void checkCopyConverter(bool isStereo, bool reverseStereo, Audio::st_volume_t volL, Audio::st_volume_t volR) {
+		const int rate = 22050;
+		int16 *samples;
+		Audio::AudioStream *s = createStream(rate, isStereo, &samples);
+		Audio::RateConverter *converter = Audio::makeRateConverter(rate, rate, isStereo, reverseStereo);
+
+		int16 *out = new int16[kFrames * 2];
+		int16 *expected = new int16[kFrames * 2];
+		fillOutput(out, kFrames * 2);
+		fillOutput(expected, kFrames * 2);
+
+		for (int i = 0; i < kFrames; ++i) {
+			const int16 in0 = samples[isStereo ? i * 2 : i];
+			const int16 in1 = isStereo ? samples[i * 2 + 1] : in0;
+			Audio::clampedAdd(expected[i * 2 + (reverseStereo ? 1 : 0)], (in0 * (int)volL) / Audio::Mixer::kMaxMixerVolume);
+			Audio::clampedAdd(expected[i * 2 + (reverseStereo ? 0 : 1)], (in1 * (int)volR) / Audio::Mixer::kMaxMixerVolume);
+		}
+
+		TS_ASSERT_EQUALS(converter->flow(*s, out, kFrames, volL, volR), kFrames);
+		for (int i = 0; i < kFrames * 2; ++i)
+			TS_ASSERT_EQUALS(out[i], expected[i]);
+
+		delete[] expected;
+		delete[] out;
+		delete converter;
+		delete s;
+		delete[] samples;
+	}
+
+	void checkLinearConverter(bool isStereo) {
+		const int inRate = 22050, outRate = 44100;
+		const Audio::st_volume_t volL = 200, volR = 77;
+
+		// First get the plain interpolated samples, by mixing at full volume
+		// into silence, ...
+		Audio::AudioStream *s = createStream(inRate, isStereo, 0);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, isStereo);
+		int16 *plain = new int16[kFrames * 2];
+		memset(plain, 0, kFrames * 2 * sizeof(int16));
+		TS_ASSERT_EQUALS(converter->flow(*s, plain, kFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), kFrames);
+		delete converter;
+		delete s;
+
+		// ... then check that they are scaled and mixed correctly
+		s = createStream(inRate, isStereo, 0);
+		converter = Audio::makeRateConverter(inRate, outRate, isStereo);
+		int16 *out = new int16[kFrames * 2];
+		fillOutput(out, kFrames * 2);
+		TS_ASSERT_EQUALS(converter->flow(*s, out, kFrames, volL, volR), kFrames);
+
+		int16 *expected = new int16[kFrames * 2];
+		fillOutput(expected, kFrames * 2);
+		for (int i = 0; i < kFrames; ++i) {
+			Audio::clampedAdd(expected[i * 2 + 0], (plain[i * 2 + 0] * (int)volL) / Audio::Mixer::kMaxMixerVolume);
+			Audio::clampedAdd(expected[i * 2 + 1], (plain[i * 2 + 1] * (int)volR) / Audio::Mixer::kMaxMixerVolume);
+		}
+
+		for (int i = 0; i < kFrames * 2; ++i)
+			TS_ASSERT_EQUALS(out[i], expected[i]);
+
+		delete[] expected;
+		delete[] out;
+		delete[] plain;
+		delete converter;
+		delete s;
+	}
+
+	void checkSincConverter(Audio::RateConverterQuality quality, int inRate, int outRate) {
+		// A constant signal has to pass through the filter unchanged, once
+		// the filter history has filled up.
+		const int numSamples = 4 * kFrames;
+		byte *data = (byte *)malloc(numSamples * 2);
+		for (int i = 0; i < numSamples; ++i)
+			WRITE_LE_UINT16(data + i * 2, (i & 1) ? -12345 : 23456);
+
+		Audio::AudioStream *s = Audio::makeRawStream(new Common::MemoryReadStream(data, numSamples * 2, DisposeAfterUse::YES), inRate,
+		                                             Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | Audio::FLAG_STEREO);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, true, false, quality);
+
+		int16 *out = new int16[kFrames * 2];
+		memset(out, 0, kFrames * 2 * sizeof(int16));
+		TS_ASSERT_EQUALS(converter->flow(*s, out, kFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), kFrames);
+
+		for (int i = kFrames / 2; i < kFrames; ++i) {
+			TS_ASSERT_DELTA(out[i * 2 + 0], 23456, 8);
+			TS_ASSERT_DELTA(out[i * 2 + 1], -12345, 8);
+		}
+
+		delete[] out;
+		delete converter;
+		delete s;
+	}
+
+	// Returns the length of the constant signal in out, in input frames
+	static double measureLength(const int16 *out, int frames, int level, int inRate, int outRate) {
+		double sum = 0;
+		for (int i = 0; i < frames; ++i)
+			sum += out[i * 2];
+		return sum / level * inRate / outRate;
+	}
+
+	void checkSincDrain(Audio::RateConverterQuality quality, int inRate, int outRate) {
+		// All of the input has to come out of the filter once it is drained,
+		// instead of stopping short by the filter delay.
+		const int numFrames = 2 * kFrames, level = 20000;
+		byte *data = (byte *)malloc(numFrames * 2);
+		for (int i = 0; i < numFrames; ++i)
+			WRITE_LE_UINT16(data + i * 2, level);
+
+		Audio::AudioStream *s = Audio::makeRawStream(new Common::MemoryReadStream(data, numFrames * 2, DisposeAfterUse::YES), inRate,
+		                                             Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, false, false, quality);
+
+		const int bufferFrames = numFrames * outRate / inRate + 1000;
+		int16 *out = new int16[bufferFrames * 2];
+		memset(out, 0, bufferFrames * 2 * sizeof(int16));
+
+		const int chunk = 100;
+		int frames = 0, res;
+		do {
+			res = converter->flow(*s, out + frames * 2, chunk, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+			frames += res;
+		} while (res == chunk);
+		TS_ASSERT(s->endOfStream());
+		TS_ASSERT_LESS_THAN(measureLength(out, frames, level, inRate, outRate), numFrames - 4);
+
+		do {
+			res = converter->drain(out + frames * 2, chunk, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+			frames += res;
+		} while (res == chunk && frames + chunk <= bufferFrames);
+		TS_ASSERT_LESS_THAN(res, chunk);
+		TS_ASSERT_DELTA(measureLength(out, frames, level, inRate, outRate), numFrames, 1.0);
+
+		TS_ASSERT_EQUALS(converter->drain(out, chunk, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 0);
+
+		delete[] out;
+		delete converter;
+		delete s;
+	}
+
+	// Run a converter over a stream, mixing into a pattern which saturates
+	static void runConverter(Audio::RateConverterQuality quality, int inRate, int outRate, bool isStereo, bool reverseStereo, int16 *out) {
+		Audio::AudioStream *s = createStream(inRate, isStereo, 0);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, isStereo, reverseStereo, quality);
+		fillOutput(out, kFrames * 2);
+		converter->flow(*s, out, kFrames, 255, 13);
+		delete converter;
+		delete s;
+	}
+
+	// The SIMD code has to produce exactly what the plain code does
+	void checkPlainCode(Audio::RateConverterQuality quality, int inRate, int outRate, bool isStereo, bool reverseStereo) {
+		int16 *simd = new int16[kFrames * 2];
+		int16 *plain = new int16[kFrames * 2];
+
+		runConverter(quality, inRate, outRate, isStereo, reverseStereo, simd);
+		Audio::setRateConverterSIMD(false);
+		runConverter(quality, inRate, outRate, isStereo, reverseStereo, plain);
+		Audio::setRateConverterSIMD(true);
+
+		TS_ASSERT(!memcmp(simd, plain, kFrames * 2 * sizeof(int16)));
+
+		delete[] simd;
+		delete[] plain;
+	}
+
+public:
+	void test_sinc() {
+		checkSincConverter(Audio::kRateConverterSincMedium, 22050, 44100);
+		checkSincConverter(Audio::kRateConverterSincMedium, 11025, 48000);
+		checkSincConverter(Audio::kRateConverterSincHigh, 22050, 44100);
+		checkSincConverter(Audio::kRateConverterSincHigh, 44100, 22050);
+	}
+
+	void test_sinc_drain() {
+		checkSincDrain(Audio::kRateConverterSincMedium, 22050, 44100);
+		checkSincDrain(Audio::kRateConverterSincHigh, 11025, 48000);
+		checkSincDrain(Audio::kRateConverterSincHigh, 44100, 22050);
+	}
+
+	void test_copy_mono() {
+		checkCopyConverter(false, false, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		checkCopyConverter(false, false, 255, 13);
+		checkCopyConverter(false, false, 0, 128);
+	}
+
+	void test_copy_stereo() {
+		checkCopyConverter(true, false, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		checkCopyConverter(true, false, 255, 13);
+		checkCopyConverter(true, false, 0, 128);
+	}
+
+	void test_copy_reverse_stereo() {
+		checkCopyConverter(true, true, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		checkCopyConverter(true, true, 255, 13);
+		checkCopyConverter(true, true, 0, 128);
+	}
+
+	void test_linear_mono() {
+		checkLinearConverter(false);
+	}
+
+	void test_linear_stereo() {
+		checkLinearConverter(true);
+	}
+
+	void test_plain_code() {
+		checkPlainCode(Audio::kRateConverterLinear, 22050, 22050, false, false);
+		checkPlainCode(Audio::kRateConverterLinear, 22050, 22050, true, true);
+		checkPlainCode(Audio::kRateConverterLinear, 22050, 48000, true, false);
+		checkPlainCode(Audio::kRateConverterSincMedium, 22050, 44100, false, false);
+		checkPlainCode(Audio::kRateConverterSincHigh, 44100, 48000, true, true);
+	}
+};
@@ -0,0 +1,155 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/str-array.h"
+
+// An archive with a fixed list of members, all of which contain just the
+// archive's id. It counts how often it has been probed and listed.
+class TestArchive : public Common::Archive {
+	Common::StringArray _members;
+	byte _id;
+
+public:
+	mutable int probes;
+	mutable int listings;
+
+	TestArchive(byte id, const char *member1, const char *member2 = 0) : _id(id), probes(0), listings(0) {
+		_members.push_back(member1);
+		if (member2)
+			_members.push_back(member2);
+	}
+
+	virtual bool hasFile(const Common::String &name) const {
+		++probes;
+		for (uint i = 0; i < _members.size(); ++i) {
+			if (_members[i].equalsIgnoreCase(name))
+				return true;
+		}
+		return false;
+	}
+
+	virtual int listMembers(Common::ArchiveMemberList &list) const {
+		++listings;
+		for (uint i = 0; i < _members.size(); ++i)
+			list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_members[i], this)));
+		return _members.size();
+	}
+
+	virtual const Common::ArchiveMemberPtr getMember(const Common::String &name) const {
+		return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(name, this));
+	}
+
+	virtual Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const {
+		if (!hasFile(name))
+			return 0;
+		return new Common::MemoryReadStream(&_id, 1);
+	}
+};
+
+class SearchSetTestSuite : public CxxTest::TestSuite {
+	// Returns the id of the archive the member was read from, or 0
+	static byte readId(const Common::Archive &archive, const char *name) {
+		Common::SeekableReadStream *stream = archive.createReadStreamForMember(name);
+		if (!stream)
+			return 0;
+		const byte id = stream->readByte();
+		delete stream;
+		return id;
+	}
+
+public:
+	void test_lookup() {
+		Common::SearchSet set;
+		TestArchive *first = new TestArchive(1, "one.dat");
+		TestArchive *second = new TestArchive(2, "two.dat", "Both.dat");
+		set.add("first", first);
+		set.add("second", second);
+
+		TS_ASSERT(set.hasFile("one.dat"));
+		TS_ASSERT(set.hasFile("TWO.DAT"));
+		TS_ASSERT(!set.hasFile("three.dat"));
+		TS_ASSERT(!set.hasFile(""));
+		TS_ASSERT_EQUALS(readId(set, "Two.Dat"), 2);
+		TS_ASSERT_EQUALS(readId(set, "three.dat"), 0);
+
+		// Once found, a member is looked up in its archive right away, no
+		// matter how its name is spelled
+		TS_ASSERT(set.hasFile("both.dat"));
+		first->probes = second->probes = 0;
+		TS_ASSERT(set.hasFile("BOTH.DAT"));
+		TS_ASSERT_EQUALS(readId(set, "Both.Dat"), 2);
+		TS_ASSERT_EQUALS(first->probes, 0);
+	}
+
+	void test_priority() {
+		Common::SearchSet set;
+		set.add("low", new TestArchive(1, "file.dat"), 0);
+		set.add("high", new TestArchive(2, "file.dat"), 10);
+		TS_ASSERT_EQUALS(readId(set, "file.dat"), 2);
+
+		set.setPriority("low", 20);
+		TS_ASSERT_EQUALS(readId(set, "file.dat"), 1);
+
+		set.add("higher", new TestArchive(3, "FILE.DAT"), 30);
+		TS_ASSERT_EQUALS(readId(set, "file.dat"), 3);
+
+		set.remove("higher");
+		TS_ASSERT_EQUALS(readId(set, "file.dat"), 1);
+
+		set.clear();
+		TS_ASSERT(!set.hasFile("file.dat"));
+	}
+
+	void test_nested_invalidation() {
+		Common::SearchSet *child = new Common::SearchSet();
+		child->add("child", new TestArchive(1, "other.dat"));
+
+		Common::SearchSet set;
+		set.add("nested", child, 10);
+		set.add("low", new TestArchive(2, "file.dat"), 0);
+		TS_ASSERT_EQUALS(readId(set, "file.dat"), 2);
+		TS_ASSERT(set.hasFile("file.dat"));
+
+		// The nested set now takes precedence, which the cached lookup in
+		// the outer set must not hide
+		child->add("override", new TestArchive(3, "file.dat"));
+		TS_ASSERT_EQUALS(readId(set, "file.dat"), 3);
+
+		child->remove("override");
+		TS_ASSERT_EQUALS(readId(set, "file.dat"), 2);
+	}
+
+	void test_member_index() {
+		Common::SearchSet set;
+		TestArchive *first = new TestArchive(1, "one.dat");
+		TestArchive *second = new TestArchive(2, "two.dat");
+		set.add("first", first);
+		set.add("second", second);
+
+		// Listed members are found without probing any archive
+		TS_ASSERT(set.hasFile("one.dat"));
+		TS_ASSERT(set.hasFile("TWO.DAT"));
+		TS_ASSERT_EQUALS(first->probes + second->probes, 0);
+		TS_ASSERT_EQUALS(first->listings, 1);
+
+		// Reading the member only opens it in the archive it is in
+		TS_ASSERT_EQUALS(readId(set, "Two.Dat"), 2);
+		TS_ASSERT_EQUALS(first->probes, 0);
+
+		// A missing member is only looked for once
+		TS_ASSERT(!set.hasFile("three.dat"));
+		const int probes = first->probes + second->probes;
+		TS_ASSERT_LESS_THAN(0, probes);
+		TS_ASSERT(!set.hasFile("Three.dat"));
+		TS_ASSERT_EQUALS(readId(set, "three.dat"), 0);
+		TS_ASSERT_EQUALS(first->probes + second->probes, probes);
+
+		// Changing another set leaves the index of this one alone
+		Common::SearchSet other;
+		other.add("other", new TestArchive(3, "three.dat"));
+		TS_ASSERT(!set.hasFile("three.dat"));
+		TS_ASSERT_EQUALS(first->listings, 1);
+		TS_ASSERT_EQUALS(first->probes + second->probes, probes);
+	}
+};
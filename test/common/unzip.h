@@ -0,0 +1,193 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/str.h"
+#include "common/unzip.h"
+
+// A ZIP archive containing "deflated.txt", a deflated member made up of the
+// lines "Line 0\n" to "Line 199\n", and "stored.txt", a stored member
+// containing "0123456789".
+static const byte zipTestData[] = {
+	0x50, 0x4B, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x21, 0x42, 0xD7, 0x2A,
+	0xB2, 0x2C, 0x8F, 0x01, 0x00, 0x00, 0x9A, 0x06, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x64, 0x65,
+	0x66, 0x6C, 0x61, 0x74, 0x65, 0x64, 0x2E, 0x74, 0x78, 0x74, 0x45, 0xD5, 0xBB, 0x51, 0x24, 0x30,
+	0x14, 0x05, 0x51, 0x9F, 0x28, 0x36, 0x04, 0x5D, 0xFD, 0x95, 0xC3, 0xA4, 0xB1, 0xC6, 0x3A, 0xE4,
+	0x6F, 0x52, 0x94, 0xBA, 0xB5, 0xD6, 0xB3, 0x38, 0x35, 0x30, 0xB7, 0xC5, 0xE7, 0xDF, 0xF7, 0xDF,
+	0x3F, 0xE5, 0xEB, 0xF3, 0x7B, 0x72, 0x4F, 0xBD, 0xA7, 0xDD, 0xD3, 0xEF, 0x19, 0xF7, 0xCC, 0x7B,
+	0xD6, 0x3D, 0xFB, 0x9E, 0xC3, 0x8F, 0xCB, 0xE0, 0x04, 0x28, 0x48, 0x81, 0x0A, 0x56, 0xC0, 0x82,
+	0x16, 0xB8, 0xE0, 0x55, 0xBC, 0xEA, 0xE7, 0xC2, 0xAB, 0x78, 0x15, 0xAF, 0xE2, 0x55, 0xBC, 0x8A,
+	0x57, 0xF1, 0x2A, 0x5E, 0xC3, 0x6B, 0x78, 0xCD, 0x5F, 0x14, 0xAF, 0xE1, 0x35, 0xBC, 0x86, 0xD7,
+	0xF0, 0x1A, 0x5E, 0xC3, 0xEB, 0x78, 0x1D, 0xAF, 0xE3, 0x75, 0xFF, 0x72, 0x78, 0x1D, 0xAF, 0xE3,
+	0x75, 0xBC, 0x8E, 0xD7, 0xF1, 0x06, 0xDE, 0xC0, 0x1B, 0x78, 0x03, 0x6F, 0xF8, 0x55, 0xE0, 0x0D,
+	0xBC, 0x81, 0x37, 0xF0, 0x06, 0xDE, 0xC4, 0x9B, 0x78, 0x13, 0x6F, 0xE2, 0x4D, 0xBC, 0xE9, 0x77,
+	0x8B, 0x37, 0xF1, 0x26, 0xDE, 0xC4, 0x5B, 0x78, 0x0B, 0x6F, 0xE1, 0x2D, 0xBC, 0x85, 0xB7, 0xF0,
+	0x96, 0x63, 0xC1, 0x5B, 0x78, 0x0B, 0x6F, 0xE3, 0x6D, 0xBC, 0x8D, 0xB7, 0xF1, 0x36, 0xDE, 0xC6,
+	0xDB, 0x78, 0xDB, 0xF5, 0xE1, 0x6D, 0xBC, 0x83, 0x77, 0xF0, 0x0E, 0xDE, 0xC1, 0x3B, 0x78, 0x07,
+	0xEF, 0xE0, 0x1D, 0xBC, 0xE3, 0x9C, 0xDF, 0x9E, 0x1D, 0x74, 0x71, 0xD1, 0xC5, 0x49, 0x17, 0x37,
+	0x5D, 0x1C, 0x75, 0x71, 0xD5, 0xC5, 0x59, 0x17, 0x77, 0x5D, 0x1C, 0x76, 0x51, 0xFE, 0x9F, 0x8A,
+	0xF2, 0x8B, 0xE5, 0xD5, 0xF2, 0x72, 0x79, 0xBD, 0xBC, 0x60, 0x5E, 0x31, 0x2F, 0x19, 0x9B, 0x89,
+	0xD1, 0xA4, 0xBE, 0x0A, 0x95, 0xED, 0x26, 0x86, 0x13, 0xCB, 0x89, 0xE9, 0xC4, 0x76, 0x62, 0x3C,
+	0xB1, 0x9E, 0x98, 0x4F, 0xEC, 0x27, 0xED, 0x05, 0xAE, 0x6C, 0x42, 0xB1, 0xA1, 0x18, 0x51, 0xAC,
+	0x28, 0x66, 0x14, 0x3B, 0x8A, 0x21, 0xC5, 0x92, 0x62, 0x4A, 0xE9, 0xEF, 0xED, 0x50, 0xB6, 0xA6,
+	0x98, 0x53, 0xEC, 0x29, 0x06, 0x15, 0x8B, 0x8A, 0x49, 0xC5, 0xA6, 0x62, 0x54, 0xB1, 0xAA, 0x8C,
+	0xF7, 0x2C, 0x29, 0x1B, 0x56, 0x2C, 0x2B, 0xA6, 0x15, 0xDB, 0x8A, 0x71, 0xC5, 0xBA, 0x62, 0x5E,
+	0xB1, 0xAF, 0x18, 0x58, 0xE6, 0x7B, 0xF1, 0x94, 0x6D, 0x2C, 0x46, 0x16, 0x2B, 0x8B, 0x99, 0xC5,
+	0xCE, 0x62, 0x68, 0xB1, 0xB4, 0x98, 0x5A, 0x6C, 0x2D, 0xEB, 0x3D, 0xA6, 0xCA, 0xE6, 0x16, 0x7B,
+	0x8B, 0xC1, 0xC5, 0xE2, 0x62, 0x72, 0xB1, 0xB9, 0x18, 0x5D, 0xAC, 0x2E, 0x66, 0x97, 0xFD, 0xDE,
+	0x69, 0x65, 0xCB, 0x8B, 0xE9, 0xC5, 0xF6, 0x62, 0x7C, 0xB1, 0xBE, 0x98, 0x5F, 0xEC, 0x2F, 0x06,
+	0x18, 0x0B, 0xCC, 0x79, 0xFF, 0x02, 0xCE, 0xD7, 0x0F, 0x50, 0x4B, 0x03, 0x04, 0x14, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x42, 0xC6, 0xC7, 0x84, 0xA6, 0x0A, 0x00, 0x00, 0x00, 0x0A,
+	0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x73, 0x74, 0x6F, 0x72, 0x65, 0x64, 0x2E, 0x74, 0x78,
+	0x74, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x50, 0x4B, 0x01, 0x02, 0x14,
+	0x03, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x21, 0x42, 0xD7, 0x2A, 0xB2, 0x2C, 0x8F,
+	0x01, 0x00, 0x00, 0x9A, 0x06, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00, 0x64, 0x65, 0x66, 0x6C, 0x61, 0x74, 0x65,
+	0x64, 0x2E, 0x74, 0x78, 0x74, 0x50, 0x4B, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x21, 0x42, 0xC6, 0xC7, 0x84, 0xA6, 0x0A, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x00,
+	0x00, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0xB9,
+	0x01, 0x00, 0x00, 0x73, 0x74, 0x6F, 0x72, 0x65, 0x64, 0x2E, 0x74, 0x78, 0x74, 0x50, 0x4B, 0x05,
+	0x06, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x02, 0x00, 0x72, 0x00, 0x00, 0x00, 0xEB, 0x01, 0x00,
+	0x00, 0x00, 0x00,
+};
+
+class UnzipTestSuite : public CxxTest::TestSuite {
+	Common::String _deflatedContents;
+
+	Common::Archive *makeArchive() {
+		Common::MemoryReadStream *ms = new Common::MemoryReadStream(zipTestData, sizeof(zipTestData));
+		return Common::makeZipArchive(ms);
+	}
+
+	public:
+	void setUp() {
+		_deflatedContents.clear();
+		for (int i = 0; i < 200; ++i)
+			_deflatedContents += Common::String::format("Line %d\n", i);
+	}
+
+	void test_read_deflated() {
+		Common::Archive *archive = makeArchive();
+		TS_ASSERT(archive != 0);
+
+		Common::SeekableReadStream *s = archive->createReadStreamForMember("deflated.txt");
+		TS_ASSERT(s != 0);
+		TS_ASSERT_EQUALS((uint)s->size(), _deflatedContents.size());
+
+		Common::String contents;
+		while (true) {
+			byte b = s->readByte();
+			if (s->eos())
+				break;
+			contents += (char)b;
+		}
+		TS_ASSERT(!s->err());
+		TS_ASSERT(contents == _deflatedContents);
+
+		delete s;
+		delete archive;
+	}
+
+	void test_seek_deflated() {
+		Common::Archive *archive = makeArchive();
+		Common::SeekableReadStream *s = archive->createReadStreamForMember("deflated.txt");
+
+		TS_ASSERT(s->seek(-9, SEEK_END));
+		TS_ASSERT_EQUALS((uint)s->pos(), _deflatedContents.size() - 9);
+		TS_ASSERT_EQUALS(s->readLine(), "Line 199");
+
+		// Seeking backwards has to work as well
+		TS_ASSERT(s->seek(7, SEEK_SET));
+		TS_ASSERT_EQUALS(s->pos(), 7);
+		TS_ASSERT_EQUALS(s->readLine(), "Line 1");
+
+		TS_ASSERT(s->seek(7, SEEK_CUR));
+		TS_ASSERT_EQUALS(s->readLine(), "Line 3");
+
+		TS_ASSERT(!s->err());
+
+		delete s;
+		delete archive;
+	}
+
+	void test_concurrent_members() {
+		Common::Archive *archive = makeArchive();
+		Common::SeekableReadStream *s1 = archive->createReadStreamForMember("deflated.txt");
+		Common::SeekableReadStream *s2 = archive->createReadStreamForMember("DEFLATED.TXT");
+		Common::SeekableReadStream *s3 = archive->createReadStreamForMember("stored.txt");
+
+		TS_ASSERT(s1 != 0);
+		TS_ASSERT(s2 != 0);
+		TS_ASSERT(s3 != 0);
+
+		TS_ASSERT_EQUALS(s1->readLine(), "Line 0");
+		TS_ASSERT_EQUALS(s3->readByte(), '0');
+		TS_ASSERT_EQUALS(s2->readLine(), "Line 0");
+		TS_ASSERT_EQUALS(s1->readLine(), "Line 1");
+		TS_ASSERT_EQUALS(s3->readByte(), '1');
+		TS_ASSERT_EQUALS(s2->readLine(), "Line 1");
+
+		TS_ASSERT_EQUALS(s3->size(), 10);
+		s3->seek(-1, SEEK_END);
+		TS_ASSERT_EQUALS(s3->readByte(), '9');
+
+		delete s1;
+		delete s2;
+		delete s3;
+		delete archive;
+	}
+
+	void test_members_outlive_archive() {
+		Common::Archive *archive = makeArchive();
+		Common::SeekableReadStream *s1 = archive->createReadStreamForMember("deflated.txt");
+		Common::SeekableReadStream *s2 = archive->createReadStreamForMember("stored.txt");
+		delete archive;
+
+		TS_ASSERT_EQUALS(s1->readLine(), "Line 0");
+		TS_ASSERT(s1->seek(-9, SEEK_END));
+		TS_ASSERT_EQUALS(s1->readLine(), "Line 199");
+		TS_ASSERT_EQUALS(s2->readLine(), "0123456789");
+		TS_ASSERT(!s1->err());
+		TS_ASSERT(!s2->err());
+
+		delete s1;
+		delete s2;
+	}
+
+	void test_missing_member() {
+		Common::Archive *archive = makeArchive();
+		TS_ASSERT(!archive->hasFile("missing.txt"));
+		TS_ASSERT(archive->createReadStreamForMember("missing.txt") == 0);
+		delete archive;
+	}
+
+	void test_stored_crc() {
+		Common::Archive *archive = makeArchive();
+		Common::SeekableReadStream *s = archive->createReadStreamForMember("stored.txt");
+		TS_ASSERT_EQUALS(s->readLine(), "0123456789");
+		TS_ASSERT(!s->err());
+		delete s;
+		delete archive;
+
+		// Change one byte of the stored member
+		byte *data = new byte[sizeof(zipTestData)];
+		memcpy(data, zipTestData, sizeof(zipTestData));
+		for (uint i = 0; i + 10 <= sizeof(zipTestData); ++i) {
+			if (!memcmp(data + i, "0123456789", 10)) {
+				data[i + 5] = 'X';
+				break;
+			}
+		}
+
+		archive = Common::makeZipArchive(new Common::MemoryReadStream(data, sizeof(zipTestData), DisposeAfterUse::YES));
+		s = archive->createReadStreamForMember("stored.txt");
+		char contents[10];
+		TS_ASSERT_EQUALS(s->read(contents, sizeof(contents)), sizeof(contents));
+		TS_ASSERT(!memcmp(contents, "01234X6789", sizeof(contents)));
+#ifdef USE_ZLIB
+		TS_ASSERT(s->err());
+#endif
+		delete s;
+		delete archive;
+	}
+};
@@ -0,0 +1,139 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+
+class ConversionTestSuite : public CxxTest::TestSuite
+{
+private:
+	uint32 _seed;
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return (_seed >> 16) | (_seed << 16);
+	}
+
+	static uint32 readColor(const byte *p, uint bytesPerPixel) {
+		return bytesPerPixel == 2 ? *(const uint16 *)p : *(const uint32 *)p;
+	}
+
+	// Converts random pixels with crossBlit() and checks each of them
+	// against PixelFormat::colorToARGB() and PixelFormat::ARGBToColor().
+	// Returns the number of wrong pixels.
+	int checkCrossBlit(const Graphics::PixelFormat &srcFmt, const Graphics::PixelFormat &dstFmt, uint w, uint h) {
+		const uint srcPitch = (w + 3) * srcFmt.bytesPerPixel;
+		const uint dstPitch = (w + 5) * dstFmt.bytesPerPixel;
+		byte *src = new byte[srcPitch * h];
+		byte *dst = new byte[dstPitch * h];
+
+		_seed = w * 7 + h;
+		for (uint i = 0; i < srcPitch * h; i++)
+			src[i] = nextRandom();
+
+		TS_ASSERT(Graphics::crossBlit(dst, src, dstPitch, srcPitch, w, h, dstFmt, srcFmt));
+
+		int errors = 0;
+		for (uint y = 0; y < h; y++) {
+			for (uint x = 0; x < w; x++) {
+				byte a, r, g, b;
+				srcFmt.colorToARGB(readColor(src + y * srcPitch + x * srcFmt.bytesPerPixel, srcFmt.bytesPerPixel), a, r, g, b);
+				uint32 expected = dstFmt.ARGBToColor(a, r, g, b);
+				if (dstFmt.bytesPerPixel == 2)
+					expected &= 0xFFFF;
+
+				if (readColor(dst + y * dstPitch + x * dstFmt.bytesPerPixel, dstFmt.bytesPerPixel) != expected)
+					errors++;
+			}
+		}
+
+		delete[] src;
+		delete[] dst;
+		return errors;
+	}
+
+	static const Graphics::PixelFormat *formats(uint &count) {
+		static const Graphics::PixelFormat list[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),  // RGB565
+			Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0),  // RGB555
+			Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15), // ARGB1555
+			Graphics::PixelFormat(2, 4, 4, 4, 4, 8, 4, 0, 12),  // ARGB4444
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0),  // XRGB8888
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24), // ARGB8888
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0), // RGBA8888
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24)  // ABGR8888
+		};
+
+		count = ARRAYSIZE(list);
+		return list;
+	}
+
+public:
+	void test_crossblit_format_pairs() {
+		uint count;
+		const Graphics::PixelFormat *list = formats(count);
+
+		for (uint i = 0; i < count; i++) {
+			for (uint j = 0; j < count; j++) {
+				if (i == j)
+					continue;
+
+				// Widths with and without a remainder after the vector
+				// loops
+				TS_ASSERT_EQUALS(checkCrossBlit(list[i], list[j], 64, 3), 0);
+				TS_ASSERT_EQUALS(checkCrossBlit(list[i], list[j], 13, 4), 0);
+				TS_ASSERT_EQUALS(checkCrossBlit(list[i], list[j], 5, 2), 0);
+			}
+		}
+	}
+
+	void test_crossblit_in_place() {
+		// RGB565 to XRGB8888 in place, which needs to run backwards
+		const Graphics::PixelFormat srcFmt(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		const Graphics::PixelFormat dstFmt(4, 8, 8, 8, 0, 16, 8, 0, 0);
+		const uint w = 37, h = 5;
+
+		uint16 src[w * h];
+		uint32 buffer[w * h];
+		_seed = 42;
+		for (uint i = 0; i < w * h; i++)
+			src[i] = nextRandom();
+		memcpy(buffer, src, sizeof(src));
+
+		TS_ASSERT(Graphics::crossBlit((byte *)buffer, (const byte *)buffer, w * 4, w * 2, w, h, dstFmt, srcFmt));
+
+		for (uint i = 0; i < w * h; i++) {
+			byte a, r, g, b;
+			srcFmt.colorToARGB(src[i], a, r, g, b);
+			TS_ASSERT_EQUALS(buffer[i], dstFmt.ARGBToColor(a, r, g, b));
+		}
+	}
+
+	void test_crossblit_map() {
+		uint32 map[256];
+		for (uint i = 0; i < 256; i++)
+			map[i] = i * 0x01010101;
+
+		const uint w = 11, h = 3;
+		byte src[w * h];
+		for (uint i = 0; i < w * h; i++)
+			src[i] = i * 7;
+
+		uint32 dst32[w * h];
+		TS_ASSERT(Graphics::crossBlitMap((byte *)dst32, src, w * 4, w, w, h, 4, map));
+		for (uint i = 0; i < w * h; i++)
+			TS_ASSERT_EQUALS(dst32[i], map[src[i]]);
+
+		uint16 dst16[w * h];
+		TS_ASSERT(Graphics::crossBlitMap((byte *)dst16, src, w * 2, w, w, h, 2, map));
+		for (uint i = 0; i < w * h; i++)
+			TS_ASSERT_EQUALS(dst16[i], (uint16)map[src[i]]);
+
+		// In place
+		byte buffer[w * h * 4];
+		memcpy(buffer, src, sizeof(src));
+		TS_ASSERT(Graphics::crossBlitMap(buffer, buffer, w * 4, w, w, h, 4, map));
+		TS_ASSERT_EQUALS(memcmp(buffer, dst32, sizeof(dst32)), 0);
+
+		TS_ASSERT(!Graphics::crossBlitMap(buffer, src, w * 3, w, w, h, 3, map));
+	}
+};
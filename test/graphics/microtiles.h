@@ -0,0 +1,151 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/microtiles.h"
+
+#include "common/array.h"
+
+class MicroTilesTestSuite : public CxxTest::TestSuite
+{
+private:
+	// The number of pixels covered by the rects, counting overlapping
+	// pixels several times.
+	static int countPixels(const Graphics::RectangleList &rects) {
+		int pixels = 0;
+		for (Graphics::RectangleList::const_iterator i = rects.begin(); i != rects.end(); ++i)
+			pixels += i->width() * i->height();
+		return pixels;
+	}
+
+public:
+	void test_single_rect() {
+		Graphics::MicroTileArray tiles(320, 200);
+		tiles.addRect(Common::Rect(10, 20, 100, 60));
+
+		// The rect is split at the tile row boundary...
+		Graphics::RectangleList *rects = tiles.getRectangles();
+		TS_ASSERT_EQUALS(rects->size(), 2u);
+		TS_ASSERT_EQUALS(rects->front(), Common::Rect(10, 20, 100, 32));
+		TS_ASSERT_EQUALS(rects->back(), Common::Rect(10, 32, 100, 60));
+		delete rects;
+
+		// ...and put back together when merging
+		Graphics::RectangleList merged;
+		tiles.getRectangles(merged, 0, 100);
+		TS_ASSERT_EQUALS(merged.size(), 1u);
+		TS_ASSERT_EQUALS(merged.front(), Common::Rect(10, 20, 100, 60));
+	}
+
+	void test_single_pixel() {
+		// The top left pixel of a tile must not be taken for an empty tile
+		Graphics::MicroTileArray tiles(320, 200);
+		tiles.addRect(Common::Rect(0, 0, 1, 1));
+		tiles.addRect(Common::Rect(32, 32, 33, 33));
+
+		Graphics::RectangleList *rects = tiles.getRectangles();
+		TS_ASSERT_EQUALS(rects->size(), 2u);
+		TS_ASSERT_EQUALS(rects->front(), Common::Rect(0, 0, 1, 1));
+		TS_ASSERT_EQUALS(rects->back(), Common::Rect(32, 32, 33, 33));
+		delete rects;
+	}
+
+	void test_clip_and_clear() {
+		Graphics::MicroTileArray tiles(100, 50);
+		tiles.addRect(Common::Rect(-10, -10, 200, 200));
+
+		Graphics::RectangleList *rects = tiles.getRectangles();
+		TS_ASSERT_EQUALS(countPixels(*rects), 100 * 50);
+		delete rects;
+
+		tiles.clear();
+		rects = tiles.getRectangles();
+		TS_ASSERT(rects->empty());
+		delete rects;
+	}
+
+	void test_merge_cost() {
+		Graphics::MicroTileArray tiles(320, 200);
+		tiles.addRect(Common::Rect(0, 0, 8, 8));
+		tiles.addRect(Common::Rect(0, 100, 8, 108));
+		tiles.addRect(Common::Rect(200, 0, 208, 8));
+
+		// Nothing is cheap enough to merge
+		Graphics::RectangleList rects;
+		tiles.getRectangles(rects, 0, 100);
+		TS_ASSERT_EQUALS(rects.size(), 3u);
+
+		// Merging the first two wastes 92 * 8 pixels, the others more
+		tiles.getRectangles(rects, 92 * 8, 100);
+		TS_ASSERT_EQUALS(rects.size(), 2u);
+		TS_ASSERT_EQUALS(rects.front(), Common::Rect(0, 0, 8, 108));
+
+		// Too many rects get merged regardless of the cost
+		tiles.getRectangles(rects, 0, 1);
+		TS_ASSERT_EQUALS(rects.size(), 1u);
+		TS_ASSERT_EQUALS(rects.front(), Common::Rect(0, 0, 208, 108));
+	}
+
+	void test_adjacent_tiles() {
+		// Changes lining up across tiles come back as a single rect
+		Graphics::MicroTileArray tiles(320, 200);
+		tiles.addRect(Common::Rect(5, 40, 300, 50));
+		tiles.addRect(Common::Rect(5, 100, 40, 110));
+		tiles.addRect(Common::Rect(80, 100, 90, 110));
+
+		Graphics::RectangleList *rects = tiles.getRectangles();
+		TS_ASSERT_EQUALS(rects->size(), 3u);
+		TS_ASSERT_EQUALS(rects->front(), Common::Rect(5, 40, 300, 50));
+		TS_ASSERT_EQUALS(countPixels(*rects), 295 * 10 + 35 * 10 + 10 * 10);
+		delete rects;
+
+		// Within a tile, only the bounding box of the changes is kept
+		tiles.clear();
+		tiles.addRect(Common::Rect(66, 100, 70, 110));
+		tiles.addRect(Common::Rect(80, 100, 90, 110));
+
+		rects = tiles.getRectangles();
+		TS_ASSERT_EQUALS(rects->size(), 1u);
+		TS_ASSERT_EQUALS(rects->front(), Common::Rect(66, 100, 90, 110));
+		delete rects;
+	}
+
+	void test_disjoint() {
+		// Merging two rects into their bounding box may cover others, which
+		// then have to be merged as well
+		Graphics::MicroTileArray tiles(320, 200);
+		Common::Array<Common::Rect> added;
+		uint32 seed = 1;
+		for (int i = 0; i < 40; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const int x = (seed >> 8) % 300;
+			const int y = (seed >> 17) % 180;
+			const Common::Rect r(x, y, x + 1 + (seed >> 4) % 20, y + 1 + (seed >> 12) % 20);
+			tiles.addRect(r);
+			added.push_back(r);
+		}
+
+		static const uint costs[] = { 0, 64, 1024, 100000 };
+		static const uint maxRects[] = { 1, 4, 10, 100 };
+		for (int c = 0; c < ARRAYSIZE(costs); ++c) {
+			for (int m = 0; m < ARRAYSIZE(maxRects); ++m) {
+				Graphics::RectangleList rects;
+				tiles.getRectangles(rects, costs[c], maxRects[m]);
+				TS_ASSERT_LESS_THAN_EQUALS(rects.size(), maxRects[m]);
+
+				for (Graphics::RectangleList::const_iterator i = rects.begin(); i != rects.end(); ++i) {
+					Graphics::RectangleList::const_iterator j = i;
+					for (++j; j != rects.end(); ++j)
+						TS_ASSERT(!i->intersects(*j));
+				}
+
+				for (uint i = 0; i < added.size(); ++i) {
+					int covered = 0;
+					for (Graphics::RectangleList::const_iterator j = rects.begin(); j != rects.end(); ++j) {
+						const Common::Rect overlap = added[i].findIntersectingRect(*j);
+						covered += overlap.width() * overlap.height();
+					}
+					TS_ASSERT_EQUALS(covered, added[i].width() * added[i].height());
+				}
+			}
+		}
+	}
+};
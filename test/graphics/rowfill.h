@@ -0,0 +1,152 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/rowfill.h"
+#include "graphics/pixelformat.h"
+
+class RowFillTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kRowSize = 80
+	};
+
+	uint32 _seed;
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return (_seed >> 16) | (_seed << 16);
+	}
+
+	static int blendChannel(int dst, int src, int alpha) {
+		// dst + (src - dst) * alpha / 256, rounded down
+		const int delta = (src - dst) * alpha;
+		return dst + (delta >= 0 ? delta / 256 : -((255 - delta) / 256));
+	}
+
+	static uint32 referenceBlend(uint32 pixel, uint32 color, int alpha, const Graphics::PixelFormat &fmt) {
+		const int shifts[3] = { fmt.rShift, fmt.gShift, fmt.bShift };
+		const int losses[3] = { fmt.rLoss, fmt.gLoss, fmt.bLoss };
+
+		uint32 result = fmt.aLoss < 8 ? pixel & ((0xFF >> fmt.aLoss) << fmt.aShift) : 0;
+		for (int i = 0; i < 3; i++) {
+			const uint32 mask = 0xFF >> losses[i];
+			result |= blendChannel((pixel >> shifts[i]) & mask, (color >> shifts[i]) & mask, alpha) << shifts[i];
+		}
+
+		return result;
+	}
+
+	// Fills rows of several lengths and at several offsets with random
+	// pixels, runs op on them and compares every pixel with ref. The pixels
+	// around the row must be left alone. Returns the number of wrong pixels.
+	template<typename PixelType, typename Op, typename Ref>
+	int checkRows(Op op, Ref ref) {
+		PixelType row[kRowSize], expected[kRowSize];
+		int errors = 0;
+
+		for (uint offset = 1; offset < 5; offset++) {
+			for (uint count = 0; count < kRowSize - 10; count += 1 + count / 8) {
+				_seed = offset * 101 + count;
+				for (uint i = 0; i < kRowSize; i++)
+					expected[i] = row[i] = (PixelType)nextRandom();
+
+				for (uint i = 0; i < count; i++)
+					expected[offset + i] = ref(i, expected[offset + i]);
+
+				op(row + offset, count);
+
+				for (uint i = 0; i < kRowSize; i++) {
+					if (row[i] != expected[i])
+						errors++;
+				}
+			}
+		}
+
+		return errors;
+	}
+
+	template<typename PixelType>
+	struct FillOp {
+		PixelType color1, color2;
+
+		FillOp(PixelType c1, PixelType c2) : color1(c1), color2(c2) {}
+		void operator()(PixelType *dst, uint count) const { Graphics::fillRow(dst, count, color1, color2); }
+		PixelType operator()(uint i, PixelType) const { return (i & 1) ? color2 : color1; }
+	};
+
+	template<typename PixelType>
+	struct BlendOp {
+		PixelType color;
+		uint8 alpha;
+		const Graphics::PixelFormat &format;
+
+		BlendOp(PixelType c, uint8 a, const Graphics::PixelFormat &f) : color(c), alpha(a), format(f) {}
+		void operator()(PixelType *dst, uint count) const { Graphics::blendRow(dst, count, color, alpha, format); }
+		PixelType operator()(uint, PixelType pixel) const { return (PixelType)referenceBlend(pixel, color, alpha, format); }
+	};
+
+	template<typename PixelType>
+	struct DarkenOp {
+		PixelType mask, orBits, addBits;
+		int shift;
+
+		DarkenOp(PixelType m, int s, PixelType o, PixelType a) : mask(m), orBits(o), addBits(a), shift(s) {}
+		void operator()(PixelType *dst, uint count) const { Graphics::darkenRow(dst, count, mask, shift, orBits, addBits); }
+		PixelType operator()(uint, PixelType pixel) const { return (PixelType)((((pixel & mask) >> shift) | orBits) + addBits); }
+	};
+
+	template<typename PixelType>
+	int checkFill(PixelType color1, PixelType color2) {
+		const FillOp<PixelType> op(color1, color2);
+		return checkRows<PixelType>(op, op);
+	}
+
+	template<typename PixelType>
+	int checkBlend(const Graphics::PixelFormat &format) {
+		static const uint8 alphas[] = { 0, 1, 64, 127, 128, 200, 255 };
+		int errors = 0;
+
+		for (uint i = 0; i < ARRAYSIZE(alphas); i++) {
+			const BlendOp<PixelType> op((PixelType)(0x9A3F71C5 * (i + 1)), alphas[i], format);
+			errors += checkRows<PixelType>(op, op);
+		}
+
+		return errors;
+	}
+
+	template<typename PixelType>
+	int checkDarken(PixelType mask, int shift, PixelType orBits, PixelType addBits) {
+		const DarkenOp<PixelType> op(mask, shift, orBits, addBits);
+		return checkRows<PixelType>(op, op);
+	}
+
+public:
+	void test_fill_row() {
+		TS_ASSERT_EQUALS(checkFill<uint16>(0x1234, 0x1234), 0);
+		TS_ASSERT_EQUALS(checkFill<uint16>(0xF800, 0x07E0), 0);
+		TS_ASSERT_EQUALS(checkFill<uint32>(0xFF102030, 0xFF102030), 0);
+		TS_ASSERT_EQUALS(checkFill<uint32>(0x80FF0000, 0x0000FFFF), 0);
+	}
+
+	void test_blend_row_16bit() {
+		TS_ASSERT_EQUALS(checkBlend<uint16>(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0)), 0);  // RGB565
+		TS_ASSERT_EQUALS(checkBlend<uint16>(Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0)), 0);  // RGB555
+		TS_ASSERT_EQUALS(checkBlend<uint16>(Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15)), 0); // ARGB1555
+		TS_ASSERT_EQUALS(checkBlend<uint16>(Graphics::PixelFormat(2, 4, 4, 4, 4, 8, 4, 0, 12)), 0);  // ARGB4444
+	}
+
+	void test_blend_row_32bit() {
+		TS_ASSERT_EQUALS(checkBlend<uint32>(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0)), 0);  // XRGB8888
+		TS_ASSERT_EQUALS(checkBlend<uint32>(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24)), 0); // ARGB8888
+		TS_ASSERT_EQUALS(checkBlend<uint32>(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0)), 0); // RGBA8888
+	}
+
+	void test_darken_row() {
+		// Halving RGB565, and darkening ARGB8888 while raising its alpha, the
+		// way the vector renderer does it
+		TS_ASSERT_EQUALS(checkDarken<uint16>(0xF7DE, 1, 0, 0), 0);
+		TS_ASSERT_EQUALS(checkDarken<uint16>(0x7BDE, 1, 0x8000, 0), 0);
+		TS_ASSERT_EQUALS(checkDarken<uint32>(0xFCFCFCFC, 2, 0, 0xC0000000), 0);
+		TS_ASSERT_EQUALS(checkDarken<uint32>(0x00FEFEFE, 1, 0xFF000000, 0), 0);
+	}
+};
@@ -0,0 +1,81 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler.h"
+
+#ifdef USE_SCALERS
+
+class ScalerTestSuite : public CxxTest::TestSuite
+{
+private:
+	uint32 _seed;
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 16;
+	}
+
+	// Scales a picture of blocks in a few similar colors with some noise,
+	// which covers all kinds of edges, and returns a checksum of the output
+	// (FNV-1a). The source has a border, as the scalers read one pixel
+	// beyond each edge.
+	uint32 scale(ScalerProc *proc, int factor, uint32 bitFormat, int width, int height) {
+		static const uint16 colors[8] = {
+			0x0000, 0xFFFF, 0x8410, 0x8430, 0xF800, 0xF820, 0x001F, 0x07E0
+		};
+
+		InitScalers(bitFormat);
+
+		const int srcPitch = width + 2;
+		uint16 *src = new uint16[srcPitch * (height + 2)];
+		_seed = 1234;
+		for (int y = 0; y < height + 2; y++) {
+			for (int x = 0; x < srcPitch; x++) {
+				uint16 color = colors[((x / 3) ^ (y / 2) ^ (nextRandom() % 3 == 0 ? nextRandom() : 0)) & 7];
+				if (bitFormat == 555)
+					color &= 0x7FFF;
+				src[y * srcPitch + x] = color;
+			}
+		}
+
+		const int dstPitch = width * factor;
+		uint16 *dst = new uint16[dstPitch * height * factor];
+		proc((const uint8 *)(src + srcPitch + 1), srcPitch * 2, (uint8 *)dst, dstPitch * 2, width, height);
+
+		uint32 checksum = 2166136261u;
+		for (int i = 0; i < dstPitch * height * factor; i++)
+			checksum = (checksum ^ dst[i]) * 16777619u;
+
+		delete[] src;
+		delete[] dst;
+		DestroyScalers();
+		return checksum;
+	}
+
+public:
+	// The expected checksums are those of the plain C scalers, which the
+	// vectorized ones have to match exactly.
+
+	void test_advmame2x() {
+		TS_ASSERT_EQUALS(scale(AdvMame2x, 2, 565, 37, 23), 4163052497u);
+		TS_ASSERT_EQUALS(scale(AdvMame2x, 2, 565, 64, 16), 3471581010u);
+	}
+
+	void test_advmame3x() {
+		TS_ASSERT_EQUALS(scale(AdvMame3x, 3, 565, 37, 23), 2775077754u);
+		TS_ASSERT_EQUALS(scale(AdvMame3x, 3, 565, 64, 16), 3518006233u);
+	}
+
+#ifdef USE_HQ_SCALERS
+	void test_hq2x() {
+		TS_ASSERT_EQUALS(scale(HQ2x, 2, 565, 37, 23), 675903357u);
+		TS_ASSERT_EQUALS(scale(HQ2x, 2, 555, 64, 16), 261625602u);
+	}
+
+	void test_hq3x() {
+		TS_ASSERT_EQUALS(scale(HQ3x, 3, 565, 37, 23), 2215995489u);
+		TS_ASSERT_EQUALS(scale(HQ3x, 3, 555, 64, 16), 1074116737u);
+	}
+#endif
+};
+
+#endif
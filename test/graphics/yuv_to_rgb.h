@@ -0,0 +1,107 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite
+{
+private:
+	uint32 _seed;
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return (_seed >> 16) | (_seed << 16);
+	}
+
+	static int clampChannel(int value, Graphics::YUVToRGBManager::LuminanceScale scale) {
+		if (scale == Graphics::YUVToRGBManager::kScaleFull)
+			return CLIP(value, 0, 255);
+
+		return (CLIP(value, 16, 235) - 16) * 255 / 219;
+	}
+
+	// The color of a single pixel, from the same coefficients as the
+	// tables in YUVToRGBManager
+	static uint32 referenceColor(const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale, byte y, byte u, byte v) {
+		int16 cr = v - 128, cb = u - 128;
+		int r = y + (int16)( (0.419 / 0.299) * cr);
+		int g = y + (int16)(-(0.299 / 0.419) * cr) + (int16)(-(0.114 / 0.331) * cb);
+		int b = y + (int16)( (0.587 / 0.331) * cb);
+
+		return format.RGBToColor(clampChannel(r, scale), clampChannel(g, scale), clampChannel(b, scale));
+	}
+
+	// Converts random YUV 4:2:0 or 4:4:4 data and checks each pixel against
+	// referenceColor(). Returns the number of wrong pixels.
+	int checkConvert(bool is420, const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale, int w, int h) {
+		const int yPitch = w + 3;
+		const int uvWidth = is420 ? w / 2 : w;
+		const int uvHeight = is420 ? h / 2 : h;
+		const int uvPitch = uvWidth + 1;
+
+		byte *ySrc = new byte[yPitch * h];
+		byte *uSrc = new byte[uvPitch * uvHeight];
+		byte *vSrc = new byte[uvPitch * uvHeight];
+
+		_seed = w * 13 + h;
+		for (int i = 0; i < yPitch * h; i++)
+			ySrc[i] = nextRandom();
+		for (int i = 0; i < uvPitch * uvHeight; i++) {
+			uSrc[i] = nextRandom();
+			vSrc[i] = nextRandom();
+		}
+
+		Graphics::Surface dst;
+		dst.create(w + 2, h, format);
+
+		if (is420)
+			YUVToRGBMan.convert420(&dst, scale, ySrc, uSrc, vSrc, w, h, yPitch, uvPitch);
+		else
+			YUVToRGBMan.convert444(&dst, scale, ySrc, uSrc, vSrc, w, h, yPitch, uvPitch);
+
+		int errors = 0;
+		for (int y = 0; y < h; y++) {
+			for (int x = 0; x < w; x++) {
+				const int uvOffset = is420 ? (y / 2) * uvPitch + x / 2 : y * uvPitch + x;
+				uint32 expected = referenceColor(format, scale, ySrc[y * yPitch + x], uSrc[uvOffset], vSrc[uvOffset]);
+				const byte *p = (const byte *)dst.getBasePtr(x, y);
+				uint32 actual = format.bytesPerPixel == 2 ? *(const uint16 *)p : *(const uint32 *)p;
+
+				if (actual != expected)
+					errors++;
+			}
+		}
+
+		dst.free();
+		delete[] ySrc;
+		delete[] uSrc;
+		delete[] vSrc;
+		return errors;
+	}
+
+	void checkAllFormats(bool is420, int w, int h) {
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 0, 8, 16, 24)
+		};
+
+		for (uint i = 0; i < ARRAYSIZE(formats); i++) {
+			TS_ASSERT_EQUALS(checkConvert(is420, formats[i], Graphics::YUVToRGBManager::kScaleFull, w, h), 0);
+			TS_ASSERT_EQUALS(checkConvert(is420, formats[i], Graphics::YUVToRGBManager::kScaleITU, w, h), 0);
+		}
+	}
+
+public:
+	void test_convert444() {
+		checkAllFormats(false, 64, 4);
+		checkAllFormats(false, 21, 3);
+	}
+
+	void test_convert420() {
+		checkAllFormats(true, 64, 4);
+		checkAllFormats(true, 22, 6);
+	}
+};
@@ -0,0 +1,137 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#ifdef USE_BINK
+
+#include "video/bink_dsp.h"
+
+class BinkDSPTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kBlocks = 20000,
+		kPitch = 11
+	};
+
+	uint32 _seed;
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 16;
+	}
+
+	// Fills block with coefficients of the given magnitude, a third of them
+	// zero. Some blocks only have a first row, which takes the shortcut in
+	// the column transform.
+	void createBlock(int16 *block, int n) {
+		static const int ranges[4] = { 32767, 2048, 256, 16 };
+		const int range = ranges[n % 4];
+
+		for (int i = 0; i < 64; i++) {
+			if (nextRandom() % 3 == 0 || (n % 5 == 0 && i >= 8))
+				block[i] = 0;
+			else
+				block[i] = (int16)((int)(nextRandom() % (2 * range + 1)) - range);
+		}
+	}
+
+	void createPixels(byte *pixels) {
+		for (int i = 0; i < 8 * kPitch; i++)
+			pixels[i] = nextRandom();
+	}
+
+public:
+	void test_idct() {
+		_seed = 1;
+		int errors = 0;
+
+		for (int n = 0; n < kBlocks; n++) {
+			int16 block[64], expected[64];
+			createBlock(block, n);
+			memcpy(expected, block, sizeof(block));
+
+			Video::binkIDCT(block);
+			Video::binkIDCTGeneric(expected);
+			if (memcmp(block, expected, sizeof(block)))
+				errors++;
+		}
+
+		TS_ASSERT_EQUALS(errors, 0);
+	}
+
+	void test_idct_put() {
+		_seed = 2;
+		int errors = 0;
+
+		for (int n = 0; n < kBlocks; n++) {
+			int16 block[64], copy[64];
+			byte pixels[8 * kPitch], expected[8 * kPitch];
+			createBlock(block, n);
+			memcpy(copy, block, sizeof(block));
+			createPixels(pixels);
+			memcpy(expected, pixels, sizeof(pixels));
+
+			Video::binkIDCTPut(pixels, kPitch, block);
+			Video::binkIDCTPutGeneric(expected, kPitch, copy);
+			if (memcmp(pixels, expected, sizeof(pixels)))
+				errors++;
+		}
+
+		TS_ASSERT_EQUALS(errors, 0);
+	}
+
+	void test_idct_add() {
+		_seed = 3;
+		int errors = 0;
+
+		for (int n = 0; n < kBlocks; n++) {
+			int16 block[64], copy[64];
+			byte pixels[8 * kPitch], expected[8 * kPitch];
+			createBlock(block, n);
+			memcpy(copy, block, sizeof(block));
+			createPixels(pixels);
+			memcpy(expected, pixels, sizeof(pixels));
+
+			Video::binkIDCTAdd(pixels, kPitch, block);
+			Video::binkIDCTAddGeneric(expected, kPitch, copy);
+			if (memcmp(pixels, expected, sizeof(pixels)))
+				errors++;
+		}
+
+		TS_ASSERT_EQUALS(errors, 0);
+	}
+
+	void test_add_pixels() {
+		_seed = 4;
+		int errors = 0;
+
+		for (int n = 0; n < kBlocks; n++) {
+			int16 block[64];
+			byte pixels[8 * kPitch], expected[8 * kPitch];
+			createBlock(block, n);
+			createPixels(pixels);
+			memcpy(expected, pixels, sizeof(pixels));
+
+			Video::binkAddPixels(pixels, kPitch, block);
+			Video::binkAddPixelsGeneric(expected, kPitch, block);
+			if (memcmp(pixels, expected, sizeof(pixels)))
+				errors++;
+		}
+
+		TS_ASSERT_EQUALS(errors, 0);
+	}
+
+	void test_idct_known_values() {
+		// A lone DC coefficient gives a flat block of (dc + 0x7F) >> 8
+		int16 block[64];
+		memset(block, 0, sizeof(block));
+		block[0] = 0x1000;
+
+		Video::binkIDCT(block);
+		for (int i = 0; i < 64; i++)
+			TS_ASSERT_EQUALS(block[i], 16);
+	}
+};
+
+#endif
@@ -68,6 +68,7 @@ public:
 
 protected:
 	 void readNextPacket();
+	bool supportsDecodeAhead() const { return true; }
 
 private:
 	struct BitmapInfoHeader {
@@ -50,6 +50,7 @@ class Huffman;
 
 class RDFT;
 class DCT;
+class WorkerPool;
 }
 
 namespace Graphics {
@@ -74,6 +75,7 @@ public:
 
 protected:
 	void readNextPacket();
+	bool supportsDecodeAhead() const { return true; }
 
 private:
 	static const int kAudioChannelsMax  = 2;
@@ -148,6 +150,7 @@ private:
 		int getCurFrame() const { return _curFrame; }
 		int getFrameCount() const { return _frameCount; }
 		const Graphics::Surface *decodeNextFrame() { return &_surface; }
+		void setDropFrames(bool drop) { _dropFrames = drop; }
 
 		/** Decode a video packet. */
 		void decodePacket(VideoFrame &frame);
@@ -232,6 +235,12 @@ private:
 		int _curFrame;
 		int _frameCount;
 
+		bool _dropFrames; ///< Skip the conversion of the decoded frames?
+
+		int _convertThreads; ///< Number of threads converting the frames to RGB.
+		int _convertBandHeight; ///< Rows converted by each of the threads.
+		Common::WorkerPool *_convertPool; ///< The threads converting the frames.
+
 		Graphics::Surface _surface;
 		int _surfaceWidth; ///< The actual surface width
 		int _surfaceHeight; ///< The actual surface height
@@ -266,6 +275,13 @@ private:
 		/** Decode a plane. */
 		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
 
+		/** Convert the decoded YUV planes into the surface. */
+		void convertFrame();
+		/** Convert a range of rows of the decoded YUV planes. */
+		void convertRows(int y, int height);
+		/** Convert one band of rows, on one of the worker threads. */
+		static void convertBand(void *param, uint band);
+
 		/** Read/Initialize a bundle for decoding a plane. */
 		void readBundle(VideoFrame &video, Source source);
 
@@ -309,11 +325,6 @@ private:
 		void readDCS         (VideoFrame &video, Bundle &bundle, int startBits, bool hasSign);
 		void readDCTCoeffs   (VideoFrame &video, int16 *block, bool isIntra);
 		void readResidue     (VideoFrame &video, int16 *block, int masksCount);
-
-		// Bink video IDCT
-		void IDCT(int16 *block);
-		void IDCTPut(DecodeContext &ctx, int16 *block);
-		void IDCTAdd(DecodeContext &ctx, int16 *block);
 	};
 
 	class BinkAudioTrack : public AudioTrack {
@@ -0,0 +1,298 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "video/bink_dsp.h"
+
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Video {
+
+#define A1  2896 /* (1/sqrt(2))<<12 */
+#define A2  2217
+#define A3  3784
+#define A4 -5352
+
+#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
+    const int a0 = (src)[s0] + (src)[s4]; \
+    const int a1 = (src)[s0] - (src)[s4]; \
+    const int a2 = (src)[s2] + (src)[s6]; \
+    const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
+    const int a4 = (src)[s5] + (src)[s3]; \
+    const int a5 = (src)[s5] - (src)[s3]; \
+    const int a6 = (src)[s1] + (src)[s7]; \
+    const int a7 = (src)[s1] - (src)[s7]; \
+    const int b0 = a4 + a6; \
+    const int b1 = (A3*(a5 + a7)) >> 11; \
+    const int b2 = ((A4*a5) >> 11) - b0 + b1; \
+    const int b3 = (A1*(a6 - a4) >> 11) - b2; \
+    const int b4 = ((A2*a7) >> 11) + b3 - b1; \
+    (dest)[d0] = munge(a0+a2   +b0); \
+    (dest)[d1] = munge(a1+a3-a2+b2); \
+    (dest)[d2] = munge(a1-a3+a2+b3); \
+    (dest)[d3] = munge(a0-a2   -b4); \
+    (dest)[d4] = munge(a0-a2   +b4); \
+    (dest)[d5] = munge(a1-a3+a2-b3); \
+    (dest)[d6] = munge(a1+a3-a2-b2); \
+    (dest)[d7] = munge(a0+a2   -b0); \
+}
+/* end IDCT_TRANSFORM macro */
+
+#define MUNGE_NONE(x) (x)
+#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
+
+#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
+#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
+
+static inline void IDCTCol(int16 *dest, const int16 *src) {
+	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
+		dest[ 0] =
+		dest[ 8] =
+		dest[16] =
+		dest[24] =
+		dest[32] =
+		dest[40] =
+		dest[48] =
+		dest[56] = src[0];
+	} else {
+		IDCT_COL(dest, src);
+	}
+}
+
+#ifdef USE_SSE2
+
+// The SSE2 IDCT works on four columns, or rows, at a time in 32 bit lanes, so
+// that it rounds and overflows exactly like the C version above.
+
+/** Multiply the 32 bit lanes, keeping the low 32 bits of the products. */
+static inline __m128i mulLo32SSE2(__m128i a, __m128i b) {
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/** (c * x) >> 11, as in IDCT_TRANSFORM. */
+static inline __m128i mulShiftSSE2(int c, __m128i x) {
+	return _mm_srai_epi32(mulLo32SSE2(_mm_set1_epi32(c), x), 11);
+}
+
+/** Truncate the 32 bit lanes to 16 bits, keeping the sign. */
+static inline __m128i truncate16SSE2(__m128i x) {
+	return _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+}
+
+/** IDCT_TRANSFORM on s[0..7], without the munging. */
+static inline void IDCTTransformSSE2(__m128i *d, const __m128i *s) {
+	const __m128i a0 = _mm_add_epi32(s[0], s[4]);
+	const __m128i a1 = _mm_sub_epi32(s[0], s[4]);
+	const __m128i a2 = _mm_add_epi32(s[2], s[6]);
+	const __m128i a3 = mulShiftSSE2(A1, _mm_sub_epi32(s[2], s[6]));
+	const __m128i a4 = _mm_add_epi32(s[5], s[3]);
+	const __m128i a5 = _mm_sub_epi32(s[5], s[3]);
+	const __m128i a6 = _mm_add_epi32(s[1], s[7]);
+	const __m128i a7 = _mm_sub_epi32(s[1], s[7]);
+	const __m128i b0 = _mm_add_epi32(a4, a6);
+	const __m128i b1 = mulShiftSSE2(A3, _mm_add_epi32(a5, a7));
+	const __m128i b2 = _mm_add_epi32(_mm_sub_epi32(mulShiftSSE2(A4, a5), b0), b1);
+	const __m128i b3 = _mm_sub_epi32(mulShiftSSE2(A1, _mm_sub_epi32(a6, a4)), b2);
+	const __m128i b4 = _mm_sub_epi32(_mm_add_epi32(mulShiftSSE2(A2, a7), b3), b1);
+
+	const __m128i c0 = _mm_add_epi32(a0, a2);
+	const __m128i c1 = _mm_sub_epi32(a0, a2);
+	const __m128i c2 = _mm_sub_epi32(_mm_add_epi32(a1, a3), a2);
+	const __m128i c3 = _mm_add_epi32(_mm_sub_epi32(a1, a3), a2);
+
+	d[0] = _mm_add_epi32(c0, b0);
+	d[1] = _mm_add_epi32(c2, b2);
+	d[2] = _mm_add_epi32(c3, b3);
+	d[3] = _mm_sub_epi32(c1, b4);
+	d[4] = _mm_add_epi32(c1, b4);
+	d[5] = _mm_sub_epi32(c3, b3);
+	d[6] = _mm_sub_epi32(c2, b2);
+	d[7] = _mm_sub_epi32(c0, b0);
+}
+
+/** Transpose an 8x8 matrix of 16 bit values. */
+static inline void transpose8x8SSE2(__m128i *r) {
+	const __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+	const __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+	const __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+	const __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+	const __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+	const __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+	const __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+	const __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+	const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	r[0] = _mm_unpacklo_epi64(b0, b4);
+	r[1] = _mm_unpackhi_epi64(b0, b4);
+	r[2] = _mm_unpacklo_epi64(b1, b5);
+	r[3] = _mm_unpackhi_epi64(b1, b5);
+	r[4] = _mm_unpacklo_epi64(b2, b6);
+	r[5] = _mm_unpackhi_epi64(b2, b6);
+	r[6] = _mm_unpacklo_epi64(b3, b7);
+	r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/** One pass of the IDCT over the columns of r, truncating the results to 16 bits. */
+static inline void IDCTPassSSE2(__m128i *r, bool munge) {
+	__m128i lo[8], hi[8];
+
+	for (int i = 0; i < 8; i++) {
+		lo[i] = _mm_srai_epi32(_mm_unpacklo_epi16(r[i], r[i]), 16);
+		hi[i] = _mm_srai_epi32(_mm_unpackhi_epi16(r[i], r[i]), 16);
+	}
+
+	IDCTTransformSSE2(lo, lo);
+	IDCTTransformSSE2(hi, hi);
+
+	const __m128i round = _mm_set1_epi32(0x7F);
+	for (int i = 0; i < 8; i++) {
+		if (munge) {
+			lo[i] = _mm_srai_epi32(_mm_add_epi32(lo[i], round), 8);
+			hi[i] = _mm_srai_epi32(_mm_add_epi32(hi[i], round), 8);
+		}
+
+		r[i] = _mm_packs_epi32(truncate16SSE2(lo[i]), truncate16SSE2(hi[i]));
+	}
+}
+
+/** Add the 16 bit rows to the 8x8 bytes in dest, wrapping around like the C version. */
+static inline void addBlockSSE2(byte *dest, uint32 pitch, const __m128i *r) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi16(0xFF);
+
+	for (int i = 0; i < 8; i++, dest += pitch) {
+		__m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)dest), zero);
+		d = _mm_and_si128(_mm_add_epi16(d, r[i]), mask);
+		_mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(d, zero));
+	}
+}
+
+/** The whole IDCT of block, returning the 8 rows of the result. */
+static inline void IDCTSSE2(__m128i *r, const int16 *block) {
+	for (int i = 0; i < 8; i++)
+		r[i] = _mm_loadu_si128((const __m128i *)(block + 8 * i));
+
+	// The columns, and then the rows, done as the columns of the transposition
+	IDCTPassSSE2(r, false);
+	transpose8x8SSE2(r);
+	IDCTPassSSE2(r, true);
+	transpose8x8SSE2(r);
+}
+
+#endif
+
+void binkIDCTGeneric(int16 *block) {
+	int i;
+	int16 temp[64];
+
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
+	}
+}
+
+void binkIDCTPutGeneric(byte *dest, uint32 pitch, int16 *block) {
+	int i;
+	int16 temp[64];
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&dest[i*pitch]), (&temp[8*i]) );
+	}
+}
+
+void binkIDCTAddGeneric(byte *dest, uint32 pitch, int16 *block) {
+	binkIDCTGeneric(block);
+	binkAddPixelsGeneric(dest, pitch, block);
+}
+
+void binkAddPixelsGeneric(byte *dest, uint32 pitch, const int16 *block) {
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8)
+		for (int j = 0; j < 8; j++)
+			dest[j] += block[j];
+}
+
+void binkIDCT(int16 *block) {
+#ifdef USE_SSE2
+	__m128i r[8];
+	IDCTSSE2(r, block);
+
+	for (int i = 0; i < 8; i++)
+		_mm_storeu_si128((__m128i *)(block + 8 * i), r[i]);
+#else
+	binkIDCTGeneric(block);
+#endif
+}
+
+void binkIDCTPut(byte *dest, uint32 pitch, int16 *block) {
+#ifdef USE_SSE2
+	__m128i r[8];
+	IDCTSSE2(r, block);
+
+	// Only the low 8 bits of each value are kept, like in the C version
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi16(0xFF);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		_mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(_mm_and_si128(r[i], mask), zero));
+#else
+	binkIDCTPutGeneric(dest, pitch, block);
+#endif
+}
+
+void binkIDCTAdd(byte *dest, uint32 pitch, int16 *block) {
+#ifdef USE_SSE2
+	__m128i r[8];
+	IDCTSSE2(r, block);
+	addBlockSSE2(dest, pitch, r);
+#else
+	binkIDCTAddGeneric(dest, pitch, block);
+#endif
+}
+
+void binkAddPixels(byte *dest, uint32 pitch, const int16 *block) {
+#ifdef USE_SSE2
+	__m128i r[8];
+	for (int i = 0; i < 8; i++)
+		r[i] = _mm_loadu_si128((const __m128i *)(block + 8 * i));
+
+	addBlockSSE2(dest, pitch, r);
+#else
+	binkAddPixelsGeneric(dest, pitch, block);
+#endif
+}
+
+} // End of namespace Video
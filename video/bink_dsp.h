@@ -0,0 +1,62 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef VIDEO_BINK_DSP_H
+#define VIDEO_BINK_DSP_H
+
+#include "common/scummsys.h"
+
+// The transforms of the Bink video decoder, which work on 8x8 blocks of
+// 16 bit coefficients and 8 bit pixels. They use SSE2 where available.
+
+namespace Video {
+
+/** Transforms the DCT coefficients in block in place. */
+void binkIDCT(int16 *block);
+
+/**
+ * Transforms the DCT coefficients in block and writes the result to dest,
+ * keeping only the low 8 bits of each value. block is clobbered.
+ */
+void binkIDCTPut(byte *dest, uint32 pitch, int16 *block);
+
+/**
+ * Transforms the DCT coefficients in block and adds the result to dest,
+ * wrapping around on overflow. block is clobbered.
+ */
+void binkIDCTAdd(byte *dest, uint32 pitch, int16 *block);
+
+/** Adds the residue in block to dest, wrapping around on overflow. */
+void binkAddPixels(byte *dest, uint32 pitch, const int16 *block);
+
+/**
+ * The portable versions of the above. The others have to give exactly the
+ * same results; these are only exposed to test that.
+ */
+void binkIDCTGeneric(int16 *block);
+void binkIDCTPutGeneric(byte *dest, uint32 pitch, int16 *block);
+void binkIDCTAddGeneric(byte *dest, uint32 pitch, int16 *block);
+void binkAddPixelsGeneric(byte *dest, uint32 pitch, const int16 *block);
+
+} // End of namespace Video
+
+#endif
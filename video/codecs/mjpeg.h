@@ -31,6 +31,7 @@ class SeekableReadStream;
 }
 
 namespace Graphics {
+class JPEGDecoder;
 struct Surface;
 }
 
@@ -52,7 +53,7 @@ public:
 
 private:
 	Graphics::PixelFormat _pixelFormat;
-	Graphics::Surface *_surface;
+	Graphics::JPEGDecoder *_jpeg;
 };
 
 } // End of namespace Video
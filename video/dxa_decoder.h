@@ -54,6 +54,8 @@ protected:
 	 */
 	virtual void readSoundData(Common::SeekableReadStream *stream);
 
+	bool supportsDecodeAhead() const { return true; }
+
 private:
 	class DXAVideoTrack : public FixedRateVideoTrack {
 	public:
@@ -438,6 +438,7 @@ PSXStreamDecoder::PSXVideoTrack::PSXVideoTrack(Common::SeekableReadStream *first
 	_crBuffer = new byte[_macroBlocksW * _macroBlocksH * 8 * 8];
 
 	_endOfTrack = false;
+	_dropFrames = false;
 	_curFrame = -1;
 	_acHuffman = new Common::Huffman(0, AC_CODE_COUNT, s_huffmanACCodes, s_huffmanACLengths, s_huffmanACSymbols);
 	_dcHuffmanChroma = new Common::Huffman(0, DC_CODE_COUNT, s_huffmanDCChromaCodes, s_huffmanDCChromaLengths, s_huffmanDCSymbols);
@@ -465,7 +466,13 @@ const Graphics::Surface *PSXStreamDecoder::PSXVideoTrack::decodeNextFrame() {
 }
 
 void PSXStreamDecoder::PSXVideoTrack::decodeFrame(Common::SeekableReadStream *frame, uint sectorCount) {
-	// A frame is essentially an MPEG-1 intra frame
+	// A frame is essentially an MPEG-1 intra frame, so no other frame
+	// depends on it and a dropped one does not need to be decoded at all
+	if (_dropFrames) {
+		_curFrame++;
+		_nextFrameStartTime = _nextFrameStartTime.addFrames(sectorCount);
+		return;
+	}
 
 	Common::BitStream16LEMSB bits(frame);
 
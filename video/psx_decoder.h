@@ -74,6 +74,7 @@ public:
 protected:
 	void readNextPacket();
 	bool useAudioSync() const;
+	bool supportsDecodeAhead() const { return true; }
 
 private:
 	class PSXVideoTrack : public VideoTrack {
@@ -89,6 +90,7 @@ private:
 		int getFrameCount() const { return _frameCount; }
 		uint32 getNextFrameStartTime() const;
 		const Graphics::Surface *decodeNextFrame();
+		void setDropFrames(bool drop) { _dropFrames = drop; }
 
 		void setEndOfTrack() { _endOfTrack = true; }
 		void decodeFrame(Common::SeekableReadStream *frame, uint sectorCount);
@@ -98,6 +100,7 @@ private:
 		uint32 _frameCount;
 		Audio::Timestamp _nextFrameStartTime;
 		bool _endOfTrack;
+		bool _dropFrames;
 		int _curFrame;
 
 		enum PlaneType {
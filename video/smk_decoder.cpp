@@ -47,6 +47,44 @@ enum SmkBlockTypes {
 	SMK_BLOCK_FILL = 3
 };
 
+/*
+ * class SmackerBitStream
+ * An LSB first bit stream over the video data of a frame, read straight
+ * from memory, so that the Huffman trees can cheaply peek at the bits of
+ * the next code. The data must be followed by kPadding zero bytes.
+ */
+
+class SmackerBitStream {
+public:
+	enum {
+		kPadding = 4
+	};
+
+	SmackerBitStream(const byte *data, uint32 size) : _data(data), _size(size * 8), _pos(0) {}
+
+	/** Return the next n bits (at most 24), without skipping them. */
+	uint32 peekBits(int n) const {
+		return (READ_LE_UINT32(_data + (_pos >> 3)) >> (_pos & 7)) & ((1 << n) - 1);
+	}
+
+	uint32 getBit() {
+		uint32 bit = (_data[_pos >> 3] >> (_pos & 7)) & 1;
+		skip(1);
+		return bit;
+	}
+
+	void skip(uint32 n) {
+		_pos += n;
+		if (_pos > _size)
+			error("SmackerBitStream::skip(): End of bit stream reached");
+	}
+
+private:
+	const byte *_data;
+	uint32 _size;
+	uint32 _pos;
+};
+
 /*
  * class SmallHuffmanTree
  * A Huffman-tree to hold 8-bit values.
@@ -143,20 +181,24 @@ public:
 	~BigHuffmanTree();
 
 	void reset();
-	uint32 getCode(Common::BitStream &bs);
+	uint32 getCode(SmackerBitStream &bs);
 private:
 	enum {
 		SMK_NODE = 0x80000000
 	};
 
+	enum {
+		SMK_LOOKUP_BITS = 10 ///< Codes up to this long are decoded with a single table lookup
+	};
+
 	uint32 decodeTree(uint32 prefix, int length);
 
 	uint32  _treeSize;
 	uint32 *_tree;
 	uint32  _last[3];
 
-	uint32 _prefixtree[256];
-	byte _prefixlength[256];
+	uint32 _prefixtree[1 << SMK_LOOKUP_BITS];
+	byte _prefixlength[1 << SMK_LOOKUP_BITS];
 
 	/* Used during construction */
 	Common::BitStream &_bs;
@@ -167,6 +209,9 @@ private:
 
 BigHuffmanTree::BigHuffmanTree(Common::BitStream &bs, int allocSize)
 	: _bs(bs) {
+	for (uint32 i = 0; i < (1 << SMK_LOOKUP_BITS); ++i)
+		_prefixtree[i] = _prefixlength[i] = 0;
+
 	uint32 bit = _bs.getBit();
 	if (!bit) {
 		_tree = new uint32[1];
@@ -175,9 +220,6 @@ BigHuffmanTree::BigHuffmanTree(Common::BitStream &bs, int allocSize)
 		return;
 	}
 
-	for (uint32 i = 0; i < 256; ++i)
-		_prefixtree[i] = _prefixlength[i] = 0;
-
 	_loBytes = new SmallHuffmanTree(_bs);
 	_hiBytes = new SmallHuffmanTree(_bs);
 
@@ -223,8 +265,8 @@ uint32 BigHuffmanTree::decodeTree(uint32 prefix, int length) {
 
 		_tree[_treeSize] = v;
 
-		if (length <= 8) {
-			for (int i = 0; i < 256; i += (1 << length)) {
+		if (length <= SMK_LOOKUP_BITS) {
+			for (int i = 0; i < (1 << SMK_LOOKUP_BITS); i += (1 << length)) {
 				_prefixtree[prefix | i] = _treeSize;
 				_prefixlength[prefix | i] = length;
 			}
@@ -243,9 +285,9 @@ uint32 BigHuffmanTree::decodeTree(uint32 prefix, int length) {
 
 	uint32 t = _treeSize++;
 
-	if (length == 8) {
+	if (length == SMK_LOOKUP_BITS) {
 		_prefixtree[prefix] = t;
-		_prefixlength[prefix] = 8;
+		_prefixlength[prefix] = SMK_LOOKUP_BITS;
 	}
 
 	uint32 r1 = decodeTree(prefix, length + 1);
@@ -256,8 +298,11 @@ uint32 BigHuffmanTree::decodeTree(uint32 prefix, int length) {
 	return r1+r2+1;
 }
 
-uint32 BigHuffmanTree::getCode(Common::BitStream &bs) {
-	byte peek = bs.peekBits(MIN<uint32>(bs.size() - bs.pos(), 8));
+uint32 BigHuffmanTree::getCode(SmackerBitStream &bs) {
+	// Codes of up to SMK_LOOKUP_BITS bits are found in the table, longer
+	// ones continue from the node after their first SMK_LOOKUP_BITS bits.
+	// Bits past the end of the data read as 0.
+	uint32 peek = bs.peekBits(SMK_LOOKUP_BITS);
 	uint32 *p = &_tree[_prefixtree[peek]];
 	bs.skip(_prefixlength[peek]);
 
@@ -409,6 +454,10 @@ void SmackerDecoder::close() {
 }
 
 bool SmackerDecoder::rewind() {
+	// Keep the decode ahead timer away until the stream is back in sync
+	// with the tracks
+	Common::StackLock lock(_decodeMutex);
+
 	// Call the parent method to rewind the tracks first
 	if (!VideoDecoder::rewind())
 		return false;
@@ -464,14 +513,15 @@ void SmackerDecoder::readNextPacket() {
 
 	uint32 frameDataSize = frameSize - (_fileStream->pos() - startPos);
 
-	byte *frameData = (byte *)malloc(frameDataSize + 1);
+	byte *frameData = (byte *)malloc(frameDataSize + 1 + SmackerBitStream::kPadding);
 	// Padding to keep the BigHuffmanTrees from reading past the data end
-	frameData[frameDataSize] = 0x00;
+	memset(frameData + frameDataSize, 0, 1 + SmackerBitStream::kPadding);
 
 	_fileStream->read(frameData, frameDataSize);
 
-	Common::BitStream8LSB bs(new Common::MemoryReadStream(frameData, frameDataSize + 1, DisposeAfterUse::YES), true);
+	SmackerBitStream bs(frameData, frameDataSize + 1);
 	videoTrack->decodeFrame(bs);
+	free(frameData);
 
 	_fileStream->seek(startPos + frameSize);
 }
@@ -551,7 +601,7 @@ void SmackerDecoder::SmackerVideoTrack::readTrees(Common::BitStream &bs, uint32
 	_TypeTree = new BigHuffmanTree(bs, typeSize);
 }
 
-void SmackerDecoder::SmackerVideoTrack::decodeFrame(Common::BitStream &bs) {
+void SmackerDecoder::SmackerVideoTrack::decodeFrame(SmackerBitStream &bs) {
 	_MMapTree->reset();
 	_MClrTree->reset();
 	_FullTree->reset();
@@ -41,6 +41,7 @@ class SeekableReadStream;
 namespace Video {
 
 class BigHuffmanTree;
+class SmackerBitStream;
 
 /**
  * Decoder for Smacker v2/v4 videos.
@@ -69,6 +70,7 @@ public:
 
 protected:
 	void readNextPacket();
+	bool supportsDecodeAhead() const { return true; }
 
 	virtual void handleAudioTrack(byte track, uint32 chunkSize, uint32 unpackedSize);
 
@@ -91,7 +93,7 @@ protected:
 
 		void readTrees(Common::BitStream &bs, uint32 mMapSize, uint32 mClrSize, uint32 fullSize, uint32 typeSize);
 		void increaseCurFrame() { _curFrame++; }
-		void decodeFrame(Common::BitStream &bs);
+		void decodeFrame(SmackerBitStream &bs);
 		void unpackPalette(Common::SeekableReadStream *stream);
 
 	protected:
@@ -272,6 +272,7 @@ TheoraDecoder::TheoraVideoTrack::TheoraVideoTrack(const Graphics::PixelFormat &f
 	_frameRate = Common::Rational(theoraInfo.fps_numerator, theoraInfo.fps_denominator);
 
 	_endOfVideo = false;
+	_dropFrames = false;
 	_nextFrameStartTime = 0.0;
 	_curFrame = -1;
 }
@@ -287,10 +288,12 @@ bool TheoraDecoder::TheoraVideoTrack::decodePacket(ogg_packet &oggPacket) {
 	if (th_decode_packetin(_theoraDecode, &oggPacket, 0) == 0) {
 		_curFrame++;
 
-		// Convert YUV data to RGB data
-		th_ycbcr_buffer yuv;
-		th_decode_ycbcr_out(_theoraDecode, yuv);
-		translateYUVtoRGBA(yuv);
+		// Convert YUV data to RGB data, unless the frame is dropped anyway
+		if (!_dropFrames) {
+			th_ycbcr_buffer yuv;
+			th_decode_ycbcr_out(_theoraDecode, yuv);
+			translateYUVtoRGBA(yuv);
+		}
 
 		double time = th_granule_time(_theoraDecode, oggPacket.granulepos);
 
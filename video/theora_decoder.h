@@ -67,6 +67,7 @@ public:
 
 protected:
 	void readNextPacket();
+	bool supportsDecodeAhead() const { return true; }
 
 private:
 	class TheoraVideoTrack : public VideoTrack {
@@ -81,6 +82,7 @@ private:
 		int getCurFrame() const { return _curFrame; }
 		uint32 getNextFrameStartTime() const { return (uint32)(_nextFrameStartTime * 1000); }
 		const Graphics::Surface *decodeNextFrame() { return &_displaySurface; }
+		void setDropFrames(bool drop) { _dropFrames = drop; }
 
 		bool decodePacket(ogg_packet &oggPacket);
 		void setEndOfVideo() { _endOfVideo = true; }
@@ -88,6 +90,7 @@ private:
 	private:
 		int _curFrame;
 		bool _endOfVideo;
+		bool _dropFrames;
 		Common::Rational _frameRate;
 		double _nextFrameStartTime;
 
@@ -25,14 +25,72 @@
 #include "audio/audiostream.h"
 #include "audio/mixer.h" // for kMaxChannelVolume
 
+#include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/rational.h"
 #include "common/file.h"
 #include "common/system.h"
+#include "common/timer.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
 
 namespace Video {
 
+/**
+ * State of the decode ahead mode. The timer is the only writer of the frame
+ * queue and decodeNextFrame() the only reader. The queue positions are only
+ * changed with the mutex held, but the frames are copied without it: the
+ * timer only writes to slots outside of the queue, and decodeNextFrame()
+ * swaps the surface of the first slot with shownSurface.
+ */
+struct VideoDecoder::DecodeAhead {
+	struct Frame {
+		Graphics::Surface surface;
+		bool hasSurface;
+		uint32 startTime;
+		bool reversed;
+		int curFrame;
+		bool dirtyPalette;
+		byte palette[256 * 3];
+	};
+
+	~DecodeAhead() {
+		for (uint i = 0; i < frames.size(); i++)
+			frames[i].surface.free();
+
+		shownSurface.free();
+	}
+
+	Common::Mutex mutex;
+	Common::Array<Frame> frames;
+	uint readPos;
+	uint count;
+
+	// Guarded by the mutex as well. The start time is that of the frame
+	// after the queued ones.
+	bool endOfFrames;
+	uint32 nextStartTime;
+	bool nextReversed;
+
+	// Only used by the timer, with _decodeMutex held: whether the next slot
+	// holds the palette of a dropped frame
+	bool droppedPalette;
+
+	// Only used by the thread playing the video
+	Graphics::Surface shownSurface;
+	int shownFrame;
+	byte palette[256 * 3];
+};
+
+enum {
+	kDecodeAheadInterval = 10 * 1000 // microseconds
+};
+
+// The decoders which are decoding ahead. The timer is removed while this is
+// changed, so the timer never sees it half updated.
+static Common::Array<VideoDecoder *> s_decodeAheadDecoders;
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -46,6 +104,13 @@ VideoDecoder::VideoDecoder() {
 	_endTime = 0;
 	_endTimeSet = false;
 	_nextVideoTrack = 0;
+	_decodeAhead = 0;
+	_decodeAheadFrames = ConfMan.hasKey("video_decode_ahead") ? MAX(ConfMan.getInt("video_decode_ahead"), 0) : 0;
+	_lateFrames = 0;
+	_droppedFrames = 0;
+	_frameDropPolicy = ConfMan.hasKey("video_frame_drop") && ConfMan.getBool("video_frame_drop") ? kFrameDropLate : kFrameDropNone;
+	_lastFrameTrack = 0;
+	_lastFrameStartTime = 0;
 
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
@@ -54,7 +119,16 @@ VideoDecoder::VideoDecoder() {
 		_defaultHighColorFormat = Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0);
 }
 
+VideoDecoder::~VideoDecoder() {
+	stopDecodeAhead();
+}
+
 void VideoDecoder::close() {
+	stopDecodeAhead();
+
+	if (_lateFrames || _droppedFrames)
+		debug(1, "VideoDecoder: %d late and %d dropped frames", _lateFrames, _droppedFrames);
+
 	if (isPlaying())
 		stop();
 
@@ -73,6 +147,9 @@ void VideoDecoder::close() {
 	_endTime = 0;
 	_endTimeSet = false;
 	_nextVideoTrack = 0;
+	_lastFrameTrack = 0;
+	_lateFrames = 0;
+	_droppedFrames = 0;
 }
 
 bool VideoDecoder::loadFile(const Common::String &filename) {
@@ -87,10 +164,15 @@ bool VideoDecoder::loadFile(const Common::String &filename) {
 }
 
 bool VideoDecoder::needsUpdate() const {
+	if (_decodeAhead)
+		return hasQueuedFrame() && getTimeToNextFrame() == 0;
+
 	return hasFramesLeft() && getTimeToNextFrame() == 0;
 }
 
 void VideoDecoder::pauseVideo(bool pause) {
+	Common::StackLock lock(_decodeMutex);
+
 	if (pause) {
 		_pauseLevel++;
 
@@ -168,6 +250,27 @@ Graphics::PixelFormat VideoDecoder::getPixelFormat() const {
 const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 
+	if (_decodeAhead)
+		return nextQueuedFrame();
+
+	// Skip the frames which are too late to be shown
+	while (_nextVideoTrack && shouldDropNextFrame()) {
+		dropNextFrame();
+
+		if (_nextVideoTrack && _nextVideoTrack->hasDirtyPalette()) {
+			_palette = _nextVideoTrack->getPalette();
+			_dirtyPalette = true;
+		}
+
+		findNextVideoTrack();
+		_droppedFrames++;
+	}
+
+	if (_nextVideoTrack) {
+		_lastFrameTrack = _nextVideoTrack;
+		_lastFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	}
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -193,17 +296,31 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	Common::StackLock lock(_decodeMutex);
+	bool changed = false;
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
-			if (!((VideoTrack *)*it)->setReverse(reverse))
+			if (!((VideoTrack *)*it)->setReverse(reverse)) {
+				if (changed)
+					flushDecodeAhead();
+
 				return false;
+			}
 
 			_needsUpdate = true; // force an update
+			changed = true;
 		}
 	}
 
 	findNextVideoTrack();
+
+	if (changed) {
+		flushDecodeAhead();
+		_lastFrameTrack = 0;
+	}
+
 	return true;
 }
 
@@ -213,6 +330,13 @@ const byte *VideoDecoder::getPalette() {
 }
 
 int VideoDecoder::getCurFrame() const {
+	if (_decodeAhead)
+		return _decodeAhead->shownFrame;
+
+	return getTrackCurFrame();
+}
+
+int VideoDecoder::getTrackCurFrame() const {
 	int32 frame = -1;
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -254,13 +378,34 @@ uint32 VideoDecoder::getTime() const {
 }
 
 uint32 VideoDecoder::getTimeToNextFrame() const {
-	if (endOfVideo() || _needsUpdate || !_nextVideoTrack)
+	if (endOfVideo() || _needsUpdate)
 		return 0;
 
+	uint32 nextFrameStartTime;
+	bool reversed;
+
+	if (_decodeAhead) {
+		Common::StackLock lock(_decodeAhead->mutex);
+
+		if (_decodeAhead->count) {
+			const DecodeAhead::Frame &frame = _decodeAhead->frames[_decodeAhead->readPos];
+			nextFrameStartTime = frame.startTime;
+			reversed = frame.reversed;
+		} else {
+			nextFrameStartTime = _decodeAhead->nextStartTime;
+			reversed = _decodeAhead->nextReversed;
+		}
+	} else {
+		if (!_nextVideoTrack)
+			return 0;
+
+		nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+		reversed = _nextVideoTrack->isReversed();
+	}
+
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
 
-	if (_nextVideoTrack->isReversed()) {
+	if (reversed) {
 		// For reversed videos, we need to handle the time difference the opposite way.
 		if (nextFrameStartTime >= currentTime)
 			return 0;
@@ -276,9 +421,17 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 }
 
 bool VideoDecoder::endOfVideo() const {
-	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
+	// The video tracks are only looked at by the decode ahead timer then
+	if (_decodeAhead && hasFramesLeft())
+		return false;
+
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if (_decodeAhead && (*it)->getTrackType() == Track::kTrackTypeVideo)
+			continue;
+
 		if (!(*it)->endOfTrack() && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
 			return false;
+	}
 
 	return true;
 }
@@ -298,6 +451,8 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	Common::StackLock lock(_decodeMutex);
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -314,6 +469,8 @@ bool VideoDecoder::rewind() {
 	_startTime = g_system->getMillis();
 	resetPauseStartTime();
 	findNextVideoTrack();
+	flushDecodeAhead();
+	_lastFrameTrack = 0;
 	return true;
 }
 
@@ -332,6 +489,8 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	Common::StackLock lock(_decodeMutex);
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -351,6 +510,8 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 
 	resetPauseStartTime();
 	findNextVideoTrack();
+	flushDecodeAhead();
+	_lastFrameTrack = 0;
 	_needsUpdate = true;
 	return true;
 }
@@ -393,6 +554,8 @@ void VideoDecoder::stop() {
 	if (!isPlaying())
 		return;
 
+	Common::StackLock lock(_decodeMutex);
+
 	// Stop audio here so we don't have it affect getTime()
 	stopAudio();
 
@@ -414,6 +577,9 @@ void VideoDecoder::stop() {
 	// Reset the pause state of the tracks too
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		(*it)->pause(false);
+
+	// The end time no longer applies
+	wakeDecodeAhead();
 }
 
 void VideoDecoder::setRate(const Common::Rational &rate) {
@@ -452,6 +618,7 @@ void VideoDecoder::setRate(const Common::Rational &rate) {
 		_startTime -= (_lastTimeChange.msecs() / _playbackRate).toInt();
 
 	startAudio();
+	startDecodeAhead();
 }
 
 bool VideoDecoder::isPlaying() const {
@@ -689,6 +856,7 @@ bool VideoDecoder::addStreamFileTrack(const Common::String &baseName) {
 }
 
 void VideoDecoder::setEndTime(const Audio::Timestamp &endTime) {
+	Common::StackLock lock(_decodeMutex);
 	Audio::Timestamp startTime = 0;
 
 	if (isPlaying()) {
@@ -698,6 +866,7 @@ void VideoDecoder::setEndTime(const Audio::Timestamp &endTime) {
 
 	_endTime = endTime;
 	_endTimeSet = true;
+	wakeDecodeAhead();
 
 	if (startTime > endTime)
 		return;
@@ -778,6 +947,20 @@ void VideoDecoder::startAudioLimit(const Audio::Timestamp &limit) {
 }
 
 bool VideoDecoder::hasFramesLeft() const {
+	if (!_decodeAhead)
+		return hasTrackFramesLeft();
+
+	{
+		Common::StackLock lock(_decodeAhead->mutex);
+
+		if (!_decodeAhead->endOfFrames)
+			return true;
+	}
+
+	return hasQueuedFrame();
+}
+
+bool VideoDecoder::hasTrackFramesLeft() const {
 	// This is similar to endOfVideo(), except it doesn't take Audio into account (and returns true if not the end of the video)
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
@@ -796,4 +979,297 @@ bool VideoDecoder::hasAudio() const {
 	return false;
 }
 
+uint32 VideoDecoder::getLateFrameCount() const {
+	if (!_decodeAhead)
+		return _lateFrames;
+
+	Common::StackLock lock(_decodeAhead->mutex);
+	return _lateFrames;
+}
+
+uint32 VideoDecoder::getDroppedFrameCount() const {
+	if (!_decodeAhead)
+		return _droppedFrames;
+
+	Common::StackLock lock(_decodeAhead->mutex);
+	return _droppedFrames;
+}
+
+bool VideoDecoder::shouldDropNextFrame() const {
+	if (_frameDropPolicy == kFrameDropNone || !isPlaying() || isPaused())
+		return false;
+
+	// Without the previous frame of the same track, the interval is unknown
+	if (!_nextVideoTrack || _nextVideoTrack != _lastFrameTrack || _nextVideoTrack->isReversed())
+		return false;
+
+	// Always show the last frame
+	int frameCount = _nextVideoTrack->getFrameCount();
+	if (frameCount != 0 && _nextVideoTrack->getCurFrame() + 2 >= frameCount)
+		return false;
+
+	uint32 startTime = _nextVideoTrack->getNextFrameStartTime();
+	if (startTime <= _lastFrameStartTime)
+		return false;
+
+	// Drop the frame if the one after it is due as well
+	return getTime() >= startTime + (startTime - _lastFrameStartTime);
+}
+
+void VideoDecoder::dropNextFrame() {
+	// Decode the frame like decodeNextFrame() does, but tell the track
+	// that it is not going to be shown
+	VideoTrack *track = _nextVideoTrack;
+	_lastFrameTrack = track;
+	_lastFrameStartTime = track->getNextFrameStartTime();
+
+	track->setDropFrames(true);
+	readNextPacket();
+
+	if (_nextVideoTrack)
+		_nextVideoTrack->decodeNextFrame();
+
+	track->setDropFrames(false);
+}
+
+void VideoDecoder::startDecodeAhead() {
+	if (_decodeAhead || !_decodeAheadFrames || !supportsDecodeAhead())
+		return;
+
+	Common::StackLock lock(_decodeMutex);
+
+	if (!_nextVideoTrack)
+		return;
+
+	_decodeAhead = new DecodeAhead();
+	_decodeAhead->frames.resize(_decodeAheadFrames);
+	_decodeAhead->readPos = 0;
+	_decodeAhead->count = 0;
+	_decodeAhead->endOfFrames = false;
+	_decodeAhead->nextStartTime = _nextVideoTrack->getNextFrameStartTime();
+	_decodeAhead->nextReversed = _nextVideoTrack->isReversed();
+	_decodeAhead->shownFrame = getTrackCurFrame();
+	_decodeAhead->droppedPalette = false;
+
+	Common::TimerManager *timerManager = g_system->getTimerManager();
+	timerManager->removeTimerProc(decodeAheadTimer);
+	s_decodeAheadDecoders.push_back(this);
+	timerManager->installTimerProc(decodeAheadTimer, kDecodeAheadInterval, 0, "VideoDecodeAhead");
+}
+
+void VideoDecoder::stopDecodeAhead() {
+	if (!_decodeAhead)
+		return;
+
+	// The timer proc locks _decodeMutex, so this must not be held here
+	Common::TimerManager *timerManager = g_system->getTimerManager();
+	timerManager->removeTimerProc(decodeAheadTimer);
+
+	for (uint i = 0; i < s_decodeAheadDecoders.size(); i++) {
+		if (s_decodeAheadDecoders[i] == this) {
+			s_decodeAheadDecoders.remove_at(i);
+			break;
+		}
+	}
+
+	if (!s_decodeAheadDecoders.empty())
+		timerManager->installTimerProc(decodeAheadTimer, kDecodeAheadInterval, 0, "VideoDecodeAhead");
+
+	delete _decodeAhead;
+	_decodeAhead = 0;
+}
+
+void VideoDecoder::flushDecodeAhead() {
+	// Called with _decodeMutex held, after the tracks were moved
+	if (!_decodeAhead)
+		return;
+
+	Common::StackLock lock(_decodeAhead->mutex);
+	_droppedFrames += _decodeAhead->count;
+	_decodeAhead->count = 0;
+	_decodeAhead->endOfFrames = false;
+	_decodeAhead->nextStartTime = _nextVideoTrack ? _nextVideoTrack->getNextFrameStartTime() : 0;
+	_decodeAhead->nextReversed = _nextVideoTrack && _nextVideoTrack->isReversed();
+	_decodeAhead->shownFrame = getTrackCurFrame();
+	_decodeAhead->droppedPalette = false;
+}
+
+void VideoDecoder::wakeDecodeAhead() {
+	// Called when the conditions of hasTrackFramesLeft() may have changed
+	if (!_decodeAhead)
+		return;
+
+	Common::StackLock lock(_decodeAhead->mutex);
+	_decodeAhead->endOfFrames = false;
+}
+
+void VideoDecoder::decodeAheadTimer(void * /* refCon */) {
+	for (uint i = 0; i < s_decodeAheadDecoders.size(); i++)
+		s_decodeAheadDecoders[i]->fillDecodeAhead();
+}
+
+void VideoDecoder::fillDecodeAhead() {
+	Common::StackLock decodeLock(_decodeMutex);
+	DecodeAhead &decodeAhead = *_decodeAhead;
+
+	// Decode (or drop) a single frame per tick, as the timer shares its
+	// thread with all the other timers
+	uint slot;
+	bool queueEmpty;
+
+	{
+		Common::StackLock lock(decodeAhead.mutex);
+
+		if (decodeAhead.endOfFrames || decodeAhead.count == decodeAhead.frames.size())
+			return;
+
+		slot = (decodeAhead.readPos + decodeAhead.count) % decodeAhead.frames.size();
+		queueEmpty = (decodeAhead.count == 0);
+	}
+
+	DecodeAhead::Frame &frame = decodeAhead.frames[slot];
+
+	// The palette of a dropped frame has to go with the next frame
+	if (!decodeAhead.droppedPalette)
+		frame.dirtyPalette = false;
+
+	if (!_nextVideoTrack || !hasTrackFramesLeft()) {
+		Common::StackLock lock(decodeAhead.mutex);
+		decodeAhead.endOfFrames = true;
+		return;
+	}
+
+	// Frames which are already queued are dropped by nextQueuedFrame()
+	if (queueEmpty && shouldDropNextFrame()) {
+		dropNextFrame();
+
+		if (_nextVideoTrack && _nextVideoTrack->hasDirtyPalette()) {
+			memcpy(frame.palette, _nextVideoTrack->getPalette(), sizeof(frame.palette));
+			frame.dirtyPalette = true;
+			decodeAhead.droppedPalette = true;
+		}
+
+		findNextVideoTrack();
+
+		Common::StackLock lock(decodeAhead.mutex);
+		_droppedFrames++;
+		return;
+	}
+
+	decodeAhead.droppedPalette = false;
+
+	// Decode the frame like decodeNextFrame() does when not decoding
+	// ahead, with the timing needsUpdate() would have used
+	frame.startTime = _nextVideoTrack->getNextFrameStartTime();
+	frame.reversed = _nextVideoTrack->isReversed();
+	_lastFrameTrack = _nextVideoTrack;
+	_lastFrameStartTime = frame.startTime;
+
+	readNextPacket();
+
+	if (!_nextVideoTrack) {
+		Common::StackLock lock(decodeAhead.mutex);
+		decodeAhead.endOfFrames = true;
+		return;
+	}
+
+	const Graphics::Surface *surface = _nextVideoTrack->decodeNextFrame();
+
+	frame.hasSurface = (surface != 0);
+	if (surface) {
+		if (frame.surface.w != surface->w || frame.surface.h != surface->h || frame.surface.format != surface->format) {
+			frame.surface.free();
+			frame.surface.create(surface->w, surface->h, surface->format);
+		}
+
+		for (int y = 0; y < surface->h; y++)
+			memcpy(frame.surface.getBasePtr(0, y), surface->getBasePtr(0, y), surface->w * surface->format.bytesPerPixel);
+	}
+
+	if (_nextVideoTrack->hasDirtyPalette()) {
+		memcpy(frame.palette, _nextVideoTrack->getPalette(), sizeof(frame.palette));
+		frame.dirtyPalette = true;
+	}
+
+	findNextVideoTrack();
+	frame.curFrame = getTrackCurFrame();
+
+	const uint32 time = getTime();
+	const bool due = frame.reversed ? (frame.startTime > time) : (frame.startTime < time);
+
+	Common::StackLock lock(decodeAhead.mutex);
+
+	if (decodeAhead.count == 0 && due && isPlaying() && !isPaused())
+		_lateFrames++;
+
+	decodeAhead.count++;
+
+	if (_nextVideoTrack) {
+		decodeAhead.nextStartTime = _nextVideoTrack->getNextFrameStartTime();
+		decodeAhead.nextReversed = _nextVideoTrack->isReversed();
+	}
+}
+
+bool VideoDecoder::hasQueuedFrame() const {
+	Common::StackLock lock(_decodeAhead->mutex);
+
+	if (!_decodeAhead->count)
+		return false;
+
+	// The end time may have been moved before frames which are already decoded
+	const DecodeAhead::Frame &frame = _decodeAhead->frames[_decodeAhead->readPos];
+	return !isPlaying() || !_endTimeSet || frame.startTime < (uint)_endTime.msecs();
+}
+
+const Graphics::Surface *VideoDecoder::nextQueuedFrame() {
+	if (!hasQueuedFrame())
+		return 0;
+
+	const bool dropLate = _frameDropPolicy != kFrameDropNone && isPlaying() && !isPaused();
+	const uint32 time = dropLate ? getTime() : 0;
+
+	DecodeAhead &decodeAhead = *_decodeAhead;
+	Common::StackLock lock(decodeAhead.mutex);
+
+	// Drop the queued frames while the one after them is due as well
+	if (dropLate) {
+		while (decodeAhead.count > 1) {
+			const DecodeAhead::Frame &following = decodeAhead.frames[(decodeAhead.readPos + 1) % decodeAhead.frames.size()];
+
+			if (following.reversed || following.startTime > time)
+				break;
+
+			DecodeAhead::Frame &dropped = decodeAhead.frames[decodeAhead.readPos];
+			if (dropped.dirtyPalette) {
+				memcpy(decodeAhead.palette, dropped.palette, sizeof(decodeAhead.palette));
+				_palette = decodeAhead.palette;
+				_dirtyPalette = true;
+			}
+
+			decodeAhead.readPos = (decodeAhead.readPos + 1) % decodeAhead.frames.size();
+			decodeAhead.count--;
+			_droppedFrames++;
+		}
+	}
+
+	DecodeAhead::Frame &frame = decodeAhead.frames[decodeAhead.readPos];
+	const bool hasSurface = frame.hasSurface;
+
+	if (hasSurface)
+		SWAP(frame.surface, decodeAhead.shownSurface);
+
+	decodeAhead.shownFrame = frame.curFrame;
+
+	if (frame.dirtyPalette) {
+		memcpy(decodeAhead.palette, frame.palette, sizeof(decodeAhead.palette));
+		_palette = decodeAhead.palette;
+		_dirtyPalette = true;
+	}
+
+	decodeAhead.readPos = (decodeAhead.readPos + 1) % decodeAhead.frames.size();
+	decodeAhead.count--;
+
+	return hasSurface ? &decodeAhead.shownSurface : 0;
+}
+
 } // End of namespace Video
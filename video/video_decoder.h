@@ -26,6 +26,7 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/mutex.h"
 #include "common/rational.h"
 #include "common/str.h"
 #include "graphics/pixelformat.h"
@@ -52,7 +53,7 @@ namespace Video {
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -354,6 +355,71 @@ public:
 	 */
 	void setDefaultHighColorFormat(const Graphics::PixelFormat &format) { _defaultHighColorFormat = format; }
 
+	/**
+	 * Set how many frames to decode ahead of time.
+	 *
+	 * When this is non-zero, the frames are decoded by a timer into a queue
+	 * of that length, so that an expensive frame does not stall the caller
+	 * of decodeNextFrame(). needsUpdate() and getTimeToNextFrame() then only
+	 * look at the queue; if the next frame is not decoded yet, needsUpdate()
+	 * returns false until it is.
+	 *
+	 * There is no separate decoding thread: the timer shares its thread with
+	 * the other timers, like the ones driving the music, so it decodes a
+	 * single frame per video and tick. A frame which takes long to decode
+	 * still delays them.
+	 *
+	 * The default is taken from the "video_decode_ahead" config key. The
+	 * setting takes effect the next time playback is started, and is
+	 * ignored by decoders which do not support it (see
+	 * supportsDecodeAhead()).
+	 *
+	 * @param numFrames	the number of frames to decode ahead, or 0 to
+	 *                  decode each frame when it is requested
+	 */
+	void setDecodeAhead(uint numFrames) { _decodeAheadFrames = numFrames; }
+
+	/**
+	 * Return how many frames were decoded ahead of time only after they
+	 * were due, i.e. how often the queue ran dry, since the video was
+	 * loaded.
+	 */
+	uint32 getLateFrameCount() const;
+
+	/**
+	 * Ways to handle frames which are requested too late.
+	 */
+	enum FrameDropPolicy {
+		kFrameDropNone, ///< Return every frame, however late
+		kFrameDropLate  ///< Drop a frame if the one after it is due too
+	};
+
+	/**
+	 * Set how to handle frames which are requested too late, i.e. when the
+	 * decoder or the caller cannot keep up with the video.
+	 *
+	 * Dropped frames are still decoded as far as the following frames need
+	 * them; tracks which can skip some of the work do so (see
+	 * VideoTrack::setDropFrames()). This keeps playback in sync with the
+	 * audio, instead of playing slower.
+	 *
+	 * The default is taken from the "video_frame_drop" config key.
+	 */
+	void setFrameDropPolicy(FrameDropPolicy policy) { _frameDropPolicy = policy; }
+
+	/**
+	 * Get the policy set by setFrameDropPolicy().
+	 */
+	FrameDropPolicy getFrameDropPolicy() const { return _frameDropPolicy; }
+
+	/**
+	 * Return how many frames were decoded but never returned, because of
+	 * the frame drop policy, or because they were decoded ahead of time and
+	 * a seek, a rewind or a change of direction made them obsolete, since
+	 * the video was loaded.
+	 */
+	uint32 getDroppedFrameCount() const;
+
 	/**
 	 * Set the video to decode frames in reverse.
 	 *
@@ -578,6 +644,20 @@ protected:
 		 * Is the video track set to play in reverse?
 		 */
 		virtual bool isReversed() const { return false; }
+
+		/**
+		 * Set whether the next frames are going to be dropped, i.e. the
+		 * surface returned by decodeNextFrame() is not used.
+		 *
+		 * This is set right before readNextPacket() is called, and reset
+		 * after decodeNextFrame() was. The track can then save time, for
+		 * example by not converting the frame to the output format, or by
+		 * not decoding it at all if no other frame depends on it. The
+		 * current frame and the timing still have to advance as usual.
+		 *
+		 * @param drop true to drop the next frames, false to decode them
+		 */
+		virtual void setDropFrames(bool drop) {}
 	};
 
 	/**
@@ -771,6 +851,36 @@ protected:
 	 */
 	virtual bool useAudioSync() const { return true; }
 
+	/**
+	 * Whether frames can be decoded ahead of time (see setDecodeAhead()).
+	 *
+	 * The tracks and readNextPacket() are then used from a timer, with all
+	 * the functions of this class which change them being synchronized with
+	 * it. Only decoders which have been checked to use their tracks and
+	 * their stream in no other way during playback return true; subclasses
+	 * of those which do, for example from their own decodeNextFrame() or
+	 * through getTrack(), have to return false again.
+	 */
+	virtual bool supportsDecodeAhead() const { return false; }
+
+	/**
+	 * Held by the decode ahead timer while it uses the tracks and the
+	 * stream, and by everything else which changes them during playback.
+	 * Subclasses supporting decoding ahead have to hold it too, when they
+	 * change them outside of readNextPacket().
+	 */
+	Common::Mutex _decodeMutex;
+
+	/**
+	 * Whether the next frame should be dropped instead of being returned,
+	 * see setFrameDropPolicy().
+	 *
+	 * The default implementation applies the frame drop policy, assuming
+	 * the frame after the next one follows at the same interval as the
+	 * last two did. It never drops the last frame of a track.
+	 */
+	virtual bool shouldDropNextFrame() const;
+
 	/**
 	 * Get the given track based on its index.
 	 *
@@ -848,6 +958,12 @@ private:
 	// Default PixelFormat settings
 	Graphics::PixelFormat _defaultHighColorFormat;
 
+	// Dropping late frames. The start time is that of the last frame
+	// decoded or dropped, if it was from _lastFrameTrack.
+	FrameDropPolicy _frameDropPolicy;
+	VideoTrack *_lastFrameTrack;
+	uint32 _lastFrameStartTime;
+
 	// Internal helper functions
 	void stopAudio();
 	void startAudio();
@@ -860,6 +976,24 @@ private:
 	uint32 _pauseStartTime;
 	byte _audioVolume;
 	int8 _audioBalance;
+
+	// Decoding ahead, see setDecodeAhead()
+	struct DecodeAhead;
+	DecodeAhead *_decodeAhead;
+	uint _decodeAheadFrames;
+	uint32 _lateFrames, _droppedFrames;
+
+	void startDecodeAhead();
+	void stopDecodeAhead();
+	void flushDecodeAhead();
+	void wakeDecodeAhead();
+	void fillDecodeAhead();
+	void dropNextFrame();
+	const Graphics::Surface *nextQueuedFrame();
+	bool hasQueuedFrame() const;
+	int getTrackCurFrame() const;
+	bool hasTrackFramesLeft() const;
+	static void decodeAheadTimer(void *refCon);
 };
 
 } // End of namespace Video